@@ -167,6 +167,159 @@ typedef union String {
  */
 typedef uint32_t Char32;
 
+/**
+    A UTF-16 code unit.
+ */
+typedef uint16_t Char16;
+
+/**
+    Iterates over the codepoints of a string in either direction. Invalid UTF-8
+    bytes are returned as the replacement character (U+FFFD), one per byte.
+    The iterator is invalidated if the string is modified.
+ */
+typedef struct StringU8Iter {
+    const char* data;
+    size_t size;
+    // The byte index of the next codepoint returned by string_u8_iter_next.
+    size_t position;
+} StringU8Iter;
+
+/**
+    A reference to a range of characters owned by something else, such as
+    part of a String. The characters are not NULL terminated.
+ */
+typedef struct StringView {
+    const char* data;
+    size_t size;
+} StringView;
+
+/**
+    The Unicode normalization forms.
+ */
+typedef enum StringNormalization {
+    STRING_NFC,
+    STRING_NFD,
+    STRING_NFKC,
+    STRING_NFKD
+} StringNormalization;
+
+/**
+    How to handle characters that can't be converted to a legacy encoding.
+ */
+typedef enum StringEncodingErrors {
+    // Replace each character that can't be converted with '?'.
+    STRING_ENCODING_REPLACE,
+    // Fail the conversion at the first character that can't be converted.
+    STRING_ENCODING_STRICT
+} StringEncodingErrors;
+
+/**
+    The result of parsing a number from the start of a string.
+ */
+typedef enum StringParseError {
+    // A number was parsed.
+    STRING_PARSE_OK,
+    // The string doesn't start with a number.
+    STRING_PARSE_INVALID,
+    // The number is out of the range of the type. The value is clamped to the closest limit.
+    STRING_PARSE_OVERFLOW
+} StringParseError;
+
+/**
+    The alphabet used to encode and decode Base64.
+ */
+typedef enum StringBase64Alphabet {
+    // The standard alphabet from RFC 4648, using '+' and '/'. Encoding adds '=' padding.
+    STRING_BASE64_STANDARD,
+    // The URL and filename safe alphabet from RFC 4648, using '-' and '_'. Encoding doesn't add padding.
+    STRING_BASE64_URL
+} StringBase64Alphabet;
+
+/**
+    Maps a codepoint to its replacement for string_u8_map. Return
+    SSO_STRING_U8_MAP_DELETE to remove the codepoint instead.
+ */
+typedef Char32 (*StringU8Mapper)(Char32 value, void* state);
+
+// Returned by a StringU8Mapper or stored in a string_u8_map_table table to remove a codepoint.
+#define SSO_STRING_U8_MAP_DELETE ((Char32)0xFFFFFFFF)
+
+/**
+    Validates UTF-8 that arrives in chunks. A sequence may be split across chunks.
+    Use string_u8_validator_init to initialize this before using it.
+ */
+typedef struct StringU8Validator {
+    size_t offset;
+    size_t error_offset;
+    unsigned char pending[4];
+    int pending_size;
+} StringU8Validator;
+
+/**
+    A printf format string that has been parsed ahead of time by
+    string_format_compile. It isn't modified when applied, so it can be
+    shared between threads.
+ */
+typedef struct StringFormat StringFormat;
+
+/**
+    The type of a value passed to string_format_braces.
+ */
+typedef enum StringFormatArgType {
+    STRING_FORMAT_ARG_INT,
+    STRING_FORMAT_ARG_UINT,
+    STRING_FORMAT_ARG_DOUBLE,
+    STRING_FORMAT_ARG_BOOL,
+    STRING_FORMAT_ARG_CHAR,
+    STRING_FORMAT_ARG_CSTR,
+    STRING_FORMAT_ARG_STRING,
+    STRING_FORMAT_ARG_VIEW
+} StringFormatArgType;
+
+/**
+    A value tagged with its type for string_format_braces. These are usually
+    created by the string_format_arg macro, which picks the type using _Generic.
+ */
+typedef struct StringFormatArg {
+    StringFormatArgType type;
+    // The name used to refer to the argument in a format, or NULL.
+    const char* name;
+    union {
+        int64_t i;
+        uint64_t u;
+        double d;
+        bool b;
+        char c;
+        const char* cstr;
+        const String* str;
+        StringView view;
+    } value;
+} StringFormatArg;
+
+// The number of codepoints between entries in a StringU8Index. Smaller values make
+// lookups faster at the cost of memory. Can be defined before including this file.
+#ifndef SSO_STRING_U8_INDEX_STRIDE
+#define SSO_STRING_U8_INDEX_STRIDE 64
+#endif
+
+/**
+    Maps codepoint positions in a string to byte offsets. Stores the byte offset of
+    every SSO_STRING_U8_INDEX_STRIDE-th codepoint so a position can be found without
+    scanning the entire string.
+
+    The index is kept up to date by the string_u8_index_* modification functions.
+    After modifying the string any other way, call string_u8_index_invalidate and
+    the index will be rebuilt the next time it is used.
+ */
+typedef struct StringU8Index {
+    size_t* offsets;
+    size_t count;
+    size_t capacity;
+    size_t codepoints;
+    size_t size;
+    bool valid;
+} StringU8Index;
+
 /**
     Initializes a string from a c-string.
 
@@ -257,282 +410,1293 @@ static inline size_t string_size(const String* str);
     @param str The string to get the codepoint count of.
 
     @return The number of codepoints in the string.
+
+    @remark Every byte that isn't a UTF-8 continuation byte (0x80 - 0xBF) is counted,
+            including embedded NULL characters.
 */
 SSO_STRING_EXPORT size_t string_u8_codepoints(const String* str);
 
 /**
-    Gets the number of characters a string can potential hold without resizing.
-    This does NOT include the NULL terminating character.
+    Gets the number of codepoints in a range of bytes in a string.
 
-    @param str The string to get the capacity of.
+    @param str The string to get the codepoint count of.
+    @param start The byte index to start counting from.
+    @param count The number of bytes to count. Clamped to the end of the string.
 
-    @return The internal capacity of the string.
+    @return The number of codepoints that start in the range.
 */
-static inline size_t string_capacity(const String* str);
+SSO_STRING_EXPORT size_t string_u8_codepoints_range(const String* str, size_t start, size_t count);
 
 /**
-    Gets the character at the specified index in a string.
+    Initializes a string with a range of codepoints from another string.
 
-    @param str The string to get the character from.
-    @param index The index of the character to get.
+    @param str The string to get the range from.
+    @param start The position of the first codepoint in the range.
+    @param count The number of codepoints in the range.
+    @param out_value The string that will be initialized with the contents of the range.
+                     This value should not be initialized by the caller, or it might cause a memory leak.
 
-    @return The character at the specified index.
+    @return true on success, false on allocation failure.
+
+    @remark Codepoints are counted the same way as string_u8_codepoints. Both start
+            and count are clamped to the end of the string.
 */
-static inline char string_get(const String* str, size_t index);
+SSO_STRING_EXPORT bool string_u8_substring(const String* str, size_t start, size_t count, String* out_value);
 
 /**
-    Gets the unicode character at the specified byte index.
+    Gets a view of a range of codepoints in a string without copying them.
 
-    @param str The string to get the unicode character from.
-    @param index The starting byte index of the unicode character.
+    @param str The string to get the range from.
+    @param start The position of the first codepoint in the range.
+    @param count The number of codepoints in the range.
 
-    @return Thee unicode character starting at the specified byte index.
+    @return A view of the range. It is invalidated if the string is modified.
+
+    @remark Codepoints are counted the same way as string_u8_codepoints. Both start
+            and count are clamped to the end of the string.
 */
-SSO_STRING_EXPORT Char32 string_u8_get(const String* str, size_t index);
+SSO_STRING_EXPORT StringView string_u8_substring_view(const String* str, size_t start, size_t count);
 
 /**
-    Gets the unicode character at the specified byte index, 
-    optionally getting the number of bytes that the character
-    takes in the string.
+    Shortens a string to the specified number of codepoints. Does nothing
+    if the string doesn't have more codepoints than that.
 
-    @param str The string to get the unicode character from.
-    @param index The starting byte index of the unicode character.
-    @param out_size If not NULL, contains the number of bytes used to represent unicode character.
+    @param str The string to shorten.
+    @param count The number of codepoints to keep.
+*/
+SSO_STRING_EXPORT void string_u8_truncate(String* str, size_t count);
 
-    @return Thee unicode character starting at the specified byte index.
+/**
+    Shortens a string to at most the specified number of bytes without
+    splitting a UTF-8 sequence. Does nothing if the string isn't longer than that.
 
-    @remark This function can be used to easily iterate over a UTF-8 string.
+    @param str The string to shorten.
+    @param max_bytes The maximum size of the string.
+
+    @remark If the cut would split a sequence, the string is cut before
+            the sequence instead. Only up to 4 bytes are inspected.
 */
-SSO_STRING_EXPORT Char32 string_u8_get_with_size(const String* str, size_t index, int* out_size);
+SSO_STRING_EXPORT void string_u8_truncate_bytes(String* str, size_t max_bytes);
 
 /**
-    Gets the unicode character size at the specified byte index in bytes. 
+    Determines if a string contains valid UTF-8, optionally getting the location of the first error.
 
-    @param str The string to gert the unicode character size from.
-    @param index The starting byte index of the unicode character.
+    @param str The string to validate.
+    @param out_error_offset If not NULL and the string is invalid, contains the byte index of the start
+                            of the first invalid or truncated sequence. Set to SIZE_MAX if the string is valid.
 
-    @return The number of bytes used to represent the unicode character.
+    @return true if the string is valid UTF-8, false otherwise.
+
+    @remark Overlong encodings, surrogates and codepoints above U+10FFFF are rejected.
 */
-SSO_STRING_EXPORT int string_u8_codepoint_size(const String* str, size_t index);
+SSO_STRING_EXPORT bool string_u8_validate(const String* str, size_t* out_error_offset);
 
 /**
-    Sets the character at the specified index in a string.
+    Determines if a string contains valid UTF-8.
 
-    @param str The string to modify.
-    @param index The index of the character to replace.
-    @param value The new character to replace the existing character with.
+    @param str The string to validate.
+
+    @return true if the string is valid UTF-8, false otherwise.
 */
-static inline void string_set(String* str, size_t index, char value);
+static inline bool string_u8_is_valid(const String* str);
 
 /**
-    Replaces the unicode character at the specified index in a string.
+    Initializes a validator for UTF-8 that is received in chunks.
 
-    @param str The string to modify.
-    @param index The index of the character to replace.
-    @param value The new character to replace the existing character with.
+    @param validator The validator to initialize.
+*/
+SSO_STRING_EXPORT void string_u8_validator_init(StringU8Validator* validator);
+
+/**
+    Validates the next chunk of a UTF-8 stream.
+
+    @param validator The validator state.
+    @param data The next chunk of the stream.
+    @param size The number of bytes in the chunk.
+
+    @return false if an error has been found in the stream so far, true otherwise.
+
+    @remark A sequence that is cut off at the end of the chunk is carried over to the next one.
+*/
+SSO_STRING_EXPORT bool string_u8_validator_update(StringU8Validator* validator, const char* data, size_t size);
+
+/**
+    Finishes validating a UTF-8 stream.
+
+    @param validator The validator state.
+    @param out_error_offset If not NULL and the stream is invalid, contains the byte index in the stream
+                            of the start of the first invalid or truncated sequence. Set to SIZE_MAX
+                            if the stream is valid.
+
+    @return true if the entire stream was valid UTF-8, false otherwise.
+*/
+SSO_STRING_EXPORT bool string_u8_validator_finish(StringU8Validator* validator, size_t* out_error_offset);
+
+/**
+    Gets the number of UTF-16 code units needed to represent a string.
+
+    @param str The UTF-8 string to measure.
+
+    @return The number of UTF-16 code units string_u8_to_utf16 will write.
+*/
+SSO_STRING_EXPORT size_t string_u8_utf16_length(const String* str);
+
+/**
+    Converts a string to UTF-16. Does not add a terminating character at the end.
+
+    @param str The UTF-8 string to convert.
+    @param out The buffer to write the UTF-16 code units to.
+    @param out_size The number of code units that can be written to out.
+
+    @return The number of code units written, or SIZE_MAX if out is too small,
+            in which case nothing is written.
+
+    @remark Each byte that isn't part of a valid UTF-8 sequence is converted to U+FFFD.
+*/
+SSO_STRING_EXPORT size_t string_u8_to_utf16(const String* str, Char16* out, size_t out_size);
+
+/**
+    Gets the number of UTF-32 code units needed to represent a string.
+
+    @param str The UTF-8 string to measure.
+
+    @return The number of UTF-32 code units string_u8_to_utf32 will write.
+*/
+SSO_STRING_EXPORT size_t string_u8_utf32_length(const String* str);
+
+/**
+    Converts a string to UTF-32. Does not add a terminating character at the end.
+
+    @param str The UTF-8 string to convert.
+    @param out The buffer to write the UTF-32 code units to.
+    @param out_size The number of code units that can be written to out.
+
+    @return The number of code units written, or SIZE_MAX if out is too small,
+            in which case nothing is written.
+
+    @remark Each byte that isn't part of a valid UTF-8 sequence is converted to U+FFFD.
+*/
+SSO_STRING_EXPORT size_t string_u8_to_utf32(const String* str, Char32* out, size_t out_size);
+
+/**
+    Appends UTF-16 text to the end of a string, converting it to UTF-8.
+
+    @param str The string to append to.
+    @param value The UTF-16 code units to append.
+    @param length The number of code units in value.
 
     @return true on success, false on allocation failure.
+
+    @remark Unpaired surrogates are converted to U+FFFD.
 */
-SSO_STRING_EXPORT bool string_u8_set(String* str, size_t index, Char32 value);
+SSO_STRING_EXPORT bool string_u8_from_utf16(String* str, const Char16* value, size_t length);
 
 /**
-    Determines if a string has no characters.
+    Appends UTF-32 text to the end of a string, converting it to UTF-8.
 
-    @return true if the string is empty; false otherwise.
+    @param str The string to append to.
+    @param value The UTF-32 code units to append.
+    @param length The number of code units in value.
+
+    @return true on success, false on allocation failure.
+
+    @remark Surrogates and values above U+10FFFF are converted to U+FFFD.
 */
-static inline bool string_empty(const String* str);
+SSO_STRING_EXPORT bool string_u8_from_utf32(String* str, const Char32* value, size_t length);
 
 /**
-    Determines if the string is NULL or has no characters.
+    Appends Latin-1 (ISO-8859-1) text to the end of a string, converting it to UTF-8.
 
-    @return true if the string is NULL or empty; false otherwise.
+    @param str The string to append to.
+    @param value The Latin-1 text to append.
+    @param length The number of bytes in value.
+
+    @return true on success, false on allocation failure.
 */
-static inline bool string_is_null_or_empty(const String* str);
+SSO_STRING_EXPORT bool string_u8_from_latin1(String* str, const char* value, size_t length);
 
 /**
-    Working with ASCII or UTF-8 strings, determines if the string is NULL,
-    empty, or comprised of only whitespace characters.
+    Appends Windows-1252 text to the end of a string, converting it to UTF-8.
 
-    @return true if the string is NULL, empty, or comprised only of whitespace characters; false otherwise.
+    @param str The string to append to.
+    @param value The Windows-1252 text to append.
+    @param length The number of bytes in value.
+
+    @return true on success, false on allocation failure.
+
+    @remark The bytes Windows-1252 leaves undefined (0x81, 0x8D, 0x8F, 0x90 and 0x9D)
+            are converted to the C1 control characters with the same value.
 */
-SSO_STRING_EXPORT bool string_u8_is_null_or_whitespace(const String* str);
+SSO_STRING_EXPORT bool string_u8_from_cp1252(String* str, const char* value, size_t length);
 
 /**
-    Ensures that a string has a capacity large enough to hold a specified number of characters. 
-    Does not include any terminating characters.
+    Converts a string to Latin-1 (ISO-8859-1).
 
-    @param str - The string to potentially enlarge.
-    @param reserve - The desired minimum capacity, not including the NULL terminating character.
+    @param str The string to convert.
+    @param out The buffer to write the Latin-1 text to. It isn't NULL terminated.
+    @param out_size The size of out. It needs as many bytes as string_u8_utf32_length
+                    returns code units.
+    @param errors How to handle characters above U+00FF and invalid UTF-8 bytes.
+    @param out_error_offset If not NULL, receives the byte index of the first character
+                            that couldn't be converted when the conversion fails.
+
+    @return The number of bytes written, or SIZE_MAX if out is too small, in which case
+            nothing is written, or if errors is STRING_ENCODING_STRICT and a character
+            couldn't be converted.
+*/
+SSO_STRING_EXPORT size_t string_u8_to_latin1(
+    const String* str,
+    char* out,
+    size_t out_size,
+    StringEncodingErrors errors,
+    size_t* out_error_offset);
+
+/**
+    Converts a string to Windows-1252.
+
+    @param str The string to convert.
+    @param out The buffer to write the Windows-1252 text to. It isn't NULL terminated.
+    @param out_size The size of out. It needs as many bytes as string_u8_utf32_length
+                    returns code units.
+    @param errors How to handle characters Windows-1252 can't represent and invalid UTF-8 bytes.
+    @param out_error_offset If not NULL, receives the byte index of the first character
+                            that couldn't be converted when the conversion fails.
+
+    @return The number of bytes written, or SIZE_MAX if out is too small, in which case
+            nothing is written, or if errors is STRING_ENCODING_STRICT and a character
+            couldn't be converted.
+*/
+SSO_STRING_EXPORT size_t string_u8_to_cp1252(
+    const String* str,
+    char* out,
+    size_t out_size,
+    StringEncodingErrors errors,
+    size_t* out_error_offset);
+
+/**
+    Initializes an iterator at the start of a string.
+
+    @param iter The iterator to initialize.
+    @param str The string to iterate over.
+*/
+static inline void string_u8_iter_init(StringU8Iter* iter, const String* str);
+
+/**
+    Initializes an iterator at the end of a string, for iterating backwards.
+
+    @param iter The iterator to initialize.
+    @param str The string to iterate over.
+*/
+static inline void string_u8_iter_init_end(StringU8Iter* iter, const String* str);
+
+/**
+    Gets the codepoint at the position of an iterator and moves past it.
+
+    @param iter The iterator to advance.
+    @param out Contains the codepoint on success.
+
+    @return true if there was a codepoint, false if the iterator is at the end of the string.
+*/
+static inline bool string_u8_iter_next(StringU8Iter* iter, Char32* out);
+
+/**
+    Gets the codepoint before the position of an iterator and moves before it.
+
+    @param iter The iterator to move.
+    @param out Contains the codepoint on success.
+
+    @return true if there was a codepoint, false if the iterator is at the start of the string.
+*/
+static inline bool string_u8_iter_prev(StringU8Iter* iter, Char32* out);
+
+/**
+    Decodes up to max codepoints starting at the position of an iterator,
+    and moves past them.
+
+    @param iter The iterator to decode from.
+    @param out The buffer to write the codepoints to.
+    @param max The maximum number of codepoints to write.
+
+    @return The number of codepoints written.
+*/
+SSO_STRING_EXPORT size_t string_u8_iter_decode(StringU8Iter* iter, Char32* out, size_t max);
+
+/**
+    Decodes up to max codepoints from the start of a string.
+
+    @param str The string to decode.
+    @param out The buffer to write the codepoints to.
+    @param max The maximum number of codepoints to write.
+
+    @return The number of codepoints written.
+
+    @remark Use string_u8_iter_decode to decode a string in chunks.
+*/
+SSO_STRING_EXPORT size_t string_u8_decode_into(const String* str, Char32* out, size_t max);
+
+/**
+    Converts a string to lowercase using the full Unicode case mappings.
+
+    @param str The string to convert.
 
     @return true on success, false on allocation failure.
+
+    @remark A capital sigma at the end of a word is converted to a final sigma.
+            Language specific mappings (e.g. Turkish dotless i) are not applied.
 */
-static inline bool string_reserve(String* str, size_t reserve);
+SSO_STRING_EXPORT bool string_u8_to_lower(String* str);
 
 /**
-    Removes any excess memory not being used by a string.
+    Appends the lowercase version of a string to the end of another string.
 
-    @param str The string to shrink.
+    @param str The string to convert.
+    @param out The string to append the result to. Must not be the same as str.
+
+    @return true on success, false on allocation failure.
 */
-SSO_STRING_EXPORT void string_shrink_to_fit(String* str);
+SSO_STRING_EXPORT bool string_u8_to_lower_into(const String* str, String* out);
 
 /**
-    Clears the contents of a string, but does not free any allocated memory.
+    Converts a string to uppercase using the full Unicode case mappings.
 
-    @param str The string to clear.
+    @param str The string to convert.
 
-    @see string_shrink_to_fit
+    @return true on success, false on allocation failure.
+
+    @remark The size of the string can change (e.g. ß is converted to "SS").
 */
-static inline void string_clear(String* str);
+SSO_STRING_EXPORT bool string_u8_to_upper(String* str);
 
 /**
-    Inserts a c-string into a string at the specified index.
+    Appends the uppercase version of a string to the end of another string.
 
-    @param str The string to insert into.
-    @param value The c-string to insert.
-    @param index The index of the string to insert the value into.
+    @param str The string to convert.
+    @param out The string to append the result to. Must not be the same as str.
 
     @return true on success, false on allocation failure.
 */
-static inline bool string_insert_cstr(String* str, const char* value, size_t index);
+SSO_STRING_EXPORT bool string_u8_to_upper_into(const String* str, String* out);
 
 /**
-    Inserts a string into another string at the specified index.
+    Case folds a string using the full Unicode case folding, which is
+    meant for caseless matching rather than display.
 
-    @param str The string to insert into.
-    @param value The string to insert.
-    @param index The index of the string to insert the value into.
+    @param str The string to convert.
 
     @return true on success, false on allocation failure.
 */
-static inline bool string_insert_string(String* str, const String* value, size_t index);
+SSO_STRING_EXPORT bool string_u8_case_fold(String* str);
 
 /**
-    Inserts a section of a c-string into a string at the specified index.
+    Appends the case folded version of a string to the end of another string.
 
-    @param str The string to insert into.
-    @param value The c-string to insert.
-    @param index The index of the string to insert the value into.
-    @param start The starting index of the value to insert.
-    @param count The number of characters following start to insert.
+    @param str The string to convert.
+    @param out The string to append the result to. Must not be the same as str.
 
     @return true on success, false on allocation failure.
 */
-static inline bool string_insert_cstr_part(String* str, const char* value, size_t index, size_t start, size_t count);
+SSO_STRING_EXPORT bool string_u8_case_fold_into(const String* str, String* out);
 
 /**
-    Inserts a section of a string into another string at the specified index.
+    Replaces every codepoint in a string with the result of a mapping function.
 
-    @param str The string to insert into.
-    @param value The string to insert.
-    @param index The index of the string to insert the value into.
-    @param start The starting index of the value to insert.
-    @param count The number of characters following start to insert.
+    @param str The string to map.
+    @param mapper The function that maps each codepoint. It can return
+                  SSO_STRING_U8_MAP_DELETE to remove the codepoint.
+    @param state A value that is passed to every call of mapper.
 
     @return true on success, false on allocation failure.
+
+    @remark mapper is called exactly once per codepoint, in order. Invalid UTF-8
+            bytes are kept as is without calling it, and any return value that
+            isn't a Unicode scalar value is converted to U+FFFD.
+            The result is built in a new buffer from the first codepoint that
+            changes, so a string that maps to itself isn't copied. str is left
+            unchanged when this fails, even if mapper has already been called.
 */
-static inline bool string_insert_string_part(String* str, const String* value, size_t index, size_t start, size_t count);
+SSO_STRING_EXPORT bool string_u8_map(String* str, StringU8Mapper mapper, void* state);
 
 /**
-    Removes a section from a string.
+    Replaces codepoints in a string using a lookup table.
 
-    @param str The string to modify.
-    @param index The starting index of the characters to erase.
-    @param count The number of characters following index to erase.
+    @param str The string to map.
+    @param table The replacement of every codepoint less than table_size. An
+                 entry can be SSO_STRING_U8_MAP_DELETE to remove the codepoint.
+    @param table_size The number of entries in table. Codepoints that are
+                      greater than or equal to this are left unchanged.
+
+    @return true on success, false on allocation failure. str is left unchanged
+            when this fails.
 */
-SSO_STRING_EXPORT void string_erase(String* str, size_t index, size_t count);
+SSO_STRING_EXPORT bool string_u8_map_table(String* str, const Char32* table, size_t table_size);
 
 /**
-    Appends a character to the end of a string.
+    Determines if a string is in a Unicode normalization form.
 
-    @param str The string to append to.
-    @param value The character to append.
+    @param str The string to check.
+    @param form The normalization form to check for.
+
+    @return true if the string is normalized, false otherwise.
+
+    @remark Invalid UTF-8 bytes are treated as characters that never change
+            when normalized.
+*/
+SSO_STRING_EXPORT bool string_u8_is_normalized(const String* str, StringNormalization form);
+
+/**
+    Converts a string to a Unicode normalization form.
+
+    @param str The string to normalize.
+    @param form The normalization form to convert to.
 
     @return true on success, false on allocation failure.
 
+    @remark A string that is already normalized is left unchanged without
+            allocating. Otherwise only the part of the string following the
+            last character that is unaffected by normalization is rewritten.
+*/
+SSO_STRING_EXPORT bool string_u8_normalize(String* str, StringNormalization form);
+
+/**
+    Appends the normalized version of a string to the end of another string.
+
+    @param str The string to normalize.
+    @param out The string to append the result to. Must not be the same as str.
+    @param form The normalization form to convert to.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_normalize_into(const String* str, String* out, StringNormalization form);
+
+/**
+    Gets the byte index of the grapheme cluster that follows the one
+    starting at the specified byte index.
+
+    @param str The string to search.
+    @param index The byte index of the start of a grapheme cluster.
+
+    @return The byte index of the next grapheme cluster, or the size of the
+            string if there are no more grapheme clusters.
+
+    @remark Uses the extended grapheme cluster rules from UAX #29, so
+            combining marks, emoji sequences and flags are kept together.
+*/
+SSO_STRING_EXPORT size_t string_gc_next(const String* str, size_t index);
+
+/**
+    Gets the byte index of the start of the grapheme cluster that
+    ends at the specified byte index.
+
+    @param str The string to search.
+    @param index The byte index of the end of a grapheme cluster.
+
+    @return The byte index of the previous grapheme cluster, or 0 if index is 0.
+*/
+SSO_STRING_EXPORT size_t string_gc_prev(const String* str, size_t index);
+
+/**
+    Gets the number of grapheme clusters in a string.
+
+    @param str The string to count the grapheme clusters of.
+
+    @return The number of grapheme clusters in the string.
+*/
+SSO_STRING_EXPORT size_t string_gc_count(const String* str);
+
+/**
+    Removes the last grapheme cluster from a string.
+
+    @param str The string to remove the grapheme cluster from.
+
+    @return The number of bytes that were removed.
+*/
+SSO_STRING_EXPORT size_t string_gc_pop_back(String* str);
+
+/**
+    Shortens a string to the specified number of grapheme clusters. Does
+    nothing if the string doesn't have more grapheme clusters than that.
+
+    @param str The string to shorten.
+    @param count The number of grapheme clusters to keep.
+*/
+SSO_STRING_EXPORT void string_gc_truncate(String* str, size_t count);
+
+/**
+    Gets the number of characters a string can potential hold without resizing.
+    This does NOT include the NULL terminating character.
+
+    @param str The string to get the capacity of.
+
+    @return The internal capacity of the string.
+*/
+static inline size_t string_capacity(const String* str);
+
+/**
+    Gets the character at the specified index in a string.
+
+    @param str The string to get the character from.
+    @param index The index of the character to get.
+
+    @return The character at the specified index.
+*/
+static inline char string_get(const String* str, size_t index);
+
+/**
+    Gets the unicode character at the specified byte index.
+
+    @param str The string to get the unicode character from.
+    @param index The starting byte index of the unicode character.
+
+    @return Thee unicode character starting at the specified byte index.
+*/
+SSO_STRING_EXPORT Char32 string_u8_get(const String* str, size_t index);
+
+/**
+    Gets the unicode character at the specified byte index, 
+    optionally getting the number of bytes that the character
+    takes in the string.
+
+    @param str The string to get the unicode character from.
+    @param index The starting byte index of the unicode character.
+    @param out_size If not NULL, contains the number of bytes used to represent unicode character.
+
+    @return Thee unicode character starting at the specified byte index.
+
+    @remark This function can be used to easily iterate over a UTF-8 string.
+*/
+SSO_STRING_EXPORT Char32 string_u8_get_with_size(const String* str, size_t index, int* out_size);
+
+/**
+    Gets the unicode character size at the specified byte index in bytes. 
+
+    @param str The string to gert the unicode character size from.
+    @param index The starting byte index of the unicode character.
+
+    @return The number of bytes used to represent the unicode character.
+*/
+SSO_STRING_EXPORT int string_u8_codepoint_size(const String* str, size_t index);
+
+/**
+    Sets the character at the specified index in a string.
+
+    @param str The string to modify.
+    @param index The index of the character to replace.
+    @param value The new character to replace the existing character with.
+*/
+static inline void string_set(String* str, size_t index, char value);
+
+/**
+    Replaces the unicode character at the specified index in a string.
+
+    @param str The string to modify.
+    @param index The index of the character to replace.
+    @param value The new character to replace the existing character with.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_set(String* str, size_t index, Char32 value);
+
+/**
+    Determines if a string has no characters.
+
+    @return true if the string is empty; false otherwise.
+*/
+static inline bool string_empty(const String* str);
+
+/**
+    Determines if the string is NULL or has no characters.
+
+    @return true if the string is NULL or empty; false otherwise.
+*/
+static inline bool string_is_null_or_empty(const String* str);
+
+/**
+    Working with ASCII or UTF-8 strings, determines if the string is NULL,
+    empty, or comprised of only whitespace characters.
+
+    @return true if the string is NULL, empty, or comprised only of whitespace characters; false otherwise.
+*/
+SSO_STRING_EXPORT bool string_u8_is_null_or_whitespace(const String* str);
+
+/**
+    Removes the whitespace from the start and end of a string.
+
+    @param str The string to trim.
+
+    @remark Uses the same whitespace characters as string_u8_is_null_or_whitespace.
+*/
+SSO_STRING_EXPORT void string_trim(String* str);
+
+/**
+    Removes the whitespace from the start of a string.
+
+    @param str The string to trim.
+*/
+SSO_STRING_EXPORT void string_trim_start(String* str);
+
+/**
+    Removes the whitespace from the end of a string.
+
+    @param str The string to trim.
+*/
+SSO_STRING_EXPORT void string_trim_end(String* str);
+
+/**
+    Gets the part of a string without the whitespace at its start and end.
+
+    @param str The string to trim.
+
+    @return A view of the trimmed string. It's only valid until the string is modified.
+*/
+SSO_STRING_EXPORT StringView string_trim_view(const String* str);
+
+/**
+    Gets the part of a string without the whitespace at its start.
+
+    @param str The string to trim.
+
+    @return A view of the trimmed string. It's only valid until the string is modified.
+*/
+SSO_STRING_EXPORT StringView string_trim_start_view(const String* str);
+
+/**
+    Gets the part of a string without the whitespace at its end.
+
+    @param str The string to trim.
+
+    @return A view of the trimmed string. It's only valid until the string is modified.
+*/
+SSO_STRING_EXPORT StringView string_trim_end_view(const String* str);
+
+/**
+    Inserts characters at the start of a string until it's the specified size.
+    Does nothing if the string is already at least that long.
+
+    @param str The string to pad.
+    @param width The size of the padded string in bytes.
+    @param value The character to pad the string with.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_pad_left(String* str, size_t width, char value);
+
+/**
+    Appends characters to the end of a string until it's the specified size.
+    Does nothing if the string is already at least that long.
+
+    @param str The string to pad.
+    @param width The size of the padded string in bytes.
+    @param value The character to pad the string with.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_pad_right(String* str, size_t width, char value);
+
+/**
+    Adds characters to both sides of a string until it's the specified size.
+    Does nothing if the string is already at least that long.
+
+    @param str The string to pad.
+    @param width The size of the padded string in bytes.
+    @param value The character to pad the string with.
+
+    @return true on success, false on allocation failure.
+
+    @remark If the padding can't be split evenly, the extra character is added to the end.
+*/
+SSO_STRING_EXPORT bool string_pad_center(String* str, size_t width, char value);
+
+/**
+    Replaces every run of whitespace in a string with a single space.
+
+    @param str The string to modify.
+
+    @remark Whitespace at the start and end of the string is collapsed
+            rather than removed. Use string_trim to remove it.
+*/
+SSO_STRING_EXPORT void string_collapse_whitespace(String* str);
+
+/**
+    Ensures that a string has a capacity large enough to hold a specified number of characters. 
+    Does not include any terminating characters.
+
+    @param str - The string to potentially enlarge.
+    @param reserve - The desired minimum capacity, not including the NULL terminating character.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_reserve(String* str, size_t reserve);
+
+/**
+    Removes any excess memory not being used by a string.
+
+    @param str The string to shrink.
+*/
+SSO_STRING_EXPORT void string_shrink_to_fit(String* str);
+
+/**
+    Clears the contents of a string, but does not free any allocated memory.
+
+    @param str The string to clear.
+
+    @see string_shrink_to_fit
+*/
+static inline void string_clear(String* str);
+
+/**
+    Inserts a c-string into a string at the specified index.
+
+    @param str The string to insert into.
+    @param value The c-string to insert.
+    @param index The index of the string to insert the value into.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_insert_cstr(String* str, const char* value, size_t index);
+
+/**
+    Inserts a string into another string at the specified index.
+
+    @param str The string to insert into.
+    @param value The string to insert.
+    @param index The index of the string to insert the value into.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_insert_string(String* str, const String* value, size_t index);
+
+/**
+    Inserts a section of a c-string into a string at the specified index.
+
+    @param str The string to insert into.
+    @param value The c-string to insert.
+    @param index The index of the string to insert the value into.
+    @param start The starting index of the value to insert.
+    @param count The number of characters following start to insert.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_insert_cstr_part(String* str, const char* value, size_t index, size_t start, size_t count);
+
+/**
+    Inserts a section of a string into another string at the specified index.
+
+    @param str The string to insert into.
+    @param value The string to insert.
+    @param index The index of the string to insert the value into.
+    @param start The starting index of the value to insert.
+    @param count The number of characters following start to insert.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_insert_string_part(String* str, const String* value, size_t index, size_t start, size_t count);
+
+/**
+    Removes a section from a string.
+
+    @param str The string to modify.
+    @param index The starting index of the characters to erase.
+    @param count The number of characters following index to erase.
+*/
+SSO_STRING_EXPORT void string_erase(String* str, size_t index, size_t count);
+
+/**
+    Appends a character to the end of a string.
+
+    @param str The string to append to.
+    @param value The character to append.
+
+    @return true on success, false on allocation failure.
+
+*/
+SSO_STRING_EXPORT bool string_push_back(String* str, char value);
+
+/**
+    Appends a unicode character to the end of a string.
+
+    @param str The string to append to.
+    @param value The unicode character to append.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_push_back(String* str, Char32 value);
+
+/**
+    Appends an array of unicode characters to the end of a string.
+
+    @param str The string to append to.
+    @param values The unicode characters to append.
+    @param count The number of characters in values.
+
+    @return true on success, false on allocation failure.
+
+    @remark The encoded size is measured first so the string grows at most
+            once. Surrogates and values above U+10FFFF are converted to U+FFFD.
+            This is the same as string_u8_from_utf32.
+*/
+static inline bool string_u8_append_codepoints(String* str, const Char32* values, size_t count);
+
+/**
+    Removes a character from the end of a string and returns
+    the characters value. 
+
+    @param str The string to get the last character of.
+
+    @return The last character of the string if any, '\\0' otherwise.
+*/
+SSO_STRING_EXPORT char string_pop_back(String* str);
+
+/**
+    Removes a unicode character from the end of a string and
+    returns the characters value.
+
+    @param str The string to get the last unicode character of.
+
+    @return The last unicode character of the string if any, '\\0' otherwise.
+*/
+SSO_STRING_EXPORT Char32 string_u8_pop_back(String* str);
+
+/**
+    Initializes a codepoint index for a string.
+
+    @param index The index to initialize.
+    @param str The string to build the index for.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_index_init(StringU8Index* index, const String* str);
+
+/**
+    Frees the memory used by a codepoint index.
+
+    @param index The index to free.
+*/
+SSO_STRING_EXPORT void string_u8_index_free_resources(StringU8Index* index);
+
+/**
+    Marks a codepoint index as out of date so it's rebuilt the next time it's used.
+    Must be called after a string is modified without using the string_u8_index_* functions.
+
+    @param index The index to invalidate.
+*/
+static inline void string_u8_index_invalidate(StringU8Index* index);
+
+/**
+    Gets the number of codepoints in an indexed string.
+
+    @param index The index of the string.
+    @param str The string that was indexed.
+
+    @return The number of codepoints in the string.
+*/
+SSO_STRING_EXPORT size_t string_u8_index_codepoints(StringU8Index* index, const String* str);
+
+/**
+    Gets the byte offset of a codepoint in an indexed string.
+
+    @param index The index of the string.
+    @param str The string that was indexed.
+    @param n The position of the codepoint.
+
+    @return The byte offset of the codepoint. If n is equal to the number of codepoints,
+            returns the size of the string. If n is greater than that, returns SIZE_MAX.
+*/
+SSO_STRING_EXPORT size_t string_u8_offset_of(StringU8Index* index, const String* str, size_t n);
+
+/**
+    Gets the position of the codepoint that contains a byte in an indexed string.
+
+    @param index The index of the string.
+    @param str The string that was indexed.
+    @param offset The byte offset to get the codepoint position of.
+
+    @return The position of the codepoint that contains the byte. If offset is equal to
+            the size of the string, returns the number of codepoints.
+*/
+SSO_STRING_EXPORT size_t string_u8_position_of(StringU8Index* index, const String* str, size_t offset);
+
+/**
+    Replaces the unicode character at the specified byte index in an indexed string,
+    updating the index.
+
+    @param index The index of the string.
+    @param str The string to modify.
+    @param offset The byte index of the character to replace.
+    @param value The new character to replace the existing character with.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_index_set(StringU8Index* index, String* str, size_t offset, Char32 value);
+
+/**
+    Appends a unicode character to the end of an indexed string, updating the index.
+
+    @param index The index of the string.
+    @param str The string to append to.
+    @param value The unicode character to append.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_u8_index_push_back(StringU8Index* index, String* str, Char32 value);
+
+/**
+    Removes a unicode character from the end of an indexed string, updating the index.
+
+    @param index The index of the string.
+    @param str The string to get the last unicode character of.
+
+    @return The last unicode character of the string if any, '\\0' otherwise.
+*/
+SSO_STRING_EXPORT Char32 string_u8_index_pop_back(StringU8Index* index, String* str);
+
+/**
+    Appends a c-string to the end of a string.
+
+    @param str The string to append to.
+    @param value The c-string to append.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_append_cstr(String* str, const char* value);
+
+/**
+    Appends a string to the end of another string.
+
+    @param str The string to append to.
+    @param value The string to append.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_append_string(String* str, const String* value);
+
+/**
+    Appends a section of a c-string to the end of a string.
+
+    @param str The string to append to.
+    @param value The c-string to append.
+    @param start The starting index of the section of the value to append.
+    @param count The number of characters following start to append.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_append_cstr_part(
+    String* str, 
+    const char* value, 
+    size_t start, 
+    size_t count);
+
+/**
+    Appends a section of a string to the end of another string.
+
+    @param str The string to append to.
+    @param value The string to append.
+    @param start The starting index of the section of the value to append.
+    @param count The number of characters following start to append.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_append_string_part(
+    String* str, 
+    const String* value, 
+    size_t start, 
+    size_t count);
+
+/**
+    Appends the decimal representation of a signed integer to the end of a string.
+
+    @param str The string to append to.
+    @param value The integer to append.
+
+    @return true on success, false on allocation failure.
+
+    @remark The digits are written directly into the string without going through
+            vsnprintf, and the output doesn't depend on the locale.
+*/
+SSO_STRING_EXPORT bool string_append_int(String* str, int64_t value);
+
+/**
+    Appends the decimal representation of an unsigned integer to the end of a string.
+
+    @param str The string to append to.
+    @param value The integer to append.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_append_uint(String* str, uint64_t value);
+
+/**
+    Appends the hexadecimal representation of an unsigned integer to the end of a string.
+
+    @param str The string to append to.
+    @param value The integer to append.
+    @param uppercase Determines if the digits above 9 are uppercase.
+
+    @return true on success, false on allocation failure.
+
+    @remark No prefix or leading zeros are added.
+*/
+SSO_STRING_EXPORT bool string_append_hex(String* str, uint64_t value, bool uppercase);
+
+/**
+    Appends the shortest decimal representation of a double that converts back
+    to the same value to the end of a string.
+
+    @param str The string to append to.
+    @param value The double to append.
+
+    @return true on success, false on allocation failure.
+
+    @remark The layout is the same as JavaScript's Number.prototype.toString, so
+            values with a magnitude of at least 1e-6 and below 1e21 are written
+            without an exponent (e.g. "0.1" and "100") and all others with one
+            (e.g. "1.5e+300" and "1e-7"). Negative zero is written as "-0",
+            infinities as "inf" and "-inf", and every NaN as "nan", all of which
+            strtod accepts.
+*/
+SSO_STRING_EXPORT bool string_append_double(String* str, double value);
+
+/**
+    Parses a signed decimal integer from the start of a view.
+
+    @param view The characters to parse. They don't have to be NULL terminated.
+    @param value Stores the parsed value. It isn't modified if the view doesn't start with a number.
+    @param consumed If this isn't NULL, it stores how many characters were part
+                    of the number, or 0 if the view doesn't start with a number.
+
+    @return STRING_PARSE_OK on success, STRING_PARSE_INVALID if there's no number,
+            or STRING_PARSE_OVERFLOW if it doesn't fit in an int64_t.
+
+    @remark The number is an optional '+' or '-' followed by decimal digits.
+            Leading whitespace isn't skipped, and parsing stops at the first
+            character that can't be part of the number. Unlike strtol, this
+            doesn't depend on the locale.
+*/
+SSO_STRING_EXPORT StringParseError string_parse_i64_view(StringView view, int64_t* value, size_t* consumed);
+
+/**
+    Parses an unsigned decimal integer from the start of a view.
+
+    @param view The characters to parse. They don't have to be NULL terminated.
+    @param value Stores the parsed value. It isn't modified if the view doesn't start with a number.
+    @param consumed If this isn't NULL, it stores how many characters were part
+                    of the number, or 0 if the view doesn't start with a number.
+
+    @return STRING_PARSE_OK on success, STRING_PARSE_INVALID if there's no number,
+            or STRING_PARSE_OVERFLOW if it doesn't fit in a uint64_t.
+
+    @remark The number is an optional '+' followed by decimal digits. A '-'
+            sign is invalid instead of wrapping around like strtoul.
+*/
+SSO_STRING_EXPORT StringParseError string_parse_u64_view(StringView view, uint64_t* value, size_t* consumed);
+
+/**
+    Parses a decimal floating point number from the start of a view, rounded
+    to the nearest double.
+
+    @param view The characters to parse. They don't have to be NULL terminated.
+    @param value Stores the parsed value. It isn't modified if the view doesn't start with a number.
+    @param consumed If this isn't NULL, it stores how many characters were part
+                    of the number, or 0 if the view doesn't start with a number.
+
+    @return STRING_PARSE_OK on success, STRING_PARSE_INVALID if there's no number,
+            or STRING_PARSE_OVERFLOW if the magnitude is too large for a double,
+            in which case the value is set to an infinity.
+
+    @remark Accepts an optional sign, digits with an optional '.', and an
+            optional exponent ("1", "-2.5", ".5", "1e-7", "6.02E+23"), as well
+            as "inf", "infinity" and "nan" in any case. Leading whitespace
+            isn't skipped, and the decimal point is always '.', regardless of
+            the locale. Values too small for a double round to zero.
+*/
+SSO_STRING_EXPORT StringParseError string_parse_f64_view(StringView view, double* value, size_t* consumed);
+
+/**
+    Parses a signed decimal integer from the start of a string.
+    See string_parse_i64_view for details.
+*/
+static inline StringParseError string_parse_i64(const String* str, int64_t* value, size_t* consumed);
+
+/**
+    Parses an unsigned decimal integer from the start of a string.
+    See string_parse_u64_view for details.
+*/
+static inline StringParseError string_parse_u64(const String* str, uint64_t* value, size_t* consumed);
+
+/**
+    Parses a decimal floating point number from the start of a string.
+    See string_parse_f64_view for details.
+*/
+static inline StringParseError string_parse_f64(const String* str, double* value, size_t* consumed);
+
+/**
+    Appends the hexadecimal representation of a block of bytes to the end of a string,
+    using two digits per byte.
+
+    @param str The string to append to.
+    @param data The bytes to encode.
+    @param size The number of bytes to encode.
+    @param uppercase Determines if the digits above 9 are uppercase.
+
+    @return true on success, false on allocation failure.
+*/
+SSO_STRING_EXPORT bool string_append_hex_bytes(String* str, const void* data, size_t size, bool uppercase);
+
+/**
+    Decodes hexadecimal text and appends the bytes to the end of a string.
+
+    @param str The string to append the decoded bytes to.
+    @param hex The text to decode. It doesn't have to be NULL terminated.
+    @param length The number of characters in hex.
+    @param out_error_offset If not NULL, receives the index of the first character that
+                            isn't a hex digit, or of the unpaired last digit, when decoding fails.
+
+    @return true on success, false if the text is invalid or on allocation failure.
+            str isn't modified when this fails.
+
+    @remark Both uppercase and lowercase digits are accepted. No prefix or
+            whitespace is allowed.
+*/
+SSO_STRING_EXPORT bool string_decode_hex(String* str, const char* hex, size_t length, size_t* out_error_offset);
+
+/**
+    Appends the Base64 encoding of a block of bytes to the end of a string.
+
+    @param str The string to append to.
+    @param data The bytes to encode.
+    @param size The number of bytes to encode.
+    @param alphabet The alphabet to encode with. This also determines if padding is added.
+
+    @return true on success, false on allocation failure.
 */
-SSO_STRING_EXPORT bool string_push_back(String* str, char value);
+SSO_STRING_EXPORT bool string_append_base64(String* str, const void* data, size_t size, StringBase64Alphabet alphabet);
 
 /**
-    Appends a unicode character to the end of a string.
+    Decodes Base64 text and appends the bytes to the end of a string.
 
-    @param str The string to append to.
-    @param value The unicode character to append.
+    @param str The string to append the decoded bytes to.
+    @param text The text to decode. It doesn't have to be NULL terminated.
+    @param length The number of characters in text.
+    @param alphabet The alphabet the text was encoded with.
+    @param out_error_offset If not NULL, receives the index of the first character that
+                            couldn't be decoded when decoding fails.
 
-    @return true on success, false on allocation failure.
+    @return true on success, false if the text is invalid or on allocation failure.
+            str isn't modified when this fails.
+
+    @remark '=' padding is optional for both alphabets, but if it's there it
+            has to complete the last group of four characters. Whitespace isn't
+            allowed, and neither are unused bits that aren't zero in the last
+            character, so every encoding decodes to exactly one value.
 */
-SSO_STRING_EXPORT bool string_u8_push_back(String* str, Char32 value);
+SSO_STRING_EXPORT bool string_decode_base64(
+    String* str,
+    const char* text,
+    size_t length,
+    StringBase64Alphabet alphabet,
+    size_t* out_error_offset);
 
 /**
-    Removes a character from the end of a string and returns
-    the characters value. 
+    Escapes text so it can be placed between the quotes of a JSON string, and
+    appends it to the end of a string.
 
-    @param str The string to get the last character of.
+    @param str The string to append to.
+    @param value The text to escape. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
 
-    @return The last character of the string if any, '\\0' otherwise.
+    @return true on success, false on allocation failure.
+
+    @remark The quotes around the value aren't added. '"' and '\\' are escaped with a
+            backslash, and control characters below 0x20 use their short escape
+            ("\\n", "\\t", ...) if they have one and "\\u00XX" otherwise. All other
+            characters, including non-ASCII UTF-8, are copied unchanged.
 */
-SSO_STRING_EXPORT char string_pop_back(String* str);
+SSO_STRING_EXPORT bool string_append_json_escaped(String* str, const char* value, size_t length);
 
 /**
-    Removes a unicode character from the end of a string and
-    returns the characters value.
+    Decodes the escape sequences in the contents of a JSON string, and appends
+    the result to the end of a string.
 
-    @param str The string to get the last unicode character of.
+    @param str The string to append to.
+    @param value The text between the quotes of a JSON string. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
+    @param out_error_offset If not NULL, receives the index of the invalid escape sequence
+                            or character when decoding fails.
 
-    @return The last unicode character of the string if any, '\\0' otherwise.
+    @return true on success, false if the text is invalid or on allocation failure.
+            str isn't modified when this fails.
+
+    @remark "\\uXXXX" escapes are converted to UTF-8, combining surrogate pairs.
+            A surrogate without its other half becomes U+FFFD. Unknown escapes,
+            unescaped '"' characters and control characters below 0x20 are invalid.
 */
-SSO_STRING_EXPORT Char32 string_u8_pop_back(String* str);
+SSO_STRING_EXPORT bool string_json_unescape(String* str, const char* value, size_t length, size_t* out_error_offset);
 
 /**
-    Appends a c-string to the end of a string.
+    Percent-encodes text, and appends it to the end of a string.
 
     @param str The string to append to.
-    @param value The c-string to append.
+    @param value The text to encode. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
+    @param safe A c-string of extra characters to copy unchanged, or NULL. The unreserved
+                characters (letters, digits, '-', '.', '_' and '~') are never encoded.
+    @param space_as_plus Whether spaces are written as '+', as in
+                         application/x-www-form-urlencoded data.
 
     @return true on success, false on allocation failure.
+
+    @remark Every other byte is written as '%' followed by two uppercase hex digits,
+            so non-ASCII characters are encoded one byte of their UTF-8 at a time.
 */
-static inline bool string_append_cstr(String* str, const char* value);
+SSO_STRING_EXPORT bool string_append_url_encoded(String* str, const char* value, size_t length, const char* safe, bool space_as_plus);
 
 /**
-    Appends a string to the end of another string.
+    Decodes percent-encoded text, and appends the result to the end of a string.
 
     @param str The string to append to.
-    @param value The string to append.
+    @param value The text to decode. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
+    @param plus_as_space Whether '+' decodes to a space, as in application/x-www-form-urlencoded data.
+    @param out_error_offset If not NULL, receives the index of the '%' that isn't followed
+                            by two hex digits when decoding fails.
 
-    @return true on success, false on allocation failure.
+    @return true on success, false if the text is invalid or on allocation failure.
+            str isn't modified when this fails.
+
+    @remark The decoded bytes aren't checked to be valid UTF-8.
 */
-static inline bool string_append_string(String* str, const String* value);
+SSO_STRING_EXPORT bool string_url_decode(String* str, const char* value, size_t length, bool plus_as_space, size_t* out_error_offset);
 
 /**
-    Appends a section of a c-string to the end of a string.
+    Escapes the characters that have a special meaning in HTML, and appends the
+    result to the end of a string.
 
     @param str The string to append to.
-    @param value The c-string to append.
-    @param start The starting index of the section of the value to append.
-    @param count The number of characters following start to append.
+    @param value The text to escape. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
 
     @return true on success, false on allocation failure.
+
+    @remark '&', '<', '>', '"' and '\'' are replaced with "&amp;", "&lt;", "&gt;", "&quot;"
+            and "&#39;", which makes the result safe to use as text and in quoted attribute values.
 */
-static inline bool string_append_cstr_part(
-    String* str, 
-    const char* value, 
-    size_t start, 
-    size_t count);
+SSO_STRING_EXPORT bool string_append_html_escaped(String* str, const char* value, size_t length);
 
 /**
-    Appends a section of a string to the end of another string.
+    Replaces HTML character references with the characters they refer to, and
+    appends the result to the end of a string.
 
     @param str The string to append to.
-    @param value The string to append.
-    @param start The starting index of the section of the value to append.
-    @param count The number of characters following start to append.
+    @param value The text to unescape. It doesn't have to be NULL terminated.
+    @param length The number of characters in value.
 
     @return true on success, false on allocation failure.
+
+    @remark "&amp;", "&lt;", "&gt;", "&quot;" and "&apos;" are decoded, along with decimal
+            ("&#39;") and hex ("&#x27;") references, which are converted to UTF-8. Numeric
+            references to 0, surrogates or values above 0x10FFFF become U+FFFD. References
+            have to end with ';', and anything that isn't one is copied unchanged.
 */
-static inline bool string_append_string_part(
-    String* str, 
-    const String* value, 
-    size_t start, 
-    size_t count);
+SSO_STRING_EXPORT bool string_html_unescape(String* str, const char* value, size_t length);
 
 /**
     Compares a string and a c-string in the same fashion as strcmp.
@@ -614,6 +1778,92 @@ static inline bool string_ends_with_cstr(const String* str, const char* value);
 */
 static inline bool string_ends_with_string(const String* str, const String* value);
 
+/**
+    Compares a string and a c-string in the same fashion as string_compare_cstr,
+    treating ASCII letters as lowercase.
+
+    @param str The string on the left side of the operation.
+    @param value The c-string on the right side of the operation.
+
+    @return A negative value if str < value, zero if str == value, a positive value if str > value.
+*/
+static inline int string_compare_ignore_case_cstr(const String* str, const char* value);
+
+/**
+    Compares two strings in the same fashion as string_compare_string,
+    treating ASCII letters as lowercase.
+
+    @param str The string on the left side of the operation.
+    @param value The string on the right side of the operation.
+
+    @return A negative value if str < value, zero if str == value, a positive value if str > value.
+*/
+static inline int string_compare_ignore_case_string(const String* str, const String* value);
+
+/**
+    Determines if the contents of a String is equivalent to a c-string,
+    ignoring the case of ASCII letters.
+
+    @param str The string on the left side of the operation.
+    @param value The c-string on the right side of the operation.
+
+    @return true if the values are equivalent; false otherwise.
+*/
+static inline bool string_equals_ignore_case_cstr(const String* str, const char* value);
+
+/**
+    Determines if the contents of two strings are equivalent,
+    ignoring the case of ASCII letters.
+
+    @param str The string on the left side of the operation.
+    @param value The string on the right side of the operation.
+
+    @return true if the values are equivalent; false otherwise.
+*/
+static inline bool string_equals_ignore_case_string(const String* str, const String* value);
+
+/**
+    Compares a UTF-8 string and a UTF-8 c-string codepoint by codepoint
+    using Unicode simple case folding.
+
+    @param str The string on the left side of the operation.
+    @param value The c-string on the right side of the operation.
+
+    @return A negative value if str < value, zero if str == value, a positive value if str > value.
+*/
+static inline int string_u8_compare_ignore_case_cstr(const String* str, const char* value);
+
+/**
+    Compares two UTF-8 strings codepoint by codepoint using Unicode simple case folding.
+
+    @param str The string on the left side of the operation.
+    @param value The string on the right side of the operation.
+
+    @return A negative value if str < value, zero if str == value, a positive value if str > value.
+*/
+static inline int string_u8_compare_ignore_case_string(const String* str, const String* value);
+
+/**
+    Determines if a UTF-8 string is equivalent to a UTF-8 c-string
+    under Unicode simple case folding.
+
+    @param str The string on the left side of the operation.
+    @param value The c-string on the right side of the operation.
+
+    @return true if the values are equivalent; false otherwise.
+*/
+static inline bool string_u8_equals_ignore_case_cstr(const String* str, const char* value);
+
+/**
+    Determines if two UTF-8 strings are equivalent under Unicode simple case folding.
+
+    @param str The string on the left side of the operation.
+    @param value The string on the right side of the operation.
+
+    @return true if the values are equivalent; false otherwise.
+*/
+static inline bool string_u8_equals_ignore_case_string(const String* str, const String* value);
+
 /**
     Replaces a section of a string with the characters in a c-string.
 
@@ -638,6 +1888,102 @@ static inline bool string_replace_cstr(String* str, size_t pos, size_t count, co
 */
 static inline bool string_replace_string(String* str, size_t pos, size_t count, const String* value);
 
+/**
+    Replaces every occurrence of a c-string in a string with another c-string.
+
+    @param str The string whose contents are to be replaced.
+    @param value The c-string to search for.
+    @param replacement The c-string to replace each occurrence of value with.
+
+    @return true on success, false on allocation failure.
+
+    @remark If the replacement is not longer than value, the string is modified in-place.
+            Otherwise the string is resized at most once.
+*/
+static inline bool string_replace_all_cstr(String* str, const char* value, const char* replacement);
+
+/**
+    Replaces every occurrence of a string in another string with a third string.
+
+    @param str The string whose contents are to be replaced.
+    @param value The string to search for.
+    @param replacement The string to replace each occurrence of value with.
+
+    @return true on success, false on allocation failure.
+
+    @remark If the replacement is not longer than value, the string is modified in-place.
+            Otherwise the string is resized at most once.
+*/
+static inline bool string_replace_all_string(String* str, const String* value, const String* replacement);
+
+/**
+    Replaces the first occurrences of a c-string in a string with another c-string.
+
+    @param str The string whose contents are to be replaced.
+    @param value The c-string to search for.
+    @param replacement The c-string to replace the occurrences of value with.
+    @param count The maximum number of occurrences to replace.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_replace_first_n_cstr(String* str, const char* value, const char* replacement, size_t count);
+
+/**
+    Replaces the first occurrences of a string in another string with a third string.
+
+    @param str The string whose contents are to be replaced.
+    @param value The string to search for.
+    @param replacement The string to replace the occurrences of value with.
+    @param count The maximum number of occurrences to replace.
+
+    @return true on success, false on allocation failure.
+*/
+static inline bool string_replace_first_n_string(String* str, const String* value, const String* replacement, size_t count);
+
+/**
+    Replaces every occurrence of any of a set of c-strings in a string with its
+    corresponding replacement, in a single pass over the string.
+
+    @param str The string whose contents are to be replaced.
+    @param values An array of c-strings to search for.
+    @param replacements An array of c-strings to replace each value with.
+                        replacements[i] is used for values[i].
+    @param count The number of elements in the values and replacements arrays.
+
+    @return true on success, false on allocation failure.
+
+    @remark When matches overlap, the one that starts first wins. If multiple matches
+            start at the same position, the longest one wins. Replaced text is never
+            searched again.
+*/
+SSO_STRING_EXPORT bool string_replace_many_cstr(
+    String* str,
+    const char** values,
+    const char** replacements,
+    size_t count);
+
+/**
+    Replaces every occurrence of any of a set of strings in a string with its
+    corresponding replacement, in a single pass over the string.
+
+    @param str The string whose contents are to be replaced.
+    @param values An array of strings to search for.
+    @param replacements An array of strings to replace each value with.
+                        replacements[i] is used for values[i].
+    @param count The number of elements in the values and replacements arrays.
+
+    @return true on success, false on allocation failure.
+
+    @remark When matches overlap, the one that starts first wins. If multiple matches
+            start at the same position, the longest one wins. Replaced text is never
+            searched again.
+*/
+SSO_STRING_EXPORT bool string_replace_many_string(
+    String* str,
+    const String* values,
+    const String* replacements,
+    size_t count);
+
 /**
     Initializes a string with the data from a slice of another string.
 
@@ -760,35 +2106,187 @@ static inline size_t string_rfind_cstr(const String* str, size_t pos, const char
     @param pos The starting position in the string to start searching, starting from the back.
     @param value The string value to search for.
 
-    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_rfind_string(const String* str, size_t pos, const String* value);
+
+/**
+    Finds the starting index of the last occurrence of part of a c-string in a string. 
+    
+    @param str The string to search.
+    @param pos The starting position in the string to start searching, starting from the back.
+    @param value The c-string value to search for.
+    @param start The beginning index of value to search for in the string.
+    @param length The number of characters following start in value to search for in the string.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_rfind_substr_cstr(const String* str, size_t pos, const char* value, size_t start, size_t length);
+
+/**
+    Finds the starting index of the last occurrence of part of a string in another string. 
+    
+    @param str The string to search.
+    @param pos The starting position in the string to start searching, starting from the back.
+    @param value The string value to search for.
+    @param start The beginning index of value to search for in the string.
+    @param length The number of characters following start in value to search for in the string.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_rfind_substr_string(const String* str, size_t pos, const String* value, size_t start, size_t length);
+
+/**
+    Finds the starting index of the first occurrence of a c-string in a string,
+    ignoring the case of ASCII letters.
+
+    @param str The string to search.
+    @param pos The starting position in the string to start searching.
+    @param value The c-string value to search for.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_find_ignore_case_cstr(const String* str, size_t pos, const char* value);
+
+/**
+    Finds the starting index of the first occurrence of a string in another string,
+    ignoring the case of ASCII letters.
+
+    @param str The string to search.
+    @param pos The starting position in the string to start searching.
+    @param value The string value to search for.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_find_ignore_case_string(const String* str, size_t pos, const String* value);
+
+/**
+    Finds the starting byte index of the first occurrence of a UTF-8 c-string in a
+    UTF-8 string under Unicode simple case folding.
+
+    @param str The string to search.
+    @param pos The starting byte position in the string to start searching.
+    @param value The c-string value to search for.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_u8_find_ignore_case_cstr(const String* str, size_t pos, const char* value);
+
+/**
+    Finds the starting byte index of the first occurrence of a UTF-8 string in
+    another UTF-8 string under Unicode simple case folding.
+
+    @param str The string to search.
+    @param pos The starting byte position in the string to start searching.
+    @param value The string value to search for.
+
+    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+*/
+static inline size_t string_u8_find_ignore_case_string(const String* str, size_t pos, const String* value);
+
+/**
+    Searches every string in an array for a c-string.
+
+    @param strs The array of strings to search.
+    @param count The number of strings in the array.
+    @param value The c-string value to search for.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] contains value, and cleared otherwise.
+    @param out_positions If not NULL, an array with at least count elements that receives the
+                         starting index of the first occurrence in each string, or SIZE_MAX.
+
+    @return The number of strings that contain the value.
+*/
+static inline size_t string_find_batch_cstr(
+    const String* strs,
+    size_t count,
+    const char* value,
+    uint8_t* out_bitmap,
+    size_t* out_positions);
+
+/**
+    Searches every string in an array for another string.
+
+    @param strs The array of strings to search.
+    @param count The number of strings in the array.
+    @param value The string value to search for.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] contains value, and cleared otherwise.
+    @param out_positions If not NULL, an array with at least count elements that receives the
+                         starting index of the first occurrence in each string, or SIZE_MAX.
+
+    @return The number of strings that contain the value.
+*/
+static inline size_t string_find_batch_string(
+    const String* strs,
+    size_t count,
+    const String* value,
+    uint8_t* out_bitmap,
+    size_t* out_positions);
+
+/**
+    Determines which strings in an array start with the characters in a c-string.
+
+    @param strs The array of strings to check.
+    @param count The number of strings in the array.
+    @param value The value to check the beginning of each string for.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] starts with value, and cleared otherwise.
+
+    @return The number of strings that start with the value.
+*/
+static inline size_t string_starts_with_batch_cstr(const String* strs, size_t count, const char* value, uint8_t* out_bitmap);
+
+/**
+    Determines which strings in an array start with the characters in another string.
+
+    @param strs The array of strings to check.
+    @param count The number of strings in the array.
+    @param value The value to check the beginning of each string for.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] starts with value, and cleared otherwise.
+
+    @return The number of strings that start with the value.
+*/
+static inline size_t string_starts_with_batch_string(const String* strs, size_t count, const String* value, uint8_t* out_bitmap);
+
+/**
+    Determines which strings in an array are equivalent to a c-string.
+
+    @param strs The array of strings to check.
+    @param count The number of strings in the array.
+    @param value The value to compare each string to.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] is equivalent to value, and cleared otherwise.
+
+    @return The number of strings that are equivalent to the value.
 */
-static inline size_t string_rfind_string(const String* str, size_t pos, const String* value);
+static inline size_t string_equals_batch_cstr(const String* strs, size_t count, const char* value, uint8_t* out_bitmap);
 
 /**
-    Finds the starting index of the last occurrence of part of a c-string in a string. 
-    
-    @param str The string to search.
-    @param pos The starting position in the string to start searching, starting from the back.
-    @param value The c-string value to search for.
-    @param start The beginning index of value to search for in the string.
-    @param length The number of characters following start in value to search for in the string.
+    Determines which strings in an array are equivalent to another string.
 
-    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+    @param strs The array of strings to check.
+    @param count The number of strings in the array.
+    @param value The value to compare each string to.
+    @param out_bitmap If not NULL, a bitmap with at least (count + 7) / 8 bytes. Bit (i % 8) of
+                      byte (i / 8) is set if strs[i] is equivalent to value, and cleared otherwise.
+
+    @return The number of strings that are equivalent to the value.
 */
-static inline size_t string_rfind_substr_cstr(const String* str, size_t pos, const char* value, size_t start, size_t length);
+static inline size_t string_equals_batch_string(const String* strs, size_t count, const String* value, uint8_t* out_bitmap);
 
 /**
-    Finds the starting index of the last occurrence of part of a string in another string. 
-    
-    @param str The string to search.
-    @param pos The starting position in the string to start searching, starting from the back.
-    @param value The string value to search for.
-    @param start The beginning index of value to search for in the string.
-    @param length The number of characters following start in value to search for in the string.
+    Converts a bitmap created by one of the string_*_batch functions into a list of indices.
 
-    @return The starting index of the substring on success, or SIZE_MAX if the substring couldn't be found.
+    @param bitmap The bitmap to convert.
+    @param count The number of bits in the bitmap (the count passed to the batch function).
+    @param out_indices An array that receives the index of every set bit, in ascending order.
+                       Must have room for as many indices as the batch function returned.
+
+    @return The number of indices written to out_indices.
 */
-static inline size_t string_rfind_substr_string(const String* str, size_t pos, const String* value, size_t start, size_t length);
+SSO_STRING_EXPORT size_t string_batch_indices(const uint8_t* bitmap, size_t count, size_t* out_indices);
 
 /**
     Reverses the bytes in-place in a string.
@@ -801,6 +2299,11 @@ SSO_STRING_EXPORT void string_reverse_bytes(String* str);
     Reverses the contents of a string in-place based on UTF-8 codepoints.
 
     @param str The string to reverse.
+
+    @remark Invalid UTF-8 is reversed one byte at a time, except that a run of
+            continuation bytes is kept in order. The run stays with the byte before
+            it when that byte isn't ASCII, and is otherwise reversed as a unit of its
+            own, so "a\x80b" becomes "b\x80a" while "é\x80b" becomes "bé\x80".
 */
 SSO_STRING_EXPORT void string_u8_reverse_codepoints(String* str);
 
@@ -928,6 +2431,9 @@ SSO_STRING_EXPORT String* string_format_string(String* result, const String* for
 
     @return result if the argument was non-null. Otherwise a newly allocated string
             that contains the format result. NULL on error.
+
+    @remark The output is written directly into the spare capacity of result, so
+            the format and its arguments can't point into result's buffer.
 */
 SSO_STRING_EXPORT String* string_format_cstr(String* result, const char* format, ...);
 
@@ -960,9 +2466,187 @@ SSO_STRING_EXPORT String* string_format_args_string(String* result, const String
 
     @return result if the argument was non-null. Otherwise a newly allocated string
             that contains the format result. NULL on error.
+
+    @remark The output is written directly into the spare capacity of result, so
+            the format and its arguments can't point into result's buffer.
 */
 SSO_STRING_EXPORT String* string_format_args_cstr(String* result, const char* format, va_list argp);
 
+/**
+    Parses a printf format string once so it can be applied repeatedly
+    without parsing it again.
+
+    @param format A c-string that contains the text and format specifiers to be written.
+
+    @return The compiled format, which has to be freed using string_format_free.
+            NULL if the format is invalid or on allocation failure.
+
+    @remark The flags, width, precision and length modifiers of the c standard
+            are supported for the d, i, u, x, X, o, c, s, p, f, F, e, E, g, G, a
+            and A conversions. Integers, characters, strings and pointers are
+            formatted without the C library. Pointers are written as 0x followed by
+            lowercase hex digits. %f, %F, %e and %E are rounded exactly from the
+            double's decimal expansion and always use '.' as the decimal point.
+            %g, %G, %a, %A and long doubles are formatted by snprintf one directive
+            at a time. %n, positional arguments and wide characters aren't supported.
+*/
+SSO_STRING_EXPORT StringFormat* string_format_compile(const char* format);
+
+/**
+    Frees a format created by string_format_compile.
+
+    @param format The format to free. Can be NULL.
+*/
+SSO_STRING_EXPORT void string_format_free(StringFormat* format);
+
+/**
+    Formats a string using a compiled format.
+
+    @param result A string that stores the result of the format operation.
+                    If this is NULL, this function allocates a string for the return value.
+                    Otherwise it appends the formatted data to the end.
+
+    @param format The compiled format.
+    @param ... The format specifier values.
+
+    @return result if the argument was non-null. Otherwise a newly allocated string
+            that contains the format result. NULL on error, in which case result
+            is left unchanged.
+
+    @remark The size of the output is estimated when the format is compiled, so the
+            result usually only grows once.
+*/
+SSO_STRING_EXPORT String* string_format_apply(String* result, const StringFormat* format, ...);
+
+/**
+    Formats a string using a compiled format.
+
+    @param result A string that stores the result of the format operation.
+                    If this is NULL, this function allocates a string for the return value.
+                    Otherwise it appends the formatted data to the end.
+
+    @param format The compiled format.
+    @param argp A list of the variadic arguments originally passed to a variadic function.
+
+    @return result if the argument was non-null. Otherwise a newly allocated string
+            that contains the format result. NULL on error, in which case result
+            is left unchanged.
+*/
+SSO_STRING_EXPORT String* string_format_apply_args(String* result, const StringFormat* format, va_list argp);
+
+/**
+    Appends text to a string using a format with {} replacement fields.
+
+    @param str The string to append to.
+    @param format A c-string that contains the text and replacement fields to be written.
+    @param args The values of the replacement fields.
+    @param count The number of values in args.
+
+    @return true on success. false if the format is invalid, refers to an argument
+            that doesn't exist or uses a spec that doesn't apply to the argument's
+            type, or on allocation failure. The string is left unchanged on failure.
+
+    @remark A replacement field is {[arg][:spec]}, where arg is either empty to use
+            the next argument, the index of an argument, or the name of an argument.
+            Empty and numbered args can't be mixed. {{ and }} write single braces.
+
+            The spec is [[fill]align][sign][#][0][width][.precision][type], similar to
+            Python and fmt. The fill is any codepoint, and align is '<', '>' or '^'.
+            Numbers are aligned right and everything else left by default. sign is
+            '+', '-' or ' ', # adds a 0x, 0o or 0b prefix and 0 pads numbers with
+            zeros after the sign.
+
+            Integers accept the types d, x, X, o and b. Doubles are written in their
+            shortest round trip form without a type or precision, otherwise the types
+            f, F, e and E round the exact value to the precision (6 by default), and a
+            precision without a type means f. Strings, views, c-strings, characters
+            and bools accept the s type, with the width and precision counted in
+            codepoints. Nothing is formatted with the C library.
+*/
+SSO_STRING_EXPORT bool string_format_braces_args(String* str, const char* format, const StringFormatArg* args, size_t count);
+
+/**
+    Creates a format argument from a signed integer.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_int(int64_t value);
+
+/**
+    Creates a format argument from an unsigned integer.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_uint(uint64_t value);
+
+/**
+    Creates a format argument from a double.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_double(double value);
+
+/**
+    Creates a format argument from a bool, which is written as true or false.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_bool(bool value);
+
+/**
+    Creates a format argument from a character.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_char(char value);
+
+/**
+    Creates a format argument from a c-string.
+
+    @param value The value of the argument. It has to outlive the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_cstr(const char* value);
+
+/**
+    Creates a format argument from a string, which is copied by its size.
+
+    @param value The value of the argument. It has to outlive the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_string(const String* value);
+
+/**
+    Creates a format argument from a string view.
+
+    @param value The value of the argument.
+
+    @return The format argument.
+*/
+static inline StringFormatArg string_format_arg_view(StringView value);
+
+/**
+    Gives a format argument a name so it can be referred to as {name}.
+
+    @param name The name of the argument. It has to outlive the argument.
+    @param arg The argument to name.
+
+    @return The named argument.
+*/
+static inline StringFormatArg string_format_arg_named(const char* name, StringFormatArg arg);
+
 /**
     Creates a hash code from a string using the fnv1-a algorithm.
 
@@ -972,6 +2656,28 @@ SSO_STRING_EXPORT String* string_format_args_cstr(String* result, const char* fo
 */
 SSO_STRING_EXPORT size_t string_hash(String* str);
 
+/**
+    Creates a hash code from a string using the fnv1-a algorithm, treating
+    ASCII letters as lowercase. Strings that are equal according to
+    string_equals_ignore_case have the same hash code.
+
+    @param str The string to generate a hash for.
+
+    @return A hash code for the string.
+*/
+SSO_STRING_EXPORT size_t string_hash_ignore_case(const String* str);
+
+/**
+    Creates a hash code from a UTF-8 string using the fnv1-a algorithm, after applying
+    Unicode simple case folding. Strings that are equal according to
+    string_u8_equals_ignore_case have the same hash code.
+
+    @param str The string to generate a hash for.
+
+    @return A hash code for the string.
+*/
+SSO_STRING_EXPORT size_t string_u8_hash_ignore_case(const String* str);
+
 
 
 // Internal Functions
@@ -1001,9 +2707,41 @@ SSO_STRING_EXPORT int sso_string_short_reserve(String* str, size_t reserve);
 SSO_STRING_EXPORT bool sso_string_insert_impl(String* str, const char* value, size_t index, size_t length);
 SSO_STRING_EXPORT bool sso_string_append_impl(String* str, const char* value, size_t length);
 SSO_STRING_EXPORT bool sso_string_replace_impl(String* str, size_t pos, size_t count, const char* value, size_t length);
+SSO_STRING_EXPORT bool sso_string_replace_all_impl(
+    String* str,
+    const char* value,
+    size_t value_length,
+    const char* replacement,
+    size_t replacement_length,
+    size_t max_count);
+SSO_STRING_EXPORT Char32 sso_string_u8_iter_next_impl(StringU8Iter* iter);
+SSO_STRING_EXPORT Char32 sso_string_u8_iter_prev_impl(StringU8Iter* iter);
 SSO_STRING_EXPORT size_t sso_string_find_impl(const String* str, size_t pos, const char* value, size_t length);
 SSO_STRING_EXPORT size_t sso_string_find_substr_impl(const String* str, size_t pos, const char* value, size_t length);
 SSO_STRING_EXPORT size_t sso_string_rfind_impl(const String* str, size_t pos, const char* value, size_t length);
+SSO_STRING_EXPORT int sso_string_compare_ignore_case_impl(const String* str, const char* value, size_t length);
+SSO_STRING_EXPORT int sso_string_u8_compare_ignore_case_impl(const String* str, const char* value, size_t length);
+SSO_STRING_EXPORT size_t sso_string_find_ignore_case_impl(const String* str, size_t pos, const char* value, size_t length);
+SSO_STRING_EXPORT size_t sso_string_u8_find_ignore_case_impl(const String* str, size_t pos, const char* value, size_t length);
+SSO_STRING_EXPORT size_t sso_string_find_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap,
+    size_t* out_positions);
+SSO_STRING_EXPORT size_t sso_string_starts_with_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap);
+SSO_STRING_EXPORT size_t sso_string_equals_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap);
 
 
 
@@ -1107,6 +2845,56 @@ static inline size_t string_size(const String* str) {
     return sso_string_is_long(str) ? sso_string_long_size(str) : sso_string_short_size(str);
 }
 
+static inline void string_u8_index_invalidate(StringU8Index* index) {
+    index->valid = false;
+}
+
+static inline bool string_u8_is_valid(const String* str) {
+    return string_u8_validate(str, NULL);
+}
+
+static inline void string_u8_iter_init(StringU8Iter* iter, const String* str) {
+    iter->data = string_data(str);
+    iter->size = string_size(str);
+    iter->position = 0;
+}
+
+static inline void string_u8_iter_init_end(StringU8Iter* iter, const String* str) {
+    iter->data = string_data(str);
+    iter->size = string_size(str);
+    iter->position = iter->size;
+}
+
+static inline bool string_u8_iter_next(StringU8Iter* iter, Char32* out) {
+    if(iter->position >= iter->size)
+        return false;
+
+    unsigned char value = (unsigned char)iter->data[iter->position];
+    if(value < 0x80) {
+        *out = value;
+        iter->position++;
+    } else {
+        *out = sso_string_u8_iter_next_impl(iter);
+    }
+
+    return true;
+}
+
+static inline bool string_u8_iter_prev(StringU8Iter* iter, Char32* out) {
+    if(iter->position == 0)
+        return false;
+
+    unsigned char value = (unsigned char)iter->data[iter->position - 1];
+    if(value < 0x80) {
+        *out = value;
+        iter->position--;
+    } else {
+        *out = sso_string_u8_iter_prev_impl(iter);
+    }
+
+    return true;
+}
+
 static inline size_t string_capacity(const String* str) {
     return sso_string_is_long(str) ? sso_string_long_cap(str) : sso_string_short_cap(str);
 }
@@ -1161,6 +2949,10 @@ static inline void string_clear(String* str) {
     }
 }
 
+static inline bool string_u8_append_codepoints(String* str, const Char32* values, size_t count) {
+    return string_u8_from_utf32(str, values, count);
+}
+
 static inline bool string_insert_cstr(String* str, const char* value, size_t index) {
     return sso_string_insert_impl(str, value, index, strlen(value));
 }
@@ -1278,6 +3070,38 @@ static inline bool string_ends_with_string(const String* str, const String* valu
     return sso_string_ends_with_impl(str, string_data(value), string_size(value));
 }
 
+static inline int string_compare_ignore_case_cstr(const String* str, const char* value) {
+    return sso_string_compare_ignore_case_impl(str, value, strlen(value));
+}
+
+static inline int string_compare_ignore_case_string(const String* str, const String* value) {
+    return sso_string_compare_ignore_case_impl(str, string_data(value), string_size(value));
+}
+
+static inline bool string_equals_ignore_case_cstr(const String* str, const char* value) {
+    return string_compare_ignore_case_cstr(str, value) == 0;
+}
+
+static inline bool string_equals_ignore_case_string(const String* str, const String* value) {
+    return string_compare_ignore_case_string(str, value) == 0;
+}
+
+static inline int string_u8_compare_ignore_case_cstr(const String* str, const char* value) {
+    return sso_string_u8_compare_ignore_case_impl(str, value, strlen(value));
+}
+
+static inline int string_u8_compare_ignore_case_string(const String* str, const String* value) {
+    return sso_string_u8_compare_ignore_case_impl(str, string_data(value), string_size(value));
+}
+
+static inline bool string_u8_equals_ignore_case_cstr(const String* str, const char* value) {
+    return string_u8_compare_ignore_case_cstr(str, value) == 0;
+}
+
+static inline bool string_u8_equals_ignore_case_string(const String* str, const String* value) {
+    return string_u8_compare_ignore_case_string(str, value) == 0;
+}
+
 
 static inline bool string_replace_cstr(String* str, size_t pos, size_t count, const char* value) {
     return sso_string_replace_impl(str, pos, count, value, strlen(value));
@@ -1288,6 +3112,34 @@ static inline bool string_replace_string(String* str, size_t pos, size_t count,
     return sso_string_replace_impl(str, pos, count, string_data(value), string_size(value));
 }
 
+static inline bool string_replace_all_cstr(String* str, const char* value, const char* replacement) {
+    return sso_string_replace_all_impl(str, value, strlen(value), replacement, strlen(replacement), SIZE_MAX);
+}
+
+static inline bool string_replace_all_string(String* str, const String* value, const String* replacement) {
+    return sso_string_replace_all_impl(
+        str,
+        string_data(value),
+        string_size(value),
+        string_data(replacement),
+        string_size(replacement),
+        SIZE_MAX);
+}
+
+static inline bool string_replace_first_n_cstr(String* str, const char* value, const char* replacement, size_t count) {
+    return sso_string_replace_all_impl(str, value, strlen(value), replacement, strlen(replacement), count);
+}
+
+static inline bool string_replace_first_n_string(String* str, const String* value, const String* replacement, size_t count) {
+    return sso_string_replace_all_impl(
+        str,
+        string_data(value),
+        string_size(value),
+        string_data(replacement),
+        string_size(replacement),
+        count);
+}
+
 static inline bool string_substring(const String* str, size_t pos, size_t count, String* value) {
     SSO_STRING_ASSERT_BOUNDS(pos + count <= string_size(str));
     return string_init_size(value, string_data(str) + pos, count);
@@ -1347,10 +3199,150 @@ static inline size_t string_rfind_substr_string(const String* str, size_t pos, c
     return sso_string_rfind_impl(str, pos, string_data(value) + start, length);
 }
 
+static inline size_t string_find_ignore_case_cstr(const String* str, size_t pos, const char* value) {
+    return sso_string_find_ignore_case_impl(str, pos, value, strlen(value));
+}
+
+static inline size_t string_find_ignore_case_string(const String* str, size_t pos, const String* value) {
+    return sso_string_find_ignore_case_impl(str, pos, string_data(value), string_size(value));
+}
+
+static inline size_t string_u8_find_ignore_case_cstr(const String* str, size_t pos, const char* value) {
+    return sso_string_u8_find_ignore_case_impl(str, pos, value, strlen(value));
+}
+
+static inline size_t string_u8_find_ignore_case_string(const String* str, size_t pos, const String* value) {
+    return sso_string_u8_find_ignore_case_impl(str, pos, string_data(value), string_size(value));
+}
+
+static inline size_t string_find_batch_cstr(
+    const String* strs,
+    size_t count,
+    const char* value,
+    uint8_t* out_bitmap,
+    size_t* out_positions)
+{
+    return sso_string_find_batch_impl(strs, count, value, strlen(value), out_bitmap, out_positions);
+}
+
+static inline size_t string_find_batch_string(
+    const String* strs,
+    size_t count,
+    const String* value,
+    uint8_t* out_bitmap,
+    size_t* out_positions)
+{
+    return sso_string_find_batch_impl(strs, count, string_data(value), string_size(value), out_bitmap, out_positions);
+}
+
+static inline size_t string_starts_with_batch_cstr(const String* strs, size_t count, const char* value, uint8_t* out_bitmap) {
+    return sso_string_starts_with_batch_impl(strs, count, value, strlen(value), out_bitmap);
+}
+
+static inline size_t string_starts_with_batch_string(const String* strs, size_t count, const String* value, uint8_t* out_bitmap) {
+    return sso_string_starts_with_batch_impl(strs, count, string_data(value), string_size(value), out_bitmap);
+}
+
+static inline size_t string_equals_batch_cstr(const String* strs, size_t count, const char* value, uint8_t* out_bitmap) {
+    return sso_string_equals_batch_impl(strs, count, value, strlen(value), out_bitmap);
+}
+
+static inline size_t string_equals_batch_string(const String* strs, size_t count, const String* value, uint8_t* out_bitmap) {
+    return sso_string_equals_batch_impl(strs, count, string_data(value), string_size(value), out_bitmap);
+}
+
 static inline bool string_is_null_or_empty(const String* str) {
     return !str || string_size(str) == 0;
 }
 
+static inline StringParseError string_parse_i64(const String* str, int64_t* value, size_t* consumed) {
+    StringView view = { string_data(str), string_size(str) };
+    return string_parse_i64_view(view, value, consumed);
+}
+
+static inline StringParseError string_parse_u64(const String* str, uint64_t* value, size_t* consumed) {
+    StringView view = { string_data(str), string_size(str) };
+    return string_parse_u64_view(view, value, consumed);
+}
+
+static inline StringParseError string_parse_f64(const String* str, double* value, size_t* consumed) {
+    StringView view = { string_data(str), string_size(str) };
+    return string_parse_f64_view(view, value, consumed);
+}
+
+static inline StringFormatArg string_format_arg_int(int64_t value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_INT;
+    arg.name = NULL;
+    arg.value.i = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_uint(uint64_t value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_UINT;
+    arg.name = NULL;
+    arg.value.u = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_double(double value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_DOUBLE;
+    arg.name = NULL;
+    arg.value.d = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_bool(bool value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_BOOL;
+    arg.name = NULL;
+    arg.value.b = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_char(char value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_CHAR;
+    arg.name = NULL;
+    arg.value.c = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_cstr(const char* value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_CSTR;
+    arg.name = NULL;
+    arg.value.cstr = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_string(const String* value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_STRING;
+    arg.name = NULL;
+    arg.value.str = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_view(StringView value) {
+    StringFormatArg arg;
+    arg.type = STRING_FORMAT_ARG_VIEW;
+    arg.name = NULL;
+    arg.value.view = value;
+    return arg;
+}
+
+static inline StringFormatArg string_format_arg_named(const char* name, StringFormatArg arg) {
+    arg.name = name;
+    return arg;
+}
+
+static inline StringFormatArg sso_string_format_arg_self(StringFormatArg arg) {
+    return arg;
+}
+
 // If C11 is available, use the _Generic macro to select the correct
 // string function, otherwise just default to using cstrings.
 
@@ -1396,6 +3388,38 @@ static inline bool string_is_null_or_empty(const String* str) {
         const String*: string_compare_string) \
     ((str), (value))
 
+#define string_equals_ignore_case(str, value) \
+    _Generic((value), \
+        char*: string_equals_ignore_case_cstr, \
+        const char*: string_equals_ignore_case_cstr, \
+        String*: string_equals_ignore_case_string, \
+        const String*: string_equals_ignore_case_string) \
+    ((str), (value))
+
+#define string_compare_ignore_case(str, value) \
+    _Generic((value), \
+        char*: string_compare_ignore_case_cstr, \
+        const char*: string_compare_ignore_case_cstr, \
+        String*: string_compare_ignore_case_string, \
+        const String*: string_compare_ignore_case_string) \
+    ((str), (value))
+
+#define string_u8_equals_ignore_case(str, value) \
+    _Generic((value), \
+        char*: string_u8_equals_ignore_case_cstr, \
+        const char*: string_u8_equals_ignore_case_cstr, \
+        String*: string_u8_equals_ignore_case_string, \
+        const String*: string_u8_equals_ignore_case_string) \
+    ((str), (value))
+
+#define string_u8_compare_ignore_case(str, value) \
+    _Generic((value), \
+        char*: string_u8_compare_ignore_case_cstr, \
+        const char*: string_u8_compare_ignore_case_cstr, \
+        String*: string_u8_compare_ignore_case_string, \
+        const String*: string_u8_compare_ignore_case_string) \
+    ((str), (value))
+
 #define string_starts_with(str, value)  \
     _Generic((value),  \
         char*: string_starts_with_cstr,  \
@@ -1420,6 +3444,30 @@ static inline bool string_is_null_or_empty(const String* str) {
         const String*: string_replace_string) \
     ((str), (pos), (count), (value))
 
+#define string_replace_all(str, value, replacement)  \
+    _Generic((value),  \
+        char*: string_replace_all_cstr,  \
+        const char*: string_replace_all_cstr,  \
+        String*: string_replace_all_string, \
+        const String*: string_replace_all_string) \
+    ((str), (value), (replacement))
+
+#define string_replace_first_n(str, value, replacement, count)  \
+    _Generic((value),  \
+        char*: string_replace_first_n_cstr,  \
+        const char*: string_replace_first_n_cstr,  \
+        String*: string_replace_first_n_string, \
+        const String*: string_replace_first_n_string) \
+    ((str), (value), (replacement), (count))
+
+#define string_replace_many(str, values, replacements, count)  \
+    _Generic((values),  \
+        char**: string_replace_many_cstr,  \
+        const char**: string_replace_many_cstr,  \
+        String*: string_replace_many_string, \
+        const String*: string_replace_many_string) \
+    ((str), (values), (replacements), (count))
+
 #define string_find(str, pos, value)  \
     _Generic((value),  \
         char*: string_find_cstr,  \
@@ -1428,6 +3476,46 @@ static inline bool string_is_null_or_empty(const String* str) {
         const String*: string_find_string) \
     ((str), (pos), (value))
 
+#define string_find_ignore_case(str, pos, value)  \
+    _Generic((value),  \
+        char*: string_find_ignore_case_cstr,  \
+        const char*: string_find_ignore_case_cstr,  \
+        String*: string_find_ignore_case_string, \
+        const String*: string_find_ignore_case_string) \
+    ((str), (pos), (value))
+
+#define string_u8_find_ignore_case(str, pos, value)  \
+    _Generic((value),  \
+        char*: string_u8_find_ignore_case_cstr,  \
+        const char*: string_u8_find_ignore_case_cstr,  \
+        String*: string_u8_find_ignore_case_string, \
+        const String*: string_u8_find_ignore_case_string) \
+    ((str), (pos), (value))
+
+#define string_find_batch(strs, count, value, out_bitmap, out_positions)  \
+    _Generic((value),  \
+        char*: string_find_batch_cstr,  \
+        const char*: string_find_batch_cstr,  \
+        String*: string_find_batch_string, \
+        const String*: string_find_batch_string) \
+    ((strs), (count), (value), (out_bitmap), (out_positions))
+
+#define string_starts_with_batch(strs, count, value, out_bitmap)  \
+    _Generic((value),  \
+        char*: string_starts_with_batch_cstr,  \
+        const char*: string_starts_with_batch_cstr,  \
+        String*: string_starts_with_batch_string, \
+        const String*: string_starts_with_batch_string) \
+    ((strs), (count), (value), (out_bitmap))
+
+#define string_equals_batch(strs, count, value, out_bitmap)  \
+    _Generic((value),  \
+        char*: string_equals_batch_cstr,  \
+        const char*: string_equals_batch_cstr,  \
+        String*: string_equals_batch_string, \
+        const String*: string_equals_batch_string) \
+    ((strs), (count), (value), (out_bitmap))
+
 #define string_find_substr(str, pos, value, start, count) \
     _Generic((value) \
         char*: string_find_substr_cstr, \
@@ -1468,6 +3556,79 @@ static inline bool string_is_null_or_empty(const String* str) {
         const String*: string_format_args_string) \
     ((str), (format), __VA_ARGS__)
 
+/**
+    Creates a StringFormatArg from a value based on its type. Strings, views and
+    c-strings are referenced, not copied, so they have to outlive the argument.
+
+    @remark Character constants such as 'a' and the true/false macros have the
+            type int in C, so they need to be cast to char or bool to be formatted
+            as a character or a boolean.
+*/
+#define string_format_arg(value) \
+    _Generic((value), \
+        bool: string_format_arg_bool, \
+        char: string_format_arg_char, \
+        signed char: string_format_arg_int, \
+        short: string_format_arg_int, \
+        int: string_format_arg_int, \
+        long: string_format_arg_int, \
+        long long: string_format_arg_int, \
+        unsigned char: string_format_arg_uint, \
+        unsigned short: string_format_arg_uint, \
+        unsigned int: string_format_arg_uint, \
+        unsigned long: string_format_arg_uint, \
+        unsigned long long: string_format_arg_uint, \
+        float: string_format_arg_double, \
+        double: string_format_arg_double, \
+        long double: string_format_arg_double, \
+        char*: string_format_arg_cstr, \
+        const char*: string_format_arg_cstr, \
+        String*: string_format_arg_string, \
+        const String*: string_format_arg_string, \
+        StringView: string_format_arg_view, \
+        StringFormatArg: sso_string_format_arg_self) \
+    (value)
+
+/**
+    Creates a named StringFormatArg that can be referred to as {name}.
+*/
+#define string_format_named(name, value) string_format_arg_named((name), string_format_arg(value))
+
+// Helpers that apply string_format_arg to each of up to 16 arguments. The extra
+// expansions are needed by preprocessors that forward __VA_ARGS__ as one argument.
+#define SSO_STRING_EXPAND(x) x
+#define SSO_STRING_CONCAT_(a, b) a##b
+#define SSO_STRING_CONCAT(a, b) SSO_STRING_CONCAT_(a, b)
+#define SSO_STRING_COUNT_ARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, count, ...) count
+#define SSO_STRING_COUNT_ARGS(...) SSO_STRING_EXPAND(SSO_STRING_COUNT_ARGS_(__VA_ARGS__, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0))
+#define SSO_STRING_FORMAT_ARGS_1(value) string_format_arg(value)
+#define SSO_STRING_FORMAT_ARGS_2(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_1(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_3(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_2(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_4(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_3(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_5(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_4(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_6(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_5(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_7(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_6(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_8(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_7(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_9(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_8(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_10(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_9(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_11(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_10(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_12(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_11(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_13(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_12(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_14(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_13(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_15(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_14(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS_16(value, ...) string_format_arg(value), SSO_STRING_EXPAND(SSO_STRING_FORMAT_ARGS_15(__VA_ARGS__))
+#define SSO_STRING_FORMAT_ARGS(...) SSO_STRING_EXPAND(SSO_STRING_CONCAT(SSO_STRING_FORMAT_ARGS_, SSO_STRING_COUNT_ARGS(__VA_ARGS__))(__VA_ARGS__))
+
+/**
+    Appends text to a string using a format with {} replacement fields. Takes
+    between 1 and 16 arguments of any type accepted by string_format_arg. See
+    string_format_braces_args for the format syntax.
+*/
+#define string_format_braces(str, format, ...) \
+    string_format_braces_args((str), (format), \
+        (const StringFormatArg[]){ SSO_STRING_FORMAT_ARGS(__VA_ARGS__) }, \
+        SSO_STRING_COUNT_ARGS(__VA_ARGS__))
+
 #else
 
 #define string_insert(str, value, index) string_insert_cstr(str, value, index)
@@ -1475,10 +3636,22 @@ static inline bool string_is_null_or_empty(const String* str) {
 #define string_append(str, value) string_append_cstr(str, value)
 #define string_equals(str, value) string_equals_cstr(str, value)
 #define string_compare(str, value) string_compare_cstr(str, value)
+#define string_equals_ignore_case(str, value) string_equals_ignore_case_cstr(str, value)
+#define string_compare_ignore_case(str, value) string_compare_ignore_case_cstr(str, value)
+#define string_u8_equals_ignore_case(str, value) string_u8_equals_ignore_case_cstr(str, value)
+#define string_u8_compare_ignore_case(str, value) string_u8_compare_ignore_case_cstr(str, value)
 #define string_starts_with(str, value) string_starts_with_cstr(str, value)
 #define string_ends_with(str, value) string_ends_with_cstr(str, value)
 #define string_replace(str, pos, count, value) string_replace_cstr(str, pos, count, value)
+#define string_replace_all(str, value, replacement) string_replace_all_cstr(str, value, replacement)
+#define string_replace_first_n(str, value, replacement, count) string_replace_first_n_cstr(str, value, replacement, count)
+#define string_replace_many(str, values, replacements, count) string_replace_many_cstr(str, values, replacements, count)
 #define string_find(str, pos, value) string_find_cstr(str, pos, value)
+#define string_find_ignore_case(str, pos, value) string_find_ignore_case_cstr(str, pos, value)
+#define string_u8_find_ignore_case(str, pos, value) string_u8_find_ignore_case_cstr(str, pos, value)
+#define string_find_batch(strs, count, value, out_bitmap, out_positions) string_find_batch_cstr(strs, count, value, out_bitmap, out_positions)
+#define string_starts_with_batch(strs, count, value, out_bitmap) string_starts_with_batch_cstr(strs, count, value, out_bitmap)
+#define string_equals_batch(strs, count, value, out_bitmap) string_equals_batch_cstr(strs, count, value, out_bitmap)
 #define string_rfind(str, pos, value) string_rfind_cstr(str, pos, value)
 #define string_format(str, format, ...) string_format_cstr(str, format, __VA_ARGS__)
 #define string_format_args(str, format, argp) string_format_args_cstr(str, format, argp)
@@ -24,6 +24,7 @@
 
 #include <sso_string.h>
 
+#include <limits.h>
 #include <stdarg.h>
 
 #if defined(SSO_STRING_SINGLE_THREAD)
@@ -50,6 +51,93 @@
 #endif
 #endif
 
+// The vectorized kernels are selected at compile time based on the target
+// instruction set. Every kernel also has a portable version that works on
+// 8 bytes at a time, which can be forced by defining SSO_STRING_NO_SIMD.
+
+#ifndef SSO_STRING_NO_SIMD
+
+#if defined(__AVX2__)
+#define SSO_STRING_AVX2
+#endif
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SSO_STRING_SSE2
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__) || defined(_M_ARM64)
+#define SSO_STRING_NEON
+#endif
+
+#endif
+
+#if defined(SSO_STRING_AVX2)
+#include <immintrin.h>
+#elif defined(SSO_STRING_SSE2)
+#include <emmintrin.h>
+#endif
+
+#if defined(SSO_STRING_NEON)
+#include <arm_neon.h>
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define SSO_STRING_PREFETCH(address) __builtin_prefetch((address))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#define SSO_STRING_PREFETCH(address) _mm_prefetch((const char*)(address), _MM_HINT_T0)
+#else
+#define SSO_STRING_PREFETCH(address) ((void)(address))
+#endif
+
+#include "sso_string_unicode.h"
+
+static inline int sso_string_ctz(uint32_t value) {
+#if defined(_MSC_VER)
+    unsigned long index;
+    _BitScanForward(&index, value);
+    return (int)index;
+#else
+    return __builtin_ctz(value);
+#endif
+}
+
+static inline int sso_string_clz64(uint64_t value) {
+#if defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, value);
+    return 63 - (int)index;
+#elif defined(_MSC_VER)
+    unsigned long index;
+    if(_BitScanReverse(&index, (uint32_t)(value >> 32)))
+        return 31 - (int)index;
+    _BitScanReverse(&index, (uint32_t)value);
+    return 63 - (int)index;
+#else
+    return __builtin_clzll(value);
+#endif
+}
+
+static inline int sso_string_popcount(uint32_t value) {
+#if defined(_MSC_VER)
+    return (int)__popcnt(value);
+#else
+    return __builtin_popcount(value);
+#endif
+}
+
+#define SSO_STRING_SWAR_ONES ((uint64_t)0x0101010101010101)
+#define SSO_STRING_SWAR_HIGHS ((uint64_t)0x8080808080808080)
+
+static inline uint64_t sso_string_load64(const void* data) {
+    uint64_t value;
+    memcpy(&value, data, sizeof(value));
+    return value;
+}
+
 #define U8_SINGLE 0x7F
 #define U8_DOUBLE 0xE0
 #define U8_TRIPLE 0xF0
@@ -114,27 +202,551 @@ SSO_STRING_EXPORT bool string_init_size(String* str, const char* cstr, size_t le
     return true;
 }
 
-SSO_STRING_EXPORT size_t string_u8_codepoints(const String* str) {
-    SSO_STRING_ASSERT_ARG(str);
+// Gets the number of bytes in the sequence started by a lead byte, or 0 if
+// the byte can never start a sequence.
+static inline int sso_string_u8_sequence_length(unsigned char lead) {
+    if(lead <= U8_SINGLE)
+        return 1;
+    if(lead >= 0xC2 && lead < U8_DOUBLE)
+        return 2;
+    if(lead >= U8_DOUBLE && lead < U8_TRIPLE)
+        return 3;
+    if(lead >= U8_TRIPLE && lead < 0xF5)
+        return 4;
+    return 0;
+}
 
-    const unsigned char* data = (unsigned char*)string_data(str);
+// Counts the codepoints in a section of memory by counting every byte that
+// isn't a continuation byte (0x80 - 0xBF). This doesn't need to branch on the
+// lead bytes, so it vectorizes cleanly.
+static size_t sso_string_u8_count(const char* str_data, size_t size) {
+    const unsigned char* data = (const unsigned char*)str_data;
     size_t count = 0;
-    while(*data) {
-        count++;
+    size_t i = 0;
 
-        if(*data  <= U8_SINGLE)
-            data += 1;
-        else if(*data < U8_DOUBLE)
-            data += 2;
-        else if(*data < U8_TRIPLE)
-            data += 3;
-        else
-            data += 4;
+#if defined(SSO_STRING_AVX2)
+    // Continuation bytes are the only bytes less than or equal to 0xBF when
+    // treated as signed. The compare results are accumulated per lane for up
+    // to 255 blocks before being summed, which keeps the inner loop to a load,
+    // a compare and a subtract.
+    const __m256i continuation = _mm256_set1_epi8((char)0xBF);
+    while(i + 32 <= size) {
+        __m256i counts = _mm256_setzero_si256();
+        size_t blocks = (size - i) / 32;
+        if(blocks > 255)
+            blocks = 255;
+
+        for(size_t block = 0; block < blocks; block++, i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            counts = _mm256_sub_epi8(counts, _mm256_cmpgt_epi8(value, continuation));
+        }
+
+        __m256i wide_sums = _mm256_sad_epu8(counts, _mm256_setzero_si256());
+        __m128i sums = _mm_add_epi64(_mm256_castsi256_si128(wide_sums), _mm256_extracti128_si256(wide_sums, 1));
+        count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i continuation_block = _mm_set1_epi8((char)0xBF);
+    while(i + 16 <= size) {
+        __m128i counts = _mm_setzero_si128();
+        size_t blocks = (size - i) / 16;
+        if(blocks > 255)
+            blocks = 255;
+
+        for(size_t block = 0; block < blocks; block++, i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            counts = _mm_sub_epi8(counts, _mm_cmpgt_epi8(value, continuation_block));
+        }
+
+        __m128i sums = _mm_sad_epu8(counts, _mm_setzero_si128());
+        count += (size_t)_mm_cvtsi128_si32(sums) + (size_t)_mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+    }
+#elif defined(SSO_STRING_NEON)
+    const int8x16_t continuation_block = vdupq_n_s8((int8_t)0xBF);
+    while(i + 16 <= size) {
+        uint8x16_t counts = vdupq_n_u8(0);
+        size_t blocks = (size - i) / 16;
+        if(blocks > 255)
+            blocks = 255;
+
+        for(size_t block = 0; block < blocks; block++, i += 16) {
+            int8x16_t value = vreinterpretq_s8_u8(vld1q_u8(data + i));
+            counts = vsubq_u8(counts, vcgtq_s8(value, continuation_block));
+        }
+
+        uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(counts)));
+        count += (size_t)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
     }
+#endif
+
+    // Moving bit 6 of each byte into bit 7 leaves the high bit set for
+    // every byte that is either ASCII or a lead byte.
+    for(; i + 8 <= size; i += 8) {
+        uint64_t value = sso_string_load64(data + i);
+        uint64_t starts = (~value | (value << 1)) & SSO_STRING_SWAR_HIGHS;
+        count += (size_t)(((starts >> 7) * SSO_STRING_SWAR_ONES) >> 56);
+    }
+
+    for(; i < size; i++)
+        count += (data[i] & 0xC0) != 0x80;
 
     return count;
 }
 
+// Gets the offset of the nth codepoint, counting codepoints the same way as
+// sso_string_u8_count. Whole blocks are skipped by counting the bytes in them
+// that aren't continuation bytes, so only the block containing the codepoint is
+// searched byte by byte. Returns size if there are exactly n codepoints, or
+// SIZE_MAX if there are fewer.
+static size_t sso_string_u8_skip(const char* str_data, size_t size, size_t n) {
+    const unsigned char* data = (const unsigned char*)str_data;
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    const __m256i continuation = _mm256_set1_epi8((char)0xBF);
+    for(; i + 32 <= size; i += 32) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+        size_t count = (size_t)sso_string_popcount((uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(value, continuation)));
+        if(count > n)
+            break;
+        n -= count;
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i continuation_block = _mm_set1_epi8((char)0xBF);
+    for(; i + 16 <= size; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        size_t count = (size_t)sso_string_popcount((uint32_t)_mm_movemask_epi8(_mm_cmpgt_epi8(value, continuation_block)));
+        if(count > n)
+            break;
+        n -= count;
+    }
+#elif defined(SSO_STRING_NEON)
+    const int8x16_t continuation_block = vdupq_n_s8((int8_t)0xBF);
+    for(; i + 16 <= size; i += 16) {
+        int8x16_t value = vreinterpretq_s8_u8(vld1q_u8(data + i));
+        uint8x16_t starts = vshrq_n_u8(vcgtq_s8(value, continuation_block), 7);
+        uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(starts)));
+        size_t count = (size_t)(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+        if(count > n)
+            break;
+        n -= count;
+    }
+#endif
+
+    for(; i + 8 <= size; i += 8) {
+        uint64_t value = sso_string_load64(data + i);
+        uint64_t starts = (~value | (value << 1)) & SSO_STRING_SWAR_HIGHS;
+        size_t count = (size_t)(((starts >> 7) * SSO_STRING_SWAR_ONES) >> 56);
+        if(count > n)
+            break;
+        n -= count;
+    }
+
+    for(; i < size; i++) {
+        if((data[i] & 0xC0) != 0x80 && n-- == 0)
+            return i;
+    }
+
+    return n == 0 ? size : SIZE_MAX;
+}
+
+SSO_STRING_EXPORT size_t string_u8_codepoints(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    return sso_string_u8_count(string_data(str), string_size(str));
+}
+
+SSO_STRING_EXPORT size_t string_u8_codepoints_range(const String* str, size_t start, size_t count) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t size = string_size(str);
+    SSO_STRING_ASSERT_BOUNDS(start <= size);
+
+    if(count > size - start)
+        count = size - start;
+
+    return sso_string_u8_count(string_data(str) + start, count);
+}
+
+// Gets the byte range of count codepoints starting at the codepoint start,
+// clamping both to the end of the string.
+static StringView sso_string_u8_substring_range(const String* str, size_t start, size_t count) {
+    const char* data = string_data(str);
+    size_t size = string_size(str);
+
+    // Any continuation bytes at the very start belong to the first codepoint.
+    size_t begin = start == 0 ? 0 : sso_string_u8_skip(data, size, start);
+    if(begin == SIZE_MAX)
+        begin = size;
+
+    // Leading continuation bytes count as no codepoints, so they're only
+    // included when the range has some codepoints to attach them to.
+    size_t length = count == 0 ? 0 : sso_string_u8_skip(data + begin, size - begin, count);
+    if(length == SIZE_MAX)
+        length = size - begin;
+
+    return (StringView){ data + begin, length };
+}
+
+SSO_STRING_EXPORT bool string_u8_substring(const String* str, size_t start, size_t count, String* out_value) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(out_value);
+
+    StringView view = sso_string_u8_substring_range(str, start, count);
+    return string_init_size(out_value, view.data, view.size);
+}
+
+SSO_STRING_EXPORT StringView string_u8_substring_view(const String* str, size_t start, size_t count) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    return sso_string_u8_substring_range(str, start, count);
+}
+
+SSO_STRING_EXPORT void string_u8_truncate(String* str, size_t count) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    char* data = string_cstr(str);
+    size_t size = count == 0 ? 0 : sso_string_u8_skip(data, string_size(str), count);
+    if(size == SIZE_MAX || size == string_size(str))
+        return;
+
+    sso_string_set_size(str, size);
+    data[size] = 0;
+}
+
+SSO_STRING_EXPORT void string_u8_truncate_bytes(String* str, size_t max_bytes) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    if(max_bytes >= string_size(str))
+        return;
+
+    // Back up over at most 3 continuation bytes to the byte that starts them,
+    // and cut there if it's the lead byte of a sequence that would be split.
+    size_t size = max_bytes;
+    size_t stop = max_bytes > 3 ? max_bytes - 3 : 0;
+    size_t i = max_bytes;
+    while(i > stop && (data[i] & 0xC0) == 0x80)
+        i--;
+
+    if((data[i] & 0xC0) != 0x80 && i + sso_string_u8_sequence_length(data[i]) > max_bytes)
+        size = i;
+
+    sso_string_set_size(str, size);
+    data[size] = 0;
+}
+
+// Validates a buffer one sequence at a time. Returns the index of the start of
+// the first invalid sequence, or size if the buffer is valid. If the only
+// error is a sequence that is valid so far but cut off by the end of the
+// buffer, incomplete is set to true.
+static size_t sso_string_u8_validate_scalar(const unsigned char* data, size_t size, bool* incomplete) {
+    size_t i = 0;
+    *incomplete = false;
+
+    while(i < size) {
+        unsigned char lead = data[i];
+        if(lead <= U8_SINGLE) {
+            i++;
+            continue;
+        }
+
+        int length = sso_string_u8_sequence_length(lead);
+        if(length == 0)
+            return i;
+
+        // The second byte has a narrower range for the leads that could
+        // otherwise encode overlong forms, surrogates or values above U+10FFFF.
+        unsigned char min = 0x80;
+        unsigned char max = 0xBF;
+        if(lead == 0xE0)
+            min = 0xA0;
+        else if(lead == 0xED)
+            max = 0x9F;
+        else if(lead == 0xF0)
+            min = 0x90;
+        else if(lead == 0xF4)
+            max = 0x8F;
+
+        for(int j = 1; j < length; j++) {
+            if(i + j >= size) {
+                *incomplete = true;
+                return i;
+            }
+
+            unsigned char byte = data[i + j];
+            if(j == 1 ? (byte < min || byte > max) : (byte & 0xC0) != 0x80)
+                return i;
+        }
+
+        i += length;
+    }
+
+    return size;
+}
+
+// Gets the index of the start of the sequence that contains the byte at index,
+// assuming every sequence that ends before index was valid.
+static inline size_t sso_string_u8_sequence_boundary(const unsigned char* data, size_t index) {
+    size_t stop = index > 3 ? index - 3 : 0;
+    for(size_t i = index; i > stop; i--) {
+        unsigned char byte = data[i - 1];
+        if((byte & 0xC0) != 0x80) {
+            int length = sso_string_u8_sequence_length(byte);
+            return length == 0 || i - 1 + length > index ? i - 1 : index;
+        }
+    }
+    return index;
+}
+
+#if defined(SSO_STRING_AVX2)
+
+// Vectorized validation based on the lookup tables described by Keiser and
+// Lemire in "Validating UTF-8 In Less Than One Instruction Per Byte". Each
+// byte is classified by the high nibble of the previous byte, the low nibble
+// of the previous byte and its own high nibble, and an error is reported
+// where the three classifications share a bit.
+
+enum {
+    SSO_U8_TOO_SHORT = 1 << 0,
+    SSO_U8_TOO_LONG = 1 << 1,
+    SSO_U8_OVERLONG_3 = 1 << 2,
+    SSO_U8_TOO_LARGE = 1 << 3,
+    SSO_U8_SURROGATE = 1 << 4,
+    SSO_U8_OVERLONG_2 = 1 << 5,
+    SSO_U8_TOO_LARGE_1000 = 1 << 6,
+    SSO_U8_OVERLONG_4 = 1 << 6,
+    SSO_U8_TWO_CONTS = 1 << 7,
+    SSO_U8_CARRY = SSO_U8_TOO_SHORT | SSO_U8_TOO_LONG | SSO_U8_TWO_CONTS
+};
+
+#define SSO_STRING_AVX2_TABLE(...) _mm256_setr_epi8(__VA_ARGS__, __VA_ARGS__)
+
+static inline __m256i sso_string_avx2_prev(__m256i input, __m256i previous, int count) {
+    __m256i shifted = _mm256_permute2x128_si256(previous, input, 0x21);
+    switch(count) {
+        case 1: return _mm256_alignr_epi8(input, shifted, 15);
+        case 2: return _mm256_alignr_epi8(input, shifted, 14);
+        default: return _mm256_alignr_epi8(input, shifted, 13);
+    }
+}
+
+static inline __m256i sso_string_avx2_u8_errors(__m256i input, __m256i previous) {
+    const __m256i nibble = _mm256_set1_epi8(0x0F);
+    __m256i prev1 = sso_string_avx2_prev(input, previous, 1);
+
+    const __m256i byte_1_high_table = SSO_STRING_AVX2_TABLE(
+        SSO_U8_TOO_LONG, SSO_U8_TOO_LONG, SSO_U8_TOO_LONG, SSO_U8_TOO_LONG,
+        SSO_U8_TOO_LONG, SSO_U8_TOO_LONG, SSO_U8_TOO_LONG, SSO_U8_TOO_LONG,
+        SSO_U8_TWO_CONTS, SSO_U8_TWO_CONTS, SSO_U8_TWO_CONTS, SSO_U8_TWO_CONTS,
+        SSO_U8_TOO_SHORT | SSO_U8_OVERLONG_2,
+        SSO_U8_TOO_SHORT,
+        SSO_U8_TOO_SHORT | SSO_U8_OVERLONG_3 | SSO_U8_SURROGATE,
+        SSO_U8_TOO_SHORT | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000 | SSO_U8_OVERLONG_4);
+
+    const __m256i byte_1_low_table = SSO_STRING_AVX2_TABLE(
+        SSO_U8_CARRY | SSO_U8_OVERLONG_3 | SSO_U8_OVERLONG_2 | SSO_U8_OVERLONG_4,
+        SSO_U8_CARRY | SSO_U8_OVERLONG_2,
+        SSO_U8_CARRY,
+        SSO_U8_CARRY,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000 | SSO_U8_SURROGATE,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000,
+        SSO_U8_CARRY | SSO_U8_TOO_LARGE | SSO_U8_TOO_LARGE_1000);
+
+    const __m256i byte_2_high_table = SSO_STRING_AVX2_TABLE(
+        SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT,
+        SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT,
+        SSO_U8_TOO_LONG | SSO_U8_OVERLONG_2 | SSO_U8_TWO_CONTS | SSO_U8_OVERLONG_3 | SSO_U8_TOO_LARGE_1000 | SSO_U8_OVERLONG_4,
+        SSO_U8_TOO_LONG | SSO_U8_OVERLONG_2 | SSO_U8_TWO_CONTS | SSO_U8_OVERLONG_3 | SSO_U8_TOO_LARGE,
+        SSO_U8_TOO_LONG | SSO_U8_OVERLONG_2 | SSO_U8_TWO_CONTS | SSO_U8_SURROGATE | SSO_U8_TOO_LARGE,
+        SSO_U8_TOO_LONG | SSO_U8_OVERLONG_2 | SSO_U8_TWO_CONTS | SSO_U8_SURROGATE | SSO_U8_TOO_LARGE,
+        SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT, SSO_U8_TOO_SHORT);
+
+    __m256i byte_1_high = _mm256_shuffle_epi8(byte_1_high_table, _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble));
+    __m256i byte_1_low = _mm256_shuffle_epi8(byte_1_low_table, _mm256_and_si256(prev1, nibble));
+    __m256i byte_2_high = _mm256_shuffle_epi8(byte_2_high_table, _mm256_and_si256(_mm256_srli_epi16(input, 4), nibble));
+    __m256i special = _mm256_and_si256(_mm256_and_si256(byte_1_high, byte_1_low), byte_2_high);
+
+    // Two continuation bytes in a row are only valid as the third or fourth
+    // byte of a sequence, which is determined by the bytes two and three back.
+    __m256i prev2 = sso_string_avx2_prev(input, previous, 2);
+    __m256i prev3 = sso_string_avx2_prev(input, previous, 3);
+    __m256i third = _mm256_subs_epu8(prev2, _mm256_set1_epi8((char)(0xE0 - 0x80)));
+    __m256i fourth = _mm256_subs_epu8(prev3, _mm256_set1_epi8((char)(0xF0 - 0x80)));
+    __m256i must_continue = _mm256_and_si256(_mm256_or_si256(third, fourth), _mm256_set1_epi8((char)0x80));
+
+    return _mm256_xor_si256(must_continue, special);
+}
+
+#endif
+
+// Validates a buffer, returning the same results as sso_string_u8_validate_scalar.
+// The vectorized paths only detect which block contains an error, then the
+// exact location is found by the scalar validator starting from the sequence
+// that the error is a part of.
+static size_t sso_string_u8_validate(const unsigned char* data, size_t size, bool* incomplete) {
+    size_t i = 0;
+    bool skip_ascii = true;
+
+#if defined(SSO_STRING_AVX2)
+    __m256i previous = _mm256_setzero_si256();
+    __m256i previous_incomplete = _mm256_setzero_si256();
+    const __m256i incomplete_limits = _mm256_setr_epi8(
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF, (char)0xFF,
+        (char)(0xF0 - 1), (char)(0xE0 - 1), (char)(0xC0 - 1));
+
+    for(; i + 32 <= size; i += 32) {
+        __m256i input = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i errors;
+
+        if(_mm256_movemask_epi8(input) == 0) {
+            // An ASCII block is only an error if the previous block ended in the
+            // middle of a sequence.
+            errors = previous_incomplete;
+        } else {
+            errors = sso_string_avx2_u8_errors(input, previous);
+            previous_incomplete = _mm256_subs_epu8(input, incomplete_limits);
+        }
+
+        if(!_mm256_testz_si256(errors, errors))
+            break;
+
+        if(_mm256_movemask_epi8(input) == 0)
+            previous_incomplete = _mm256_setzero_si256();
+        previous = input;
+    }
+
+    // If the last block ended in the middle of a sequence, the following bytes
+    // can't be skipped even if they're ASCII.
+    skip_ascii = i + 32 > size && _mm256_testz_si256(previous_incomplete, previous_incomplete);
+#elif defined(SSO_STRING_SSE2)
+    for(; i + 16 <= size; i += 16) {
+        if(_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(data + i))) != 0)
+            break;
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= size; i += 16) {
+        uint8x16_t high = vshrq_n_u8(vld1q_u8(data + i), 7);
+        uint64x2_t lanes = vreinterpretq_u64_u8(high);
+        if((vgetq_lane_u64(lanes, 0) | vgetq_lane_u64(lanes, 1)) != 0)
+            break;
+    }
+#endif
+
+    // Skip over any ASCII before falling back to checking each sequence.
+    for(; skip_ascii && i + 8 <= size; i += 8) {
+        if((sso_string_load64(data + i) & SSO_STRING_SWAR_HIGHS) != 0)
+            break;
+    }
+
+    size_t start = sso_string_u8_sequence_boundary(data, i);
+    return start + sso_string_u8_validate_scalar(data + start, size - start, incomplete);
+}
+
+SSO_STRING_EXPORT bool string_u8_validate(const String* str, size_t* out_error_offset) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t size = string_size(str);
+    bool incomplete;
+    size_t offset = sso_string_u8_validate((const unsigned char*)string_data(str), size, &incomplete);
+
+    if(out_error_offset)
+        *out_error_offset = offset == size ? SIZE_MAX : offset;
+
+    return offset == size;
+}
+
+SSO_STRING_EXPORT void string_u8_validator_init(StringU8Validator* validator) {
+    SSO_STRING_ASSERT_ARG(validator);
+
+    validator->offset = 0;
+    validator->error_offset = SIZE_MAX;
+    validator->pending_size = 0;
+}
+
+SSO_STRING_EXPORT bool string_u8_validator_update(StringU8Validator* validator, const char* data, size_t size) {
+    SSO_STRING_ASSERT_ARG(validator);
+    SSO_STRING_ASSERT_ARG(data || size == 0);
+
+    if(validator->error_offset != SIZE_MAX)
+        return false;
+
+    const unsigned char* bytes = (const unsigned char*)data;
+    size_t start = 0;
+    bool incomplete;
+
+    if(validator->pending_size > 0) {
+        // Finish the sequence that was cut off by the end of the last chunk.
+        int pending = validator->pending_size;
+        int length = sso_string_u8_sequence_length(validator->pending[0]);
+        size_t needed = (size_t)(length - pending);
+        size_t available = size < needed ? size : needed;
+
+        unsigned char sequence[4];
+        memcpy(sequence, validator->pending, pending);
+        memcpy(sequence + pending, bytes, available);
+
+        size_t result = sso_string_u8_validate_scalar(sequence, pending + available, &incomplete);
+        if(result != (size_t)(pending + available) && !incomplete) {
+            validator->error_offset = validator->offset - pending;
+            return false;
+        }
+
+        if(available < needed) {
+            memcpy(validator->pending + pending, bytes, available);
+            validator->pending_size += (int)available;
+            validator->offset += size;
+            return true;
+        }
+
+        validator->pending_size = 0;
+        start = needed;
+    }
+
+    size_t result = start + sso_string_u8_validate(bytes + start, size - start, &incomplete);
+    if(result != size) {
+        if(!incomplete) {
+            validator->error_offset = validator->offset + result;
+            return false;
+        }
+
+        validator->pending_size = (int)(size - result);
+        memcpy(validator->pending, bytes + result, validator->pending_size);
+    }
+
+    validator->offset += size;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_u8_validator_finish(StringU8Validator* validator, size_t* out_error_offset) {
+    SSO_STRING_ASSERT_ARG(validator);
+
+    // A sequence that is still waiting on bytes when the stream ends is truncated.
+    if(validator->error_offset == SIZE_MAX && validator->pending_size > 0)
+        validator->error_offset = validator->offset - validator->pending_size;
+
+    if(out_error_offset)
+        *out_error_offset = validator->error_offset;
+
+    return validator->error_offset == SIZE_MAX;
+}
+
 SSO_STRING_EXPORT Char32 string_u8_get(const String* str, size_t index) {
     SSO_STRING_ASSERT_ARG(str);
 
@@ -286,61 +898,6 @@ SSO_STRING_EXPORT bool string_u8_set(String* str, size_t index, Char32 value) {
     return true;
 }
 
-SSO_STRING_EXPORT bool string_u8_is_null_or_whitespace(const String* str) {
-    // These tables define the whitespace characters in the various codepoint sizes.
-
-    if(string_is_null_or_empty(str))
-        return true;
-
-    size_t size = string_size(str);
-    const char* data = string_data(str);
-    size_t i = 0;
-
-    while(i < size) {
-        int cp;
-        Char32 next = string_u8_get_with_size(str, i, &cp);
-        switch(next) {
-            case 9:
-            case 10:
-            case 11:
-            case 12:
-            case 13:
-            case 32:
-            case 133:
-            case 160:
-            case 5760:
-            case 6158:
-            case 8192:
-            case 8193:
-            case 8194:
-            case 8195:
-            case 8196:
-            case 8197:
-            case 8198:
-            case 8199:
-            case 8200:
-            case 8201:
-            case 8202:
-            case 8203:
-            case 8204:
-            case 8205:
-            case 8232:
-            case 8233:
-            case 8287:
-            case 8288:
-            case 12288:
-            case 65279:
-                break;
-            default:
-                return false;
-        }
-
-        i += cp;
-    }
-
-    return true;
-}
-
 SSO_STRING_EXPORT bool sso_string_long_reserve(String* str, size_t reserve) {
     SSO_STRING_ASSERT_ARG(str);
 
@@ -576,35 +1133,250 @@ SSO_STRING_EXPORT Char32 string_u8_pop_back(String* str) {
     return result;
 }
 
-SSO_STRING_EXPORT bool sso_string_append_impl(String* str, const char* value, size_t length) {
-    SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(value);
+static bool sso_string_u8_index_reserve(StringU8Index* index, size_t count) {
+    if(count <= index->capacity)
+        return true;
 
+    size_t capacity = index->capacity == 0 ? 8 : index->capacity * 2;
+    if(capacity < count)
+        capacity = count;
+
+    size_t* offsets = realloc(index->offsets, capacity * sizeof(size_t));
+    if(!offsets)
+        return false;
+
+    index->offsets = offsets;
+    index->capacity = capacity;
+    return true;
+}
+
+static bool sso_string_u8_index_build(StringU8Index* index, const String* str) {
+    const unsigned char* data = (const unsigned char*)string_data(str);
     size_t size = string_size(str);
-    if(!string_reserve(str, size + length))
+
+    index->valid = false;
+    index->count = 0;
+    if(!sso_string_u8_index_reserve(index, size / SSO_STRING_U8_INDEX_STRIDE + 1))
         return false;
-    char* data = string_cstr(str);
-    memmove(data + size, value, length);
-    data[size + length] = 0;
-    sso_string_set_size(str, size + length);
+
+    size_t codepoints = 0;
+    for(size_t i = 0; i < size; i++) {
+        if((data[i] & 0xC0) == 0x80)
+            continue;
+
+        if(codepoints % SSO_STRING_U8_INDEX_STRIDE == 0)
+            index->offsets[index->count++] = i;
+        codepoints++;
+    }
+
+    index->codepoints = codepoints;
+    index->size = size;
+    index->valid = true;
     return true;
 }
 
-SSO_STRING_EXPORT bool sso_string_replace_impl(String* str, size_t pos, size_t count, const char* value, size_t length) {
-    if(length == 0)
-        string_erase(str, pos, count);
+// Makes sure the index matches the string, rebuilding it if it was invalidated
+// or the size of the string changed since the index was last updated.
+static inline bool sso_string_u8_index_refresh(StringU8Index* index, const String* str) {
+    if(index->valid && index->size == string_size(str))
+        return true;
+    return sso_string_u8_index_build(index, str);
+}
 
+SSO_STRING_EXPORT bool string_u8_index_init(StringU8Index* index, const String* str) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    index->offsets = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->codepoints = 0;
+    index->size = 0;
+    index->valid = false;
+
+    return sso_string_u8_index_build(index, str);
+}
+
+SSO_STRING_EXPORT void string_u8_index_free_resources(StringU8Index* index) {
+    SSO_STRING_ASSERT_ARG(index);
+
+    free(index->offsets);
+    index->offsets = NULL;
+    index->count = 0;
+    index->capacity = 0;
+    index->valid = false;
+}
+
+SSO_STRING_EXPORT size_t string_u8_index_codepoints(StringU8Index* index, const String* str) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    if(!sso_string_u8_index_refresh(index, str))
+        return string_u8_codepoints(str);
+
+    return index->codepoints;
+}
+
+SSO_STRING_EXPORT size_t string_u8_offset_of(StringU8Index* index, const String* str, size_t n) {
+    SSO_STRING_ASSERT_ARG(index);
     SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(value);
 
+    const unsigned char* data = (const unsigned char*)string_data(str);
     size_t size = string_size(str);
+    size_t offset = 0;
+    size_t remaining = n;
 
-    SSO_STRING_ASSERT_BOUNDS(pos + count <= size);
+    // Without an index, fall back to scanning from the start of the string.
+    if(sso_string_u8_index_refresh(index, str)) {
+        if(n >= index->codepoints)
+            return n == index->codepoints ? size : SIZE_MAX;
 
-    char* data;
-    if(count == length) {
-        data = (char*)string_cstr(str);
-        memmove(data + pos, value, length);
+        offset = index->offsets[n / SSO_STRING_U8_INDEX_STRIDE];
+        remaining = n % SSO_STRING_U8_INDEX_STRIDE;
+    }
+
+    size_t skipped = sso_string_u8_skip((const char*)data + offset, size - offset, remaining);
+    return skipped == SIZE_MAX ? SIZE_MAX : offset + skipped;
+}
+
+SSO_STRING_EXPORT size_t string_u8_position_of(StringU8Index* index, const String* str, size_t offset) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    const char* data = string_data(str);
+    size_t size = string_size(str);
+    SSO_STRING_ASSERT_BOUNDS(offset <= size);
+
+    if(!sso_string_u8_index_refresh(index, str)) {
+        size_t count = sso_string_u8_count(data, offset == size ? size : offset + 1);
+        return offset == size ? count : (count > 0 ? count - 1 : 0);
+    }
+
+    if(offset == size)
+        return index->codepoints;
+
+    // Find the last entry at or before the offset.
+    size_t low = 0;
+    size_t high = index->count;
+    while(high - low > 1) {
+        size_t middle = low + (high - low) / 2;
+        if(index->offsets[middle] <= offset)
+            low = middle;
+        else
+            high = middle;
+    }
+
+    size_t start = index->count > 0 ? index->offsets[low] : 0;
+    if(offset < start)
+        return 0;
+
+    size_t count = sso_string_u8_count(data + start, offset + 1 - start);
+    return low * SSO_STRING_U8_INDEX_STRIDE + (count > 0 ? count - 1 : 0);
+}
+
+SSO_STRING_EXPORT bool string_u8_index_set(StringU8Index* index, String* str, size_t offset, Char32 value) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    if(offset == string_size(str))
+        return string_u8_index_push_back(index, str, value);
+
+    bool indexed = sso_string_u8_index_refresh(index, str);
+    size_t old_size = string_size(str);
+
+    if(!string_u8_set(str, offset, value))
+        return false;
+
+    if(!indexed)
+        return true;
+
+    // The number of codepoints doesn't change, only the offsets of the
+    // entries after the replaced character.
+    size_t new_size = string_size(str);
+    if(new_size != old_size) {
+        for(size_t i = index->count; i > 0 && index->offsets[i - 1] > offset; i--)
+            index->offsets[i - 1] = index->offsets[i - 1] + new_size - old_size;
+    }
+
+    index->size = new_size;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_u8_index_push_back(StringU8Index* index, String* str, Char32 value) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    bool indexed = sso_string_u8_index_refresh(index, str);
+    size_t old_size = string_size(str);
+
+    if(!string_u8_push_back(str, value))
+        return false;
+
+    if(!indexed)
+        return true;
+
+    if(index->codepoints % SSO_STRING_U8_INDEX_STRIDE == 0) {
+        // If the entry can't be added the index is rebuilt the next time it's used.
+        if(!sso_string_u8_index_reserve(index, index->count + 1)) {
+            index->valid = false;
+            return true;
+        }
+        index->offsets[index->count++] = old_size;
+    }
+
+    index->codepoints++;
+    index->size = string_size(str);
+    return true;
+}
+
+SSO_STRING_EXPORT Char32 string_u8_index_pop_back(StringU8Index* index, String* str) {
+    SSO_STRING_ASSERT_ARG(index);
+    SSO_STRING_ASSERT_ARG(str);
+
+    bool indexed = sso_string_u8_index_refresh(index, str);
+    if(string_size(str) == 0)
+        return 0;
+
+    Char32 result = string_u8_pop_back(str);
+    if(!indexed)
+        return result;
+
+    index->codepoints--;
+    if(index->codepoints % SSO_STRING_U8_INDEX_STRIDE == 0)
+        index->count--;
+    index->size = string_size(str);
+    return result;
+}
+
+SSO_STRING_EXPORT bool sso_string_append_impl(String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    size_t size = string_size(str);
+    if(!string_reserve(str, size + length))
+        return false;
+    char* data = string_cstr(str);
+    memmove(data + size, value, length);
+    data[size + length] = 0;
+    sso_string_set_size(str, size + length);
+    return true;
+}
+
+SSO_STRING_EXPORT bool sso_string_replace_impl(String* str, size_t pos, size_t count, const char* value, size_t length) {
+    if(length == 0)
+        string_erase(str, pos, count);
+
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    size_t size = string_size(str);
+
+    SSO_STRING_ASSERT_BOUNDS(pos + count <= size);
+
+    char* data;
+    if(count == length) {
+        data = (char*)string_cstr(str);
+        memmove(data + pos, value, length);
     } else if(count > length) {
         data = (char*)string_cstr(str);
         size_t offset = pos + count;
@@ -636,6 +1408,419 @@ SSO_STRING_EXPORT bool sso_string_replace_impl(String* str, size_t pos, size_t c
     return true;
 }
 
+// Finds the first occurrence of value in a section of memory that
+// is not necessarily NULL terminated.
+static const char* sso_string_memmem(const char* data, size_t size, const char* value, size_t length) {
+    if(length > size)
+        return NULL;
+
+    const char* last = data + (size - length);
+    char first = *value;
+
+    while(data <= last) {
+        data = memchr(data, first, last - data + 1);
+        if(!data)
+            return NULL;
+        if(memcmp(data + 1, value + 1, length - 1) == 0)
+            return data;
+        data++;
+    }
+
+    return NULL;
+}
+
+SSO_STRING_EXPORT bool sso_string_replace_all_impl(
+    String* str,
+    const char* value,
+    size_t value_length,
+    const char* replacement,
+    size_t replacement_length,
+    size_t max_count)
+{
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+    SSO_STRING_ASSERT_ARG(replacement);
+
+    if(value_length == 0 || max_count == 0)
+        return true;
+
+    size_t size = string_size(str);
+    char* data = string_cstr(str);
+    const char* end = data + size;
+    const char* read = data;
+    const char* match;
+    char* write = data;
+
+    if(replacement_length <= value_length) {
+        // The result can't be bigger than the original, so the string can be
+        // compacted in a single forward pass. The write position never passes
+        // the read position.
+        size_t replaced = 0;
+        while(replaced < max_count && (match = sso_string_memmem(read, end - read, value, value_length)) != NULL) {
+            size_t span = match - read;
+            memmove(write, read, span);
+            write += span;
+            memcpy(write, replacement, replacement_length);
+            write += replacement_length;
+            read = match + value_length;
+            replaced++;
+        }
+
+        if(replaced == 0 || replacement_length == value_length)
+            return true;
+
+        size_t tail = end - read;
+        memmove(write, read, tail);
+        write += tail;
+        *write = '\0';
+        sso_string_set_size(str, write - data);
+        return true;
+    }
+
+    // Count the matches first so that the string is only resized once.
+    size_t matches = 0;
+    while(matches < max_count && (match = sso_string_memmem(read, end - read, value, value_length)) != NULL) {
+        read = match + value_length;
+        matches++;
+    }
+
+    if(matches == 0)
+        return true;
+
+    size_t growth = matches * (replacement_length - value_length);
+    SSO_STRING_ASSERT_BOUNDS(size + growth < STRING_MAX);
+
+    if(!string_reserve(str, size + growth))
+        return false;
+
+    // Move the contents to the end of the buffer, then rebuild the string
+    // from front to back. The gap between the write and read positions
+    // shrinks by the growth of a single replacement for every match, so
+    // a replacement never overwrites data that hasn't been read yet.
+    data = string_cstr(str);
+    memmove(data + growth, data, size);
+
+    read = data + growth;
+    end = read + size;
+    write = data;
+
+    for(size_t i = 0; i < matches; i++) {
+        match = sso_string_memmem(read, end - read, value, value_length);
+        size_t span = match - read;
+        memmove(write, read, span);
+        write += span;
+        memcpy(write, replacement, replacement_length);
+        write += replacement_length;
+        read = match + value_length;
+    }
+
+    // At this point the gap is closed, so the tail is already in place.
+    data[size + growth] = '\0';
+    sso_string_set_size(str, size + growth);
+    return true;
+}
+
+struct sso_string_pattern {
+    const char* value;
+    size_t value_length;
+    const char* replacement;
+    size_t replacement_length;
+};
+
+// An Aho-Corasick automaton with every transition precomputed, so each
+// input byte costs a single table lookup. Bytes are mapped to classes first.
+// Any byte that doesn't appear in a pattern shares class 0, which keeps the
+// transition table small.
+struct sso_string_automaton {
+    int32_t* next;
+    int32_t* match;
+    size_t* depth;
+    int class_count;
+    unsigned char classes[256];
+};
+
+static bool sso_string_automaton_init(
+    struct sso_string_automaton* ac,
+    const struct sso_string_pattern* patterns,
+    size_t count)
+{
+    memset(ac->classes, 0, sizeof(ac->classes));
+    ac->class_count = 1;
+
+    size_t max_states = 1;
+    for(size_t i = 0; i < count; i++) {
+        const unsigned char* value = (const unsigned char*)patterns[i].value;
+        for(size_t j = 0; j < patterns[i].value_length; j++) {
+            if(ac->classes[value[j]] == 0)
+                ac->classes[value[j]] = ac->class_count++;
+        }
+        max_states += patterns[i].value_length;
+    }
+
+    int classes = ac->class_count;
+
+    // All of the tables are allocated in a single block.
+    // The fail and queue tables are only needed while building.
+    size_t table_size = max_states * classes * sizeof(int32_t)
+                      + max_states * sizeof(int32_t) * 3
+                      + max_states * sizeof(size_t);
+
+    char* block = malloc(table_size);
+    if(!block)
+        return false;
+
+    ac->depth = (size_t*)block;
+    ac->next = (int32_t*)(ac->depth + max_states);
+    ac->match = ac->next + max_states * classes;
+    int32_t* fail = ac->match + max_states;
+    int32_t* queue = fail + max_states;
+
+    for(size_t i = 0; i < max_states * classes; i++)
+        ac->next[i] = -1;
+
+    ac->match[0] = -1;
+    ac->depth[0] = 0;
+    int32_t states = 1;
+
+    // Build the trie. If a pattern is given more than once, the first one wins.
+    for(size_t i = 0; i < count; i++) {
+        if(patterns[i].value_length == 0)
+            continue;
+
+        const unsigned char* value = (const unsigned char*)patterns[i].value;
+        int32_t state = 0;
+        for(size_t j = 0; j < patterns[i].value_length; j++) {
+            int32_t* edge = ac->next + (size_t)state * classes + ac->classes[value[j]];
+            if(*edge == -1) {
+                ac->match[states] = -1;
+                ac->depth[states] = j + 1;
+                *edge = states++;
+            }
+            state = *edge;
+        }
+
+        if(ac->match[state] == -1)
+            ac->match[state] = (int32_t)i;
+    }
+
+    // Breadth first traversal to compute the failure links, and fill in the
+    // missing transitions using them. Each state also inherits the longest
+    // pattern ending at its failure state if it doesn't end a pattern itself.
+    size_t head = 0;
+    size_t tail = 0;
+    fail[0] = 0;
+
+    for(int c = 0; c < classes; c++) {
+        int32_t child = ac->next[c];
+        if(child == -1) {
+            ac->next[c] = 0;
+        } else {
+            fail[child] = 0;
+            queue[tail++] = child;
+        }
+    }
+
+    while(head < tail) {
+        int32_t state = queue[head++];
+        int32_t* row = ac->next + (size_t)state * classes;
+        const int32_t* fail_row = ac->next + (size_t)fail[state] * classes;
+
+        if(ac->match[state] == -1)
+            ac->match[state] = ac->match[fail[state]];
+
+        for(int c = 0; c < classes; c++) {
+            if(row[c] == -1) {
+                row[c] = fail_row[c];
+            } else {
+                fail[row[c]] = fail_row[c];
+                queue[tail++] = row[c];
+            }
+        }
+    }
+
+    return true;
+}
+
+static inline void sso_string_automaton_free(struct sso_string_automaton* ac) {
+    // The depth table is the start of the allocated block.
+    free(ac->depth);
+}
+
+// Runs the automaton over the input, resolving overlapping matches by picking
+// the leftmost-longest one. If out is NULL, only the size of the result is
+// computed, along with the number of matches and the lead: how far the output
+// gets ahead of the input at most. out can overlap data if it starts at least
+// lead characters before it.
+static size_t sso_string_automaton_replace(
+    const struct sso_string_automaton* ac,
+    const struct sso_string_pattern* patterns,
+    const char* data,
+    size_t size,
+    char* out,
+    size_t* out_matches,
+    size_t* out_lead)
+{
+    const unsigned char* input = (const unsigned char*)data;
+    const int classes = ac->class_count;
+    size_t result = 0;
+    size_t matches = 0;
+    size_t lead = 0;
+    size_t last = 0;
+    size_t i = 0;
+    size_t candidate_start = 0;
+    int32_t candidate = -1;
+    int32_t state = 0;
+
+    while(true) {
+        if(i < size) {
+            state = ac->next[(size_t)state * classes + ac->classes[input[i++]]];
+            int32_t match = ac->match[state];
+            if(match != -1) {
+                // Any match found later than the candidate that starts at or before
+                // it is also longer, so it always replaces the candidate.
+                size_t start = i - patterns[match].value_length;
+                if(candidate == -1 || start <= candidate_start) {
+                    candidate = match;
+                    candidate_start = start;
+                }
+            }
+
+            // A future match has to start within the current state's depth. If the
+            // candidate starts before that, nothing can beat it anymore.
+            if(candidate == -1 || candidate_start + ac->depth[state] >= i)
+                continue;
+        } else if(candidate == -1) {
+            break;
+        }
+
+        size_t span = candidate_start - last;
+        const struct sso_string_pattern* pattern = patterns + candidate;
+        if(out) {
+            memmove(out + result, data + last, span);
+            memcpy(out + result + span, pattern->replacement, pattern->replacement_length);
+        }
+        result += span + pattern->replacement_length;
+        matches++;
+
+        // Resume matching right after the replaced text.
+        last = i = candidate_start + pattern->value_length;
+        candidate = -1;
+        state = 0;
+        if(result > last && result - last > lead)
+            lead = result - last;
+    }
+
+    if(out)
+        memmove(out + result, data + last, size - last);
+
+    if(out_matches)
+        *out_matches = matches;
+    if(out_lead)
+        *out_lead = lead;
+
+    return result + (size - last);
+}
+
+static bool sso_string_replace_many_impl(
+    String* str,
+    const struct sso_string_pattern* patterns,
+    size_t count)
+{
+    struct sso_string_automaton ac;
+    if(!sso_string_automaton_init(&ac, patterns, count))
+        return false;
+
+    size_t size = string_size(str);
+    bool success = false;
+
+    // The first pass computes the exact size of the result so that the
+    // string is resized at most once, and finds out if anything matches.
+    size_t matches;
+    size_t lead;
+    size_t result_size = sso_string_automaton_replace(&ac, patterns, string_data(str), size, NULL, &matches, &lead);
+    if(matches == 0) {
+        success = true;
+        goto cleanup;
+    }
+
+    // The result is written over the string from the front. The contents are
+    // moved back by the lead first, so a replacement never overwrites
+    // characters that haven't been read yet.
+    if(!string_reserve(str, result_size > size + lead ? result_size : size + lead))
+        goto cleanup;
+
+    char* data = string_cstr(str);
+    memmove(data + lead, data, size);
+    sso_string_automaton_replace(&ac, patterns, data + lead, size, data, NULL, NULL);
+    data[result_size] = '\0';
+    sso_string_set_size(str, result_size);
+    success = true;
+
+    cleanup:
+        sso_string_automaton_free(&ac);
+        return success;
+}
+
+SSO_STRING_EXPORT bool string_replace_many_cstr(
+    String* str,
+    const char** values,
+    const char** replacements,
+    size_t count)
+{
+    SSO_STRING_ASSERT_ARG(str);
+
+    if(count == 0)
+        return true;
+
+    SSO_STRING_ASSERT_ARG(values);
+    SSO_STRING_ASSERT_ARG(replacements);
+
+    struct sso_string_pattern* patterns = malloc(count * sizeof(*patterns));
+    if(!patterns)
+        return false;
+
+    for(size_t i = 0; i < count; i++) {
+        patterns[i].value = values[i];
+        patterns[i].value_length = strlen(values[i]);
+        patterns[i].replacement = replacements[i];
+        patterns[i].replacement_length = strlen(replacements[i]);
+    }
+
+    bool result = sso_string_replace_many_impl(str, patterns, count);
+    free(patterns);
+    return result;
+}
+
+SSO_STRING_EXPORT bool string_replace_many_string(
+    String* str,
+    const String* values,
+    const String* replacements,
+    size_t count)
+{
+    SSO_STRING_ASSERT_ARG(str);
+
+    if(count == 0)
+        return true;
+
+    SSO_STRING_ASSERT_ARG(values);
+    SSO_STRING_ASSERT_ARG(replacements);
+
+    struct sso_string_pattern* patterns = malloc(count * sizeof(*patterns));
+    if(!patterns)
+        return false;
+
+    for(size_t i = 0; i < count; i++) {
+        patterns[i].value = string_data(values + i);
+        patterns[i].value_length = string_size(values + i);
+        patterns[i].replacement = string_data(replacements + i);
+        patterns[i].replacement_length = string_size(replacements + i);
+    }
+
+    bool result = sso_string_replace_many_impl(str, patterns, count);
+    free(patterns);
+    return result;
+}
+
 SSO_STRING_EXPORT bool string_resize(String* str, size_t count, char ch) {
     SSO_STRING_ASSERT_ARG(str);
     SSO_STRING_ASSERT_BOUNDS(count < STRING_MAX);
@@ -725,438 +1910,7813 @@ SSO_STRING_EXPORT size_t sso_string_rfind_impl(const String* str, size_t pos, co
     return SIZE_MAX;
 }
 
-// Todo: Attempt to use intrinsic bswap
-
-static inline void string_reverse_bytes_impl(char* start, char* end) {
-    while (start < end) {
-        char tmp = *start;
-        *start++ = *end;
-        *end-- = tmp;
-    }
+static inline unsigned char sso_string_ascii_fold(unsigned char value) {
+    return (unsigned char)(value - 'A') < 26 ? value | 0x20 : value;
 }
 
-SSO_STRING_EXPORT void string_reverse_bytes(String* str) {
-    SSO_STRING_ASSERT_ARG(str);
+// Lowercases the ASCII letters in 8 bytes at a time.
+static inline uint64_t sso_string_swar_fold(uint64_t value) {
+    uint64_t heptets = value & ~SSO_STRING_SWAR_HIGHS;
+    uint64_t above_z = heptets + SSO_STRING_SWAR_ONES * (0x7F - 'Z');
+    uint64_t from_a = heptets + SSO_STRING_SWAR_ONES * (0x80 - 'A');
+    uint64_t upper = (above_z ^ from_a) & ~value & SSO_STRING_SWAR_HIGHS;
+    return value | (upper >> 2);
+}
 
-    size_t size = string_size(str);
-    char* start = string_cstr(str);
-    char* end = start + size - 1;
+#if defined(SSO_STRING_AVX2)
 
-    string_reverse_bytes_impl(start, end);
+static inline __m256i sso_string_avx2_fold(__m256i value) {
+    // Bytes above 0x7F are negative, so they fail the first comparison.
+    __m256i upper = _mm256_and_si256(
+        _mm256_cmpgt_epi8(value, _mm256_set1_epi8('A' - 1)),
+        _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), value));
+    return _mm256_or_si256(value, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
 }
 
-SSO_STRING_EXPORT void string_u8_reverse_codepoints(String* str) {
-    SSO_STRING_ASSERT_ARG(str);
+#endif
 
-    size_t size = string_size(str);
-    char* data;
-    char* start = data = string_cstr(str);
-    char* end = start + size - 1;
-    char tmp;
-
-    // Reverse string bytewise
-    string_reverse_bytes_impl(start, end);
-
-    start = NULL;
-
-    // Todo: Speed this up
-    // Fix up utf8 characters.
-    for (size_t i = 0; i < size; i++) {
-        switch((*(data + i)) & 0xC0) {
-            case 0xC0:
-                string_reverse_bytes_impl(start, data + i);
-                start = NULL;
-                break;
-            case 0x80:
-                if(!start)
-                    start = data + i;
-                break;
-        }
-    }
+#if defined(SSO_STRING_SSE2)
+
+static inline __m128i sso_string_sse2_fold(__m128i value) {
+    // Bytes above 0x7F are negative, so they fail the first comparison.
+    __m128i upper = _mm_and_si128(
+        _mm_cmpgt_epi8(value, _mm_set1_epi8('A' - 1)),
+        _mm_cmplt_epi8(value, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(value, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
 }
 
-SSO_STRING_EXPORT bool string_join(
-    String* str, 
-    const String* separator,
-    const String* values,
-    size_t value_count)
-{
-    if(value_count == 0)
-        return true;
+#endif
 
-    SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(separator);
-    SSO_STRING_ASSERT_ARG(values);
+#if defined(SSO_STRING_NEON)
 
-    // Put the joined values in a temporary variable to avoid
-    // altering the result string if the operation fails.
+static inline uint8x16_t sso_string_neon_fold(uint8x16_t value) {
+    uint8x16_t upper = vcltq_u8(vsubq_u8(value, vdupq_n_u8('A')), vdupq_n_u8(26));
+    return vorrq_u8(value, vandq_u8(upper, vdupq_n_u8(0x20)));
+}
 
-    // Append the temp string to the result (str) at the end
-    // to finalize the operation.
-    bool result = false;
-    String temp = string_create("");
+static inline bool sso_string_neon_all_set(uint8x16_t value) {
+    uint64x2_t wide = vreinterpretq_u64_u8(value);
+    return (vgetq_lane_u64(wide, 0) & vgetq_lane_u64(wide, 1)) == UINT64_MAX;
+}
 
-    if(!string_append_string(&temp, values))
-        goto cleanup;
+#endif
 
-    for(size_t i = 1; i < value_count; i++) {
-        if(!string_append_string(&temp, separator))
-            goto cleanup;
+// Lowercases the ASCII letters in a 16 byte block.
+static inline void sso_string_fold_block16(unsigned char* out, const unsigned char* data) {
+#if defined(SSO_STRING_SSE2)
+    _mm_storeu_si128((__m128i*)out, sso_string_sse2_fold(_mm_loadu_si128((const __m128i*)data)));
+#elif defined(SSO_STRING_NEON)
+    vst1q_u8(out, sso_string_neon_fold(vld1q_u8(data)));
+#else
+    uint64_t low = sso_string_swar_fold(sso_string_load64(data));
+    uint64_t high = sso_string_swar_fold(sso_string_load64(data + 8));
+    memcpy(out, &low, 8);
+    memcpy(out + 8, &high, 8);
+#endif
+}
 
-        if(!string_append_string(&temp, values + i))
-            goto cleanup;
-    }
+// Gets the index of the first byte that differs between two buffers
+// when ASCII letters are lowercased, or length if there is no difference.
+static size_t sso_string_mismatch_ignore_case(const char* left, const char* right, size_t length) {
+    const unsigned char* a = (const unsigned char*)left;
+    const unsigned char* b = (const unsigned char*)right;
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    for(; i + 32 <= length; i += 32) {
+        __m256i x = sso_string_avx2_fold(_mm256_loadu_si256((const __m256i*)(a + i)));
+        __m256i y = sso_string_avx2_fold(_mm256_loadu_si256((const __m256i*)(b + i)));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y));
+        if(mask != UINT32_MAX)
+            return i + sso_string_ctz(~mask);
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    for(; i + 16 <= length; i += 16) {
+        __m128i x = sso_string_sse2_fold(_mm_loadu_si128((const __m128i*)(a + i)));
+        __m128i y = sso_string_sse2_fold(_mm_loadu_si128((const __m128i*)(b + i)));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(x, y));
+        if(mask != 0xFFFF)
+            return i + sso_string_ctz(~mask);
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= length; i += 16) {
+        uint8x16_t x = sso_string_neon_fold(vld1q_u8(a + i));
+        uint8x16_t y = sso_string_neon_fold(vld1q_u8(b + i));
+        if(!sso_string_neon_all_set(vceqq_u8(x, y)))
+            break;
+    }
+#endif
+
+    for(; i + 8 <= length; i += 8) {
+        uint64_t x = sso_string_swar_fold(sso_string_load64(a + i));
+        uint64_t y = sso_string_swar_fold(sso_string_load64(b + i));
+        if(x != y)
+            break;
+    }
+
+    for(; i < length; i++) {
+        if(sso_string_ascii_fold(a[i]) != sso_string_ascii_fold(b[i]))
+            return i;
+    }
+
+    return length;
+}
+
+SSO_STRING_EXPORT int sso_string_compare_ignore_case_impl(const String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    size_t size = string_size(str);
+    if(size != length)
+        return size < length ? -1 : 1;
+
+    const char* data = string_data(str);
+    size_t index = sso_string_mismatch_ignore_case(data, value, length);
+    if(index == length)
+        return 0;
+
+    return (int)sso_string_ascii_fold((unsigned char)data[index]) - (int)sso_string_ascii_fold((unsigned char)value[index]);
+}
+
+SSO_STRING_EXPORT size_t sso_string_find_ignore_case_impl(const String* str, size_t pos, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    size_t size = string_size(str);
+    if(pos + length > size)
+        return SIZE_MAX;
+
+    if(length == 0)
+        return pos;
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    const unsigned char first = sso_string_ascii_fold((unsigned char)value[0]);
+    const unsigned char last = sso_string_ascii_fold((unsigned char)value[length - 1]);
+    size_t end = size - length;
+    size_t i = pos;
+
+#if defined(SSO_STRING_SSE2)
+    // Compare the first and last characters of the value against 16 positions
+    // at once, and only check the middle of the value for the candidates.
+    const __m128i first_block = _mm_set1_epi8((char)first);
+    const __m128i last_block = _mm_set1_epi8((char)last);
+
+    for(; i + 16 <= end + 1; i += 16) {
+        __m128i head = sso_string_sse2_fold(_mm_loadu_si128((const __m128i*)(data + i)));
+        __m128i tail = sso_string_sse2_fold(_mm_loadu_si128((const __m128i*)(data + i + length - 1)));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first_block), _mm_cmpeq_epi8(tail, last_block)));
+
+        while(mask != 0) {
+            size_t candidate = i + sso_string_ctz(mask);
+            if(length <= 2 || sso_string_mismatch_ignore_case((const char*)data + candidate + 1, value + 1, length - 2) == length - 2)
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for(; i <= end; i++) {
+        if(sso_string_ascii_fold(data[i]) != first || sso_string_ascii_fold(data[i + length - 1]) != last)
+            continue;
+
+        if(length <= 2 || sso_string_mismatch_ignore_case((const char*)data + i + 1, value + 1, length - 2) == length - 2)
+            return i;
+    }
+
+    return SIZE_MAX;
+}
+
+// Decodes the codepoint at the start of a buffer without reading past its end.
+// A byte that doesn't start a valid sequence decodes to a lone surrogate in the
+// range U+DC80 - U+DCFF (the same convention as Python's surrogateescape), which
+// keeps malformed input distinct from any valid codepoint.
+static inline Char32 sso_string_u8_decode_escaped(const unsigned char* data, size_t size, int* length) {
+    unsigned char lead = data[0];
+    Char32 result;
+    Char32 min;
+    int count;
+
+    if(lead <= U8_SINGLE) {
+        *length = 1;
+        return lead;
+    } else if(lead >= 0xC2 && lead < U8_DOUBLE) {
+        count = 2;
+        result = lead & 0x1F;
+        min = 0x80;
+    } else if(lead >= U8_DOUBLE && lead < U8_TRIPLE) {
+        count = 3;
+        result = lead & 0x0F;
+        min = 0x800;
+    } else if(lead >= U8_TRIPLE && lead < 0xF5) {
+        count = 4;
+        result = lead & 0x07;
+        min = 0x10000;
+    } else {
+        goto invalid;
+    }
+
+    if(size < (size_t)count)
+        goto invalid;
+
+    for(int i = 1; i < count; i++) {
+        if((data[i] & 0xC0) != 0x80)
+            goto invalid;
+        result = (result << 6) | (data[i] & 0x3F);
+    }
+
+    if(result < min || result > 0x10FFFF || (result >= 0xD800 && result <= 0xDFFF))
+        goto invalid;
+
+    *length = count;
+    return result;
+
+    invalid:
+        *length = 1;
+        return 0xDC00 | lead;
+}
+
+static inline Char32 sso_unicode_simple_fold(Char32 value) {
+    if(value >= SSO_UNICODE_SIMPLE_FOLD_LIMIT)
+        return value;
+
+    uint32_t block = sso_unicode_simple_fold_stage1[value >> SSO_UNICODE_BLOCK_SHIFT];
+    uint32_t index = sso_unicode_simple_fold_stage2[(block << SSO_UNICODE_BLOCK_SHIFT) | (value & SSO_UNICODE_BLOCK_MASK)];
+    return (Char32)((int32_t)value + sso_unicode_simple_fold_deltas[index]);
+}
+
+static inline Char32 sso_string_u8_decode_folded(const unsigned char* data, size_t size, int* length) {
+    if(*data <= U8_SINGLE) {
+        *length = 1;
+        return sso_string_ascii_fold(*data);
+    }
+
+    return sso_unicode_simple_fold(sso_string_u8_decode_escaped(data, size, length));
+}
+
+SSO_STRING_EXPORT int sso_string_u8_compare_ignore_case_impl(const String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    const unsigned char* left = (const unsigned char*)string_data(str);
+    const unsigned char* right = (const unsigned char*)value;
+    size_t left_size = string_size(str);
+    size_t i = 0;
+    size_t j = 0;
+
+    while(true) {
+        // Skip over the bytes that are the same once ASCII letters are folded.
+        // If the difference is in the middle of a codepoint in either string, back up
+        // to its start, which is at the same offset in both strings since the bytes
+        // before it match.
+        size_t count = left_size - i < length - j ? left_size - i : length - j;
+        size_t same = sso_string_mismatch_ignore_case((const char*)left + i, (const char*)right + j, count);
+        if(same == count) {
+            i += count;
+            j += count;
+            break;
+        }
+
+        while(same > 0 && ((left[i + same] & 0xC0) == 0x80 || (right[j + same] & 0xC0) == 0x80))
+            same--;
+
+        i += same;
+        j += same;
+
+        int left_length;
+        int right_length;
+        Char32 a = sso_string_u8_decode_folded(left + i, left_size - i, &left_length);
+        Char32 b = sso_string_u8_decode_folded(right + j, length - j, &right_length);
+        if(a != b)
+            return a < b ? -1 : 1;
+
+        i += left_length;
+        j += right_length;
+    }
+
+    return (int)(i < left_size) - (int)(j < length);
+}
+
+SSO_STRING_EXPORT size_t sso_string_u8_find_ignore_case_impl(const String* str, size_t pos, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value);
+
+    size_t size = string_size(str);
+    if(pos > size)
+        return SIZE_MAX;
+
+    if(length == 0)
+        return pos;
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    const unsigned char* needle = (const unsigned char*)value;
+
+    int first_length;
+    Char32 first = sso_string_u8_decode_folded(needle, length, &first_length);
+
+    size_t i = pos;
+    while(i < size) {
+        int current_length;
+        Char32 current = sso_string_u8_decode_folded(data + i, size - i, &current_length);
+
+        if(current == first) {
+            size_t hay = i + current_length;
+            size_t index = first_length;
+            while(index < length && hay < size) {
+                int a_length;
+                int b_length;
+                if(sso_string_u8_decode_folded(data + hay, size - hay, &a_length) !=
+                   sso_string_u8_decode_folded(needle + index, length - index, &b_length))
+                {
+                    break;
+                }
+
+                hay += a_length;
+                index += b_length;
+            }
+
+            if(index == length)
+                return i;
+        }
+
+        i += current_length;
+    }
+
+    return SIZE_MAX;
+}
+
+// The transcoding functions below measure their output before writing any of it,
+// so the output can be written without bounds checks or reallocation. Runs of
+// ASCII are converted a block at a time.
+
+#define SSO_UNICODE_REPLACEMENT 0xFFFD
+
+// Gets the number of ASCII characters at the start of a buffer.
+static inline size_t sso_string_ascii_length(const unsigned char* data, size_t size) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    for(; i + 32 <= size; i += 32) {
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_loadu_si256((const __m256i*)(data + i)));
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    for(; i + 16 <= size; i += 16) {
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)(data + i)));
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= size; i += 16) {
+        uint64x2_t high = vreinterpretq_u64_u8(vshrq_n_u8(vld1q_u8(data + i), 7));
+        if((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0)
+            break;
+    }
+#endif
+
+    for(; i + 8 <= size; i += 8) {
+        if((sso_string_load64(data + i) & SSO_STRING_SWAR_HIGHS) != 0)
+            break;
+    }
+
+    while(i < size && data[i] <= U8_SINGLE)
+        i++;
+
+    return i;
+}
+
+// Decodes a UTF-8 sequence, converting a byte that doesn't start a valid
+// sequence into the replacement character.
+static inline Char32 sso_string_u8_decode_replaced(const unsigned char* data, size_t size, int* length) {
+    Char32 value = sso_string_u8_decode_escaped(data, size, length);
+    return value >= 0xDC80 && value <= 0xDCFF ? SSO_UNICODE_REPLACEMENT : value;
+}
+
+static inline int sso_string_u8_encode(unsigned char* out, Char32 value) {
+    if(value < 0x80) {
+        out[0] = (unsigned char)value;
+        return 1;
+    } else if(value < 0x800) {
+        out[0] = 0xC0 | (value >> 6);
+        out[1] = 0x80 | (value & 0x3F);
+        return 2;
+    } else if(value < 0x10000) {
+        out[0] = 0xE0 | (value >> 12);
+        out[1] = 0x80 | ((value >> 6) & 0x3F);
+        out[2] = 0x80 | (value & 0x3F);
+        return 3;
+    } else {
+        out[0] = 0xF0 | (value >> 18);
+        out[1] = 0x80 | ((value >> 12) & 0x3F);
+        out[2] = 0x80 | ((value >> 6) & 0x3F);
+        out[3] = 0x80 | (value & 0x3F);
+        return 4;
+    }
+}
+
+static inline void sso_string_widen16(const unsigned char* data, size_t count, Char16* out) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= count; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi8(value, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpackhi_epi8(value, zero));
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= count; i += 16) {
+        uint8x16_t value = vld1q_u8(data + i);
+        vst1q_u16(out + i, vmovl_u8(vget_low_u8(value)));
+        vst1q_u16(out + i + 8, vmovl_u8(vget_high_u8(value)));
+    }
+#endif
+
+    for(; i < count; i++)
+        out[i] = data[i];
+}
+
+static inline void sso_string_widen32(const unsigned char* data, size_t count, Char32* out) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for(; i + 16 <= count; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i low = _mm_unpacklo_epi8(value, zero);
+        __m128i high = _mm_unpackhi_epi8(value, zero);
+        _mm_storeu_si128((__m128i*)(out + i), _mm_unpacklo_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 4), _mm_unpackhi_epi16(low, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 8), _mm_unpacklo_epi16(high, zero));
+        _mm_storeu_si128((__m128i*)(out + i + 12), _mm_unpackhi_epi16(high, zero));
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= count; i += 16) {
+        uint8x16_t value = vld1q_u8(data + i);
+        uint16x8_t low = vmovl_u8(vget_low_u8(value));
+        uint16x8_t high = vmovl_u8(vget_high_u8(value));
+        vst1q_u32(out + i, vmovl_u16(vget_low_u16(low)));
+        vst1q_u32(out + i + 4, vmovl_u16(vget_high_u16(low)));
+        vst1q_u32(out + i + 8, vmovl_u16(vget_low_u16(high)));
+        vst1q_u32(out + i + 12, vmovl_u16(vget_high_u16(high)));
+    }
+#endif
+
+    for(; i < count; i++)
+        out[i] = data[i];
+}
+
+SSO_STRING_EXPORT size_t string_u8_utf16_length(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t units = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            units += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_replaced(data + i, size - i, &length);
+        units += value >= 0x10000 ? 2 : 1;
+        i += length;
+    }
+
+    return units;
+}
+
+SSO_STRING_EXPORT size_t string_u8_to_utf16(const String* str, Char16* out, size_t out_size) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t required = string_u8_utf16_length(str);
+    if(out_size < required)
+        return SIZE_MAX;
+
+    SSO_STRING_ASSERT_ARG(out || required == 0);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t written = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            sso_string_widen16(data + i, ascii, out + written);
+            written += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_replaced(data + i, size - i, &length);
+        if(value >= 0x10000) {
+            value -= 0x10000;
+            out[written++] = (Char16)(0xD800 | (value >> 10));
+            out[written++] = (Char16)(0xDC00 | (value & 0x3FF));
+        } else {
+            out[written++] = (Char16)value;
+        }
+        i += length;
+    }
+
+    return written;
+}
+
+SSO_STRING_EXPORT size_t string_u8_utf32_length(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t units = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            units += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        sso_string_u8_decode_replaced(data + i, size - i, &length);
+        units++;
+        i += length;
+    }
+
+    return units;
+}
+
+SSO_STRING_EXPORT size_t string_u8_to_utf32(const String* str, Char32* out, size_t out_size) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t required = string_u8_utf32_length(str);
+    if(out_size < required)
+        return SIZE_MAX;
+
+    SSO_STRING_ASSERT_ARG(out || required == 0);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t written = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            sso_string_widen32(data + i, ascii, out + written);
+            written += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        out[written++] = sso_string_u8_decode_replaced(data + i, size - i, &length);
+        i += length;
+    }
+
+    return written;
+}
+
+// Decodes the UTF-16 character at the start of a buffer, converting unpaired
+// surrogates into the replacement character.
+static inline Char32 sso_string_u16_decode(const Char16* value, size_t length, int* count) {
+    Char32 unit = value[0];
+    *count = 1;
+
+    if(unit < 0xD800 || unit > 0xDFFF)
+        return unit;
+
+    if(unit <= 0xDBFF && length > 1 && value[1] >= 0xDC00 && value[1] <= 0xDFFF) {
+        *count = 2;
+        return 0x10000 + ((unit - 0xD800) << 10) + (value[1] - 0xDC00);
+    }
+
+    return SSO_UNICODE_REPLACEMENT;
+}
+
+static size_t sso_string_u16_u8_length(const Char16* value, size_t length) {
+    size_t bytes = 0;
+    size_t i = 0;
+
+    while(i < length) {
+#if defined(SSO_STRING_SSE2)
+        // A block without any surrogates can be measured by counting the units
+        // that need a second and third byte.
+        const __m128i zero = _mm_setzero_si128();
+        for(; i + 8 <= length; i += 8) {
+            __m128i units = _mm_loadu_si128((const __m128i*)(value + i));
+            __m128i surrogates = _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short)0xF800)), _mm_set1_epi16((short)0xD800));
+            if(_mm_movemask_epi8(surrogates) != 0)
+                break;
+
+            uint32_t single = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short)0xFF80)), zero));
+            uint32_t pair = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short)0xF800)), zero));
+            bytes += 8 + (16 - sso_string_popcount(single)) / 2 + (16 - sso_string_popcount(pair)) / 2;
+        }
+
+        if(i >= length)
+            break;
+#endif
+
+        int count;
+        Char32 decoded = sso_string_u16_decode(value + i, length - i, &count);
+        bytes += decoded < 0x80 ? 1 : decoded < 0x800 ? 2 : decoded < 0x10000 ? 3 : 4;
+        i += count;
+    }
+
+    return bytes;
+}
+
+SSO_STRING_EXPORT bool string_u8_from_utf16(String* str, const Char16* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    size_t bytes = sso_string_u16_u8_length(value, length);
+    size_t size = string_size(str);
+    if(!string_reserve(str, size + bytes))
+        return false;
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    unsigned char* out = data + size;
+    size_t i = 0;
+
+    while(i < length) {
+#if defined(SSO_STRING_SSE2)
+        for(; i + 8 <= length; i += 8, out += 8) {
+            __m128i units = _mm_loadu_si128((const __m128i*)(value + i));
+            __m128i ascii = _mm_cmpeq_epi16(_mm_and_si128(units, _mm_set1_epi16((short)0xFF80)), _mm_setzero_si128());
+            if(_mm_movemask_epi8(ascii) != 0xFFFF)
+                break;
+            _mm_storel_epi64((__m128i*)out, _mm_packus_epi16(units, units));
+        }
+#elif defined(SSO_STRING_NEON)
+        for(; i + 8 <= length; i += 8, out += 8) {
+            uint16x8_t units = vld1q_u16(value + i);
+            uint64x2_t high = vreinterpretq_u64_u16(vandq_u16(units, vdupq_n_u16(0xFF80)));
+            if((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) != 0)
+                break;
+            vst1_u8(out, vmovn_u16(units));
+        }
+#endif
+
+        if(i >= length)
+            break;
+
+        int count;
+        out += sso_string_u8_encode(out, sso_string_u16_decode(value + i, length - i, &count));
+        i += count;
+    }
+
+    size += bytes;
+    sso_string_set_size(str, size);
+    data[size] = 0;
+    return true;
+}
+
+// Gets the number of bytes needed to encode UTF-32 as UTF-8, counting anything that
+// isn't a scalar value as the 3 bytes of U+FFFD. Every unit takes one byte plus one
+// for each of the 0x7F, 0x7FF and 0xFFFF thresholds it's above, minus one if it's
+// above 0x10FFFF, which is counted with compares instead of branches.
+static size_t sso_string_u32_u8_length(const Char32* value, size_t length) {
+    size_t bytes = length;
+    size_t i = 0;
+
+#if defined(SSO_STRING_SSE2)
+    // SSE2 only has signed compares, so flip the sign bits to compare unsigned values.
+    const __m128i bias = _mm_set1_epi32((int)0x80000000);
+    const __m128i two = _mm_set1_epi32((int)(0x7F ^ 0x80000000));
+    const __m128i three = _mm_set1_epi32((int)(0x7FF ^ 0x80000000));
+    const __m128i four = _mm_set1_epi32((int)(0xFFFF ^ 0x80000000));
+    const __m128i invalid = _mm_set1_epi32((int)(0x10FFFF ^ 0x80000000));
+
+    while(i + 4 <= length) {
+        // Each lane grows by at most 3 per iteration, so flush before it can overflow.
+        size_t end = i + ((length - i) & ~(size_t)3);
+        if(end - i > ((size_t)1 << 30))
+            end = i + ((size_t)1 << 30);
+        __m128i extra = _mm_setzero_si128();
+
+        for(; i < end; i += 4) {
+            __m128i units = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(value + i)), bias);
+            extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(units, two));
+            extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(units, three));
+            extra = _mm_sub_epi32(extra, _mm_cmpgt_epi32(units, four));
+            extra = _mm_add_epi32(extra, _mm_cmpgt_epi32(units, invalid));
+        }
+
+        uint32_t lanes[4];
+        _mm_storeu_si128((__m128i*)lanes, extra);
+        bytes += (size_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+#elif defined(SSO_STRING_NEON)
+    while(i + 4 <= length) {
+        size_t end = i + ((length - i) & ~(size_t)3);
+        if(end - i > ((size_t)1 << 30))
+            end = i + ((size_t)1 << 30);
+        uint32x4_t extra = vdupq_n_u32(0);
+
+        for(; i < end; i += 4) {
+            uint32x4_t units = vld1q_u32(value + i);
+            extra = vsubq_u32(extra, vcgtq_u32(units, vdupq_n_u32(0x7F)));
+            extra = vsubq_u32(extra, vcgtq_u32(units, vdupq_n_u32(0x7FF)));
+            extra = vsubq_u32(extra, vcgtq_u32(units, vdupq_n_u32(0xFFFF)));
+            extra = vaddq_u32(extra, vcgtq_u32(units, vdupq_n_u32(0x10FFFF)));
+        }
+
+        bytes += (size_t)vgetq_lane_u32(extra, 0) + vgetq_lane_u32(extra, 1)
+            + vgetq_lane_u32(extra, 2) + vgetq_lane_u32(extra, 3);
+    }
+#endif
+
+    for(; i < length; i++) {
+        Char32 unit = value[i];
+        bytes += (unit > 0x7F) + (unit > 0x7FF) + (unit > 0xFFFF) - (unit > 0x10FFFF);
+    }
+
+    return bytes;
+}
+
+SSO_STRING_EXPORT bool string_u8_from_utf32(String* str, const Char32* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    size_t bytes = sso_string_u32_u8_length(value, length);
+    size_t size = string_size(str);
+    if(!string_reserve(str, size + bytes))
+        return false;
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    unsigned char* out = data + size;
+    size_t i = 0;
+
+    // Blocks of 4 units that are all ASCII or all two bytes long are encoded at once,
+    // which covers most Latin, Greek, Cyrillic, Hebrew and Arabic text. Anything
+    // else is encoded one unit at a time.
+    while(i < length) {
+#if defined(SSO_STRING_SSE2)
+        if(i + 4 <= length) {
+            const __m128i bias = _mm_set1_epi32((int)0x80000000);
+            __m128i units = _mm_loadu_si128((const __m128i*)(value + i));
+            __m128i ascii = _mm_cmpeq_epi32(_mm_and_si128(units, _mm_set1_epi32((int)0xFFFFFF80)), _mm_setzero_si128());
+            if(_mm_movemask_epi8(ascii) == 0xFFFF) {
+                __m128i packed = _mm_packs_epi32(units, units);
+                int result = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+                memcpy(out, &result, 4);
+                i += 4;
+                out += 4;
+                continue;
+            }
+
+            // Every unit is in [0x80, 0x800) if unit - 0x80 < 0x780 as an unsigned value.
+            __m128i offset = _mm_xor_si128(_mm_sub_epi32(units, _mm_set1_epi32(0x80)), bias);
+            __m128i two = _mm_cmplt_epi32(offset, _mm_set1_epi32((int)(0x780 ^ 0x80000000)));
+            if(_mm_movemask_epi8(two) == 0xFFFF) {
+                __m128i lead = _mm_or_si128(_mm_srli_epi32(units, 6), _mm_set1_epi32(0xC0));
+                __m128i trail = _mm_or_si128(_mm_and_si128(units, _mm_set1_epi32(0x3F)), _mm_set1_epi32(0x80));
+                __m128i pairs = _mm_or_si128(lead, _mm_slli_epi32(trail, 8));
+                // The pairs don't fit a signed 16 bit pack, so shift them into range and back.
+                pairs = _mm_packs_epi32(_mm_sub_epi32(pairs, _mm_set1_epi32(0x8000)), _mm_setzero_si128());
+                pairs = _mm_add_epi16(pairs, _mm_set1_epi16((short)0x8000));
+                _mm_storel_epi64((__m128i*)out, pairs);
+                i += 4;
+                out += 8;
+                continue;
+            }
+        }
+#elif defined(SSO_STRING_NEON)
+        if(i + 4 <= length) {
+            uint32x4_t units = vld1q_u32(value + i);
+            uint64x2_t high = vreinterpretq_u64_u32(vandq_u32(units, vdupq_n_u32(0xFFFFFF80)));
+            if((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) == 0) {
+                uint16x4_t narrow = vmovn_u32(units);
+                uint8x8_t packed = vmovn_u16(vcombine_u16(narrow, narrow));
+                uint32_t result = vget_lane_u32(vreinterpret_u32_u8(packed), 0);
+                memcpy(out, &result, 4);
+                i += 4;
+                out += 4;
+                continue;
+            }
+
+            uint32x4_t two = vcltq_u32(vsubq_u32(units, vdupq_n_u32(0x80)), vdupq_n_u32(0x780));
+            if(sso_string_neon_all_set(vreinterpretq_u8_u32(two))) {
+                uint32x4_t lead = vorrq_u32(vshrq_n_u32(units, 6), vdupq_n_u32(0xC0));
+                uint32x4_t trail = vorrq_u32(vandq_u32(units, vdupq_n_u32(0x3F)), vdupq_n_u32(0x80));
+                uint16x4_t pairs = vmovn_u32(vorrq_u32(lead, vshlq_n_u32(trail, 8)));
+                vst1_u8(out, vreinterpret_u8_u16(pairs));
+                i += 4;
+                out += 8;
+                continue;
+            }
+        }
+#endif
+
+        Char32 unit = value[i++];
+        if((unit >= 0xD800 && unit <= 0xDFFF) || unit > 0x10FFFF)
+            unit = SSO_UNICODE_REPLACEMENT;
+        out += sso_string_u8_encode(out, unit);
+    }
+
+    size += bytes;
+    sso_string_set_size(str, size);
+    data[size] = 0;
+    return true;
+}
+
+// Latin-1 and Windows-1252. Latin-1 bytes are the codepoints U+0000 - U+00FF,
+// and Windows-1252 only differs in 0x80 - 0x9F. The five bytes in that range
+// that Windows-1252 leaves undefined are mapped to the matching C1 control
+// characters, the same as the WHATWG encoding standard, so decoding never fails.
+
+static const Char32 sso_string_cp1252_c1[32] = {
+    0x20AC, 0x0081, 0x201A, 0x0192, 0x201E, 0x2026, 0x2020, 0x2021,
+    0x02C6, 0x2030, 0x0160, 0x2039, 0x0152, 0x008D, 0x017D, 0x008F,
+    0x0090, 0x2018, 0x2019, 0x201C, 0x201D, 0x2022, 0x2013, 0x2014,
+    0x02DC, 0x2122, 0x0161, 0x203A, 0x0153, 0x009D, 0x017E, 0x0178
+};
+
+// sso_string_cp1252_c1 encoded as UTF-8, padded to 3 bytes and followed by the encoded length.
+static const unsigned char sso_string_cp1252_c1_utf8[32][4] = {
+    { 0xE2, 0x82, 0xAC, 3 }, { 0xC2, 0x81, 0x00, 2 }, { 0xE2, 0x80, 0x9A, 3 }, { 0xC6, 0x92, 0x00, 2 },
+    { 0xE2, 0x80, 0x9E, 3 }, { 0xE2, 0x80, 0xA6, 3 }, { 0xE2, 0x80, 0xA0, 3 }, { 0xE2, 0x80, 0xA1, 3 },
+    { 0xCB, 0x86, 0x00, 2 }, { 0xE2, 0x80, 0xB0, 3 }, { 0xC5, 0xA0, 0x00, 2 }, { 0xE2, 0x80, 0xB9, 3 },
+    { 0xC5, 0x92, 0x00, 2 }, { 0xC2, 0x8D, 0x00, 2 }, { 0xC5, 0xBD, 0x00, 2 }, { 0xC2, 0x8F, 0x00, 2 },
+    { 0xC2, 0x90, 0x00, 2 }, { 0xE2, 0x80, 0x98, 3 }, { 0xE2, 0x80, 0x99, 3 }, { 0xE2, 0x80, 0x9C, 3 },
+    { 0xE2, 0x80, 0x9D, 3 }, { 0xE2, 0x80, 0xA2, 3 }, { 0xE2, 0x80, 0x93, 3 }, { 0xE2, 0x80, 0x94, 3 },
+    { 0xCB, 0x9C, 0x00, 2 }, { 0xE2, 0x84, 0xA2, 3 }, { 0xC5, 0xA1, 0x00, 2 }, { 0xE2, 0x80, 0xBA, 3 },
+    { 0xC5, 0x93, 0x00, 2 }, { 0xC2, 0x9D, 0x00, 2 }, { 0xC5, 0xBE, 0x00, 2 }, { 0xC5, 0xB8, 0x00, 2 }
+};
+
+// A bit for each byte in 0x80 - 0x9F that CP1252 maps to a three byte sequence.
+#define SSO_STRING_CP1252_WIDE 0x0AFE0AF5u
+
+// Gets the number of extra bytes a byte needs when converting CP1252 to UTF-8
+// on top of the two every byte with the high bit set needs.
+#define SSO_STRING_CP1252_EXTRA(byte) \
+    (((byte) & 0xE0) == 0x80 && ((SSO_STRING_CP1252_WIDE >> ((byte) & 0x1F)) & 1))
+
+// Gets the number of bytes needed to convert single byte text to UTF-8. Every
+// byte with the high bit set needs one more byte, and the CP1252 characters in
+// 0x80 - 0x9F that are above U+07FF need another. Blocks are measured with a
+// movemask and a popcount, and only blocks with C1 bytes are checked byte by byte.
+static size_t sso_string_single_byte_u8_length(const unsigned char* data, size_t length, bool cp1252) {
+    size_t bytes = length;
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    // C1 bytes are the only bytes less than 0xA0 when treated as signed.
+    const __m256i control_limit = _mm256_set1_epi8((char)0xA0);
+    for(; i + 32 <= length; i += 32) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+        uint32_t high = (uint32_t)_mm256_movemask_epi8(value);
+        if(high == 0)
+            continue;
+
+        bytes += (size_t)sso_string_popcount(high);
+        if(cp1252) {
+            uint32_t controls = (uint32_t)_mm256_movemask_epi8(_mm256_cmpgt_epi8(control_limit, value));
+            // Checking every byte without branching is faster than visiting each set bit.
+            if(controls != 0) {
+                for(size_t j = i; j < i + 32; j++)
+                    bytes += SSO_STRING_CP1252_EXTRA(data[j]);
+            }
+        }
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i control_block = _mm_set1_epi8((char)0xA0);
+    for(; i + 16 <= length; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        uint32_t high = (uint32_t)_mm_movemask_epi8(value);
+        if(high == 0)
+            continue;
+
+        bytes += (size_t)sso_string_popcount(high);
+        if(cp1252) {
+            uint32_t controls = (uint32_t)_mm_movemask_epi8(_mm_cmplt_epi8(value, control_block));
+            if(controls != 0) {
+                for(size_t j = i; j < i + 16; j++)
+                    bytes += SSO_STRING_CP1252_EXTRA(data[j]);
+            }
+        }
+    }
+#endif
+
+    for(; i + 8 <= length; i += 8) {
+        uint64_t high = sso_string_load64(data + i) & SSO_STRING_SWAR_HIGHS;
+        if(high == 0)
+            continue;
+
+        bytes += (size_t)(((high >> 7) * SSO_STRING_SWAR_ONES) >> 56);
+        if(cp1252) {
+            for(size_t j = i; j < i + 8; j++)
+                bytes += SSO_STRING_CP1252_EXTRA(data[j]);
+        }
+    }
+
+    for(; i < length; i++) {
+        bytes += data[i] >> 7;
+        if(cp1252)
+            bytes += SSO_STRING_CP1252_EXTRA(data[i]);
+    }
+
+    return bytes;
+}
+
+static bool sso_string_u8_from_single_byte(String* str, const char* value, size_t length, bool cp1252) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    const unsigned char* input = (const unsigned char*)value;
+    size_t bytes = sso_string_single_byte_u8_length(input, length, cp1252);
+    size_t size = string_size(str);
+    if(!string_reserve(str, size + bytes))
+        return false;
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    unsigned char* out = data + size;
+
+    if(bytes == length) {
+        // Plain ASCII is the same in every encoding.
+        memcpy(out, input, length);
+    } else {
+        // Each input byte becomes at least one output byte, so while there are 16
+        // bytes of input left there's room to store a whole block. The ASCII bytes
+        // before the first non-ASCII byte in the block are kept and the rest is
+        // overwritten, which costs a store per non-ASCII byte instead of per byte.
+        size_t i = 0;
+        while(i < length) {
+#if defined(SSO_STRING_SSE2)
+            if(i + 16 <= length) {
+                __m128i block = _mm_loadu_si128((const __m128i*)(input + i));
+                uint32_t high = (uint32_t)_mm_movemask_epi8(block);
+                if((high & 1) == 0) {
+                    size_t ascii = high == 0 ? 16 : (size_t)sso_string_ctz(high);
+                    _mm_storeu_si128((__m128i*)out, block);
+                    i += ascii;
+                    out += ascii;
+                    continue;
+                }
+            }
+#elif defined(SSO_STRING_NEON)
+            if(i + 16 <= length) {
+                uint8x16_t block = vld1q_u8(input + i);
+                uint64x2_t high = vreinterpretq_u64_u8(vshrq_n_u8(block, 7));
+                if((vgetq_lane_u64(high, 0) | vgetq_lane_u64(high, 1)) == 0) {
+                    vst1q_u8(out, block);
+                    i += 16;
+                    out += 16;
+                    continue;
+                }
+            }
+#else
+            if(i + 8 <= length && (sso_string_load64(input + i) & SSO_STRING_SWAR_HIGHS) == 0) {
+                memcpy(out, input + i, 8);
+                i += 8;
+                out += 8;
+                continue;
+            }
+#endif
+
+            unsigned char byte = input[i++];
+            if(byte < 0x80) {
+                *out++ = byte;
+                continue;
+            }
+
+            if(cp1252 && (byte & 0xE0) == 0x80) {
+                // Copying 3 bytes is safe for the same reason as the block stores.
+                const unsigned char* encoded = sso_string_cp1252_c1_utf8[byte & 0x1F];
+                memcpy(out, encoded, 3);
+                out += encoded[3];
+            } else {
+                out[0] = (unsigned char)(0xC0 | (byte >> 6));
+                out[1] = (unsigned char)(0x80 | (byte & 0x3F));
+                out += 2;
+            }
+        }
+    }
+
+    size += bytes;
+    sso_string_set_size(str, size);
+    data[size] = 0;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_u8_from_latin1(String* str, const char* value, size_t length) {
+    return sso_string_u8_from_single_byte(str, value, length, false);
+}
+
+SSO_STRING_EXPORT bool string_u8_from_cp1252(String* str, const char* value, size_t length) {
+    return sso_string_u8_from_single_byte(str, value, length, true);
+}
+
+// Gets the CP1252 byte for a codepoint, or -1 if it doesn't have one.
+static inline int sso_string_cp1252_byte(Char32 value) {
+    if(value < 0x80 || (value >= 0xA0 && value <= 0xFF))
+        return (int)value;
+
+    for(int i = 0; i < 32; i++) {
+        if(sso_string_cp1252_c1[i] == value)
+            return 0x80 + i;
+    }
+
+    return -1;
+}
+
+static size_t sso_string_u8_to_single_byte(
+    const String* str,
+    char* out,
+    size_t out_size,
+    StringEncodingErrors errors,
+    size_t* out_error_offset,
+    bool cp1252)
+{
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t required = string_u8_utf32_length(str);
+    if(out_size < required)
+        return SIZE_MAX;
+
+    SSO_STRING_ASSERT_ARG(out || required == 0);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t written = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            memcpy(out + written, data + i, ascii);
+            written += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        int byte;
+
+        // Invalid bytes decode to U+DC80 - U+DCFF, which can't be represented either.
+        if(cp1252)
+            byte = sso_string_cp1252_byte(value);
+        else
+            byte = value <= 0xFF ? (int)value : -1;
+
+        if(byte < 0) {
+            if(errors == STRING_ENCODING_STRICT) {
+                if(out_error_offset)
+                    *out_error_offset = i;
+                return SIZE_MAX;
+            }
+            byte = '?';
+        }
+
+        out[written++] = (char)byte;
+        i += length;
+    }
+
+    return written;
+}
+
+SSO_STRING_EXPORT size_t string_u8_to_latin1(
+    const String* str,
+    char* out,
+    size_t out_size,
+    StringEncodingErrors errors,
+    size_t* out_error_offset)
+{
+    return sso_string_u8_to_single_byte(str, out, out_size, errors, out_error_offset, false);
+}
+
+SSO_STRING_EXPORT size_t string_u8_to_cp1252(
+    const String* str,
+    char* out,
+    size_t out_size,
+    StringEncodingErrors errors,
+    size_t* out_error_offset)
+{
+    return sso_string_u8_to_single_byte(str, out, out_size, errors, out_error_offset, true);
+}
+
+// A DFA that validates UTF-8 one byte at a time. Each byte maps to a class,
+// and each class to a row holding the next state for every current state in
+// 6 bit fields. The states are stored as shift amounts, so moving to the next
+// state is a lookup, a shift and a mask without any branches.
+
+#define SSO_STRING_U8_ACCEPT 0
+
+static const uint8_t sso_string_u8_dfa_classes[256] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    4, 4, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5,
+    6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 7,
+    9, 10, 10, 10, 11, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4,
+};
+
+static const uint64_t sso_string_u8_dfa_transitions[12] = {
+    0x06186186186180, 0x12486306300186, 0x06492306300186, 0x0649218C300186,
+    0x06186186186186, 0x0618618618618C, 0x06186186186198, 0x06186186186192,
+    0x0618618618619E, 0x061861861861A4, 0x061861861861AA, 0x061861861861B0,
+};
+
+#define SSO_STRING_U8_DFA_STEP(state, value, byte) \
+    do { \
+        state = (sso_string_u8_dfa_transitions[sso_string_u8_dfa_classes[byte]] >> state) & 63; \
+        value = (value << 6) | ((byte) & 0x3F); \
+    } while(0)
+
+// Decodes the non-ASCII codepoint at the start of a buffer, converting a byte
+// that doesn't start a valid sequence into the replacement character. The
+// length of the sequence is taken from the lead byte so the DFA steps don't
+// wait on each other to know when to stop.
+static inline Char32 sso_string_u8_dfa_decode(const unsigned char* data, size_t size, size_t* length) {
+    unsigned char lead = data[0];
+    size_t continuations = (lead >= 0xC0) + (lead >= 0xE0) + (lead >= 0xF0);
+    uint32_t state = sso_string_u8_dfa_transitions[sso_string_u8_dfa_classes[lead]] & 63;
+    Char32 value = lead & (0x7F >> (continuations + 1));
+
+    if(continuations == 0 || continuations >= size) {
+        *length = 1;
+        return 0xFFFD;
+    }
+
+    SSO_STRING_U8_DFA_STEP(state, value, data[1]);
+    if(continuations > 1) {
+        SSO_STRING_U8_DFA_STEP(state, value, data[2]);
+        if(continuations > 2)
+            SSO_STRING_U8_DFA_STEP(state, value, data[3]);
+    }
+
+    if(state != SSO_STRING_U8_ACCEPT) {
+        *length = 1;
+        return 0xFFFD;
+    }
+
+    *length = continuations + 1;
+    return value;
+}
+
+SSO_STRING_EXPORT Char32 sso_string_u8_iter_next_impl(StringU8Iter* iter) {
+    size_t length;
+    Char32 value = sso_string_u8_dfa_decode(
+        (const unsigned char*)iter->data + iter->position,
+        iter->size - iter->position,
+        &length);
+
+    iter->position += length;
+    return value;
+}
+
+SSO_STRING_EXPORT Char32 sso_string_u8_iter_prev_impl(StringU8Iter* iter) {
+    const unsigned char* data = (const unsigned char*)iter->data;
+    size_t end = iter->position;
+    size_t lead = end - 1;
+    size_t limit = end > 4 ? end - 4 : 0;
+    while(lead > limit && (data[lead] & 0xC0) == 0x80)
+        lead--;
+
+    // The sequence is only valid if it ends exactly at the current position.
+    // Otherwise the last byte is invalid on its own.
+    size_t length;
+    Char32 value = sso_string_u8_dfa_decode(data + lead, end - lead, &length);
+    if(lead + length == end) {
+        iter->position = lead;
+        return value;
+    }
+
+    iter->position = end - 1;
+    return 0xFFFD;
+}
+
+// Gets a mask with a bit set for each non-ASCII byte in a block of 16 bytes.
+static inline uint32_t sso_string_u8_block_mask(const unsigned char* data) {
+#if defined(SSO_STRING_SSE2)
+    return (uint32_t)_mm_movemask_epi8(_mm_loadu_si128((const __m128i*)data));
+#elif defined(SSO_STRING_NEON)
+    // Spread the high bit over each byte, then a narrowing shift packs a nibble
+    // per byte. Keep one bit of each.
+    uint8x16_t high = vreinterpretq_u8_s8(vshrq_n_s8(vreinterpretq_s8_u8(vld1q_u8(data)), 7));
+    uint64_t packed = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(high), 4)), 0);
+    uint32_t mask = 0;
+    for(int i = 0; i < 16; i++)
+        mask |= (uint32_t)((packed >> (i * 4)) & 1) << i;
+    return mask;
+#else
+    uint32_t mask = 0;
+    for(int i = 0; i < 16; i++)
+        mask |= (uint32_t)(data[i] >> 7) << i;
+    return mask;
+#endif
+}
+
+SSO_STRING_EXPORT size_t string_u8_iter_decode(StringU8Iter* iter, Char32* out, size_t max) {
+    SSO_STRING_ASSERT_ARG(iter);
+    SSO_STRING_ASSERT_ARG(out || max == 0);
+
+    const unsigned char* data = (const unsigned char*)iter->data;
+    size_t size = iter->size;
+    size_t position = iter->position;
+    size_t count = 0;
+
+    // Blocks of 16 ASCII bytes are widened at once. Otherwise the codepoints
+    // that start in the block are decoded one at a time.
+    while(position + 16 <= size && max - count >= 16) {
+        if(sso_string_u8_block_mask(data + position) == 0) {
+            sso_string_widen32(data + position, 16, out + count);
+            count += 16;
+            position += 16;
+            continue;
+        }
+
+        size_t end = position + 16;
+        while(position < end) {
+            if(data[position] <= U8_SINGLE) {
+                out[count++] = data[position++];
+                continue;
+            }
+
+            size_t length;
+            out[count++] = sso_string_u8_dfa_decode(data + position, size - position, &length);
+            position += length;
+        }
+    }
+
+    while(count < max && position < size) {
+        if(data[position] <= U8_SINGLE) {
+            out[count++] = data[position++];
+            continue;
+        }
+
+        size_t length;
+        out[count++] = sso_string_u8_dfa_decode(data + position, size - position, &length);
+        position += length;
+    }
+
+    iter->position = position;
+    return count;
+}
+
+SSO_STRING_EXPORT size_t string_u8_decode_into(const String* str, Char32* out, size_t max) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    StringU8Iter iter;
+    string_u8_iter_init(&iter, str);
+    return string_u8_iter_decode(&iter, out, max);
+}
+
+// Unicode case mapping. Runs of ASCII are converted a block at a time. The
+// output is measured before anything is written, so a mapping that changes
+// the size of the string (e.g. ß -> SS) only needs a single allocation.
+
+enum sso_unicode_case {
+    SSO_UNICODE_CASE_LOWER,
+    SSO_UNICODE_CASE_UPPER,
+    SSO_UNICODE_CASE_FOLD
+};
+
+#define SSO_UNICODE_CASED 0x1
+#define SSO_UNICODE_CASE_IGNORABLE 0x2
+
+#define SSO_UNICODE_LOOKUP(name, value) \
+    name##_stage2[((uint32_t)name##_stage1[(value) >> SSO_UNICODE_BLOCK_SHIFT] << SSO_UNICODE_BLOCK_SHIFT) | ((value) & SSO_UNICODE_BLOCK_MASK)]
+
+static inline int sso_unicode_case_properties(Char32 value) {
+    if(value >= SSO_UNICODE_CASE_PROPERTIES_LIMIT)
+        return 0;
+    return SSO_UNICODE_LOOKUP(sso_unicode_case_properties, value);
+}
+
+// Gets the full case mapping of a codepoint, which is between 1 and 3 codepoints long.
+// Returns the number of codepoints written to out.
+static int sso_unicode_case_mapping(Char32 value, enum sso_unicode_case mode, Char32* out) {
+    uint32_t index = 0;
+    const int32_t* deltas;
+    const uint32_t* special;
+    uint32_t delta_count;
+
+    switch(mode) {
+        case SSO_UNICODE_CASE_LOWER:
+            if(value < SSO_UNICODE_LOWER_LIMIT)
+                index = SSO_UNICODE_LOOKUP(sso_unicode_lower, value);
+            deltas = sso_unicode_lower_deltas;
+            special = sso_unicode_lower_special;
+            delta_count = SSO_UNICODE_LOWER_DELTAS;
+            break;
+        case SSO_UNICODE_CASE_UPPER:
+            if(value < SSO_UNICODE_UPPER_LIMIT)
+                index = SSO_UNICODE_LOOKUP(sso_unicode_upper, value);
+            deltas = sso_unicode_upper_deltas;
+            special = sso_unicode_upper_special;
+            delta_count = SSO_UNICODE_UPPER_DELTAS;
+            break;
+        default:
+            if(value < SSO_UNICODE_FOLD_LIMIT)
+                index = SSO_UNICODE_LOOKUP(sso_unicode_fold, value);
+            deltas = sso_unicode_fold_deltas;
+            special = sso_unicode_fold_special;
+            delta_count = SSO_UNICODE_FOLD_DELTAS;
+            break;
+    }
+
+    if(index < delta_count) {
+        out[0] = (Char32)((int32_t)value + deltas[index]);
+        return 1;
+    }
+
+    special += (index - delta_count) * 4;
+    for(uint32_t i = 0; i < special[0]; i++)
+        out[i] = special[i + 1];
+    return (int)special[0];
+}
+
+static inline int sso_string_u8_encoded_size(Char32 value) {
+    return value < 0x80 ? 1 : value < 0x800 ? 2 : value < 0x10000 ? 3 : 4;
+}
+
+// Flips the case of the ASCII letters from first to first + 25. Works in place
+// when out is the same as data.
+static void sso_string_ascii_flip_case(unsigned char* out, const unsigned char* data, size_t count, unsigned char first) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    const __m256i below_wide = _mm256_set1_epi8((char)(first - 1));
+    const __m256i above_wide = _mm256_set1_epi8((char)(first + 26));
+    const __m256i bit_wide = _mm256_set1_epi8(0x20);
+    for(; i + 32 <= count; i += 32) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i letters = _mm256_and_si256(_mm256_cmpgt_epi8(value, below_wide), _mm256_cmpgt_epi8(above_wide, value));
+        _mm256_storeu_si256((__m256i*)(out + i), _mm256_xor_si256(value, _mm256_and_si256(letters, bit_wide)));
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i below = _mm_set1_epi8((char)(first - 1));
+    const __m128i above = _mm_set1_epi8((char)(first + 26));
+    const __m128i bit = _mm_set1_epi8(0x20);
+    for(; i + 16 <= count; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i letters = _mm_and_si128(_mm_cmpgt_epi8(value, below), _mm_cmplt_epi8(value, above));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_xor_si128(value, _mm_and_si128(letters, bit)));
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= count; i += 16) {
+        uint8x16_t value = vld1q_u8(data + i);
+        uint8x16_t letters = vcltq_u8(vsubq_u8(value, vdupq_n_u8(first)), vdupq_n_u8(26));
+        vst1q_u8(out + i, veorq_u8(value, vandq_u8(letters, vdupq_n_u8(0x20))));
+    }
+#endif
+
+    for(; i + 8 <= count; i += 8) {
+        uint64_t value = sso_string_load64(data + i);
+        uint64_t heptets = value & ~SSO_STRING_SWAR_HIGHS;
+        uint64_t above_last = heptets + SSO_STRING_SWAR_ONES * (0x7F - (first + 25));
+        uint64_t from_first = heptets + SSO_STRING_SWAR_ONES * (0x80 - first);
+        uint64_t letters = (above_last ^ from_first) & ~value & SSO_STRING_SWAR_HIGHS;
+        value ^= letters >> 2;
+        memcpy(out + i, &value, 8);
+    }
+
+    for(; i < count; i++)
+        out[i] = (unsigned char)(data[i] - first) < 26 ? data[i] ^ 0x20 : data[i];
+}
+
+// Determines if a capital sigma is at the end of a word, in which case it
+// lowercases to a final sigma. The sigma must follow a cased letter, which is
+// tracked by the caller, and must not be followed by one. Case ignorable
+// characters between them are skipped.
+static bool sso_string_u8_is_final_sigma(const unsigned char* data, size_t size, size_t next) {
+    while(next < size) {
+        int length;
+        int properties = sso_unicode_case_properties(sso_string_u8_decode_escaped(data + next, size - next, &length));
+        if(!(properties & SSO_UNICODE_CASE_IGNORABLE))
+            return !(properties & SSO_UNICODE_CASED);
+        next += length;
+    }
+    return true;
+}
+
+// Updates whether the previous character is a cased letter, skipping over
+// case ignorable characters. Characters that are both are treated as case
+// ignorable, which matches ICU.
+static inline bool sso_string_u8_after_cased(bool after_cased, Char32 value) {
+    int properties = sso_unicode_case_properties(value);
+    if(properties & SSO_UNICODE_CASE_IGNORABLE)
+        return after_cased;
+    return (properties & SSO_UNICODE_CASED) != 0;
+}
+
+// Measures the output of a case mapping. same_length is set to true if every
+// character maps to a character with the same encoded size.
+static size_t sso_string_u8_case_size(const unsigned char* data, size_t size, enum sso_unicode_case mode, bool* same_length) {
+    size_t result = 0;
+    size_t i = 0;
+    *same_length = true;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            result += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        size_t mapped_size = (size_t)length;
+
+        if(value < 0xDC80 || value > 0xDCFF) {
+            Char32 mapped[3];
+            int count = sso_unicode_case_mapping(value, mode, mapped);
+            mapped_size = 0;
+            for(int j = 0; j < count; j++)
+                mapped_size += sso_string_u8_encoded_size(mapped[j]);
+        }
+
+        if(mapped_size != (size_t)length)
+            *same_length = false;
+
+        result += mapped_size;
+        i += length;
+    }
+
+    return result;
+}
+
+// Writes the case mapping of data into out. out can be the same as data if
+// every character keeps the same encoded size.
+static void sso_string_u8_case_write(const unsigned char* data, size_t size, unsigned char* out, enum sso_unicode_case mode) {
+    unsigned char first = mode == SSO_UNICODE_CASE_UPPER ? 'a' : 'A';
+    bool after_cased = false;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            for(size_t j = ascii; j > 0; j--) {
+                int properties = sso_unicode_case_properties(data[i + j - 1]);
+                if(!(properties & SSO_UNICODE_CASE_IGNORABLE)) {
+                    after_cased = (properties & SSO_UNICODE_CASED) != 0;
+                    break;
+                }
+            }
+
+            sso_string_ascii_flip_case(out, data + i, ascii, first);
+            out += ascii;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+
+        if(value >= 0xDC80 && value <= 0xDCFF) {
+            // Invalid bytes are copied unchanged.
+            *out++ = data[i++];
+            after_cased = false;
+            continue;
+        }
+
+        Char32 mapped[3];
+        int count;
+        if(mode == SSO_UNICODE_CASE_LOWER && value == 0x03A3 && after_cased
+            && sso_string_u8_is_final_sigma(data, size, i + length))
+        {
+            mapped[0] = 0x03C2;
+            count = 1;
+        } else {
+            count = sso_unicode_case_mapping(value, mode, mapped);
+        }
+
+        after_cased = sso_string_u8_after_cased(after_cased, value);
+        for(int j = 0; j < count; j++)
+            out += sso_string_u8_encode(out, mapped[j]);
+        i += length;
+    }
+}
+
+static bool sso_string_u8_case_impl(String* str, enum sso_unicode_case mode) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    size_t size = string_size(str);
+    bool same_length;
+    size_t result_size = sso_string_u8_case_size(data, size, mode, &same_length);
+
+    if(same_length) {
+        sso_string_u8_case_write(data, size, data, mode);
+        return true;
+    }
+
+    String result;
+    string_init_size(&result, "", 0);
+    if(!string_reserve(&result, result_size))
+        return false;
+
+    unsigned char* out = (unsigned char*)string_cstr(&result);
+    sso_string_u8_case_write(data, size, out, mode);
+    sso_string_set_size(&result, result_size);
+    out[result_size] = 0;
+
+    string_free_resources(str);
+    *str = result;
+    return true;
+}
+
+static bool sso_string_u8_case_into_impl(const String* str, String* out, enum sso_unicode_case mode) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(out);
+    SSO_STRING_ASSERT_ARG(str != out);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    bool same_length;
+    size_t result_size = sso_string_u8_case_size(data, size, mode, &same_length);
+
+    size_t out_size = string_size(out);
+    if(!string_reserve(out, out_size + result_size))
+        return false;
+
+    unsigned char* out_data = (unsigned char*)string_cstr(out);
+    sso_string_u8_case_write(data, size, out_data + out_size, mode);
+    out_size += result_size;
+    sso_string_set_size(out, out_size);
+    out_data[out_size] = 0;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_u8_to_lower(String* str) {
+    return sso_string_u8_case_impl(str, SSO_UNICODE_CASE_LOWER);
+}
+
+SSO_STRING_EXPORT bool string_u8_to_upper(String* str) {
+    return sso_string_u8_case_impl(str, SSO_UNICODE_CASE_UPPER);
+}
+
+SSO_STRING_EXPORT bool string_u8_case_fold(String* str) {
+    return sso_string_u8_case_impl(str, SSO_UNICODE_CASE_FOLD);
+}
+
+SSO_STRING_EXPORT bool string_u8_to_lower_into(const String* str, String* out) {
+    return sso_string_u8_case_into_impl(str, out, SSO_UNICODE_CASE_LOWER);
+}
+
+SSO_STRING_EXPORT bool string_u8_to_upper_into(const String* str, String* out) {
+    return sso_string_u8_case_into_impl(str, out, SSO_UNICODE_CASE_UPPER);
+}
+
+SSO_STRING_EXPORT bool string_u8_case_fold_into(const String* str, String* out) {
+    return sso_string_u8_case_into_impl(str, out, SSO_UNICODE_CASE_FOLD);
+}
+
+// Codepoint mapping. The mapper is only ever called once per codepoint, so
+// the size of the result isn't known up front. Nothing is written while the
+// output matches the input, and from the first codepoint that changes the rest
+// is written to a new string, which only replaces str once it's complete. That
+// way str is left unchanged when an allocation fails.
+
+static bool sso_string_u8_map_impl(String* str, StringU8Mapper mapper, void* state) {
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    unsigned char* out = NULL;
+    size_t capacity = 0;
+    size_t written = 0;
+    size_t i = 0;
+    String result;
+
+    while(i < size) {
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        unsigned char encoded[4];
+        int count = 0;
+
+        if(value >= 0xDC80 && value <= 0xDCFF) {
+            // Invalid bytes are copied unchanged.
+            encoded[0] = data[i];
+            count = 1;
+        } else {
+            value = mapper(value, state);
+            if(value != SSO_STRING_U8_MAP_DELETE) {
+                if((value >= 0xD800 && value <= 0xDFFF) || value > 0x10FFFF)
+                    value = SSO_UNICODE_REPLACEMENT;
+                count = sso_string_u8_encode(encoded, value);
+            }
+        }
+
+        size_t start = i;
+        i += length;
+
+        if(!out) {
+            if(count == length && memcmp(encoded, data + start, count) == 0)
+                continue;
+
+            // Everything before this codepoint is unchanged.
+            string_init_size(&result, "", 0);
+            if(!string_reserve(&result, size + count))
+                return false;
+
+            out = (unsigned char*)string_cstr(&result);
+            capacity = string_capacity(&result);
+            memcpy(out, data, start);
+            written = start;
+        } else if(written + count > capacity) {
+            // Reserving only keeps the characters within the size.
+            sso_string_set_size(&result, written);
+            if(!string_reserve(&result, capacity * 2 + count)) {
+                string_free_resources(&result);
+                return false;
+            }
+
+            out = (unsigned char*)string_cstr(&result);
+            capacity = string_capacity(&result);
+        }
+
+        memcpy(out + written, encoded, count);
+        written += count;
+    }
+
+    if(!out)
+        return true;
+
+    sso_string_set_size(&result, written);
+    out[written] = 0;
+    string_free_resources(str);
+    *str = result;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_u8_map(String* str, StringU8Mapper mapper, void* state) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(mapper);
+
+    return sso_string_u8_map_impl(str, mapper, state);
+}
+
+struct sso_string_u8_map_table {
+    const Char32* table;
+    size_t size;
+};
+
+static Char32 sso_string_u8_map_table_lookup(Char32 value, void* state) {
+    struct sso_string_u8_map_table* table = state;
+    return value < table->size ? table->table[value] : value;
+}
+
+SSO_STRING_EXPORT bool string_u8_map_table(String* str, const Char32* table, size_t table_size) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(table || table_size == 0);
+
+    struct sso_string_u8_map_table state = { table, table_size };
+    return sso_string_u8_map_impl(str, sso_string_u8_map_table_lookup, &state);
+}
+
+// Unicode normalization. The quick check properties let most strings be
+// verified in a single pass without decoding runs of ASCII. When a string
+// isn't normalized, only the part following the last character that can't
+// interact with the rest of the string is decomposed, reordered and composed.
+
+#define SSO_UNICODE_QC_NFD_NO 0x1
+#define SSO_UNICODE_QC_NFKD_NO 0x2
+#define SSO_UNICODE_QC_NFC_NO 0x4
+#define SSO_UNICODE_QC_NFC_MAYBE 0x8
+#define SSO_UNICODE_QC_NFKC_NO 0x10
+#define SSO_UNICODE_QC_NFKC_MAYBE 0x20
+
+enum sso_unicode_quick_check {
+    SSO_UNICODE_QC_YES,
+    SSO_UNICODE_QC_NO,
+    SSO_UNICODE_QC_MAYBE
+};
+
+#define SSO_UNICODE_HANGUL_S_BASE 0xAC00
+#define SSO_UNICODE_HANGUL_L_BASE 0x1100
+#define SSO_UNICODE_HANGUL_V_BASE 0x1161
+#define SSO_UNICODE_HANGUL_T_BASE 0x11A7
+#define SSO_UNICODE_HANGUL_L_COUNT 19
+#define SSO_UNICODE_HANGUL_V_COUNT 21
+#define SSO_UNICODE_HANGUL_T_COUNT 28
+#define SSO_UNICODE_HANGUL_N_COUNT (SSO_UNICODE_HANGUL_V_COUNT * SSO_UNICODE_HANGUL_T_COUNT)
+#define SSO_UNICODE_HANGUL_S_COUNT (SSO_UNICODE_HANGUL_L_COUNT * SSO_UNICODE_HANGUL_N_COUNT)
+
+static inline int sso_unicode_combining_class(Char32 value) {
+    if(value >= SSO_UNICODE_COMBINING_CLASS_LIMIT)
+        return 0;
+    return SSO_UNICODE_LOOKUP(sso_unicode_combining_class, value);
+}
+
+static inline int sso_unicode_quick_check(Char32 value) {
+    if(value >= SSO_UNICODE_QUICK_CHECK_LIMIT)
+        return 0;
+    return SSO_UNICODE_LOOKUP(sso_unicode_quick_check, value);
+}
+
+static inline bool sso_unicode_normalization_composes(StringNormalization form) {
+    return form == STRING_NFC || form == STRING_NFKC;
+}
+
+// Writes the full decomposition of a codepoint to out, which must have room for
+// SSO_UNICODE_DECOMPOSITION_MAX codepoints. Returns the number of codepoints written.
+static int sso_unicode_decompose(Char32 value, bool compat, Char32* out) {
+    uint32_t index = value - SSO_UNICODE_HANGUL_S_BASE;
+    if(index < SSO_UNICODE_HANGUL_S_COUNT) {
+        out[0] = SSO_UNICODE_HANGUL_L_BASE + index / SSO_UNICODE_HANGUL_N_COUNT;
+        out[1] = SSO_UNICODE_HANGUL_V_BASE + (index % SSO_UNICODE_HANGUL_N_COUNT) / SSO_UNICODE_HANGUL_T_COUNT;
+        if(index % SSO_UNICODE_HANGUL_T_COUNT == 0)
+            return 2;
+        out[2] = SSO_UNICODE_HANGUL_T_BASE + index % SSO_UNICODE_HANGUL_T_COUNT;
+        return 3;
+    }
+
+    index = 0;
+    if(compat) {
+        if(value < SSO_UNICODE_COMPAT_DECOMPOSITION_LIMIT)
+            index = SSO_UNICODE_LOOKUP(sso_unicode_compat_decomposition, value);
+    } else {
+        if(value < SSO_UNICODE_CANONICAL_DECOMPOSITION_LIMIT)
+            index = SSO_UNICODE_LOOKUP(sso_unicode_canonical_decomposition, value);
+    }
+
+    if(index == 0) {
+        out[0] = value;
+        return 1;
+    }
+
+    const uint32_t* decomposition = sso_unicode_decompositions + index;
+    for(uint32_t i = 0; i < decomposition[0]; i++)
+        out[i] = decomposition[i + 1];
+    return (int)decomposition[0];
+}
+
+// Gets the primary composite of two codepoints, or 0 if they don't compose.
+static Char32 sso_unicode_compose(Char32 first, Char32 second) {
+    uint32_t l_index = first - SSO_UNICODE_HANGUL_L_BASE;
+    uint32_t s_index = first - SSO_UNICODE_HANGUL_S_BASE;
+    if(l_index < SSO_UNICODE_HANGUL_L_COUNT) {
+        uint32_t v_index = second - SSO_UNICODE_HANGUL_V_BASE;
+        if(v_index < SSO_UNICODE_HANGUL_V_COUNT)
+            return SSO_UNICODE_HANGUL_S_BASE + (l_index * SSO_UNICODE_HANGUL_V_COUNT + v_index) * SSO_UNICODE_HANGUL_T_COUNT;
+        return 0;
+    } else if(s_index < SSO_UNICODE_HANGUL_S_COUNT && s_index % SSO_UNICODE_HANGUL_T_COUNT == 0) {
+        uint32_t t_index = second - SSO_UNICODE_HANGUL_T_BASE;
+        if(t_index > 0 && t_index < SSO_UNICODE_HANGUL_T_COUNT)
+            return first + t_index;
+        return 0;
+    }
+
+    // Only characters that are maybe allowed in NFC can be the second
+    // character of a composite.
+    if(!(sso_unicode_quick_check(second) & SSO_UNICODE_QC_NFC_MAYBE))
+        return 0;
+
+    uint64_t key = ((uint64_t)first << 21) | second;
+    size_t low = 0;
+    size_t high = SSO_UNICODE_COMPOSITION_COUNT;
+    while(low < high) {
+        size_t mid = low + (high - low) / 2;
+        if(sso_unicode_composition_keys[mid] < key)
+            low = mid + 1;
+        else
+            high = mid;
+    }
+
+    if(low < SSO_UNICODE_COMPOSITION_COUNT && sso_unicode_composition_keys[low] == key)
+        return sso_unicode_composition_values[low];
+    return 0;
+}
+
+// Checks whether a string is normalized using the quick check properties. If
+// the result isn't SSO_UNICODE_QC_YES, start is set to the offset of the
+// character that normalization has to begin at. Everything before it is
+// already normalized and isn't affected by the characters that follow it.
+static enum sso_unicode_quick_check sso_string_u8_quick_check(const unsigned char* data, size_t size, StringNormalization form, size_t* start) {
+    static const int no_masks[] = { SSO_UNICODE_QC_NFC_NO, SSO_UNICODE_QC_NFD_NO, SSO_UNICODE_QC_NFKC_NO, SSO_UNICODE_QC_NFKD_NO };
+    static const int maybe_masks[] = { SSO_UNICODE_QC_NFC_MAYBE, 0, SSO_UNICODE_QC_NFKC_MAYBE, 0 };
+    int no_mask = no_masks[form];
+    int maybe_mask = maybe_masks[form];
+    size_t stable = 0;
+    int last_ccc = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            i += sso_string_ascii_length(data + i, size - i);
+            stable = i - 1;
+            last_ccc = 0;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        int ccc = sso_unicode_combining_class(value);
+        int quick_check = sso_unicode_quick_check(value);
+
+        if((ccc != 0 && last_ccc > ccc) || (quick_check & no_mask)) {
+            *start = stable;
+            return SSO_UNICODE_QC_NO;
+        }
+
+        if(quick_check & maybe_mask) {
+            *start = stable;
+            return SSO_UNICODE_QC_MAYBE;
+        }
+
+        if(ccc == 0)
+            stable = i;
+        last_ccc = ccc;
+        i += length;
+    }
+
+    return SSO_UNICODE_QC_YES;
+}
+
+// Runs of non-starters longer than this are sorted with a counting sort, so a
+// long run of combining marks can't take quadratic time.
+#define SSO_STRING_MARKS_INSERTION_MAX 32
+
+// Stably sorts a run of non-starters by combining class. Returns false on
+// allocation failure.
+static bool sso_string_u8_sort_marks(Char32* marks, size_t count) {
+    if(count <= SSO_STRING_MARKS_INSERTION_MAX) {
+        for(size_t i = 1; i < count; i++) {
+            Char32 value = marks[i];
+            int ccc = sso_unicode_combining_class(value);
+            size_t position = i;
+            while(position > 0 && sso_unicode_combining_class(marks[position - 1]) > ccc) {
+                marks[position] = marks[position - 1];
+                position--;
+            }
+            marks[position] = value;
+        }
+        return true;
+    }
+
+    Char32* sorted = malloc(count * sizeof(Char32));
+    if(!sorted)
+        return false;
+
+    size_t starts[256] = { 0 };
+    for(size_t i = 0; i < count; i++)
+        starts[sso_unicode_combining_class(marks[i])]++;
+
+    size_t total = 0;
+    for(int ccc = 0; ccc < 256; ccc++) {
+        size_t classes = starts[ccc];
+        starts[ccc] = total;
+        total += classes;
+    }
+
+    for(size_t i = 0; i < count; i++)
+        sorted[starts[sso_unicode_combining_class(marks[i])]++] = marks[i];
+
+    memcpy(marks, sorted, count * sizeof(Char32));
+    free(sorted);
+    return true;
+}
+
+// Decomposes data into out in canonical order. If out is NULL, only the
+// number of codepoints in the result is computed. Returns SIZE_MAX on
+// allocation failure.
+static size_t sso_string_u8_decompose(const unsigned char* data, size_t size, bool compat, Char32* out) {
+    Char32 decomposition[SSO_UNICODE_DECOMPOSITION_MAX];
+    size_t count = 0;
+    size_t marks = 0;
+    size_t i = 0;
+
+    // Each run of non-starters is sorted once the next starter ends it.
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            if(out) {
+                if(!sso_string_u8_sort_marks(out + marks, count - marks))
+                    return SIZE_MAX;
+                sso_string_widen32(data + i, ascii, out + count);
+            }
+            count += ascii;
+            marks = count;
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        int decomposed = sso_unicode_decompose(value, compat, decomposition);
+        i += length;
+
+        if(!out) {
+            count += decomposed;
+            continue;
+        }
+
+        for(int j = 0; j < decomposed; j++) {
+            if(sso_unicode_combining_class(decomposition[j]) == 0) {
+                if(!sso_string_u8_sort_marks(out + marks, count - marks))
+                    return SIZE_MAX;
+                marks = count + 1;
+            }
+            out[count++] = decomposition[j];
+        }
+    }
+
+    if(out && !sso_string_u8_sort_marks(out + marks, count - marks))
+        return SIZE_MAX;
+
+    return count;
+}
+
+// Canonically composes a decomposed buffer in place. Returns the new length.
+static size_t sso_unicode_compose_buffer(Char32* buffer, size_t count) {
+    size_t starter = SIZE_MAX;
+    size_t out = 0;
+    int last_ccc = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        Char32 value = buffer[i];
+        int ccc = sso_unicode_combining_class(value);
+
+        if(starter != SIZE_MAX) {
+            bool blocked = out > starter + 1 && (last_ccc == 0 || last_ccc >= ccc);
+            if(!blocked) {
+                Char32 composite = sso_unicode_compose(buffer[starter], value);
+                if(composite != 0) {
+                    buffer[starter] = composite;
+                    continue;
+                }
+            }
+        }
+
+        if(ccc == 0)
+            starter = out;
+        last_ccc = ccc;
+        buffer[out++] = value;
+    }
+
+    return out;
+}
+
+static inline int sso_string_u8_normalized_encoded_size(Char32 value) {
+    // Invalid bytes are decoded into lone surrogates and are written back as is.
+    if(value >= 0xDC80 && value <= 0xDCFF)
+        return 1;
+    return sso_string_u8_encoded_size(value);
+}
+
+static inline int sso_string_u8_normalized_encode(unsigned char* out, Char32 value) {
+    if(value >= 0xDC80 && value <= 0xDCFF) {
+        *out = (unsigned char)(value - 0xDC00);
+        return 1;
+    }
+    return sso_string_u8_encode(out, value);
+}
+
+// The number of codepoints that can be normalized without allocating a buffer.
+#define SSO_STRING_NORMALIZE_BUFFER 128
+
+// Normalizes data into a buffer of codepoints. buffer must have room for
+// SSO_STRING_NORMALIZE_BUFFER codepoints, and is replaced with an allocated
+// buffer if that isn't enough. Returns false on allocation failure.
+static bool sso_string_u8_normalize_buffer(
+    const unsigned char* data,
+    size_t size,
+    StringNormalization form,
+    Char32** buffer,
+    size_t* count,
+    size_t* encoded_size)
+{
+    bool compat = form == STRING_NFKC || form == STRING_NFKD;
+    size_t length = sso_string_u8_decompose(data, size, compat, NULL);
+
+    bool allocated = length > SSO_STRING_NORMALIZE_BUFFER;
+    if(allocated) {
+        *buffer = malloc(length * sizeof(Char32));
+        if(!*buffer)
+            return false;
+    }
+
+    length = sso_string_u8_decompose(data, size, compat, *buffer);
+    if(length == SIZE_MAX) {
+        if(allocated)
+            free(*buffer);
+        return false;
+    }
+
+    if(sso_unicode_normalization_composes(form))
+        length = sso_unicode_compose_buffer(*buffer, length);
+
+    size_t bytes = 0;
+    for(size_t i = 0; i < length; i++)
+        bytes += sso_string_u8_normalized_encoded_size((*buffer)[i]);
+
+    *count = length;
+    *encoded_size = bytes;
+    return true;
+}
+
+static void sso_string_u8_normalize_write(unsigned char* out, const Char32* buffer, size_t count) {
+    for(size_t i = 0; i < count; i++)
+        out += sso_string_u8_normalized_encode(out, buffer[i]);
+}
+
+static bool sso_string_u8_normalized_equals(const unsigned char* data, size_t size, const Char32* buffer, size_t count) {
+    unsigned char encoded[4];
+    size_t offset = 0;
+    for(size_t i = 0; i < count; i++) {
+        int length = sso_string_u8_normalized_encode(encoded, buffer[i]);
+        if(offset + length > size || memcmp(data + offset, encoded, length) != 0)
+            return false;
+        offset += length;
+    }
+    return offset == size;
+}
+
+SSO_STRING_EXPORT bool string_u8_is_normalized(const String* str, StringNormalization form) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t start;
+
+    switch(sso_string_u8_quick_check(data, size, form, &start)) {
+        case SSO_UNICODE_QC_YES:
+            return true;
+        case SSO_UNICODE_QC_NO:
+            return false;
+        default:
+            break;
+    }
+
+    Char32 stack_buffer[SSO_STRING_NORMALIZE_BUFFER];
+    Char32* buffer = stack_buffer;
+    size_t count, encoded_size;
+
+    // Allocation failure can't be reported here, so fall back to saying the
+    // string isn't normalized, which only costs the caller a normalization.
+    if(!sso_string_u8_normalize_buffer(data + start, size - start, form, &buffer, &count, &encoded_size))
+        return false;
+
+    bool result = encoded_size == size - start
+        && sso_string_u8_normalized_equals(data + start, size - start, buffer, count);
+
+    if(buffer != stack_buffer)
+        free(buffer);
+    return result;
+}
+
+SSO_STRING_EXPORT bool string_u8_normalize(String* str, StringNormalization form) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t start;
+
+    if(sso_string_u8_quick_check(data, size, form, &start) == SSO_UNICODE_QC_YES)
+        return true;
+
+    Char32 stack_buffer[SSO_STRING_NORMALIZE_BUFFER];
+    Char32* buffer = stack_buffer;
+    size_t count, encoded_size;
+
+    if(!sso_string_u8_normalize_buffer(data + start, size - start, form, &buffer, &count, &encoded_size))
+        return false;
+
+    bool result = true;
+    if(encoded_size != size - start || !sso_string_u8_normalized_equals(data + start, size - start, buffer, count)) {
+        size_t result_size = start + encoded_size;
+        if(string_reserve(str, result_size)) {
+            unsigned char* out = (unsigned char*)string_cstr(str);
+            sso_string_u8_normalize_write(out + start, buffer, count);
+            sso_string_set_size(str, result_size);
+            out[result_size] = 0;
+        } else {
+            result = false;
+        }
+    }
+
+    if(buffer != stack_buffer)
+        free(buffer);
+    return result;
+}
+
+SSO_STRING_EXPORT bool string_u8_normalize_into(const String* str, String* out, StringNormalization form) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(out);
+    SSO_STRING_ASSERT_ARG(str != out);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t start;
+
+    if(sso_string_u8_quick_check(data, size, form, &start) == SSO_UNICODE_QC_YES)
+        return string_append_string(out, str);
+
+    Char32 stack_buffer[SSO_STRING_NORMALIZE_BUFFER];
+    Char32* buffer = stack_buffer;
+    size_t count, encoded_size;
+
+    if(!sso_string_u8_normalize_buffer(data + start, size - start, form, &buffer, &count, &encoded_size))
+        return false;
+
+    bool result = false;
+    size_t out_size = string_size(out);
+    if(string_reserve(out, out_size + start + encoded_size)) {
+        unsigned char* out_data = (unsigned char*)string_cstr(out);
+        memcpy(out_data + out_size, data, start);
+        sso_string_u8_normalize_write(out_data + out_size + start, buffer, count);
+        out_size += start + encoded_size;
+        sso_string_set_size(out, out_size);
+        out_data[out_size] = 0;
+        result = true;
+    }
+
+    if(buffer != stack_buffer)
+        free(buffer);
+    return result;
+}
+
+// Extended grapheme cluster boundaries (UAX #29). Whether there is a boundary
+// between two codepoints is looked up in a table indexed by their
+// Grapheme_Cluster_Break values. The two rules that depend on the codepoints
+// before the pair (emoji ZWJ sequences and regional indicator pairs) are
+// tracked separately. Codepoints below U+0300 are classified without
+// touching the property tables, and runs of ASCII are skipped in bulk.
+
+enum sso_string_gc_rule {
+    SSO_STRING_GC_BREAK,
+    SSO_STRING_GC_JOIN,
+    // GB11: Extended_Pictographic Extend* ZWJ x Extended_Pictographic
+    SSO_STRING_GC_EMOJI,
+    // GB12, GB13: Only pairs of regional indicators are joined.
+    SSO_STRING_GC_REGIONAL
+};
+
+#define B SSO_STRING_GC_BREAK
+#define J SSO_STRING_GC_JOIN
+#define E SSO_STRING_GC_EMOJI
+#define R SSO_STRING_GC_REGIONAL
+
+// Indexed by the previous value, then the current value, in the order of
+// the SSO_UNICODE_GCB_* values.
+static const uint8_t sso_string_gc_rules[SSO_UNICODE_GCB_COUNT][SSO_UNICODE_GCB_COUNT] = {
+    //           Oth CR LF Ctl Ext ZWJ RI Pre SpM L  V  T  LV LVT EP
+    /* Other */ { B, B, B, B, J, J, B, B, J, B, B, B, B, B, B },
+    /* CR    */ { B, B, J, B, B, B, B, B, B, B, B, B, B, B, B },
+    /* LF    */ { B, B, B, B, B, B, B, B, B, B, B, B, B, B, B },
+    /* Ctl   */ { B, B, B, B, B, B, B, B, B, B, B, B, B, B, B },
+    /* Ext   */ { B, B, B, B, J, J, B, B, J, B, B, B, B, B, B },
+    /* ZWJ   */ { B, B, B, B, J, J, B, B, J, B, B, B, B, B, E },
+    /* RI    */ { B, B, B, B, J, J, R, B, J, B, B, B, B, B, B },
+    /* Pre   */ { J, B, B, B, J, J, J, J, J, J, J, J, J, J, J },
+    /* SpM   */ { B, B, B, B, J, J, B, B, J, B, B, B, B, B, B },
+    /* L     */ { B, B, B, B, J, J, B, B, J, J, J, B, J, J, B },
+    /* V     */ { B, B, B, B, J, J, B, B, J, B, J, J, B, B, B },
+    /* T     */ { B, B, B, B, J, J, B, B, J, B, B, J, B, B, B },
+    /* LV    */ { B, B, B, B, J, J, B, B, J, B, J, J, B, B, B },
+    /* LVT   */ { B, B, B, B, J, J, B, B, J, B, B, J, B, B, B },
+    /* EP    */ { B, B, B, B, J, J, B, B, J, B, B, B, B, B, B }
+};
+
+#undef B
+#undef J
+#undef E
+#undef R
+
+static inline int sso_unicode_grapheme_break(Char32 value) {
+    if(value < 0x300) {
+        if(value == '\r')
+            return SSO_UNICODE_GCB_CR;
+        if(value == '\n')
+            return SSO_UNICODE_GCB_LF;
+        if(value < 0x20 || (value >= 0x7F && value < 0xA0) || value == 0xAD)
+            return SSO_UNICODE_GCB_CONTROL;
+        if(value == 0xA9 || value == 0xAE)
+            return SSO_UNICODE_GCB_EXTENDED_PICTOGRAPHIC;
+        return SSO_UNICODE_GCB_OTHER;
+    }
+
+    if(value >= SSO_UNICODE_GRAPHEME_BREAK_LIMIT)
+        return SSO_UNICODE_GCB_OTHER;
+    return SSO_UNICODE_LOOKUP(sso_unicode_grapheme_break, value);
+}
+
+struct sso_string_gc_state {
+    int previous;
+    // 1 after Extended_Pictographic Extend*, 2 after Extended_Pictographic Extend* ZWJ.
+    int emoji;
+    // Set after an odd number of regional indicators.
+    bool regional_odd;
+};
+
+static inline void sso_string_gc_state_init(struct sso_string_gc_state* state) {
+    // Nothing joins with a control character, so the first codepoint always
+    // starts a cluster.
+    state->previous = SSO_UNICODE_GCB_CONTROL;
+    state->emoji = 0;
+    state->regional_odd = false;
+}
+
+// Advances the state by a codepoint with the specified Grapheme_Cluster_Break value.
+// Returns true if there is a cluster boundary before the codepoint.
+static inline bool sso_string_gc_advance(struct sso_string_gc_state* state, int value) {
+    bool boundary;
+    switch(sso_string_gc_rules[state->previous][value]) {
+        case SSO_STRING_GC_JOIN: boundary = false; break;
+        case SSO_STRING_GC_EMOJI: boundary = state->emoji != 2; break;
+        case SSO_STRING_GC_REGIONAL: boundary = !state->regional_odd; break;
+        default: boundary = true; break;
+    }
+
+    if(value == SSO_UNICODE_GCB_EXTENDED_PICTOGRAPHIC)
+        state->emoji = 1;
+    else if(state->emoji == 1 && value == SSO_UNICODE_GCB_EXTEND)
+        state->emoji = 1;
+    else if(state->emoji == 1 && value == SSO_UNICODE_GCB_ZWJ)
+        state->emoji = 2;
+    else
+        state->emoji = 0;
+
+    state->regional_odd = value == SSO_UNICODE_GCB_REGIONAL_INDICATOR && !state->regional_odd;
+    state->previous = value;
+    return boundary;
+}
+
+// Decodes the codepoint that ends at end, consistent with how
+// sso_string_u8_decode_escaped decodes the string from the front.
+static inline Char32 sso_string_u8_decode_before(const unsigned char* data, size_t end, size_t* start) {
+    size_t lead = end - 1;
+    size_t limit = end > 4 ? end - 4 : 0;
+    while(lead > limit && (data[lead] & 0xC0) == 0x80)
+        lead--;
+
+    int length;
+    Char32 value = sso_string_u8_decode_escaped(data + lead, end - lead, &length);
+    if(lead + length == end) {
+        *start = lead;
+        return value;
+    }
+
+    *start = end - 1;
+    return 0xDC00 | data[end - 1];
+}
+
+static size_t sso_string_gc_next_impl(const unsigned char* data, size_t size, size_t index) {
+    if(index >= size)
+        return size;
+
+    // Fast path for ASCII followed by ASCII, which is always a boundary
+    // unless it's a CR LF pair.
+    if(data[index] <= U8_SINGLE && index + 1 < size && data[index + 1] <= U8_SINGLE)
+        return data[index] == '\r' && data[index + 1] == '\n' ? index + 2 : index + 1;
+
+    struct sso_string_gc_state state;
+    sso_string_gc_state_init(&state);
+
+    int length;
+    Char32 value = sso_string_u8_decode_escaped(data + index, size - index, &length);
+    sso_string_gc_advance(&state, sso_unicode_grapheme_break(value));
+    index += length;
+
+    while(index < size) {
+        value = sso_string_u8_decode_escaped(data + index, size - index, &length);
+        if(sso_string_gc_advance(&state, sso_unicode_grapheme_break(value)))
+            break;
+        index += length;
+    }
+
+    return index;
+}
+
+static size_t sso_string_gc_prev_impl(const unsigned char* data, size_t index) {
+    if(index == 0)
+        return 0;
+
+    size_t start;
+    int current = sso_unicode_grapheme_break(sso_string_u8_decode_before(data, index, &start));
+
+    while(start > 0) {
+        size_t previous_start;
+        int previous = sso_unicode_grapheme_break(sso_string_u8_decode_before(data, start, &previous_start));
+        bool boundary;
+
+        switch(sso_string_gc_rules[previous][current]) {
+            case SSO_STRING_GC_JOIN:
+                boundary = false;
+                break;
+            case SSO_STRING_GC_EMOJI: {
+                // Look for Extended_Pictographic Extend* before the ZWJ.
+                size_t position = previous_start;
+                int value = SSO_UNICODE_GCB_EXTEND;
+                while(position > 0 && value == SSO_UNICODE_GCB_EXTEND)
+                    value = sso_unicode_grapheme_break(sso_string_u8_decode_before(data, position, &position));
+                boundary = value != SSO_UNICODE_GCB_EXTENDED_PICTOGRAPHIC;
+                break;
+            }
+            case SSO_STRING_GC_REGIONAL: {
+                // Count the regional indicators before the current one.
+                size_t position = previous_start;
+                size_t count = 1;
+                while(position > 0) {
+                    size_t next;
+                    if(sso_unicode_grapheme_break(sso_string_u8_decode_before(data, position, &next)) != SSO_UNICODE_GCB_REGIONAL_INDICATOR)
+                        break;
+                    position = next;
+                    count++;
+                }
+                boundary = count % 2 == 0;
+                break;
+            }
+            default:
+                boundary = true;
+                break;
+        }
+
+        if(boundary)
+            break;
+
+        start = previous_start;
+        current = previous;
+    }
+
+    return start;
+}
+
+SSO_STRING_EXPORT size_t string_gc_next(const String* str, size_t index) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_BOUNDS(index <= string_size(str));
+
+    return sso_string_gc_next_impl((const unsigned char*)string_data(str), string_size(str), index);
+}
+
+SSO_STRING_EXPORT size_t string_gc_prev(const String* str, size_t index) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_BOUNDS(index <= string_size(str));
+
+    return sso_string_gc_prev_impl((const unsigned char*)string_data(str), index);
+}
+
+SSO_STRING_EXPORT size_t string_gc_count(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    struct sso_string_gc_state state;
+    size_t count = 0;
+    size_t i = 0;
+
+    sso_string_gc_state_init(&state);
+
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            // Only the first character of an ASCII run can join with what
+            // comes before it. After that, every character starts a new
+            // cluster except for LF following CR.
+            size_t ascii = sso_string_ascii_length(data + i, size - i);
+            const unsigned char* end = data + i + ascii;
+            count += sso_string_gc_advance(&state, sso_unicode_grapheme_break(data[i])) + ascii - 1;
+
+            const unsigned char* cr = data + i;
+            while((cr = memchr(cr, '\r', end - cr)) != NULL && ++cr < end) {
+                if(*cr == '\n')
+                    count--;
+            }
+
+            sso_string_gc_state_init(&state);
+            state.previous = sso_unicode_grapheme_break(end[-1]);
+            i += ascii;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        count += sso_string_gc_advance(&state, sso_unicode_grapheme_break(value));
+        i += length;
+    }
+
+    return count;
+}
+
+SSO_STRING_EXPORT size_t string_gc_pop_back(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    char* data = string_cstr(str);
+    size_t size = string_size(str);
+    size_t start = sso_string_gc_prev_impl((const unsigned char*)data, size);
+
+    sso_string_set_size(str, start);
+    data[start] = 0;
+    return size - start;
+}
+
+SSO_STRING_EXPORT void string_gc_truncate(String* str, size_t count) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    char* data = string_cstr(str);
+    size_t size = string_size(str);
+    size_t end = 0;
+
+    while(count > 0 && end < size) {
+        end = sso_string_gc_next_impl((const unsigned char*)data, size, end);
+        count--;
+    }
+
+    if(end < size) {
+        sso_string_set_size(str, end);
+        data[end] = 0;
+    }
+}
+
+// Whitespace. These are the characters string_u8_is_null_or_whitespace has
+// always accepted: the ASCII whitespace characters, the Unicode spaces and
+// separators, the zero width characters and the byte order mark. Runs of
+// ASCII are classified a block at a time.
+
+// Bit n is set if U+2000 + n is whitespace.
+static const uint64_t sso_unicode_space_bitmap[2] = { 0x0000030000003FFF, 0x0000000180000000 };
+
+static inline bool sso_string_ascii_is_space(unsigned char value) {
+    return value == ' ' || (unsigned char)(value - '\t') < 5;
+}
+
+static inline bool sso_unicode_is_space(Char32 value) {
+    uint32_t offset = value - 0x2000;
+    if(offset < 128)
+        return (sso_unicode_space_bitmap[offset >> 6] >> (offset & 63)) & 1;
+
+    switch(value) {
+        case 0x85:
+        case 0xA0:
+        case 0x1680:
+        case 0x180E:
+        case 0x3000:
+        case 0xFEFF:
+            return true;
+        default:
+            return value < 0x80 && sso_string_ascii_is_space((unsigned char)value);
+    }
+}
+
+// Gets the size of the whitespace character at the start of a buffer,
+// or 0 if the buffer doesn't start with whitespace.
+static inline int sso_string_u8_space_size(const unsigned char* data, size_t size) {
+    if(data[0] <= U8_SINGLE)
+        return sso_string_ascii_is_space(data[0]);
+
+    // Every non-ASCII whitespace character starts with one of these bytes.
+    switch(data[0]) {
+        case 0xC2:
+        case 0xE1:
+        case 0xE2:
+        case 0xE3:
+        case 0xEF:
+            break;
+        default:
+            return 0;
+    }
+
+    int length;
+    Char32 value = sso_string_u8_decode_escaped(data, size, &length);
+    return sso_unicode_is_space(value) ? length : 0;
+}
+
+#if defined(SSO_STRING_AVX2)
+
+static inline uint32_t sso_string_avx2_space_mask(__m256i value) {
+    __m256i control = _mm256_sub_epi8(value, _mm256_set1_epi8('\t'));
+    control = _mm256_cmpeq_epi8(_mm256_min_epu8(control, _mm256_set1_epi8(4)), control);
+    __m256i space = _mm256_cmpeq_epi8(value, _mm256_set1_epi8(' '));
+    return (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(control, space));
+}
+
+#endif
+
+#if defined(SSO_STRING_SSE2)
+
+static inline uint32_t sso_string_sse2_space_mask(__m128i value) {
+    __m128i control = _mm_sub_epi8(value, _mm_set1_epi8('\t'));
+    control = _mm_cmpeq_epi8(_mm_min_epu8(control, _mm_set1_epi8(4)), control);
+    __m128i space = _mm_cmpeq_epi8(value, _mm_set1_epi8(' '));
+    return (uint32_t)_mm_movemask_epi8(_mm_or_si128(control, space));
+}
+
+#elif defined(SSO_STRING_NEON)
+
+static inline uint8x16_t sso_string_neon_space_mask(uint8x16_t value) {
+    uint8x16_t control = vcleq_u8(vsubq_u8(value, vdupq_n_u8('\t')), vdupq_n_u8(4));
+    return vorrq_u8(control, vceqq_u8(value, vdupq_n_u8(' ')));
+}
+
+#endif
+
+// Gets the number of ASCII whitespace characters at the start of a buffer.
+static size_t sso_string_ascii_space_length(const unsigned char* data, size_t size) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    for(; i + 32 <= size; i += 32) {
+        uint32_t mask = ~sso_string_avx2_space_mask(_mm256_loadu_si256((const __m256i*)(data + i)));
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    for(; i + 16 <= size; i += 16) {
+        uint32_t mask = sso_string_sse2_space_mask(_mm_loadu_si128((const __m128i*)(data + i))) ^ 0xFFFF;
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= size; i += 16) {
+        if(!sso_string_neon_all_set(sso_string_neon_space_mask(vld1q_u8(data + i))))
+            break;
+    }
+#endif
+
+    while(i < size && sso_string_ascii_is_space(data[i]))
+        i++;
+
+    return i;
+}
+
+// Gets the number of ASCII characters other than whitespace at the start of a buffer.
+static size_t sso_string_ascii_word_length(const unsigned char* data, size_t size) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    for(; i + 32 <= size; i += 32) {
+        __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+        uint32_t mask = sso_string_avx2_space_mask(value) | (uint32_t)_mm256_movemask_epi8(value);
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    for(; i + 16 <= size; i += 16) {
+        __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+        uint32_t mask = sso_string_sse2_space_mask(value) | (uint32_t)_mm_movemask_epi8(value);
+        if(mask != 0)
+            return i + sso_string_ctz(mask);
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 16 <= size; i += 16) {
+        uint8x16_t value = vld1q_u8(data + i);
+        uint8x16_t stop = vorrq_u8(sso_string_neon_space_mask(value), vtstq_u8(value, vdupq_n_u8(0x80)));
+        uint64x2_t wide = vreinterpretq_u64_u8(stop);
+        if((vgetq_lane_u64(wide, 0) | vgetq_lane_u64(wide, 1)) != 0)
+            break;
+    }
+#endif
+
+    while(i < size && data[i] <= U8_SINGLE && !sso_string_ascii_is_space(data[i]))
+        i++;
+
+    return i;
+}
+
+// Gets the index of the first character in a buffer that isn't whitespace.
+static size_t sso_string_u8_trim_start_index(const unsigned char* data, size_t size) {
+    size_t i = 0;
+    while(i < size) {
+        i += sso_string_ascii_space_length(data + i, size - i);
+        if(i == size || data[i] <= U8_SINGLE)
+            break;
+
+        int length = sso_string_u8_space_size(data + i, size - i);
+        if(length == 0)
+            break;
+        i += length;
+    }
+
+    return i;
+}
+
+// Gets the index following the last character in a buffer that isn't
+// whitespace, without moving before start.
+static size_t sso_string_u8_trim_end_index(const unsigned char* data, size_t start, size_t end) {
+    while(end > start) {
+        if(data[end - 1] <= U8_SINGLE) {
+            if(!sso_string_ascii_is_space(data[end - 1]))
+                break;
+            end--;
+            continue;
+        }
+
+        size_t previous;
+        Char32 value = sso_string_u8_decode_before(data, end, &previous);
+        if(previous < start || !sso_unicode_is_space(value))
+            break;
+        end = previous;
+    }
+
+    return end;
+}
+
+static void sso_string_trim_impl(String* str, size_t start, size_t end) {
+    char* data = string_cstr(str);
+    if(start == 0 && end == string_size(str))
+        return;
+
+    memmove(data, data + start, end - start);
+    sso_string_set_size(str, end - start);
+    data[end - start] = 0;
+}
+
+SSO_STRING_EXPORT bool string_u8_is_null_or_whitespace(const String* str) {
+    if(string_is_null_or_empty(str))
+        return true;
+
+    size_t size = string_size(str);
+    return sso_string_u8_trim_start_index((const unsigned char*)string_data(str), size) == size;
+}
+
+SSO_STRING_EXPORT void string_trim(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t start = sso_string_u8_trim_start_index(data, string_size(str));
+    size_t end = sso_string_u8_trim_end_index(data, start, string_size(str));
+    sso_string_trim_impl(str, start, end);
+}
+
+SSO_STRING_EXPORT void string_trim_start(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t start = sso_string_u8_trim_start_index((const unsigned char*)string_data(str), string_size(str));
+    sso_string_trim_impl(str, start, string_size(str));
+}
+
+SSO_STRING_EXPORT void string_trim_end(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t end = sso_string_u8_trim_end_index((const unsigned char*)string_data(str), 0, string_size(str));
+    sso_string_trim_impl(str, 0, end);
+}
+
+SSO_STRING_EXPORT StringView string_trim_view(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t start = sso_string_u8_trim_start_index(data, string_size(str));
+    size_t end = sso_string_u8_trim_end_index(data, start, string_size(str));
+    return (StringView){ (const char*)data + start, end - start };
+}
+
+SSO_STRING_EXPORT StringView string_trim_start_view(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t start = sso_string_u8_trim_start_index(data, string_size(str));
+    return (StringView){ (const char*)data + start, string_size(str) - start };
+}
+
+SSO_STRING_EXPORT StringView string_trim_end_view(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t end = sso_string_u8_trim_end_index(data, 0, string_size(str));
+    return (StringView){ (const char*)data, end };
+}
+
+// Pads a string to width characters, putting left of the padding
+// characters before the string and the rest after it.
+static bool sso_string_pad_impl(String* str, size_t width, char value, size_t left) {
+    size_t size = string_size(str);
+    if(!string_reserve(str, width))
+        return false;
+
+    char* data = string_cstr(str);
+    size_t right = width - size - left;
+
+    memmove(data + left, data, size);
+    memset(data, value, left);
+    memset(data + left + size, value, right);
+    sso_string_set_size(str, width);
+    data[width] = 0;
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_pad_left(String* str, size_t width, char value) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t size = string_size(str);
+    if(size >= width)
+        return true;
+    return sso_string_pad_impl(str, width, value, width - size);
+}
+
+SSO_STRING_EXPORT bool string_pad_right(String* str, size_t width, char value) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    if(string_size(str) >= width)
+        return true;
+    return sso_string_pad_impl(str, width, value, 0);
+}
+
+SSO_STRING_EXPORT bool string_pad_center(String* str, size_t width, char value) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t size = string_size(str);
+    if(size >= width)
+        return true;
+    return sso_string_pad_impl(str, width, value, (width - size) / 2);
+}
+
+SSO_STRING_EXPORT void string_collapse_whitespace(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    size_t size = string_size(str);
+    size_t out = 0;
+    size_t i = 0;
+
+    while(i < size) {
+        size_t word = sso_string_ascii_word_length(data + i, size - i);
+        if(out != i)
+            memmove(data + out, data + i, word);
+        out += word;
+        i += word;
+        if(i == size)
+            break;
+
+        int length = sso_string_u8_space_size(data + i, size - i);
+        if(length == 0) {
+            sso_string_u8_decode_escaped(data + i, size - i, &length);
+            memmove(data + out, data + i, length);
+            out += length;
+            i += length;
+            continue;
+        }
+
+        i = sso_string_u8_trim_start_index(data + i, size - i) + i;
+        data[out++] = ' ';
+    }
+
+    sso_string_set_size(str, out);
+    data[out] = 0;
+}
+
+// The batch functions below preprocess the value once and reuse it for every
+// string in the array. Short strings are compared directly against an image of
+// the value laid out like a short String, which avoids chasing the data
+// pointer and branching on the string mode for the common case. The data of
+// upcoming long strings is prefetched so the cache misses overlap with work
+// on the current string.
+
+#define SSO_STRING_BATCH_PREFETCH_DISTANCE 8
+#define SSO_STRING_IMAGE_WORDS (sizeof(String) / sizeof(size_t))
+
+struct sso_string_needle {
+    const char* value;
+    size_t length;
+    unsigned char first;
+    unsigned char last;
+    bool fits_short;
+    size_t image[SSO_STRING_IMAGE_WORDS];
+    size_t prefix_mask[SSO_STRING_IMAGE_WORDS];
+    size_t equals_mask[SSO_STRING_IMAGE_WORDS];
+};
+
+static void sso_string_needle_init(struct sso_string_needle* needle, const char* value, size_t length) {
+    needle->value = value;
+    needle->length = length;
+    needle->first = length > 0 ? (unsigned char)value[0] : 0;
+    needle->last = length > 0 ? (unsigned char)value[length - 1] : 0;
+    needle->fits_short = length + 1 <= sizeof(needle->image) && length <= SSO_STRING_MIN_CAP;
+
+    memset(needle->image, 0, sizeof(needle->image));
+    memset(needle->prefix_mask, 0, sizeof(needle->prefix_mask));
+    memset(needle->equals_mask, 0, sizeof(needle->equals_mask));
+
+    if(!needle->fits_short)
+        return;
+
+    // Build the value as it would be stored in a short string. The size byte
+    // is only part of the mask for equality, since it also encodes the mode.
+    String image;
+    memset(&image, 0, sizeof(image));
+    sso_string_short_set_size(&image, length);
+    memcpy(image.s.data, value, length);
+    memcpy(needle->image, &image, sizeof(needle->image));
+
+    unsigned char prefix[sizeof(needle->image)] = { 0 };
+    memset(prefix + offsetof(struct sso_string_short, data), 0xFF, length);
+    memcpy(needle->prefix_mask, prefix, sizeof(prefix));
+
+    prefix[0] = 0xFF;
+    memcpy(needle->equals_mask, prefix, sizeof(prefix));
+}
+
+static inline bool sso_string_needle_masked_equals(const struct sso_string_needle* needle, const String* str, const size_t* mask) {
+    size_t difference = 0;
+    for(size_t i = 0; i < SSO_STRING_IMAGE_WORDS; i++) {
+        size_t word;
+        memcpy(&word, (const char*)str + i * sizeof(size_t), sizeof(word));
+        difference |= (word ^ needle->image[i]) & mask[i];
+    }
+    return difference == 0;
+}
+
+static inline void sso_string_batch_prefetch(const String* strs, size_t index, size_t count) {
+    if(index + SSO_STRING_BATCH_PREFETCH_DISTANCE < count) {
+        const String* ahead = strs + index + SSO_STRING_BATCH_PREFETCH_DISTANCE;
+        if(sso_string_is_long(ahead))
+            SSO_STRING_PREFETCH(ahead->l.data);
+    }
+}
+
+static inline void sso_string_batch_set_bit(uint8_t* out_bitmap, size_t index, bool value, uint8_t* current) {
+    if(value)
+        *current |= (uint8_t)(1u << (index & 7));
+
+    if((index & 7) == 7) {
+        if(out_bitmap)
+            out_bitmap[index >> 3] = *current;
+        *current = 0;
+    }
+}
+
+static inline void sso_string_batch_flush(uint8_t* out_bitmap, size_t count, uint8_t current) {
+    if(out_bitmap && (count & 7) != 0)
+        out_bitmap[count >> 3] = current;
+}
+
+static size_t sso_string_needle_find(const struct sso_string_needle* needle, const char* str_data, size_t size) {
+    size_t length = needle->length;
+    if(length > size)
+        return SIZE_MAX;
+
+    if(length == 0)
+        return 0;
+
+    const unsigned char* data = (const unsigned char*)str_data;
+    size_t end = size - length;
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    const __m256i first_wide = _mm256_set1_epi8((char)needle->first);
+    const __m256i last_wide = _mm256_set1_epi8((char)needle->last);
+
+    for(; i + 32 <= end + 1; i += 32) {
+        __m256i head = _mm256_loadu_si256((const __m256i*)(data + i));
+        __m256i tail = _mm256_loadu_si256((const __m256i*)(data + i + length - 1));
+        uint32_t mask = (uint32_t)_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(head, first_wide), _mm256_cmpeq_epi8(tail, last_wide)));
+
+        while(mask != 0) {
+            size_t candidate = i + sso_string_ctz(mask);
+            if(length <= 2 || memcmp(data + candidate + 1, needle->value + 1, length - 2) == 0)
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    const __m128i first_block = _mm_set1_epi8((char)needle->first);
+    const __m128i last_block = _mm_set1_epi8((char)needle->last);
+
+    for(; i + 16 <= end + 1; i += 16) {
+        __m128i head = _mm_loadu_si128((const __m128i*)(data + i));
+        __m128i tail = _mm_loadu_si128((const __m128i*)(data + i + length - 1));
+        uint32_t mask = (uint32_t)_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(head, first_block), _mm_cmpeq_epi8(tail, last_block)));
+
+        while(mask != 0) {
+            size_t candidate = i + sso_string_ctz(mask);
+            if(length <= 2 || memcmp(data + candidate + 1, needle->value + 1, length - 2) == 0)
+                return candidate;
+            mask &= mask - 1;
+        }
+    }
+#endif
+
+    for(; i <= end; i++) {
+        if(data[i] != needle->first || data[i + length - 1] != needle->last)
+            continue;
+
+        if(length <= 2 || memcmp(data + i + 1, needle->value + 1, length - 2) == 0)
+            return i;
+    }
+
+    return SIZE_MAX;
+}
+
+SSO_STRING_EXPORT size_t sso_string_find_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap,
+    size_t* out_positions)
+{
+    SSO_STRING_ASSERT_ARG(strs || count == 0);
+    SSO_STRING_ASSERT_ARG(value);
+
+    struct sso_string_needle needle;
+    sso_string_needle_init(&needle, value, length);
+
+    size_t matches = 0;
+    uint8_t current = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        sso_string_batch_prefetch(strs, i, count);
+
+        const String* str = strs + i;
+        size_t position;
+
+        if(sso_string_is_long(str))
+            position = sso_string_needle_find(&needle, str->l.data, sso_string_long_size(str));
+        else
+            position = sso_string_needle_find(&needle, str->s.data, sso_string_short_size(str));
+
+        if(out_positions)
+            out_positions[i] = position;
+
+        matches += position != SIZE_MAX;
+        sso_string_batch_set_bit(out_bitmap, i, position != SIZE_MAX, &current);
+    }
+
+    sso_string_batch_flush(out_bitmap, count, current);
+    return matches;
+}
+
+SSO_STRING_EXPORT size_t sso_string_starts_with_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap)
+{
+    SSO_STRING_ASSERT_ARG(strs || count == 0);
+    SSO_STRING_ASSERT_ARG(value);
+
+    struct sso_string_needle needle;
+    sso_string_needle_init(&needle, value, length);
+
+    size_t matches = 0;
+    uint8_t current = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        sso_string_batch_prefetch(strs, i, count);
+
+        const String* str = strs + i;
+        bool result;
+
+        if(!sso_string_is_long(str)) {
+            // A short string can't start with a value that doesn't fit in one.
+            result = needle.fits_short
+                && sso_string_short_size(str) >= length
+                && sso_string_needle_masked_equals(&needle, str, needle.prefix_mask);
+        } else {
+            result = sso_string_long_size(str) >= length
+                && memcmp(str->l.data, value, length) == 0;
+        }
+
+        matches += result;
+        sso_string_batch_set_bit(out_bitmap, i, result, &current);
+    }
+
+    sso_string_batch_flush(out_bitmap, count, current);
+    return matches;
+}
+
+SSO_STRING_EXPORT size_t sso_string_equals_batch_impl(
+    const String* strs,
+    size_t count,
+    const char* value,
+    size_t length,
+    uint8_t* out_bitmap)
+{
+    SSO_STRING_ASSERT_ARG(strs || count == 0);
+    SSO_STRING_ASSERT_ARG(value);
+
+    struct sso_string_needle needle;
+    sso_string_needle_init(&needle, value, length);
+
+    size_t matches = 0;
+    uint8_t current = 0;
+
+    for(size_t i = 0; i < count; i++) {
+        sso_string_batch_prefetch(strs, i, count);
+
+        const String* str = strs + i;
+        bool result;
+
+        if(!sso_string_is_long(str)) {
+            // The size byte is part of the mask, so this also checks the length.
+            result = needle.fits_short && sso_string_needle_masked_equals(&needle, str, needle.equals_mask);
+        } else {
+            result = sso_string_long_size(str) == length
+                && memcmp(str->l.data, value, length) == 0;
+        }
+
+        matches += result;
+        sso_string_batch_set_bit(out_bitmap, i, result, &current);
+    }
+
+    sso_string_batch_flush(out_bitmap, count, current);
+    return matches;
+}
+
+SSO_STRING_EXPORT size_t string_batch_indices(const uint8_t* bitmap, size_t count, size_t* out_indices) {
+    SSO_STRING_ASSERT_ARG(bitmap || count == 0);
+    SSO_STRING_ASSERT_ARG(out_indices);
+
+    size_t written = 0;
+    size_t bytes = (count + 7) / 8;
+
+    for(size_t i = 0; i < bytes; i++) {
+        uint32_t bits = bitmap[i];
+
+        // Ignore any bits past the end of the final partial byte.
+        if(i == bytes - 1 && (count & 7) != 0)
+            bits &= (1u << (count & 7)) - 1;
+
+        while(bits != 0) {
+            out_indices[written++] = i * 8 + sso_string_ctz(bits);
+            bits &= bits - 1;
+        }
+    }
+
+    return written;
+}
+
+static inline uint64_t sso_string_bswap64(uint64_t value) {
+#if defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#elif defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#else
+    value = ((value & 0x00FF00FF00FF00FFull) << 8) | ((value >> 8) & 0x00FF00FF00FF00FFull);
+    value = ((value & 0x0000FFFF0000FFFFull) << 16) | ((value >> 16) & 0x0000FFFF0000FFFFull);
+    return (value << 32) | (value >> 32);
+#endif
+}
+
+#if defined(SSO_STRING_AVX2)
+
+static inline __m256i sso_string_avx2_reverse(__m256i value) {
+    // pshufb only shuffles within each 128 bit lane, so the lanes are swapped afterwards.
+    const __m256i shuffle = _mm256_setr_epi8(
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0,
+        15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0);
+    value = _mm256_shuffle_epi8(value, shuffle);
+    return _mm256_permute2x128_si256(value, value, 1);
+}
+
+#endif
+
+#if defined(SSO_STRING_SSE2)
+
+static inline __m128i sso_string_sse2_reverse(__m128i value) {
+    // SSE2 has no byte shuffle, so reverse the dwords, then the words in each dword,
+    // then the bytes in each word.
+    value = _mm_shuffle_epi32(value, _MM_SHUFFLE(0, 1, 2, 3));
+    value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+}
+
+#elif defined(SSO_STRING_NEON)
+
+static inline uint8x16_t sso_string_neon_reverse(uint8x16_t value) {
+    value = vrev64q_u8(value);
+    return vextq_u8(value, value, 8);
+}
+
+#endif
+
+// Reverses size bytes in place. Blocks are taken from both ends at once and swapped,
+// so every byte is loaded and stored exactly once.
+static void sso_string_reverse_bytes_impl(unsigned char* data, size_t size) {
+    unsigned char* start = data;
+    unsigned char* end = data + size;
+
+#if defined(SSO_STRING_AVX2)
+    while(end - start >= 64) {
+        __m256i front = _mm256_loadu_si256((const __m256i*)start);
+        __m256i back = _mm256_loadu_si256((const __m256i*)(end - 32));
+        _mm256_storeu_si256((__m256i*)start, sso_string_avx2_reverse(back));
+        _mm256_storeu_si256((__m256i*)(end - 32), sso_string_avx2_reverse(front));
+        start += 32;
+        end -= 32;
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    while(end - start >= 32) {
+        __m128i front = _mm_loadu_si128((const __m128i*)start);
+        __m128i back = _mm_loadu_si128((const __m128i*)(end - 16));
+        _mm_storeu_si128((__m128i*)start, sso_string_sse2_reverse(back));
+        _mm_storeu_si128((__m128i*)(end - 16), sso_string_sse2_reverse(front));
+        start += 16;
+        end -= 16;
+    }
+#elif defined(SSO_STRING_NEON)
+    while(end - start >= 32) {
+        uint8x16_t front = vld1q_u8(start);
+        uint8x16_t back = vld1q_u8(end - 16);
+        vst1q_u8(start, sso_string_neon_reverse(back));
+        vst1q_u8(end - 16, sso_string_neon_reverse(front));
+        start += 16;
+        end -= 16;
+    }
+#endif
+
+    while(end - start >= 16) {
+        uint64_t front = sso_string_bswap64(sso_string_load64(start));
+        uint64_t back = sso_string_bswap64(sso_string_load64(end - 8));
+        memcpy(start, &back, sizeof(back));
+        memcpy(end - 8, &front, sizeof(front));
+        start += 8;
+        end -= 8;
+    }
+
+    while(end - start > 1) {
+        unsigned char tmp = *start;
+        *start++ = *--end;
+        *end = tmp;
+    }
+}
+
+SSO_STRING_EXPORT void string_reverse_bytes(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    sso_string_reverse_bytes_impl((unsigned char*)string_cstr(str), string_size(str));
+}
+
+SSO_STRING_EXPORT void string_u8_reverse_codepoints(String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t size = string_size(str);
+    unsigned char* data = (unsigned char*)string_cstr(str);
+    size_t i = 0;
+
+    // Reverse the bytes of every multibyte sequence while they're still easy to find
+    // from their lead byte, then reverse the whole string so they end up back in order.
+    // Runs of ASCII are skipped in bulk, so they're only touched by the final reversal.
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            i += sso_string_ascii_length(data + i, size - i);
+            continue;
+        }
+
+        size_t start = i++;
+        while(i < size && (data[i] & 0xC0) == 0x80)
+            i++;
+
+        unsigned char tmp = data[start];
+        data[start] = data[i - 1];
+        data[i - 1] = tmp;
+
+        // The outer bytes are all that need swapping for anything but a four byte
+        // sequence, or invalid UTF-8 with even more continuation bytes.
+        if(i - start > 3)
+            sso_string_reverse_bytes_impl(data + start + 1, i - start - 2);
+    }
+
+    sso_string_reverse_bytes_impl(data, size);
+}
+
+SSO_STRING_EXPORT bool string_join(
+    String* str, 
+    const String* separator,
+    const String* values,
+    size_t value_count)
+{
+    if(value_count == 0)
+        return true;
+
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(separator);
+    SSO_STRING_ASSERT_ARG(values);
+
+    // Put the joined values in a temporary variable to avoid
+    // altering the result string if the operation fails.
+
+    // Append the temp string to the result (str) at the end
+    // to finalize the operation.
+    bool result = false;
+    String temp = string_create("");
+
+    if(!string_append_string(&temp, values))
+        goto cleanup;
+
+    for(size_t i = 1; i < value_count; i++) {
+        if(!string_append_string(&temp, separator))
+            goto cleanup;
+
+        if(!string_append_string(&temp, values + i))
+            goto cleanup;
+    }
+
+    if(!string_append_string(str, &temp))
+        goto cleanup;
+
+    result = true;
+
+    cleanup:
+        string_free_resources(&temp);
+
+        return result;
+}
+
+SSO_STRING_EXPORT bool string_join_refs(
+    String* str,
+    const String* separator,
+    const String** values,
+    size_t value_count)
+{
+    if(value_count == 0)
+        return true;
+
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(separator);
+    SSO_STRING_ASSERT_ARG(values);
+
+    // Put the joined values in a temporary variable to avoid
+    // altering the result string if the operation fails.
+
+    // Append the temp string to the result (str) at the end
+    // to finalize the operation.
+    bool result = false;
+    String temp = string_create("");
+
+    if(!string_append_string(&temp, values[0]))
+        goto cleanup;
+
+    for(size_t i = 1; i < value_count; i++) {
+        if(!string_append_string(&temp, separator))
+            goto cleanup;
+
+        if(!string_append_string(&temp, values[i]))
+            goto cleanup;
+    }
 
     if(!string_append_string(str, &temp))
         goto cleanup;
 
-    result = true;
+    result = true;
+
+    cleanup:
+        string_free_resources(&temp);
+
+        return result;
+}
+
+SSO_STRING_EXPORT String* string_split(
+    const String* str,
+    const String* separator,
+    String* results,
+    int results_count,
+    int* results_filled,
+    bool skip_empty,
+    bool init_results)
+{
+    // Make sure the required inputs aren't NULL.
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(separator);
+
+    // results only needs to be initialized when results_count is > 0.
+    // On 0, it doesn't matter what state it is.
+    // On a negative number, results will be allocated by the function.
+    if(results_count > 0)
+        SSO_STRING_ASSERT_ARG(results);
+
+    // Nothing needs to happen if there is no room for results. Return immediately.
+    if(results_count == 0) {
+        *results_filled = 0;
+        return results;
+    }
+
+    // Determine if the results array needs to be allocated. If so, create an
+    // initial buffer that has space for two items. This is the starting space since
+    // splitting small items tends to be pretty common (e.g. an array of key-value pairs).
+    bool allocate_results = results_count < 0;
+    if(allocate_results) {
+        results_count = 2;
+        results = malloc(results_count * sizeof(*results));
+        if(!results)
+            return NULL;
+
+        // The results always have to be initialized by this function if the results array 
+        // was also created by it. UB otherwise.
+        init_results = true;
+    }
+
+    int count = 0;
+    size_t start = 0;
+    size_t size = string_size(str);
+
+    while(true) {
+        // Find the next instance of the separator. If the index is SIZE_MAX,
+        // the function reached the end of the string without finding it.
+        size_t next = string_find_string(str, start, separator);
+        if(next == SIZE_MAX)
+            next = size;
+
+        size_t copy_length = next - start;
+        if(copy_length != 0 || !skip_empty) {
+            // Add the string segment to the results array. If the value fails to be added,
+            // there was an allocation error, so just break out of the function right away.
+            if(init_results) {
+                if(!string_init_size(results + count, string_data(str) + start, copy_length))
+                    goto error;
+            } else {
+                if(!string_append_string_part(results + count, str, start, copy_length))
+                    goto error;
+            }
+
+            if(++count == results_count) {
+                if(allocate_results) {
+                    results_count *= 2;
+                    void* array = realloc(results, results_count * sizeof(*results));
+                    if(!array)
+                        goto error;
+
+                    results = array;
+                } else {
+                    *results_filled = count;
+                    return results;
+                }
+            }
+        }
+
+        start = next + string_size(separator);
+
+        // This indicates that the end of the string has been reached, and 
+        // that all relevant substrings have been copied into the results array.
+        if(start >= size) {
+            *results_filled = count;
+            return results;
+        }
+    }
+
+    error:
+        if(allocate_results)
+            free(results);
+
+        *results_filled = 0;
+        return NULL;
+}
+
+SSO_STRING_EXPORT String** string_split_refs(
+    const String* str,
+    const String* separator,
+    String** results,
+    int results_count,
+    int* results_filled,
+    bool skip_empty,
+    bool init_results) 
+{
+    // Make sure the required inputs aren't NULL.
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(separator);
+
+    // results only needs to be initialized when results_count is > 0.
+    // On 0, it doesn't matter what state it is.
+    // On a negative number, results will be allocated by the function.
+    if(results_count > 0)
+        SSO_STRING_ASSERT_ARG(results);
+
+    // Nothing needs to happen if there is no room for results. Return immediately.
+    if(results_count == 0) {
+        *results_filled = 0;
+        return results;
+    }
+
+    // Determine if the results array needs to be allocated. If so, create an
+    // initial buffer that has space for two items. This is the starting space since
+    // splitting small items tends to be pretty common (e.g. an array of key-value pairs).
+    bool allocate_results = results_count < 0;
+    if(allocate_results) {
+        results_count = 2;
+        results = malloc(results_count * sizeof(*results));
+        if(!results)
+            return NULL;
+
+        // The results always have to be initialized by this function if the results array 
+        // was also created by it. UB otherwise.
+        init_results = true;
+    }
+
+    int count = 0;
+    size_t start = 0;
+    size_t size = string_size(str);
+
+    while(true) {
+        // Find the next instance of the separator. If the index is SIZE_MAX,
+        // the function reached the end of the string without finding it.
+        size_t next = string_find_string(str, start, separator);
+        if(next == SIZE_MAX)
+            next = size;
+
+        size_t copy_length = next - start;
+        if(copy_length != 0 || !skip_empty) {
+            // Add the string segment to the results array. If the value fails to be added,
+            // there was an allocation error, so just break out of the function right away.
+            if(init_results) {
+                String* slice = string_create_ref("");
+                if(!slice)
+                    goto error;
+                results[count] = slice;
+            }
+
+            if(!string_append_string_part(results[count], str, start, copy_length))
+                goto error;
+
+            if(++count == results_count) {
+                if(allocate_results) {
+                    results_count *= 2;
+                    void* array = realloc(results, results_count * sizeof(*results));
+                    if(!array)
+                        goto error;
+
+                    results = array;
+                } else {
+                    *results_filled = count;
+                    return results;
+                }
+            }
+        }
+
+        start = next + string_size(separator);
+
+        // This indicates that the end of the string has been reached, and 
+        // that all relevant substrings have been copied into the results array.
+        if(start >= size) {
+            *results_filled = count;
+            return results;
+        }
+    }
+
+    error:
+        if(allocate_results) {
+            for(size_t i = 0; i < count; i++)
+                string_free(results[i]);
+
+            free(results);
+        }
+
+        *results_filled = 0;
+        return NULL;
+}
+
+// Number formatting. Every function measures its output first so it can be
+// written straight into the string's buffer after a single reserve, without
+// going through vsnprintf or depending on the locale.
+
+static const char sso_string_digit_pairs[200] = {
+    '0','0','0','1','0','2','0','3','0','4','0','5','0','6','0','7','0','8','0','9',
+    '1','0','1','1','1','2','1','3','1','4','1','5','1','6','1','7','1','8','1','9',
+    '2','0','2','1','2','2','2','3','2','4','2','5','2','6','2','7','2','8','2','9',
+    '3','0','3','1','3','2','3','3','3','4','3','5','3','6','3','7','3','8','3','9',
+    '4','0','4','1','4','2','4','3','4','4','4','5','4','6','4','7','4','8','4','9',
+    '5','0','5','1','5','2','5','3','5','4','5','5','5','6','5','7','5','8','5','9',
+    '6','0','6','1','6','2','6','3','6','4','6','5','6','6','6','7','6','8','6','9',
+    '7','0','7','1','7','2','7','3','7','4','7','5','7','6','7','7','7','8','7','9',
+    '8','0','8','1','8','2','8','3','8','4','8','5','8','6','8','7','8','8','8','9',
+    '9','0','9','1','9','2','9','3','9','4','9','5','9','6','9','7','9','8','9','9'
+};
+
+static inline int sso_string_decimal_length(uint64_t value) {
+    int length = 1;
+    for(;;) {
+        if(value < 10)
+            return length;
+        if(value < 100)
+            return length + 1;
+        if(value < 1000)
+            return length + 2;
+        if(value < 10000)
+            return length + 3;
+        value /= 10000;
+        length += 4;
+    }
+}
+
+// Writes the decimal digits of value so that the last one is just before end.
+static inline void sso_string_write_decimal(char* end, uint64_t value) {
+    // Splitting off 8 digits at a time keeps most of the divisions 32 bit.
+    while(value > UINT32_MAX) {
+        uint32_t low = (uint32_t)(value % 100000000);
+        value /= 100000000;
+        for(int i = 0; i < 4; i++) {
+            end -= 2;
+            memcpy(end, sso_string_digit_pairs + (low % 100) * 2, 2);
+            low /= 100;
+        }
+    }
+
+    uint32_t rest = (uint32_t)value;
+    while(rest >= 100) {
+        end -= 2;
+        memcpy(end, sso_string_digit_pairs + (rest % 100) * 2, 2);
+        rest /= 100;
+    }
+
+    if(rest >= 10) {
+        end -= 2;
+        memcpy(end, sso_string_digit_pairs + rest * 2, 2);
+    } else {
+        *--end = (char)('0' + rest);
+    }
+}
+
+// Makes room for count characters at the end of a string and returns where
+// they go. sso_string_append_commit has to be called once they're written.
+static inline char* sso_string_append_space(String* str, size_t count) {
+    if(!string_reserve(str, string_size(str) + count))
+        return NULL;
+
+    return string_cstr(str) + string_size(str);
+}
+
+static inline void sso_string_append_commit(String* str, size_t count) {
+    size_t size = string_size(str) + count;
+    sso_string_set_size(str, size);
+    string_cstr(str)[size] = 0;
+}
+
+static bool sso_string_append_decimal(String* str, uint64_t value, bool negative) {
+    size_t length = (size_t)sso_string_decimal_length(value) + negative;
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
+
+    out[0] = '-';
+    sso_string_write_decimal(out + length, value);
+    sso_string_append_commit(str, length);
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_append_int(String* str, int64_t value) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    // Negating in unsigned arithmetic handles INT64_MIN.
+    if(value < 0)
+        return sso_string_append_decimal(str, 0 - (uint64_t)value, true);
+
+    return sso_string_append_decimal(str, (uint64_t)value, false);
+}
+
+SSO_STRING_EXPORT bool string_append_uint(String* str, uint64_t value) {
+    SSO_STRING_ASSERT_ARG(str);
+    return sso_string_append_decimal(str, value, false);
+}
+
+// Gets the number of digits needed to write value in a power of 2 base.
+static inline int sso_string_radix_length(uint64_t value, int shift) {
+    int length = 1;
+    while((value >>= shift) != 0)
+        length++;
+    return length;
+}
+
+// Writes the digits of value in a power of 2 base so that the last one is just before end.
+static inline void sso_string_write_radix(char* end, uint64_t value, int shift, const char* digits) {
+    uint64_t mask = ((uint64_t)1 << shift) - 1;
+    do {
+        *--end = digits[value & mask];
+        value >>= shift;
+    } while(value != 0);
+}
+
+static const char sso_string_hex_lower[] = "0123456789abcdef";
+static const char sso_string_hex_upper[] = "0123456789ABCDEF";
+
+SSO_STRING_EXPORT bool string_append_hex(String* str, uint64_t value, bool uppercase) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    size_t length = (size_t)sso_string_radix_length(value, 4);
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
+
+    sso_string_write_radix(out + length, value, 4, uppercase ? sso_string_hex_upper : sso_string_hex_lower);
+    sso_string_append_commit(str, length);
+    return true;
+}
+
+// Doubles are converted with Ryu (Ulf Adams, "Ryu: Fast Float-to-String
+// Conversion", PLDI 2018), which finds the shortest decimal that rounds back
+// to the same double using a few 64x128 bit multiplications.
+//
+// The multipliers are 5^i and 2^k / 5^i scaled to 125 bits. Instead of storing
+// all ~600 of them, every 26th one is stored and the rest are computed by
+// multiplying with a power of 5 that fits in 64 bits. The offsets hold the
+// 2 bit correction that makes the computed value exact for each i, 16 per word.
+// All of the values were generated with arbitrary precision arithmetic and
+// checked against the full tables for every i.
+
+#define SSO_STRING_POW5_BITS 125
+#define SSO_STRING_POW5_TABLE_SIZE 26
+
+static const uint64_t sso_string_pow5_table[SSO_STRING_POW5_TABLE_SIZE] = {
+    1ull, 5ull, 25ull, 125ull, 625ull, 3125ull, 15625ull, 78125ull, 390625ull,
+    1953125ull, 9765625ull, 48828125ull, 244140625ull, 1220703125ull, 6103515625ull,
+    30517578125ull, 152587890625ull, 762939453125ull, 3814697265625ull,
+    19073486328125ull, 95367431640625ull, 476837158203125ull, 2384185791015625ull,
+    11920928955078125ull, 59604644775390625ull, 298023223876953125ull
+};
+
+// 5^(26 * i) as { low, high }.
+static const uint64_t sso_string_pow5_split[13][2] = {
+    { 0x0000000000000000, 0x1000000000000000 },
+    { 0x0000000000000000, 0x14ADF4B7320334B9 },
+    { 0x0E549208B31ADB10, 0x1ABA4714957D300D },
+    { 0x6DC6AD264D8F0866, 0x1145B7E285BF98F5 },
+    { 0xEB1DBD923D8596CA, 0x1652EFDC6018A1FC },
+    { 0xB4C1B80B22AE923C, 0x1CDA62055B2D9D83 },
+    { 0x5BB28B4E8F7E4C30, 0x12A5568B9F52F416 },
+    { 0xF08AED437682D4FB, 0x1819651531F9E78F },
+    { 0xB4EE134AD99BF150, 0x1F25C186A6F04C28 },
+    { 0x16499ECB70C25F03, 0x1420EB449C8842E6 },
+    { 0x85A56EAD360865B0, 0x1A03FDE214CAF085 },
+    { 0x093DB1D57999890B, 0x10CFEB353A97DAD8 },
+    { 0xCF38BB735E3F36AC, 0x15BAAF44FA52673E }
+};
+
+static const uint32_t sso_string_pow5_offsets[21] = {
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x40000000, 0x59695995,
+    0x55545555, 0x56555515, 0x41150504, 0x40555410, 0x44555145, 0x44504540,
+    0x45555550, 0x40004000, 0x96440440, 0x55565565, 0x54454045, 0x40154151,
+    0x55559155, 0x51405555, 0x00000105
+};
+
+// 2^k / 5^(26 * i) + 1 as { low, high }.
+static const uint64_t sso_string_pow5_inv_split[13][2] = {
+    { 0x0000000000000001, 0x2000000000000000 },
+    { 0x52A6C95FC0655034, 0x18C240C4AECB13BB },
+    { 0x7CA8D50071DFC806, 0x1327FC58DA0F6FF5 },
+    { 0x6520247D3556476E, 0x1DA48CE468E7C702 },
+    { 0x6139CDD76802E6E9, 0x16EF5B40C2FC7779 },
+    { 0xF951A7FF43DE8C79, 0x11BEBDF578B2F391 },
+    { 0x7BE8BEE8D6E957E8, 0x1B758D848FAC54B0 },
+    { 0x8BD3F9E999A423EA, 0x153EDA614071A3B7 },
+    { 0x0848F973CB3EE3CE, 0x10701BD527B4978C },
+    { 0x153285EBB9EFBFA2, 0x196FBB9BB44DB44D },
+    { 0xADEEE7F86C07B696, 0x13AE3591F5B4D936 },
+    { 0x4D686A4EAF182222, 0x1E74404F3DAADA91 },
+    { 0x98C0A106E09EBD9F, 0x17900EA4FDA7C257 }
+};
+
+static const uint32_t sso_string_pow5_inv_offsets[19] = {
+    0x54544554, 0x04055545, 0x10041000, 0x00400414, 0x40010000, 0x41155555,
+    0x00000454, 0x00010044, 0x40000000, 0x44000041, 0x50454450, 0x55550054,
+    0x51655554, 0x40004000, 0x01000001, 0x00010500, 0x51515411, 0x05555554,
+    0x50411500
+};
+
+static inline uint64_t sso_string_umul128(uint64_t a, uint64_t b, uint64_t* high) {
+#if defined(__SIZEOF_INT128__)
+    __extension__ unsigned __int128 product = (unsigned __int128)a * b;
+    *high = (uint64_t)(product >> 64);
+    return (uint64_t)product;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return _umul128(a, b, high);
+#else
+    uint64_t a_low = (uint32_t)a;
+    uint64_t a_high = a >> 32;
+    uint64_t b_low = (uint32_t)b;
+    uint64_t b_high = b >> 32;
+
+    uint64_t low_low = a_low * b_low;
+    uint64_t middle = a_high * b_low + (low_low >> 32);
+    uint64_t middle2 = a_low * b_high + (uint32_t)middle;
+
+    *high = a_high * b_high + (middle >> 32) + (middle2 >> 32);
+    return (middle2 << 32) | (uint32_t)low_low;
+#endif
+}
+
+// Shifts a 128 bit value right by 0 < shift < 64 bits.
+static inline uint64_t sso_string_shift_right128(uint64_t low, uint64_t high, uint32_t shift) {
+    return (high << (64 - shift)) | (low >> shift);
+}
+
+// ceil(log2(5^e)) for 0 < e <= 3528, and 1 for e == 0.
+static inline int32_t sso_string_pow5_bits(int32_t e) {
+    return (int32_t)(((uint32_t)e * 1217359) >> 19) + 1;
+}
+
+// floor(log10(2^e)) for 0 <= e <= 1650.
+static inline uint32_t sso_string_log10_pow2(int32_t e) {
+    return ((uint32_t)e * 78913) >> 18;
+}
+
+// floor(log10(5^e)) for 0 <= e <= 2620.
+static inline uint32_t sso_string_log10_pow5(int32_t e) {
+    return ((uint32_t)e * 732923) >> 20;
+}
+
+static inline bool sso_string_multiple_of_pow5(uint64_t value, uint32_t p) {
+    uint32_t count = 0;
+    while(value % 5 == 0) {
+        value /= 5;
+        count++;
+    }
+    return count >= p;
+}
+
+static inline bool sso_string_multiple_of_pow2(uint64_t value, uint32_t p) {
+    return (value & ((1ull << p) - 1)) == 0;
+}
+
+static inline void sso_string_compute_pow5(uint32_t i, uint64_t* result) {
+    uint32_t base = i / SSO_STRING_POW5_TABLE_SIZE;
+    uint32_t base2 = base * SSO_STRING_POW5_TABLE_SIZE;
+    uint32_t offset = i - base2;
+    const uint64_t* mul = sso_string_pow5_split[base];
+    if(offset == 0) {
+        result[0] = mul[0];
+        result[1] = mul[1];
+        return;
+    }
+
+    uint64_t m = sso_string_pow5_table[offset];
+    uint64_t high1, high0;
+    uint64_t low1 = sso_string_umul128(m, mul[1], &high1);
+    uint64_t low0 = sso_string_umul128(m, mul[0], &high0);
+    uint64_t sum = high0 + low1;
+    if(sum < high0)
+        high1++;
+
+    uint32_t shift = (uint32_t)(sso_string_pow5_bits((int32_t)i) - sso_string_pow5_bits((int32_t)base2));
+    result[0] = sso_string_shift_right128(low0, sum, shift) + ((sso_string_pow5_offsets[i / 16] >> ((i % 16) << 1)) & 3);
+    result[1] = sso_string_shift_right128(sum, high1, shift);
+}
+
+static inline void sso_string_compute_inv_pow5(uint32_t i, uint64_t* result) {
+    uint32_t base = (i + SSO_STRING_POW5_TABLE_SIZE - 1) / SSO_STRING_POW5_TABLE_SIZE;
+    uint32_t base2 = base * SSO_STRING_POW5_TABLE_SIZE;
+    uint32_t offset = base2 - i;
+    const uint64_t* mul = sso_string_pow5_inv_split[base];
+    if(offset == 0) {
+        result[0] = mul[0];
+        result[1] = mul[1];
+        return;
+    }
+
+    uint64_t m = sso_string_pow5_table[offset];
+    uint64_t high1, high0;
+    uint64_t low1 = sso_string_umul128(m, mul[1], &high1);
+    uint64_t low0 = sso_string_umul128(m, mul[0] - 1, &high0);
+    uint64_t sum = high0 + low1;
+    if(sum < high0)
+        high1++;
+
+    uint32_t shift = (uint32_t)(sso_string_pow5_bits((int32_t)base2) - sso_string_pow5_bits((int32_t)i));
+    result[0] = sso_string_shift_right128(low0, sum, shift) + 1 + ((sso_string_pow5_inv_offsets[i / 16] >> ((i % 16) << 1)) & 3);
+    result[1] = sso_string_shift_right128(sum, high1, shift);
+}
+
+// Computes (m * mul) >> j for a 55 bit m and 64 < j < 128.
+static inline uint64_t sso_string_mul_shift64(uint64_t m, const uint64_t* mul, int32_t j) {
+    uint64_t high1, high0;
+    uint64_t low1 = sso_string_umul128(m, mul[1], &high1);
+    sso_string_umul128(m, mul[0], &high0);
+    uint64_t sum = high0 + low1;
+    if(sum < high0)
+        high1++;
+
+    return sso_string_shift_right128(sum, high1, (uint32_t)(j - 64));
+}
+
+// Converts a finite, non-zero double to the shortest decimal mantissa and
+// exponent that round trip.
+static void sso_string_double_to_decimal(uint64_t ieee_mantissa, uint32_t ieee_exponent, uint64_t* out_mantissa, int32_t* out_exponent) {
+    // Integers below 2^53 are their own shortest representation once their
+    // trailing zeros are removed.
+    int32_t exact_e2 = (int32_t)ieee_exponent - 1023 - 52;
+    if(ieee_exponent != 0 && exact_e2 <= 0 && exact_e2 >= -52) {
+        uint64_t m2 = (1ull << 52) | ieee_mantissa;
+        if((m2 & ((1ull << -exact_e2) - 1)) == 0) {
+            uint64_t value = m2 >> -exact_e2;
+            int32_t exponent = 0;
+            while(value % 10 == 0) {
+                value /= 10;
+                exponent++;
+            }
+            *out_mantissa = value;
+            *out_exponent = exponent;
+            return;
+        }
+    }
+
+    int32_t e2;
+    uint64_t m2;
+    if(ieee_exponent == 0) {
+        e2 = 1 - 1023 - 52 - 2;
+        m2 = ieee_mantissa;
+    } else {
+        e2 = (int32_t)ieee_exponent - 1023 - 52 - 2;
+        m2 = (1ull << 52) | ieee_mantissa;
+    }
+
+    // The halfway points between this double and its neighbours round to it
+    // when the mantissa is even. The lower neighbour is closer when the
+    // mantissa is a power of 2.
+    bool accept_bounds = (m2 & 1) == 0;
+    uint64_t mv = 4 * m2;
+    uint32_t mm_shift = ieee_mantissa != 0 || ieee_exponent <= 1;
+
+    uint64_t vr, vp, vm;
+    int32_t e10;
+    bool vm_trailing_zeros = false;
+    bool vr_trailing_zeros = false;
+    uint64_t pow5[2];
+
+    if(e2 >= 0) {
+        uint32_t q = sso_string_log10_pow2(e2) - (e2 > 3);
+        e10 = (int32_t)q;
+        int32_t k = SSO_STRING_POW5_BITS + sso_string_pow5_bits((int32_t)q) - 1;
+        int32_t i = -e2 + (int32_t)q + k;
+        sso_string_compute_inv_pow5(q, pow5);
+        vr = sso_string_mul_shift64(4 * m2, pow5, i);
+        vp = sso_string_mul_shift64(4 * m2 + 2, pow5, i);
+        vm = sso_string_mul_shift64(4 * m2 - 1 - mm_shift, pow5, i);
+        if(q <= 21) {
+            // Only one of mp, mv and mm can be a multiple of 5, if any.
+            if(mv % 5 == 0)
+                vr_trailing_zeros = sso_string_multiple_of_pow5(mv, q);
+            else if(accept_bounds)
+                vm_trailing_zeros = sso_string_multiple_of_pow5(mv - 1 - mm_shift, q);
+            else
+                vp -= sso_string_multiple_of_pow5(mv + 2, q);
+        }
+    } else {
+        uint32_t q = sso_string_log10_pow5(-e2) - (-e2 > 1);
+        e10 = (int32_t)q + e2;
+        int32_t i = -e2 - (int32_t)q;
+        int32_t k = sso_string_pow5_bits(i) - SSO_STRING_POW5_BITS;
+        int32_t j = (int32_t)q - k;
+        sso_string_compute_pow5((uint32_t)i, pow5);
+        vr = sso_string_mul_shift64(4 * m2, pow5, j);
+        vp = sso_string_mul_shift64(4 * m2 + 2, pow5, j);
+        vm = sso_string_mul_shift64(4 * m2 - 1 - mm_shift, pow5, j);
+        if(q <= 1) {
+            // mv = 4 * m2 always has at least 2 trailing zero bits.
+            vr_trailing_zeros = true;
+            if(accept_bounds)
+                vm_trailing_zeros = mm_shift == 1;
+            else
+                vp--;
+        } else if(q < 63) {
+            vr_trailing_zeros = sso_string_multiple_of_pow2(mv, q);
+        }
+    }
+
+    // Remove digits while the bounds still differ, keeping track of the last
+    // removed digit to round the result.
+    int32_t removed = 0;
+    uint64_t output;
+    if(vm_trailing_zeros || vr_trailing_zeros) {
+        // The rare general case, where the bounds or the value are exact.
+        unsigned last_removed = 0;
+        while(vp / 10 > vm / 10) {
+            vm_trailing_zeros &= vm % 10 == 0;
+            vr_trailing_zeros &= last_removed == 0;
+            last_removed = (unsigned)(vr % 10);
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        if(vm_trailing_zeros) {
+            while(vm % 10 == 0) {
+                vr_trailing_zeros &= last_removed == 0;
+                last_removed = (unsigned)(vr % 10);
+                vr /= 10;
+                vp /= 10;
+                vm /= 10;
+                removed++;
+            }
+        }
+
+        // Round half to even when the exact value ends in 5 followed by zeros.
+        if(vr_trailing_zeros && last_removed == 5 && vr % 2 == 0)
+            last_removed = 4;
+
+        output = vr + ((vr == vm && (!accept_bounds || !vm_trailing_zeros)) || last_removed >= 5);
+    } else {
+        bool round_up = false;
+        if(vp / 100 > vm / 100) {
+            round_up = vr % 100 >= 50;
+            vr /= 100;
+            vp /= 100;
+            vm /= 100;
+            removed += 2;
+        }
+
+        while(vp / 10 > vm / 10) {
+            round_up = vr % 10 >= 5;
+            vr /= 10;
+            vp /= 10;
+            vm /= 10;
+            removed++;
+        }
+
+        output = vr + (vr == vm || round_up);
+    }
+
+    *out_mantissa = output;
+    *out_exponent = e10 + removed;
+}
+
+// The shortest representation of a double, split into the parts needed to
+// measure it before writing it.
+typedef struct SsoShortestDouble {
+    // Set for infinities and NaN, which are written as is.
+    const char* special;
+    uint64_t mantissa;
+    int32_t digits;
+    // The value is 0.[digits] * 10^point.
+    int32_t point;
+    bool negative;
+    // The number of characters, not including the sign.
+    size_t length;
+} SsoShortestDouble;
+
+static void sso_string_shortest_double(double value, SsoShortestDouble* out) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t ieee_mantissa = bits & ((1ull << 52) - 1);
+    uint32_t ieee_exponent = (uint32_t)((bits >> 52) & 0x7FF);
+
+    out->negative = (bits >> 63) != 0;
+    out->special = NULL;
+
+    if(ieee_exponent == 0x7FF) {
+        out->special = ieee_mantissa != 0 ? "nan" : "inf";
+        out->negative = out->negative && ieee_mantissa == 0;
+        out->length = 3;
+        return;
+    }
+
+    if(ieee_exponent == 0 && ieee_mantissa == 0) {
+        out->mantissa = 0;
+        out->digits = 1;
+        out->point = 1;
+        out->length = 1;
+        return;
+    }
+
+    int32_t exponent;
+    sso_string_double_to_decimal(ieee_mantissa, ieee_exponent, &out->mantissa, &exponent);
+
+    int32_t digits = sso_string_decimal_length(out->mantissa);
+    int32_t point = digits + exponent;
+    int32_t exponent10 = point - 1;
+    out->digits = digits;
+    out->point = point;
+
+    if(digits <= point && point <= 21) {
+        out->length = (size_t)point;
+    } else if(0 < point && point <= 21) {
+        out->length = (size_t)digits + 1;
+    } else if(-6 < point && point <= 0) {
+        out->length = (size_t)(2 - point + digits);
+    } else {
+        out->length = (size_t)(digits + (digits > 1) + 2);
+        out->length += exponent10 <= -100 || exponent10 >= 100 ? 3 : (exponent10 <= -10 || exponent10 >= 10 ? 2 : 1);
+    }
+}
+
+// Writes the characters measured by sso_string_shortest_double, without the sign.
+static void sso_string_write_shortest_double(char* out, const SsoShortestDouble* value) {
+    uint64_t mantissa = value->mantissa;
+    int32_t digits = value->digits;
+    int32_t point = value->point;
+
+    if(value->special) {
+        memcpy(out, value->special, 3);
+    } else if(digits <= point && point <= 21) {
+        // An integer, padded with zeros.
+        sso_string_write_decimal(out + digits, mantissa);
+        memset(out + digits, '0', (size_t)(point - digits));
+    } else if(0 < point && point <= 21) {
+        // Write the digits one place to the right, then move the integer part
+        // back to make room for the decimal point.
+        sso_string_write_decimal(out + 1 + digits, mantissa);
+        memmove(out, out + 1, (size_t)point);
+        out[point] = '.';
+    } else if(-6 < point && point <= 0) {
+        out[0] = '0';
+        out[1] = '.';
+        memset(out + 2, '0', (size_t)-point);
+        sso_string_write_decimal(out + 2 - point + digits, mantissa);
+    } else {
+        int32_t exponent10 = point - 1;
+        sso_string_write_decimal(out + 1 + digits, mantissa);
+        out[0] = out[1];
+        if(digits > 1) {
+            out[1] = '.';
+            out += digits + 1;
+        } else {
+            out += 1;
+        }
+
+        *out++ = 'e';
+        *out++ = exponent10 < 0 ? '-' : '+';
+        uint32_t magnitude = (uint32_t)(exponent10 < 0 ? -exponent10 : exponent10);
+        sso_string_write_decimal(out + sso_string_decimal_length(magnitude), magnitude);
+    }
+}
+
+SSO_STRING_EXPORT bool string_append_double(String* str, double value) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    SsoShortestDouble shortest;
+    sso_string_shortest_double(value, &shortest);
+
+    size_t length = shortest.length + shortest.negative;
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
+
+    if(shortest.negative)
+        *out++ = '-';
+
+    sso_string_write_shortest_double(out, &shortest);
+    sso_string_append_commit(str, length);
+    return true;
+}
+
+SSO_STRING_EXPORT String* string_format_string(String* result, const String* format, ...) {
+    va_list argp;
+
+    va_start(argp, format);
+
+    result = string_format_args_cstr(result, string_data(format), argp);
+
+    va_end(argp);
+
+    return result;
+}
+
+SSO_STRING_EXPORT String* string_format_cstr(String* result, const char* format, ...) {
+    va_list argp;
+
+    va_start(argp, format);
+
+    result = string_format_args_cstr(result, format, argp);
+
+    va_end(argp);
+
+    return result;
+}
+
+SSO_STRING_EXPORT String* string_format_args_string(String* result, const String* format, va_list argp) {
+    return string_format_args_cstr(result, string_data(format), argp);
+}
+
+// The output size of the last call with each format string, keyed by the
+// format's address. Format strings are almost always literals, so the address
+// identifies the call site, and the next call from it can reserve enough space
+// up front to format in a single pass. Without thread local storage the hints
+// can't be shared safely, so they are disabled.
+
+#define SSO_STRING_FORMAT_HINTS 64
+
+typedef struct SsoFormatHint {
+    const char* format;
+    size_t size;
+} SsoFormatHint;
+
+#ifdef SSO_THREAD_LOCAL
+
+static SSO_THREAD_LOCAL SsoFormatHint sso_string_format_hints[SSO_STRING_FORMAT_HINTS];
+
+static inline SsoFormatHint* sso_string_format_hint(const char* format) {
+    uint64_t key = (uint64_t)(uintptr_t)format * UINT64_C(0x9E3779B97F4A7C15);
+    return sso_string_format_hints + ((key >> 32) & (SSO_STRING_FORMAT_HINTS - 1));
+}
+
+#else
+
+static inline SsoFormatHint* sso_string_format_hint(const char* format) {
+    (void)format;
+    return NULL;
+}
+
+#endif
+
+SSO_STRING_EXPORT String* string_format_args_cstr(String* result, const char* format, va_list argp) {
+    SSO_STRING_ASSERT_ARG(format);
+
+    size_t original_size = SIZE_MAX;
+    if(!result) {
+        result = string_create_ref("");
+        if(!result)
+            return NULL;
+        
+    } else {
+        original_size = string_size(result);
+    }
+
+    size_t size = string_size(result);
+    SsoFormatHint* hint = sso_string_format_hint(format);
+
+    if(hint && hint->format == format && !string_reserve(result, size + hint->size))
+        goto error;
+
+    // Format straight into the spare capacity (including the inline buffer of
+    // short strings). argp has to be used again if that space is too small, so
+    // make a copy of it to be used with the initial format.
+    size_t available = string_capacity(result) - size;
+
+    va_list copy;
+    va_copy(copy, argp);
+
+    int written = vsnprintf(string_cstr(result) + size, available + 1, format, copy);
+    va_end(copy);
+
+    if(written < 0)
+        goto error;
+
+    if((size_t)written > available) {
+        if(!string_reserve(result, size + written))
+            goto error;
+
+        written = vsnprintf(string_cstr(result) + size, written + 1, format, argp);
+
+        if(written < 0)
+            goto error;
+    }
+
+    sso_string_set_size(result, size + written);
+
+    if(hint) {
+        hint->format = format;
+        hint->size = written;
+    }
+
+    return result;
+
+    error:
+        if(original_size == SIZE_MAX)
+            string_free(result);
+        else
+            string_cstr(result)[original_size] = '\0';
+
+        return NULL;
+}
+
+// Exact float formatting. Every double is a binary fraction, so it has a finite
+// decimal expansion, which is rounded half to even to the requested number of
+// digits. printf's %f and %e and the f and e brace types are written this way,
+// which unlike snprintf doesn't depend on the locale.
+
+// The most digits the exact expansion of a double can have (5^1074 * 2^53 has 767).
+#define SSO_STRING_DOUBLE_EXACT_DIGITS 810
+
+static void sso_string_limbs_multiply(uint32_t* limbs, size_t* count, uint32_t factor) {
+    uint64_t carry = 0;
+    for(size_t i = 0; i < *count; i++) {
+        uint64_t product = (uint64_t)limbs[i] * factor + carry;
+        limbs[i] = (uint32_t)(product % 1000000000);
+        carry = product / 1000000000;
+    }
+
+    while(carry != 0) {
+        limbs[(*count)++] = (uint32_t)(carry % 1000000000);
+        carry /= 1000000000;
+    }
+}
+
+// Writes the exact decimal digits of m * 2^e2 (m != 0) without the trailing
+// zeros and returns how many there are. The value is 0.[digits] * 10^point.
+// The digits are those of m * 2^e2 when e2 >= 0, or of m * 5^-e2 with the
+// decimal point moved -e2 places to the left otherwise. m * 2^e2 has to be at
+// most twice as precise as a double, which covers the midpoints between doubles.
+static size_t sso_string_binary_exact_digits(uint64_t m, int32_t e2, char* digits, int32_t* point) {
+    // Base 10^9 limbs, least significant first.
+    uint32_t limbs[SSO_STRING_DOUBLE_EXACT_DIGITS / 9];
+    size_t count = 0;
+    while(m != 0) {
+        limbs[count++] = (uint32_t)(m % 1000000000);
+        m /= 1000000000;
+    }
+
+    int32_t shift = 0;
+    if(e2 >= 0) {
+        for(; e2 >= 29; e2 -= 29)
+            sso_string_limbs_multiply(limbs, &count, 1u << 29);
+        if(e2 != 0)
+            sso_string_limbs_multiply(limbs, &count, 1u << e2);
+    } else {
+        shift = -e2;
+        int32_t k = shift;
+        for(; k >= 13; k -= 13)
+            sso_string_limbs_multiply(limbs, &count, 1220703125u);
+        if(k != 0)
+            sso_string_limbs_multiply(limbs, &count, (uint32_t)sso_string_pow5_table[k]);
+    }
+
+    size_t length = (size_t)sso_string_decimal_length(limbs[count - 1]);
+    sso_string_write_decimal(digits + length, limbs[count - 1]);
+    for(size_t i = count - 1; i > 0; i--) {
+        uint32_t limb = limbs[i - 1];
+        for(int j = 8; j >= 0; j--) {
+            digits[length + (size_t)j] = (char)('0' + limb % 10);
+            limb /= 10;
+        }
+        length += 9;
+    }
+
+    *point = (int32_t)length - shift;
+    while(digits[length - 1] == '0')
+        length--;
+
+    return length;
+}
+
+static inline void sso_string_double_decode(uint64_t bits, uint64_t* m, int32_t* e2) {
+    *m = bits & ((1ull << 52) - 1);
+    int32_t ieee_exponent = (int32_t)((bits >> 52) & 0x7FF);
+    *e2 = 1 - 1075;
+    if(ieee_exponent != 0) {
+        *m |= 1ull << 52;
+        *e2 = ieee_exponent - 1075;
+    }
+}
+
+// Writes the exact decimal digits of a finite, non-zero double. See sso_string_binary_exact_digits.
+static size_t sso_string_double_exact_digits(double value, char* digits, int32_t* point) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    uint64_t m;
+    int32_t e2;
+    sso_string_double_decode(bits, &m, &e2);
+    return sso_string_binary_exact_digits(m, e2, digits, point);
+}
+
+// Rounds exact digits half to even so only the first keep digits are left,
+// and returns how many digits are left. A carry out of the first digit makes
+// the digits "1" and increments the point.
+static size_t sso_string_round_digits(char* digits, size_t length, ptrdiff_t keep, int32_t* point) {
+    if(keep < 0)
+        return 0;
+    if((size_t)keep >= length)
+        return length;
+
+    size_t kept = (size_t)keep;
+    char next = digits[kept];
+    // Trailing zeros were removed, so any digits after the next one make it more than half.
+    bool round_up = next > '5' || (next == '5' && (kept + 1 < length || (kept > 0 && ((digits[kept - 1] - '0') & 1))));
+    if(!round_up)
+        return kept;
+
+    size_t i = kept;
+    while(i > 0 && digits[i - 1] == '9')
+        i--;
+
+    if(i == 0) {
+        digits[0] = '1';
+        (*point)++;
+        return 1;
+    }
+
+    digits[i - 1]++;
+    return i;
+}
+
+// A finite double rounded for %f or %e style output, without its sign.
+typedef struct SsoFixedDouble {
+    char digits[SSO_STRING_DOUBLE_EXACT_DIGITS];
+    size_t count;
+    // The value is 0.[digits] * 10^point.
+    int32_t point;
+    int precision;
+    bool exponential;
+    // Whether the decimal point is written when the precision is 0.
+    bool force_point;
+    // The number of characters, not including the sign.
+    size_t length;
+} SsoFixedDouble;
+
+// Rounds a finite double to precision decimals, or to precision decimals after
+// the first significant digit when exponential is set. The sign is ignored.
+static void sso_string_fixed_double(double value, int precision, bool exponential, bool force_point, SsoFixedDouble* out) {
+    out->precision = precision;
+    out->exponential = exponential;
+    out->force_point = force_point;
+    out->point = 1;
+    out->count = 0;
+    if(value != 0)
+        out->count = sso_string_double_exact_digits(value, out->digits, &out->point);
+
+    size_t fraction = (precision > 0 || force_point ? 1 : 0) + (size_t)precision;
+    if(exponential) {
+        out->count = sso_string_round_digits(out->digits, out->count, (ptrdiff_t)precision + 1, &out->point);
+        int32_t exponent10 = out->count == 0 ? 0 : out->point - 1;
+        uint32_t magnitude = (uint32_t)(exponent10 < 0 ? -exponent10 : exponent10);
+        int exponent_digits = sso_string_decimal_length(magnitude);
+        out->length = 1 + fraction + 2 + (size_t)(exponent_digits < 2 ? 2 : exponent_digits);
+    } else {
+        out->count = sso_string_round_digits(out->digits, out->count, (ptrdiff_t)out->point + precision, &out->point);
+        if(out->count == 0)
+            out->point = 1;
+        out->length = (size_t)(out->point > 0 ? out->point : 1) + fraction;
+    }
+}
+
+static void sso_string_write_fixed_double(char* out, const SsoFixedDouble* value, bool upper) {
+    const char* digits = value->digits;
+    size_t count = value->count;
+    int32_t point = value->point;
+    int precision = value->precision;
+    bool dot = precision > 0 || value->force_point;
+
+    if(value->exponential) {
+        *out++ = count > 0 ? digits[0] : '0';
+        if(dot)
+            *out++ = '.';
+        for(size_t i = 1; i <= (size_t)precision; i++)
+            *out++ = i < count ? digits[i] : '0';
+
+        int32_t exponent10 = count == 0 ? 0 : point - 1;
+        *out++ = upper ? 'E' : 'e';
+        *out++ = exponent10 < 0 ? '-' : '+';
+        uint32_t magnitude = (uint32_t)(exponent10 < 0 ? -exponent10 : exponent10);
+        if(magnitude < 10)
+            *out++ = '0';
+        sso_string_write_decimal(out + sso_string_decimal_length(magnitude), magnitude);
+        return;
+    }
+
+    if(point <= 0) {
+        *out++ = '0';
+    } else {
+        for(int32_t i = 0; i < point; i++)
+            *out++ = (size_t)i < count ? digits[i] : '0';
+    }
+
+    if(dot)
+        *out++ = '.';
+    for(int32_t i = point; i < point + precision; i++)
+        *out++ = i >= 0 && (size_t)i < count ? digits[i] : '0';
+}
+
+// Compiled formats. string_format_compile parses a printf format into a list
+// of ops once. Literal text is copied into the format's own buffer with %%
+// already collapsed, and every directive records its conversion, flags, width
+// and precision, so applying the format is a switch per op.
+
+enum {
+    SSO_FORMAT_LITERAL,
+    SSO_FORMAT_SIGNED,
+    SSO_FORMAT_UNSIGNED,
+    SSO_FORMAT_CHAR,
+    SSO_FORMAT_STRING,
+    SSO_FORMAT_POINTER,
+    // %f and %F.
+    SSO_FORMAT_FIXED,
+    // %e and %E.
+    SSO_FORMAT_EXPONENT,
+    // %g, %a and long doubles, which go through snprintf.
+    SSO_FORMAT_FLOAT
+};
+
+enum {
+    SSO_FORMAT_LEFT = 1,
+    SSO_FORMAT_PLUS = 2,
+    SSO_FORMAT_SPACE = 4,
+    SSO_FORMAT_ALT = 8,
+    SSO_FORMAT_ZERO = 16,
+    SSO_FORMAT_UPPER = 32
+};
+
+// The length modifiers.
+enum {
+    SSO_FORMAT_DEFAULT,
+    SSO_FORMAT_HH,
+    SSO_FORMAT_H,
+    SSO_FORMAT_L,
+    SSO_FORMAT_LL,
+    SSO_FORMAT_J,
+    SSO_FORMAT_Z,
+    SSO_FORMAT_T,
+    SSO_FORMAT_LONG_DOUBLE
+};
+
+// Width and precision values for a directive that doesn't have one, or that
+// takes it from the arguments.
+#define SSO_FORMAT_NONE -1
+#define SSO_FORMAT_ARGUMENT -2
+
+typedef struct StringFormatOp {
+    unsigned char kind;
+    unsigned char flags;
+    unsigned char length;
+    // 10, 16 or 8 for integers.
+    unsigned char base;
+    int width;
+    int precision;
+    // The span of literal text in the format's buffer. For SSO_FORMAT_FLOAT this
+    // is the NULL terminated spec that's passed to snprintf.
+    size_t start;
+    size_t count;
+} StringFormatOp;
+
+struct StringFormat {
+    StringFormatOp* ops;
+    size_t count;
+    char* text;
+    // The number of bytes reserved before applying the ops.
+    size_t estimate;
+};
+
+// Parses a width or precision. Returns false if it doesn't fit in an int.
+static bool sso_string_format_parse_number(const char** format, int* out_value) {
+    const char* c = *format;
+    int value = 0;
+    while(*c >= '0' && *c <= '9') {
+        if(value > (INT_MAX - (*c - '0')) / 10)
+            return false;
+        value = value * 10 + (*c++ - '0');
+    }
+
+    *format = c;
+    *out_value = value;
+    return true;
+}
+
+// Gets a rough size of the output of an op to reserve up front.
+static size_t sso_string_format_op_estimate(const StringFormatOp* op) {
+    size_t estimate;
+    switch(op->kind) {
+        case SSO_FORMAT_LITERAL:
+            return op->count;
+        case SSO_FORMAT_SIGNED:
+        case SSO_FORMAT_UNSIGNED:
+            estimate = op->length == SSO_FORMAT_DEFAULT || op->length == SSO_FORMAT_H || op->length == SSO_FORMAT_HH ? 11 : 20;
+            break;
+        case SSO_FORMAT_CHAR:
+            estimate = 1;
+            break;
+        case SSO_FORMAT_STRING:
+            estimate = op->precision >= 0 ? (size_t)op->precision : 16;
+            break;
+        case SSO_FORMAT_POINTER:
+            estimate = 18;
+            break;
+        default:
+            estimate = 24;
+            break;
+    }
+
+    if(op->width > 0 && (size_t)op->width > estimate)
+        estimate = (size_t)op->width;
+
+    return estimate;
+}
+
+SSO_STRING_EXPORT StringFormat* string_format_compile(const char* format) {
+    SSO_STRING_ASSERT_ARG(format);
+
+    // Every directive starts with a '%', so counting them bounds the number of
+    // ops, and the size of the float specs that are stored with the text.
+    size_t length = strlen(format);
+    size_t directives = 0;
+    for(const char* c = strchr(format, '%'); c; c = strchr(c + 1, '%'))
+        directives++;
+
+    size_t op_capacity = directives * 2 + 1;
+    StringFormat* result = malloc(sizeof(StringFormat) + op_capacity * sizeof(StringFormatOp) + length + directives * 12 + 1);
+    if(!result)
+        return NULL;
+
+    result->ops = (StringFormatOp*)(result + 1);
+    result->text = (char*)(result->ops + op_capacity);
+    result->count = 0;
+    result->estimate = 0;
+
+    char* text = result->text;
+    size_t text_size = 0;
+    size_t literal_start = 0;
+    const char* c = format;
+
+    while(*c) {
+        if(*c != '%') {
+            text[text_size++] = *c++;
+            continue;
+        }
+
+        if(c[1] == '%') {
+            text[text_size++] = '%';
+            c += 2;
+            continue;
+        }
+
+        if(text_size != literal_start) {
+            StringFormatOp* literal = result->ops + result->count++;
+            memset(literal, 0, sizeof(*literal));
+            literal->kind = SSO_FORMAT_LITERAL;
+            literal->start = literal_start;
+            literal->count = text_size - literal_start;
+        }
+
+        StringFormatOp* op = result->ops + result->count++;
+        memset(op, 0, sizeof(*op));
+        op->width = SSO_FORMAT_NONE;
+        op->precision = SSO_FORMAT_NONE;
+        c++;
+
+        for(;; c++) {
+            if(*c == '-')
+                op->flags |= SSO_FORMAT_LEFT;
+            else if(*c == '+')
+                op->flags |= SSO_FORMAT_PLUS;
+            else if(*c == ' ')
+                op->flags |= SSO_FORMAT_SPACE;
+            else if(*c == '#')
+                op->flags |= SSO_FORMAT_ALT;
+            else if(*c == '0')
+                op->flags |= SSO_FORMAT_ZERO;
+            else
+                break;
+        }
+
+        if(*c == '*') {
+            op->width = SSO_FORMAT_ARGUMENT;
+            c++;
+        } else if(*c >= '0' && *c <= '9' && !sso_string_format_parse_number(&c, &op->width)) {
+            goto error;
+        }
+
+        if(*c == '.') {
+            c++;
+            if(*c == '*') {
+                op->precision = SSO_FORMAT_ARGUMENT;
+                c++;
+            } else if(!sso_string_format_parse_number(&c, &op->precision)) {
+                goto error;
+            }
+        }
+
+        switch(*c) {
+            case 'h':
+                op->length = c[1] == 'h' ? SSO_FORMAT_HH : SSO_FORMAT_H;
+                c += op->length == SSO_FORMAT_HH ? 2 : 1;
+                break;
+            case 'l':
+                op->length = c[1] == 'l' ? SSO_FORMAT_LL : SSO_FORMAT_L;
+                c += op->length == SSO_FORMAT_LL ? 2 : 1;
+                break;
+            case 'j': op->length = SSO_FORMAT_J; c++; break;
+            case 'z': op->length = SSO_FORMAT_Z; c++; break;
+            case 't': op->length = SSO_FORMAT_T; c++; break;
+            case 'L': op->length = SSO_FORMAT_LONG_DOUBLE; c++; break;
+        }
+
+        char conversion = *c++;
+        switch(conversion) {
+            case 'd':
+            case 'i':
+                op->kind = SSO_FORMAT_SIGNED;
+                op->base = 10;
+                break;
+            case 'u':
+                op->kind = SSO_FORMAT_UNSIGNED;
+                op->base = 10;
+                break;
+            case 'X':
+                op->flags |= SSO_FORMAT_UPPER;
+                // fallthrough
+            case 'x':
+                op->kind = SSO_FORMAT_UNSIGNED;
+                op->base = 16;
+                break;
+            case 'o':
+                op->kind = SSO_FORMAT_UNSIGNED;
+                op->base = 8;
+                break;
+            case 'c':
+                op->kind = SSO_FORMAT_CHAR;
+                break;
+            case 's':
+                op->kind = SSO_FORMAT_STRING;
+                break;
+            case 'p':
+                op->kind = SSO_FORMAT_POINTER;
+                op->base = 16;
+                break;
+            case 'F':
+            case 'E':
+                op->flags |= SSO_FORMAT_UPPER;
+                // fallthrough
+            case 'f':
+            case 'e':
+                op->kind = conversion == 'f' || conversion == 'F' ? SSO_FORMAT_FIXED : SSO_FORMAT_EXPONENT;
+                break;
+            case 'g': case 'G':
+            case 'a': case 'A':
+                op->kind = SSO_FORMAT_FLOAT;
+                break;
+            default:
+                // %n, wide characters and unknown conversions aren't supported.
+                goto error;
+        }
+
+        bool floating = op->kind == SSO_FORMAT_FIXED || op->kind == SSO_FORMAT_EXPONENT || op->kind == SSO_FORMAT_FLOAT;
+        if(floating && op->length != SSO_FORMAT_DEFAULT && op->length != SSO_FORMAT_L && op->length != SSO_FORMAT_LONG_DOUBLE)
+            goto error;
+
+        // Long doubles can't be rounded as doubles.
+        if(floating && op->length == SSO_FORMAT_LONG_DOUBLE)
+            op->kind = SSO_FORMAT_FLOAT;
+
+        if(op->kind == SSO_FORMAT_FLOAT) {
+            // %g, %a and long doubles are formatted by the C library one directive
+            // at a time, with the width and precision always passed as arguments.
+            op->start = text_size;
+            text[text_size++] = '%';
+            if(op->flags & SSO_FORMAT_LEFT)
+                text[text_size++] = '-';
+            if(op->flags & SSO_FORMAT_PLUS)
+                text[text_size++] = '+';
+            if(op->flags & SSO_FORMAT_SPACE)
+                text[text_size++] = ' ';
+            if(op->flags & SSO_FORMAT_ALT)
+                text[text_size++] = '#';
+            if(op->flags & SSO_FORMAT_ZERO)
+                text[text_size++] = '0';
+            memcpy(text + text_size, "*.*", 3);
+            text_size += 3;
+            if(op->length == SSO_FORMAT_LONG_DOUBLE)
+                text[text_size++] = 'L';
+            text[text_size++] = conversion;
+            op->count = text_size - op->start;
+            text[text_size++] = '\0';
+        } else if(!floating && (op->length == SSO_FORMAT_LONG_DOUBLE
+            || (op->kind != SSO_FORMAT_SIGNED && op->kind != SSO_FORMAT_UNSIGNED && op->length != SSO_FORMAT_DEFAULT)))
+        {
+            goto error;
+        }
+
+        literal_start = text_size;
+    }
+
+    if(text_size != literal_start) {
+        StringFormatOp* literal = result->ops + result->count++;
+        memset(literal, 0, sizeof(*literal));
+        literal->kind = SSO_FORMAT_LITERAL;
+        literal->start = literal_start;
+        literal->count = text_size - literal_start;
+    }
+
+    for(size_t i = 0; i < result->count; i++)
+        result->estimate += sso_string_format_op_estimate(result->ops + i);
+
+    return result;
+
+    error:
+        free(result);
+        return NULL;
+}
+
+SSO_STRING_EXPORT void string_format_free(StringFormat* format) {
+    free(format);
+}
+
+// Appends to a string through a cursor, so a sequence of writes only has to
+// compare against the capacity and the size is stored once at the end.
+typedef struct SsoStringWriter {
+    String* str;
+    char* data;
+    size_t size;
+    size_t capacity;
+} SsoStringWriter;
+
+static inline void sso_string_writer_init(SsoStringWriter* writer, String* str) {
+    writer->str = str;
+    writer->data = string_cstr(str);
+    writer->size = string_size(str);
+    writer->capacity = string_capacity(str);
+}
+
+static char* sso_string_writer_grow(SsoStringWriter* writer, size_t count) {
+    // string_reserve only keeps the characters within the size.
+    sso_string_set_size(writer->str, writer->size);
+    if(!string_reserve(writer->str, writer->size + count))
+        return NULL;
+
+    writer->data = string_cstr(writer->str);
+    writer->capacity = string_capacity(writer->str);
+    return writer->data + writer->size;
+}
+
+// Gets where the next count characters go. Add them to writer->size once written.
+static inline char* sso_string_writer_space(SsoStringWriter* writer, size_t count) {
+    if(count > writer->capacity - writer->size)
+        return sso_string_writer_grow(writer, count);
+
+    return writer->data + writer->size;
+}
+
+static inline void sso_string_writer_finish(SsoStringWriter* writer) {
+    sso_string_set_size(writer->str, writer->size);
+    writer->data[writer->size] = '\0';
+}
+
+// Appends a value padded with spaces to a width.
+static bool sso_string_format_padded(SsoStringWriter* writer, const char* value, size_t length, int width, unsigned char flags) {
+    size_t pad = width > 0 && (size_t)width > length ? (size_t)width - length : 0;
+    char* out = sso_string_writer_space(writer, length + pad);
+    if(!out)
+        return false;
+
+    if(flags & SSO_FORMAT_LEFT) {
+        memcpy(out, value, length);
+        memset(out + length, ' ', pad);
+    } else {
+        memset(out, ' ', pad);
+        memcpy(out + pad, value, length);
+    }
+
+    writer->size += length + pad;
+    return true;
+}
+
+// Appends an integer following printf's rules for flags, width and precision.
+static bool sso_string_format_integer(
+    SsoStringWriter* writer,
+    const StringFormatOp* op,
+    uint64_t magnitude,
+    bool negative,
+    int width,
+    int precision,
+    unsigned char flags)
+{
+    int shift = op->base == 16 ? 4 : 3;
+    size_t digits = op->base == 10 ? (size_t)sso_string_decimal_length(magnitude) : (size_t)sso_string_radix_length(magnitude, shift);
+    if(precision == 0 && magnitude == 0)
+        digits = 0;
+
+    size_t zeros = precision > 0 && (size_t)precision > digits ? (size_t)precision - digits : 0;
+    char prefix[2];
+    size_t prefix_length = 0;
+
+    if(op->kind == SSO_FORMAT_SIGNED) {
+        if(negative)
+            prefix[prefix_length++] = '-';
+        else if(flags & SSO_FORMAT_PLUS)
+            prefix[prefix_length++] = '+';
+        else if(flags & SSO_FORMAT_SPACE)
+            prefix[prefix_length++] = ' ';
+    } else if(op->kind == SSO_FORMAT_POINTER || (op->base == 16 && (flags & SSO_FORMAT_ALT) && magnitude != 0)) {
+        prefix[prefix_length++] = '0';
+        prefix[prefix_length++] = (flags & SSO_FORMAT_UPPER) ? 'X' : 'x';
+    } else if(op->base == 8 && (flags & SSO_FORMAT_ALT) && zeros == 0 && (magnitude != 0 || digits == 0)) {
+        // The alternate octal form makes the first digit a zero.
+        zeros = 1;
+    }
+
+    size_t length = prefix_length + zeros + digits;
+    size_t pad = 0;
+    if(width > 0 && (size_t)width > length) {
+        if((flags & SSO_FORMAT_ZERO) && !(flags & SSO_FORMAT_LEFT) && precision < 0)
+            zeros += (size_t)width - length;
+        else
+            pad = (size_t)width - length;
+        length = (size_t)width;
+    }
+
+    char* out = sso_string_writer_space(writer, length);
+    if(!out)
+        return false;
+
+    if(!(flags & SSO_FORMAT_LEFT)) {
+        memset(out, ' ', pad);
+        out += pad;
+    }
+
+    memcpy(out, prefix, prefix_length);
+    out += prefix_length;
+    memset(out, '0', zeros);
+    out += zeros + digits;
+
+    if(digits != 0) {
+        if(op->base == 10)
+            sso_string_write_decimal(out, magnitude);
+        else
+            sso_string_write_radix(out, magnitude, shift, (flags & SSO_FORMAT_UPPER) ? sso_string_hex_upper : sso_string_hex_lower);
+    }
+
+    if(flags & SSO_FORMAT_LEFT)
+        memset(out, ' ', pad);
+
+    writer->size += length;
+    return true;
+}
+
+static int64_t sso_string_format_signed_arg(va_list* args, unsigned char length) {
+    switch(length) {
+        case SSO_FORMAT_HH: return (signed char)va_arg(*args, int);
+        case SSO_FORMAT_H: return (short)va_arg(*args, int);
+        case SSO_FORMAT_L: return va_arg(*args, long);
+        case SSO_FORMAT_LL: return va_arg(*args, long long);
+        case SSO_FORMAT_J: return va_arg(*args, intmax_t);
+        case SSO_FORMAT_Z: return (int64_t)(ptrdiff_t)va_arg(*args, size_t);
+        case SSO_FORMAT_T: return va_arg(*args, ptrdiff_t);
+        default: return va_arg(*args, int);
+    }
+}
+
+static uint64_t sso_string_format_unsigned_arg(va_list* args, unsigned char length) {
+    switch(length) {
+        case SSO_FORMAT_HH: return (unsigned char)va_arg(*args, unsigned int);
+        case SSO_FORMAT_H: return (unsigned short)va_arg(*args, unsigned int);
+        case SSO_FORMAT_L: return va_arg(*args, unsigned long);
+        case SSO_FORMAT_LL: return va_arg(*args, unsigned long long);
+        case SSO_FORMAT_J: return va_arg(*args, uintmax_t);
+        case SSO_FORMAT_Z: return va_arg(*args, size_t);
+        case SSO_FORMAT_T: return (uint64_t)va_arg(*args, ptrdiff_t);
+        default: return va_arg(*args, unsigned int);
+    }
+}
+
+// Formats %f, %F, %e and %E. Infinities and NaN aren't padded with zeros.
+static bool sso_string_format_double(SsoStringWriter* writer, double value, bool exponential, int width, int precision, unsigned char flags) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bool upper = (flags & SSO_FORMAT_UPPER) != 0;
+
+    char prefix = 0;
+    if(bits >> 63)
+        prefix = '-';
+    else if(flags & SSO_FORMAT_PLUS)
+        prefix = '+';
+    else if(flags & SSO_FORMAT_SPACE)
+        prefix = ' ';
+
+    SsoFixedDouble fixed;
+    const char* special = NULL;
+    size_t length = 3;
+    if(((bits >> 52) & 0x7FF) == 0x7FF) {
+        if(bits & ((1ull << 52) - 1))
+            special = upper ? "NAN" : "nan";
+        else
+            special = upper ? "INF" : "inf";
+    } else {
+        sso_string_fixed_double(value, precision >= 0 ? precision : 6, exponential, (flags & SSO_FORMAT_ALT) != 0, &fixed);
+        length = fixed.length;
+    }
+
+    size_t total = (prefix != 0) + length;
+    size_t zeros = 0;
+    size_t pad = 0;
+    if(width > 0 && (size_t)width > total) {
+        if((flags & SSO_FORMAT_ZERO) && !(flags & SSO_FORMAT_LEFT) && !special)
+            zeros = (size_t)width - total;
+        else
+            pad = (size_t)width - total;
+        total = (size_t)width;
+    }
+
+    char* out = sso_string_writer_space(writer, total);
+    if(!out)
+        return false;
+
+    if(!(flags & SSO_FORMAT_LEFT)) {
+        memset(out, ' ', pad);
+        out += pad;
+    }
+
+    if(prefix != 0)
+        *out++ = prefix;
+    memset(out, '0', zeros);
+    out += zeros;
+
+    if(special)
+        memcpy(out, special, 3);
+    else
+        sso_string_write_fixed_double(out, &fixed, upper);
+
+    if(flags & SSO_FORMAT_LEFT)
+        memset(out + length, ' ', pad);
+
+    writer->size += total;
+    return true;
+}
+
+static bool sso_string_format_float(SsoStringWriter* writer, const char* spec, va_list* args, bool long_double, int width, int precision) {
+    char buffer[64];
+    long double long_value = 0;
+    double value = 0;
+    int written;
+
+    if(long_double) {
+        long_value = va_arg(*args, long double);
+        written = snprintf(buffer, sizeof(buffer), spec, width, precision, long_value);
+    } else {
+        value = va_arg(*args, double);
+        written = snprintf(buffer, sizeof(buffer), spec, width, precision, value);
+    }
+
+    if(written < 0)
+        return false;
+
+    char* out = sso_string_writer_space(writer, (size_t)written);
+    if(!out)
+        return false;
+
+    // Large values are formatted again straight into the string, which always
+    // has room for the NULL terminator snprintf writes.
+    if((size_t)written < sizeof(buffer))
+        memcpy(out, buffer, (size_t)written);
+    else if(long_double)
+        snprintf(out, (size_t)written + 1, spec, width, precision, long_value);
+    else
+        snprintf(out, (size_t)written + 1, spec, width, precision, value);
+
+    writer->size += (size_t)written;
+    return true;
+}
+
+SSO_STRING_EXPORT String* string_format_apply(String* result, const StringFormat* format, ...) {
+    va_list argp;
+
+    va_start(argp, format);
+
+    result = string_format_apply_args(result, format, argp);
+
+    va_end(argp);
+
+    return result;
+}
+
+SSO_STRING_EXPORT String* string_format_apply_args(String* result, const StringFormat* format, va_list argp) {
+    SSO_STRING_ASSERT_ARG(format);
+
+    size_t original_size = SIZE_MAX;
+    if(!result) {
+        result = string_create_ref("");
+        if(!result)
+            return NULL;
+    } else {
+        original_size = string_size(result);
+    }
+
+    // The helpers take a pointer to the argument list, which has to be a local
+    // copy since va_list may be an array type that decays when passed.
+    va_list args;
+    va_copy(args, argp);
+
+    if(!string_reserve(result, string_size(result) + format->estimate))
+        goto error;
+
+    SsoStringWriter writer;
+    sso_string_writer_init(&writer, result);
+
+    for(size_t i = 0; i < format->count; i++) {
+        const StringFormatOp* op = format->ops + i;
+        unsigned char flags = op->flags;
+        int width = op->width;
+        int precision = op->precision;
+
+        if(width == SSO_FORMAT_ARGUMENT) {
+            width = va_arg(args, int);
+            if(width < 0) {
+                // A negative width is a '-' flag followed by a positive width.
+                flags |= SSO_FORMAT_LEFT;
+                width = width == INT_MIN ? INT_MAX : -width;
+            }
+        }
+
+        if(precision == SSO_FORMAT_ARGUMENT) {
+            precision = va_arg(args, int);
+            if(precision < 0)
+                precision = SSO_FORMAT_NONE;
+        }
+
+        bool success;
+        char* out;
+        switch(op->kind) {
+            case SSO_FORMAT_LITERAL:
+                out = sso_string_writer_space(&writer, op->count);
+                success = out != NULL;
+                if(success) {
+                    memcpy(out, format->text + op->start, op->count);
+                    writer.size += op->count;
+                }
+                break;
+            case SSO_FORMAT_SIGNED: {
+                int64_t value = sso_string_format_signed_arg(&args, op->length);
+                uint64_t magnitude = value < 0 ? 0 - (uint64_t)value : (uint64_t)value;
+                success = sso_string_format_integer(&writer, op, magnitude, value < 0, width, precision, flags);
+                break;
+            }
+            case SSO_FORMAT_UNSIGNED:
+                success = sso_string_format_integer(&writer, op, sso_string_format_unsigned_arg(&args, op->length), false, width, precision, flags);
+                break;
+            case SSO_FORMAT_POINTER:
+                success = sso_string_format_integer(&writer, op, (uint64_t)(uintptr_t)va_arg(args, void*), false, width, precision, flags);
+                break;
+            case SSO_FORMAT_CHAR: {
+                char value = (char)va_arg(args, int);
+                success = sso_string_format_padded(&writer, &value, 1, width, flags);
+                break;
+            }
+            case SSO_FORMAT_STRING: {
+                const char* value = va_arg(args, const char*);
+                if(!value)
+                    value = "(null)";
+
+                size_t length;
+                if(precision >= 0) {
+                    // Only the characters within the precision may be read.
+                    const char* end = memchr(value, 0, (size_t)precision);
+                    length = end ? (size_t)(end - value) : (size_t)precision;
+                } else {
+                    length = strlen(value);
+                }
+
+                success = sso_string_format_padded(&writer, value, length, width, flags);
+                break;
+            }
+            case SSO_FORMAT_FIXED:
+            case SSO_FORMAT_EXPONENT:
+                success = sso_string_format_double(&writer, va_arg(args, double), op->kind == SSO_FORMAT_EXPONENT, width, precision, flags);
+                break;
+            default:
+                success = sso_string_format_float(
+                    &writer,
+                    format->text + op->start,
+                    &args,
+                    op->length == SSO_FORMAT_LONG_DOUBLE,
+                    width < 0 ? 0 : width,
+                    precision);
+                break;
+        }
+
+        if(!success)
+            goto error;
+    }
+
+    sso_string_writer_finish(&writer);
+    va_end(args);
+    return result;
+
+    error:
+        va_end(args);
+        if(original_size == SIZE_MAX) {
+            string_free(result);
+        } else {
+            sso_string_set_size(result, original_size);
+            string_cstr(result)[original_size] = '\0';
+        }
+
+        return NULL;
+}
+
+// Brace formatting. The arguments are tagged with their type, so Strings and
+// views are copied by length and numbers go through the emitters above.
+
+typedef struct SsoBraceSpec {
+    const char* fill;
+    size_t fill_size;
+    char align;
+    char sign;
+    bool alt;
+    bool zero;
+    size_t width;
+    int precision;
+    char type;
+} SsoBraceSpec;
+
+// Parses the part of a replacement field after the ':'. Returns false if it's invalid.
+static bool sso_string_brace_parse_spec(const char** format, SsoBraceSpec* spec) {
+    const unsigned char* c = (const unsigned char*)*format;
+
+    // The fill is any single codepoint other than a brace, and is only
+    // recognized when followed by an alignment.
+    size_t fill_size = (size_t)sso_string_u8_sequence_length(c[0]);
+    for(size_t i = 1; i < fill_size; i++) {
+        if((c[i] & 0xC0) != 0x80)
+            fill_size = 0;
+    }
+
+    bool explicit_fill = fill_size != 0 && c[0] != '{' && c[0] != '}' && c[0] != 0
+        && (c[fill_size] == '<' || c[fill_size] == '>' || c[fill_size] == '^');
+
+    if(explicit_fill) {
+        spec->fill = (const char*)c;
+        spec->fill_size = fill_size;
+        spec->align = (char)c[fill_size];
+        c += fill_size + 1;
+    } else if(*c == '<' || *c == '>' || *c == '^') {
+        spec->align = (char)*c++;
+    }
+
+    if(*c == '+' || *c == '-' || *c == ' ')
+        spec->sign = (char)*c++;
+    if(*c == '#') {
+        spec->alt = true;
+        c++;
+    }
+    if(*c == '0') {
+        // With an explicit alignment, 0 is the fill instead of sign aware padding.
+        if(spec->align == 0)
+            spec->zero = true;
+        else if(!explicit_fill)
+            spec->fill = "0";
+        c++;
+    }
+
+    int width = 0;
+    if(!sso_string_format_parse_number((const char**)&c, &width))
+        return false;
+    spec->width = (size_t)width;
+
+    if(*c == '.') {
+        c++;
+        if(*c < '0' || *c > '9' || !sso_string_format_parse_number((const char**)&c, &spec->precision))
+            return false;
+    }
+
+    if(*c != '}' && *c != '\0' && strchr("dxXobsfFeE", *c))
+        spec->type = (char)*c++;
+
+    *format = (const char*)c;
+    return true;
+}
+
+static bool sso_string_brace_fill(SsoStringWriter* writer, const SsoBraceSpec* spec, size_t count) {
+    char* out = sso_string_writer_space(writer, count * spec->fill_size);
+    if(!out)
+        return false;
+
+    if(spec->fill_size == 1) {
+        memset(out, spec->fill[0], count);
+    } else {
+        for(size_t i = 0; i < count; i++)
+            memcpy(out + i * spec->fill_size, spec->fill, spec->fill_size);
+    }
+
+    writer->size += count * spec->fill_size;
+    return true;
+}
+
+// Writes the padding before a value and the sign, and returns where the length
+// characters of the value go. *out_after receives the padding that goes after it.
+static char* sso_string_brace_begin(
+    SsoStringWriter* writer,
+    const SsoBraceSpec* spec,
+    const char* prefix,
+    size_t prefix_length,
+    size_t length,
+    size_t width,
+    bool numeric,
+    size_t* out_after)
+{
+    size_t zeros = 0;
+    size_t before = 0;
+    size_t after = 0;
+    if(spec->width > width) {
+        size_t pad = spec->width - width;
+        if(numeric && spec->zero && spec->align == 0)
+            zeros = pad;
+        else if(spec->align == '<' || (spec->align == 0 && !numeric))
+            after = pad;
+        else if(spec->align == '^') {
+            before = pad / 2;
+            after = pad - before;
+        } else {
+            before = pad;
+        }
+    }
+
+    if(before != 0 && !sso_string_brace_fill(writer, spec, before))
+        return NULL;
+
+    char* out = sso_string_writer_space(writer, prefix_length + zeros + length);
+    if(!out)
+        return NULL;
+
+    memcpy(out, prefix, prefix_length);
+    memset(out + prefix_length, '0', zeros);
+    writer->size += prefix_length + zeros + length;
+    *out_after = after;
+    return out + prefix_length + zeros;
+}
+
+static bool sso_string_brace_text(SsoStringWriter* writer, const SsoBraceSpec* spec, const char* value, size_t size) {
+    if(spec->sign || spec->alt || (spec->type != 0 && spec->type != 's'))
+        return false;
+
+    // Text isn't signed, so 0 only changes the fill.
+    SsoBraceSpec zero_fill;
+    if(spec->zero) {
+        zero_fill = *spec;
+        zero_fill.zero = false;
+        zero_fill.fill = "0";
+        spec = &zero_fill;
+    }
+
+    if(spec->precision >= 0) {
+        size_t end = sso_string_u8_skip(value, size, (size_t)spec->precision);
+        if(end != SIZE_MAX)
+            size = end;
+    }
+
+    // The width is measured in codepoints, but there's no need to count them
+    // when there are too many bytes for the width to matter.
+    size_t width = spec->width == 0 || size >= spec->width * 4 ? size : sso_string_u8_count(value, size);
+
+    size_t after;
+    char* out = sso_string_brace_begin(writer, spec, "", 0, size, width, false, &after);
+    if(!out)
+        return false;
+
+    memcpy(out, value, size);
+    return sso_string_brace_fill(writer, spec, after);
+}
+
+static bool sso_string_brace_integer(SsoStringWriter* writer, const SsoBraceSpec* spec, uint64_t magnitude, bool negative) {
+    if(spec->precision >= 0)
+        return false;
+
+    char prefix[3];
+    size_t prefix_length = 0;
+    if(negative)
+        prefix[prefix_length++] = '-';
+    else if(spec->sign == '+' || spec->sign == ' ')
+        prefix[prefix_length++] = spec->sign;
+
+    int shift = 0;
+    const char* digits = sso_string_hex_lower;
+    switch(spec->type) {
+        case 0:
+        case 'd':
+            break;
+        case 'X':
+            digits = sso_string_hex_upper;
+            // fallthrough
+        case 'x':
+            shift = 4;
+            break;
+        case 'o':
+            shift = 3;
+            break;
+        case 'b':
+            shift = 1;
+            break;
+        default:
+            return false;
+    }
+
+    if(spec->alt && shift != 0) {
+        prefix[prefix_length++] = '0';
+        prefix[prefix_length++] = shift == 4 ? spec->type : (shift == 3 ? 'o' : 'b');
+    }
+
+    size_t length = shift == 0 ? (size_t)sso_string_decimal_length(magnitude) : (size_t)sso_string_radix_length(magnitude, shift);
+    size_t after;
+    char* out = sso_string_brace_begin(writer, spec, prefix, prefix_length, length, prefix_length + length, true, &after);
+    if(!out)
+        return false;
+
+    if(shift == 0)
+        sso_string_write_decimal(out + length, magnitude);
+    else
+        sso_string_write_radix(out + length, magnitude, shift, digits);
+
+    return sso_string_brace_fill(writer, spec, after);
+}
+
+static bool sso_string_brace_double(SsoStringWriter* writer, const SsoBraceSpec* spec, double value) {
+    char type = spec->type;
+    if(type == 0 && spec->precision >= 0)
+        type = 'f';
+    if(spec->alt || (type != 0 && type != 'f' && type != 'F' && type != 'e' && type != 'E'))
+        return false;
+
+    bool upper = type == 'F' || type == 'E';
+    SsoShortestDouble shortest;
+    sso_string_shortest_double(value, &shortest);
+
+    char prefix[1];
+    size_t prefix_length = 0;
+    if(shortest.negative)
+        prefix[prefix_length++] = '-';
+    else if(spec->sign == '+' || spec->sign == ' ')
+        prefix[prefix_length++] = spec->sign;
+
+    if(shortest.special || type == 0) {
+        size_t after;
+        char* out = sso_string_brace_begin(writer, spec, prefix, prefix_length, shortest.length, prefix_length + shortest.length, true, &after);
+        if(!out)
+            return false;
+
+        if(shortest.special && upper) {
+            for(int i = 0; i < 3; i++)
+                out[i] = (char)(shortest.special[i] - 'a' + 'A');
+        } else {
+            sso_string_write_shortest_double(out, &shortest);
+        }
+
+        return sso_string_brace_fill(writer, spec, after);
+    }
+
+    SsoFixedDouble fixed;
+    sso_string_fixed_double(value, spec->precision >= 0 ? spec->precision : 6, type == 'e' || type == 'E', false, &fixed);
+
+    size_t after;
+    char* out = sso_string_brace_begin(writer, spec, prefix, prefix_length, fixed.length, prefix_length + fixed.length, true, &after);
+    if(!out)
+        return false;
+
+    sso_string_write_fixed_double(out, &fixed, upper);
+    return sso_string_brace_fill(writer, spec, after);
+}
+
+static inline bool sso_string_is_identifier(char value) {
+    return (value >= 'a' && value <= 'z') || (value >= 'A' && value <= 'Z') || (value >= '0' && value <= '9') || value == '_';
+}
+
+static bool sso_string_brace_arg(SsoStringWriter* writer, const StringFormatArg* arg, const SsoBraceSpec* spec) {
+    switch(arg->type) {
+        case STRING_FORMAT_ARG_INT: {
+            int64_t value = arg->value.i;
+            return sso_string_brace_integer(writer, spec, value < 0 ? 0 - (uint64_t)value : (uint64_t)value, value < 0);
+        }
+        case STRING_FORMAT_ARG_UINT:
+            return sso_string_brace_integer(writer, spec, arg->value.u, false);
+        case STRING_FORMAT_ARG_DOUBLE:
+            return sso_string_brace_double(writer, spec, arg->value.d);
+        case STRING_FORMAT_ARG_BOOL:
+            return arg->value.b ? sso_string_brace_text(writer, spec, "true", 4) : sso_string_brace_text(writer, spec, "false", 5);
+        case STRING_FORMAT_ARG_CHAR:
+            return sso_string_brace_text(writer, spec, &arg->value.c, 1);
+        case STRING_FORMAT_ARG_CSTR: {
+            const char* value = arg->value.cstr ? arg->value.cstr : "(null)";
+            return sso_string_brace_text(writer, spec, value, strlen(value));
+        }
+        case STRING_FORMAT_ARG_STRING:
+            return sso_string_brace_text(writer, spec, string_data(arg->value.str), string_size(arg->value.str));
+        case STRING_FORMAT_ARG_VIEW:
+            return sso_string_brace_text(writer, spec, arg->value.view.data, arg->value.view.size);
+        default:
+            return false;
+    }
+}
+
+SSO_STRING_EXPORT bool string_format_braces_args(String* str, const char* format, const StringFormatArg* args, size_t count) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(format);
+    SSO_STRING_ASSERT_ARG(args || count == 0);
+
+    size_t original_size = string_size(str);
+    SsoStringWriter writer;
+    sso_string_writer_init(&writer, str);
+
+    // Automatic and manual numbering can't be mixed, since it's ambiguous which
+    // argument {} refers to after a {1}.
+    size_t next = 0;
+    bool automatic = false;
+    bool manual = false;
+    const char* c = format;
+
+    while(*c) {
+        size_t run = strcspn(c, "{}");
+        if(run != 0) {
+            char* out = sso_string_writer_space(&writer, run);
+            if(!out)
+                goto error;
+            memcpy(out, c, run);
+            writer.size += run;
+            c += run;
+            continue;
+        }
+
+        if(c[0] == c[1]) {
+            // {{ and }} are escaped braces.
+            char* out = sso_string_writer_space(&writer, 1);
+            if(!out)
+                goto error;
+            out[0] = c[0];
+            writer.size++;
+            c += 2;
+            continue;
+        }
+
+        if(*c++ == '}')
+            goto error;
+
+        const StringFormatArg* arg = NULL;
+        if(*c == '}' || *c == ':') {
+            if(manual || next >= count)
+                goto error;
+            automatic = true;
+            arg = args + next++;
+        } else if(*c >= '0' && *c <= '9') {
+            int index;
+            if(automatic || !sso_string_format_parse_number(&c, &index) || (size_t)index >= count)
+                goto error;
+            manual = true;
+            arg = args + index;
+        } else {
+            size_t name_length = 0;
+            while(sso_string_is_identifier(c[name_length]))
+                name_length++;
+
+            for(size_t i = 0; i < count && name_length != 0; i++) {
+                const char* name = args[i].name;
+                if(name && strncmp(name, c, name_length) == 0 && name[name_length] == '\0') {
+                    arg = args + i;
+                    break;
+                }
+            }
+
+            if(!arg)
+                goto error;
+            c += name_length;
+        }
+
+        SsoBraceSpec spec = { " ", 1, 0, 0, false, false, 0, -1, 0 };
+        if(*c == ':') {
+            c++;
+            if(!sso_string_brace_parse_spec(&c, &spec))
+                goto error;
+        }
+
+        if(*c++ != '}' || !sso_string_brace_arg(&writer, arg, &spec))
+            goto error;
+    }
+
+    sso_string_writer_finish(&writer);
+    return true;
+
+    error:
+        sso_string_set_size(str, original_size);
+        string_cstr(str)[original_size] = '\0';
+        return false;
+}
+
+// Number parsing. Digits are validated and converted eight at a time with
+// SWAR on little endian targets. Floats use the Eisel-Lemire algorithm: the
+// first 19 significant digits w are multiplied by a 128 bit approximation of
+// 10^q, which always gives the correctly rounded double when w * 10^q is the
+// exact value. When more digits were dropped, w and w + 1 are both converted,
+// and if they disagree the digits are compared with the exact midpoint between
+// the two candidates.
+
+static inline bool sso_string_is_digit(char value) {
+    return (unsigned char)(value - '0') < 10;
+}
+
+#ifdef SSO_STRING_LITTLE_ENDIAN
+
+static inline bool sso_string_is_eight_digits(uint64_t chunk) {
+    return ((chunk & 0xF0F0F0F0F0F0F0F0) | (((chunk + 0x0606060606060606) & 0xF0F0F0F0F0F0F0F0) >> 4)) == 0x3333333333333333;
+}
+
+static inline uint32_t sso_string_eight_digits_value(uint64_t chunk) {
+    chunk -= 0x3030303030303030;
+    chunk = chunk * 10 + (chunk >> 8);
+    return (uint32_t)(((chunk & 0x000000FF000000FF) * (100 + (1000000ull << 32))
+        + ((chunk >> 16) & 0x000000FF000000FF) * (1 + (10000ull << 32))) >> 32);
+}
+
+#endif
+
+static size_t sso_string_count_digits(const char* start, const char* end) {
+    const char* c = start;
+#ifdef SSO_STRING_LITTLE_ENDIAN
+    while(end - c >= 8 && sso_string_is_eight_digits(sso_string_load64(c)))
+        c += 8;
+#endif
+    while(c != end && sso_string_is_digit(*c))
+        c++;
+
+    return (size_t)(c - start);
+}
+
+// Appends count digits to value. The caller makes sure it can't overflow.
+static uint64_t sso_string_digits_value(uint64_t value, const char* digits, size_t count) {
+#ifdef SSO_STRING_LITTLE_ENDIAN
+    for(; count >= 8; count -= 8, digits += 8)
+        value = value * 100000000 + sso_string_eight_digits_value(sso_string_load64(digits));
+#endif
+    for(; count > 0; count--, digits++)
+        value = value * 10 + (uint64_t)(*digits - '0');
+
+    return value;
+}
+
+static StringParseError sso_string_parse_magnitude(const char* start, const char* end, uint64_t* value, const char** stop) {
+    const char* c = start;
+    while(c != end && *c == '0')
+        c++;
+
+    size_t count = sso_string_count_digits(c, end);
+    *stop = c + count;
+    if(*stop == start)
+        return STRING_PARSE_INVALID;
+
+    // UINT64_MAX has 20 digits, so only the last digit of a 20 digit number can overflow.
+    if(count > 20) {
+        *value = UINT64_MAX;
+        return STRING_PARSE_OVERFLOW;
+    } else if(count == 20) {
+        uint64_t high = sso_string_digits_value(0, c, 19);
+        uint64_t digit = (uint64_t)(c[19] - '0');
+        if(high > (UINT64_MAX - digit) / 10) {
+            *value = UINT64_MAX;
+            return STRING_PARSE_OVERFLOW;
+        }
+
+        *value = high * 10 + digit;
+        return STRING_PARSE_OK;
+    }
+
+    *value = sso_string_digits_value(0, c, count);
+    return STRING_PARSE_OK;
+}
+
+SSO_STRING_EXPORT StringParseError string_parse_i64_view(StringView view, int64_t* value, size_t* consumed) {
+    SSO_STRING_ASSERT_ARG(value);
+
+    const char* c = view.data;
+    const char* end = view.data + view.size;
+    bool negative = false;
+    if(c != end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        c++;
+    }
+
+    uint64_t magnitude;
+    const char* stop;
+    StringParseError result = sso_string_parse_magnitude(c, end, &magnitude, &stop);
+    if(result == STRING_PARSE_INVALID) {
+        if(consumed)
+            *consumed = 0;
+        return result;
+    }
+
+    uint64_t limit = negative ? (uint64_t)INT64_MAX + 1 : (uint64_t)INT64_MAX;
+    if(magnitude > limit) {
+        magnitude = limit;
+        result = STRING_PARSE_OVERFLOW;
+    }
+
+    *value = negative ? -(int64_t)(magnitude - 1) - 1 : (int64_t)magnitude;
+    if(consumed)
+        *consumed = (size_t)(stop - view.data);
+
+    return result;
+}
+
+SSO_STRING_EXPORT StringParseError string_parse_u64_view(StringView view, uint64_t* value, size_t* consumed) {
+    SSO_STRING_ASSERT_ARG(value);
+
+    const char* c = view.data;
+    const char* end = view.data + view.size;
+    if(c != end && *c == '+')
+        c++;
+
+    uint64_t magnitude;
+    const char* stop;
+    StringParseError result = sso_string_parse_magnitude(c, end, &magnitude, &stop);
+    if(result == STRING_PARSE_INVALID) {
+        if(consumed)
+            *consumed = 0;
+        return result;
+    }
+
+    *value = magnitude;
+    if(consumed)
+        *consumed = (size_t)(stop - view.data);
+
+    return result;
+}
+
+// The 128 most significant bits of 5^q for -342 <= q <= 308 as { low, high }.
+// Negative powers are rounded up and positive powers are truncated, which is
+// what makes the Eisel-Lemire result exact.
+#define SSO_STRING_POW5_128_MIN (-342)
+#define SSO_STRING_POW5_128_MAX 308
+
+static const uint64_t sso_string_pow5_128[SSO_STRING_POW5_128_MAX - SSO_STRING_POW5_128_MIN + 1][2] = {
+    { 0x113FAA2906A13B3F, 0xEEF453D6923BD65A },
+    { 0x4AC7CA59A424C507, 0x9558B4661B6565F8 },
+    { 0x5D79BCF00D2DF649, 0xBAAEE17FA23EBF76 },
+    { 0xF4D82C2C107973DC, 0xE95A99DF8ACE6F53 },
+    { 0x79071B9B8A4BE869, 0x91D8A02BB6C10594 },
+    { 0x9748E2826CDEE284, 0xB64EC836A47146F9 },
+    { 0xFD1B1B2308169B25, 0xE3E27A444D8D98B7 },
+    { 0xFE30F0F5E50E20F7, 0x8E6D8C6AB0787F72 },
+    { 0xBDBD2D335E51A935, 0xB208EF855C969F4F },
+    { 0xAD2C788035E61382, 0xDE8B2B66B3BC4723 },
+    { 0x4C3BCB5021AFCC31, 0x8B16FB203055AC76 },
+    { 0xDF4ABE242A1BBF3D, 0xADDCB9E83C6B1793 },
+    { 0xD71D6DAD34A2AF0D, 0xD953E8624B85DD78 },
+    { 0x8672648C40E5AD68, 0x87D4713D6F33AA6B },
+    { 0x680EFDAF511F18C2, 0xA9C98D8CCB009506 },
+    { 0x0212BD1B2566DEF2, 0xD43BF0EFFDC0BA48 },
+    { 0x014BB630F7604B57, 0x84A57695FE98746D },
+    { 0x419EA3BD35385E2D, 0xA5CED43B7E3E9188 },
+    { 0x52064CAC828675B9, 0xCF42894A5DCE35EA },
+    { 0x7343EFEBD1940993, 0x818995CE7AA0E1B2 },
+    { 0x1014EBE6C5F90BF8, 0xA1EBFB4219491A1F },
+    { 0xD41A26E077774EF6, 0xCA66FA129F9B60A6 },
+    { 0x8920B098955522B4, 0xFD00B897478238D0 },
+    { 0x55B46E5F5D5535B0, 0x9E20735E8CB16382 },
+    { 0xEB2189F734AA831D, 0xC5A890362FDDBC62 },
+    { 0xA5E9EC7501D523E4, 0xF712B443BBD52B7B },
+    { 0x47B233C92125366E, 0x9A6BB0AA55653B2D },
+    { 0x999EC0BB696E840A, 0xC1069CD4EABE89F8 },
+    { 0xC00670EA43CA250D, 0xF148440A256E2C76 },
+    { 0x380406926A5E5728, 0x96CD2A865764DBCA },
+    { 0xC605083704F5ECF2, 0xBC807527ED3E12BC },
+    { 0xF7864A44C633682E, 0xEBA09271E88D976B },
+    { 0x7AB3EE6AFBE0211D, 0x93445B8731587EA3 },
+    { 0x5960EA05BAD82964, 0xB8157268FDAE9E4C },
+    { 0x6FB92487298E33BD, 0xE61ACF033D1A45DF },
+    { 0xA5D3B6D479F8E056, 0x8FD0C16206306BAB },
+    { 0x8F48A4899877186C, 0xB3C4F1BA87BC8696 },
+    { 0x331ACDABFE94DE87, 0xE0B62E2929ABA83C },
+    { 0x9FF0C08B7F1D0B14, 0x8C71DCD9BA0B4925 },
+    { 0x07ECF0AE5EE44DD9, 0xAF8E5410288E1B6F },
+    { 0xC9E82CD9F69D6150, 0xDB71E91432B1A24A },
+    { 0xBE311C083A225CD2, 0x892731AC9FAF056E },
+    { 0x6DBD630A48AAF406, 0xAB70FE17C79AC6CA },
+    { 0x092CBBCCDAD5B108, 0xD64D3D9DB981787D },
+    { 0x25BBF56008C58EA5, 0x85F0468293F0EB4E },
+    { 0xAF2AF2B80AF6F24E, 0xA76C582338ED2621 },
+    { 0x1AF5AF660DB4AEE1, 0xD1476E2C07286FAA },
+    { 0x50D98D9FC890ED4D, 0x82CCA4DB847945CA },
+    { 0xE50FF107BAB528A0, 0xA37FCE126597973C },
+    { 0x1E53ED49A96272C8, 0xCC5FC196FEFD7D0C },
+    { 0x25E8E89C13BB0F7A, 0xFF77B1FCBEBCDC4F },
+    { 0x77B191618C54E9AC, 0x9FAACF3DF73609B1 },
+    { 0xD59DF5B9EF6A2417, 0xC795830D75038C1D },
+    { 0x4B0573286B44AD1D, 0xF97AE3D0D2446F25 },
+    { 0x4EE367F9430AEC32, 0x9BECCE62836AC577 },
+    { 0x229C41F793CDA73F, 0xC2E801FB244576D5 },
+    { 0x6B43527578C1110F, 0xF3A20279ED56D48A },
+    { 0x830A13896B78AAA9, 0x9845418C345644D6 },
+    { 0x23CC986BC656D553, 0xBE5691EF416BD60C },
+    { 0x2CBFBE86B7EC8AA8, 0xEDEC366B11C6CB8F },
+    { 0x7BF7D71432F3D6A9, 0x94B3A202EB1C3F39 },
+    { 0xDAF5CCD93FB0CC53, 0xB9E08A83A5E34F07 },
+    { 0xD1B3400F8F9CFF68, 0xE858AD248F5C22C9 },
+    { 0x23100809B9C21FA1, 0x91376C36D99995BE },
+    { 0xABD40A0C2832A78A, 0xB58547448FFFFB2D },
+    { 0x16C90C8F323F516C, 0xE2E69915B3FFF9F9 },
+    { 0xAE3DA7D97F6792E3, 0x8DD01FAD907FFC3B },
+    { 0x99CD11CFDF41779C, 0xB1442798F49FFB4A },
+    { 0x40405643D711D583, 0xDD95317F31C7FA1D },
+    { 0x482835EA666B2572, 0x8A7D3EEF7F1CFC52 },
+    { 0xDA3243650005EECF, 0xAD1C8EAB5EE43B66 },
+    { 0x90BED43E40076A82, 0xD863B256369D4A40 },
+    { 0x5A7744A6E804A291, 0x873E4F75E2224E68 },
+    { 0x711515D0A205CB36, 0xA90DE3535AAAE202 },
+    { 0x0D5A5B44CA873E03, 0xD3515C2831559A83 },
+    { 0xE858790AFE9486C2, 0x8412D9991ED58091 },
+    { 0x626E974DBE39A872, 0xA5178FFF668AE0B6 },
+    { 0xFB0A3D212DC8128F, 0xCE5D73FF402D98E3 },
+    { 0x7CE66634BC9D0B99, 0x80FA687F881C7F8E },
+    { 0x1C1FFFC1EBC44E80, 0xA139029F6A239F72 },
+    { 0xA327FFB266B56220, 0xC987434744AC874E },
+    { 0x4BF1FF9F0062BAA8, 0xFBE9141915D7A922 },
+    { 0x6F773FC3603DB4A9, 0x9D71AC8FADA6C9B5 },
+    { 0xCB550FB4384D21D3, 0xC4CE17B399107C22 },
+    { 0x7E2A53A146606A48, 0xF6019DA07F549B2B },
+    { 0x2EDA7444CBFC426D, 0x99C102844F94E0FB },
+    { 0xFA911155FEFB5308, 0xC0314325637A1939 },
+    { 0x793555AB7EBA27CA, 0xF03D93EEBC589F88 },
+    { 0x4BC1558B2F3458DE, 0x96267C7535B763B5 },
+    { 0x9EB1AAEDFB016F16, 0xBBB01B9283253CA2 },
+    { 0x465E15A979C1CADC, 0xEA9C227723EE8BCB },
+    { 0x0BFACD89EC191EC9, 0x92A1958A7675175F },
+    { 0xCEF980EC671F667B, 0xB749FAED14125D36 },
+    { 0x82B7E12780E7401A, 0xE51C79A85916F484 },
+    { 0xD1B2ECB8B0908810, 0x8F31CC0937AE58D2 },
+    { 0x861FA7E6DCB4AA15, 0xB2FE3F0B8599EF07 },
+    { 0x67A791E093E1D49A, 0xDFBDCECE67006AC9 },
+    { 0xE0C8BB2C5C6D24E0, 0x8BD6A141006042BD },
+    { 0x58FAE9F773886E18, 0xAECC49914078536D },
+    { 0xAF39A475506A899E, 0xDA7F5BF590966848 },
+    { 0x6D8406C952429603, 0x888F99797A5E012D },
+    { 0xC8E5087BA6D33B83, 0xAAB37FD7D8F58178 },
+    { 0xFB1E4A9A90880A64, 0xD5605FCDCF32E1D6 },
+    { 0x5CF2EEA09A55067F, 0x855C3BE0A17FCD26 },
+    { 0xF42FAA48C0EA481E, 0xA6B34AD8C9DFC06F },
+    { 0xF13B94DAF124DA26, 0xD0601D8EFC57B08B },
+    { 0x76C53D08D6B70858, 0x823C12795DB6CE57 },
+    { 0x54768C4B0C64CA6E, 0xA2CB1717B52481ED },
+    { 0xA9942F5DCF7DFD09, 0xCB7DDCDDA26DA268 },
+    { 0xD3F93B35435D7C4C, 0xFE5D54150B090B02 },
+    { 0xC47BC5014A1A6DAF, 0x9EFA548D26E5A6E1 },
+    { 0x359AB6419CA1091B, 0xC6B8E9B0709F109A },
+    { 0xC30163D203C94B62, 0xF867241C8CC6D4C0 },
+    { 0x79E0DE63425DCF1D, 0x9B407691D7FC44F8 },
+    { 0x985915FC12F542E4, 0xC21094364DFB5636 },
+    { 0x3E6F5B7B17B2939D, 0xF294B943E17A2BC4 },
+    { 0xA705992CEECF9C42, 0x979CF3CA6CEC5B5A },
+    { 0x50C6FF782A838353, 0xBD8430BD08277231 },
+    { 0xA4F8BF5635246428, 0xECE53CEC4A314EBD },
+    { 0x871B7795E136BE99, 0x940F4613AE5ED136 },
+    { 0x28E2557B59846E3F, 0xB913179899F68584 },
+    { 0x331AEADA2FE589CF, 0xE757DD7EC07426E5 },
+    { 0x3FF0D2C85DEF7621, 0x9096EA6F3848984F },
+    { 0x0FED077A756B53A9, 0xB4BCA50B065ABE63 },
+    { 0xD3E8495912C62894, 0xE1EBCE4DC7F16DFB },
+    { 0x64712DD7ABBBD95C, 0x8D3360F09CF6E4BD },
+    { 0xBD8D794D96AACFB3, 0xB080392CC4349DEC },
+    { 0xECF0D7A0FC5583A0, 0xDCA04777F541C567 },
+    { 0xF41686C49DB57244, 0x89E42CAAF9491B60 },
+    { 0x311C2875C522CED5, 0xAC5D37D5B79B6239 },
+    { 0x7D633293366B828B, 0xD77485CB25823AC7 },
+    { 0xAE5DFF9C02033197, 0x86A8D39EF77164BC },
+    { 0xD9F57F830283FDFC, 0xA8530886B54DBDEB },
+    { 0xD072DF63C324FD7B, 0xD267CAA862A12D66 },
+    { 0x4247CB9E59F71E6D, 0x8380DEA93DA4BC60 },
+    { 0x52D9BE85F074E608, 0xA46116538D0DEB78 },
+    { 0x67902E276C921F8B, 0xCD795BE870516656 },
+    { 0x00BA1CD8A3DB53B6, 0x806BD9714632DFF6 },
+    { 0x80E8A40ECCD228A4, 0xA086CFCD97BF97F3 },
+    { 0x6122CD128006B2CD, 0xC8A883C0FDAF7DF0 },
+    { 0x796B805720085F81, 0xFAD2A4B13D1B5D6C },
+    { 0xCBE3303674053BB0, 0x9CC3A6EEC6311A63 },
+    { 0xBEDBFC4411068A9C, 0xC3F490AA77BD60FC },
+    { 0xEE92FB5515482D44, 0xF4F1B4D515ACB93B },
+    { 0x751BDD152D4D1C4A, 0x991711052D8BF3C5 },
+    { 0xD262D45A78A0635D, 0xBF5CD54678EEF0B6 },
+    { 0x86FB897116C87C34, 0xEF340A98172AACE4 },
+    { 0xD45D35E6AE3D4DA0, 0x9580869F0E7AAC0E },
+    { 0x8974836059CCA109, 0xBAE0A846D2195712 },
+    { 0x2BD1A438703FC94B, 0xE998D258869FACD7 },
+    { 0x7B6306A34627DDCF, 0x91FF83775423CC06 },
+    { 0x1A3BC84C17B1D542, 0xB67F6455292CBF08 },
+    { 0x20CABA5F1D9E4A93, 0xE41F3D6A7377EECA },
+    { 0x547EB47B7282EE9C, 0x8E938662882AF53E },
+    { 0xE99E619A4F23AA43, 0xB23867FB2A35B28D },
+    { 0x6405FA00E2EC94D4, 0xDEC681F9F4C31F31 },
+    { 0xDE83BC408DD3DD04, 0x8B3C113C38F9F37E },
+    { 0x9624AB50B148D445, 0xAE0B158B4738705E },
+    { 0x3BADD624DD9B0957, 0xD98DDAEE19068C76 },
+    { 0xE54CA5D70A80E5D6, 0x87F8A8D4CFA417C9 },
+    { 0x5E9FCF4CCD211F4C, 0xA9F6D30A038D1DBC },
+    { 0x7647C3200069671F, 0xD47487CC8470652B },
+    { 0x29ECD9F40041E073, 0x84C8D4DFD2C63F3B },
+    { 0xF468107100525890, 0xA5FB0A17C777CF09 },
+    { 0x7182148D4066EEB4, 0xCF79CC9DB955C2CC },
+    { 0xC6F14CD848405530, 0x81AC1FE293D599BF },
+    { 0xB8ADA00E5A506A7C, 0xA21727DB38CB002F },
+    { 0xA6D90811F0E4851C, 0xCA9CF1D206FDC03B },
+    { 0x908F4A166D1DA663, 0xFD442E4688BD304A },
+    { 0x9A598E4E043287FE, 0x9E4A9CEC15763E2E },
+    { 0x40EFF1E1853F29FD, 0xC5DD44271AD3CDBA },
+    { 0xD12BEE59E68EF47C, 0xF7549530E188C128 },
+    { 0x82BB74F8301958CE, 0x9A94DD3E8CF578B9 },
+    { 0xE36A52363C1FAF01, 0xC13A148E3032D6E7 },
+    { 0xDC44E6C3CB279AC1, 0xF18899B1BC3F8CA1 },
+    { 0x29AB103A5EF8C0B9, 0x96F5600F15A7B7E5 },
+    { 0x7415D448F6B6F0E7, 0xBCB2B812DB11A5DE },
+    { 0x111B495B3464AD21, 0xEBDF661791D60F56 },
+    { 0xCAB10DD900BEEC34, 0x936B9FCEBB25C995 },
+    { 0x3D5D514F40EEA742, 0xB84687C269EF3BFB },
+    { 0x0CB4A5A3112A5112, 0xE65829B3046B0AFA },
+    { 0x47F0E785EABA72AB, 0x8FF71A0FE2C2E6DC },
+    { 0x59ED216765690F56, 0xB3F4E093DB73A093 },
+    { 0x306869C13EC3532C, 0xE0F218B8D25088B8 },
+    { 0x1E414218C73A13FB, 0x8C974F7383725573 },
+    { 0xE5D1929EF90898FA, 0xAFBD2350644EEACF },
+    { 0xDF45F746B74ABF39, 0xDBAC6C247D62A583 },
+    { 0x6B8BBA8C328EB783, 0x894BC396CE5DA772 },
+    { 0x066EA92F3F326564, 0xAB9EB47C81F5114F },
+    { 0xC80A537B0EFEFEBD, 0xD686619BA27255A2 },
+    { 0xBD06742CE95F5F36, 0x8613FD0145877585 },
+    { 0x2C48113823B73704, 0xA798FC4196E952E7 },
+    { 0xF75A15862CA504C5, 0xD17F3B51FCA3A7A0 },
+    { 0x9A984D73DBE722FB, 0x82EF85133DE648C4 },
+    { 0xC13E60D0D2E0EBBA, 0xA3AB66580D5FDAF5 },
+    { 0x318DF905079926A8, 0xCC963FEE10B7D1B3 },
+    { 0xFDF17746497F7052, 0xFFBBCFE994E5C61F },
+    { 0xFEB6EA8BEDEFA633, 0x9FD561F1FD0F9BD3 },
+    { 0xFE64A52EE96B8FC0, 0xC7CABA6E7C5382C8 },
+    { 0x3DFDCE7AA3C673B0, 0xF9BD690A1B68637B },
+    { 0x06BEA10CA65C084E, 0x9C1661A651213E2D },
+    { 0x486E494FCFF30A62, 0xC31BFA0FE5698DB8 },
+    { 0x5A89DBA3C3EFCCFA, 0xF3E2F893DEC3F126 },
+    { 0xF89629465A75E01C, 0x986DDB5C6B3A76B7 },
+    { 0xF6BBB397F1135823, 0xBE89523386091465 },
+    { 0x746AA07DED582E2C, 0xEE2BA6C0678B597F },
+    { 0xA8C2A44EB4571CDC, 0x94DB483840B717EF },
+    { 0x92F34D62616CE413, 0xBA121A4650E4DDEB },
+    { 0x77B020BAF9C81D17, 0xE896A0D7E51E1566 },
+    { 0x0ACE1474DC1D122E, 0x915E2486EF32CD60 },
+    { 0x0D819992132456BA, 0xB5B5ADA8AAFF80B8 },
+    { 0x10E1FFF697ED6C69, 0xE3231912D5BF60E6 },
+    { 0xCA8D3FFA1EF463C1, 0x8DF5EFABC5979C8F },
+    { 0xBD308FF8A6B17CB2, 0xB1736B96B6FD83B3 },
+    { 0xAC7CB3F6D05DDBDE, 0xDDD0467C64BCE4A0 },
+    { 0x6BCDF07A423AA96B, 0x8AA22C0DBEF60EE4 },
+    { 0x86C16C98D2C953C6, 0xAD4AB7112EB3929D },
+    { 0xE871C7BF077BA8B7, 0xD89D64D57A607744 },
+    { 0x11471CD764AD4972, 0x87625F056C7C4A8B },
+    { 0xD598E40D3DD89BCF, 0xA93AF6C6C79B5D2D },
+    { 0x4AFF1D108D4EC2C3, 0xD389B47879823479 },
+    { 0xCEDF722A585139BA, 0x843610CB4BF160CB },
+    { 0xC2974EB4EE658828, 0xA54394FE1EEDB8FE },
+    { 0x733D226229FEEA32, 0xCE947A3DA6A9273E },
+    { 0x0806357D5A3F525F, 0x811CCC668829B887 },
+    { 0xCA07C2DCB0CF26F7, 0xA163FF802A3426A8 },
+    { 0xFC89B393DD02F0B5, 0xC9BCFF6034C13052 },
+    { 0xBBAC2078D443ACE2, 0xFC2C3F3841F17C67 },
+    { 0xD54B944B84AA4C0D, 0x9D9BA7832936EDC0 },
+    { 0x0A9E795E65D4DF11, 0xC5029163F384A931 },
+    { 0x4D4617B5FF4A16D5, 0xF64335BCF065D37D },
+    { 0x504BCED1BF8E4E45, 0x99EA0196163FA42E },
+    { 0xE45EC2862F71E1D6, 0xC06481FB9BCF8D39 },
+    { 0x5D767327BB4E5A4C, 0xF07DA27A82C37088 },
+    { 0x3A6A07F8D510F86F, 0x964E858C91BA2655 },
+    { 0x890489F70A55368B, 0xBBE226EFB628AFEA },
+    { 0x2B45AC74CCEA842E, 0xEADAB0ABA3B2DBE5 },
+    { 0x3B0B8BC90012929D, 0x92C8AE6B464FC96F },
+    { 0x09CE6EBB40173744, 0xB77ADA0617E3BBCB },
+    { 0xCC420A6A101D0515, 0xE55990879DDCAABD },
+    { 0x9FA946824A12232D, 0x8F57FA54C2A9EAB6 },
+    { 0x47939822DC96ABF9, 0xB32DF8E9F3546564 },
+    { 0x59787E2B93BC56F7, 0xDFF9772470297EBD },
+    { 0x57EB4EDB3C55B65A, 0x8BFBEA76C619EF36 },
+    { 0xEDE622920B6B23F1, 0xAEFAE51477A06B03 },
+    { 0xE95FAB368E45ECED, 0xDAB99E59958885C4 },
+    { 0x11DBCB0218EBB414, 0x88B402F7FD75539B },
+    { 0xD652BDC29F26A119, 0xAAE103B5FCD2A881 },
+    { 0x4BE76D3346F0495F, 0xD59944A37C0752A2 },
+    { 0x6F70A4400C562DDB, 0x857FCAE62D8493A5 },
+    { 0xCB4CCD500F6BB952, 0xA6DFBD9FB8E5B88E },
+    { 0x7E2000A41346A7A7, 0xD097AD07A71F26B2 },
+    { 0x8ED400668C0C28C8, 0x825ECC24C873782F },
+    { 0x728900802F0F32FA, 0xA2F67F2DFA90563B },
+    { 0x4F2B40A03AD2FFB9, 0xCBB41EF979346BCA },
+    { 0xE2F610C84987BFA8, 0xFEA126B7D78186BC },
+    { 0x0DD9CA7D2DF4D7C9, 0x9F24B832E6B0F436 },
+    { 0x91503D1C79720DBB, 0xC6EDE63FA05D3143 },
+    { 0x75A44C6397CE912A, 0xF8A95FCF88747D94 },
+    { 0xC986AFBE3EE11ABA, 0x9B69DBE1B548CE7C },
+    { 0xFBE85BADCE996168, 0xC24452DA229B021B },
+    { 0xFAE27299423FB9C3, 0xF2D56790AB41C2A2 },
+    { 0xDCCD879FC967D41A, 0x97C560BA6B0919A5 },
+    { 0x5400E987BBC1C920, 0xBDB6B8E905CB600F },
+    { 0x290123E9AAB23B68, 0xED246723473E3813 },
+    { 0xF9A0B6720AAF6521, 0x9436C0760C86E30B },
+    { 0xF808E40E8D5B3E69, 0xB94470938FA89BCE },
+    { 0xB60B1D1230B20E04, 0xE7958CB87392C2C2 },
+    { 0xB1C6F22B5E6F48C2, 0x90BD77F3483BB9B9 },
+    { 0x1E38AEB6360B1AF3, 0xB4ECD5F01A4AA828 },
+    { 0x25C6DA63C38DE1B0, 0xE2280B6C20DD5232 },
+    { 0x579C487E5A38AD0E, 0x8D590723948A535F },
+    { 0x2D835A9DF0C6D851, 0xB0AF48EC79ACE837 },
+    { 0xF8E431456CF88E65, 0xDCDB1B2798182244 },
+    { 0x1B8E9ECB641B58FF, 0x8A08F0F8BF0F156B },
+    { 0xE272467E3D222F3F, 0xAC8B2D36EED2DAC5 },
+    { 0x5B0ED81DCC6ABB0F, 0xD7ADF884AA879177 },
+    { 0x98E947129FC2B4E9, 0x86CCBB52EA94BAEA },
+    { 0x3F2398D747B36224, 0xA87FEA27A539E9A5 },
+    { 0x8EEC7F0D19A03AAD, 0xD29FE4B18E88640E },
+    { 0x1953CF68300424AC, 0x83A3EEEEF9153E89 },
+    { 0x5FA8C3423C052DD7, 0xA48CEAAAB75A8E2B },
+    { 0x3792F412CB06794D, 0xCDB02555653131B6 },
+    { 0xE2BBD88BBEE40BD0, 0x808E17555F3EBF11 },
+    { 0x5B6ACEAEAE9D0EC4, 0xA0B19D2AB70E6ED6 },
+    { 0xF245825A5A445275, 0xC8DE047564D20A8B },
+    { 0xEED6E2F0F0D56712, 0xFB158592BE068D2E },
+    { 0x55464DD69685606B, 0x9CED737BB6C4183D },
+    { 0xAA97E14C3C26B886, 0xC428D05AA4751E4C },
+    { 0xD53DD99F4B3066A8, 0xF53304714D9265DF },
+    { 0xE546A8038EFE4029, 0x993FE2C6D07B7FAB },
+    { 0xDE98520472BDD033, 0xBF8FDB78849A5F96 },
+    { 0x963E66858F6D4440, 0xEF73D256A5C0F77C },
+    { 0xDDE7001379A44AA8, 0x95A8637627989AAD },
+    { 0x5560C018580D5D52, 0xBB127C53B17EC159 },
+    { 0xAAB8F01E6E10B4A6, 0xE9D71B689DDE71AF },
+    { 0xCAB3961304CA70E8, 0x9226712162AB070D },
+    { 0x3D607B97C5FD0D22, 0xB6B00D69BB55C8D1 },
+    { 0x8CB89A7DB77C506A, 0xE45C10C42A2B3B05 },
+    { 0x77F3608E92ADB242, 0x8EB98A7A9A5B04E3 },
+    { 0x55F038B237591ED3, 0xB267ED1940F1C61C },
+    { 0x6B6C46DEC52F6688, 0xDF01E85F912E37A3 },
+    { 0x2323AC4B3B3DA015, 0x8B61313BBABCE2C6 },
+    { 0xABEC975E0A0D081A, 0xAE397D8AA96C1B77 },
+    { 0x96E7BD358C904A21, 0xD9C7DCED53C72255 },
+    { 0x7E50D64177DA2E54, 0x881CEA14545C7575 },
+    { 0xDDE50BD1D5D0B9E9, 0xAA242499697392D2 },
+    { 0x955E4EC64B44E864, 0xD4AD2DBFC3D07787 },
+    { 0xBD5AF13BEF0B113E, 0x84EC3C97DA624AB4 },
+    { 0xECB1AD8AEACDD58E, 0xA6274BBDD0FADD61 },
+    { 0x67DE18EDA5814AF2, 0xCFB11EAD453994BA },
+    { 0x80EACF948770CED7, 0x81CEB32C4B43FCF4 },
+    { 0xA1258379A94D028D, 0xA2425FF75E14FC31 },
+    { 0x096EE45813A04330, 0xCAD2F7F5359A3B3E },
+    { 0x8BCA9D6E188853FC, 0xFD87B5F28300CA0D },
+    { 0x775EA264CF55347E, 0x9E74D1B791E07E48 },
+    { 0x95364AFE032A819E, 0xC612062576589DDA },
+    { 0x3A83DDBD83F52205, 0xF79687AED3EEC551 },
+    { 0xC4926A9672793543, 0x9ABE14CD44753B52 },
+    { 0x75B7053C0F178294, 0xC16D9A0095928A27 },
+    { 0x5324C68B12DD6339, 0xF1C90080BAF72CB1 },
+    { 0xD3F6FC16EBCA5E04, 0x971DA05074DA7BEE },
+    { 0x88F4BB1CA6BCF585, 0xBCE5086492111AEA },
+    { 0x2B31E9E3D06C32E6, 0xEC1E4A7DB69561A5 },
+    { 0x3AFF322E62439FD0, 0x9392EE8E921D5D07 },
+    { 0x09BEFEB9FAD487C3, 0xB877AA3236A4B449 },
+    { 0x4C2EBE687989A9B4, 0xE69594BEC44DE15B },
+    { 0x0F9D37014BF60A11, 0x901D7CF73AB0ACD9 },
+    { 0x538484C19EF38C95, 0xB424DC35095CD80F },
+    { 0x2865A5F206B06FBA, 0xE12E13424BB40E13 },
+    { 0xF93F87B7442E45D4, 0x8CBCCC096F5088CB },
+    { 0xF78F69A51539D749, 0xAFEBFF0BCB24AAFE },
+    { 0xB573440E5A884D1C, 0xDBE6FECEBDEDD5BE },
+    { 0x31680A88F8953031, 0x89705F4136B4A597 },
+    { 0xFDC20D2B36BA7C3E, 0xABCC77118461CEFC },
+    { 0x3D32907604691B4D, 0xD6BF94D5E57A42BC },
+    { 0xA63F9A49C2C1B110, 0x8637BD05AF6C69B5 },
+    { 0x0FCF80DC33721D54, 0xA7C5AC471B478423 },
+    { 0xD3C36113404EA4A9, 0xD1B71758E219652B },
+    { 0x645A1CAC083126EA, 0x83126E978D4FDF3B },
+    { 0x3D70A3D70A3D70A4, 0xA3D70A3D70A3D70A },
+    { 0xCCCCCCCCCCCCCCCD, 0xCCCCCCCCCCCCCCCC },
+    { 0x0000000000000000, 0x8000000000000000 },
+    { 0x0000000000000000, 0xA000000000000000 },
+    { 0x0000000000000000, 0xC800000000000000 },
+    { 0x0000000000000000, 0xFA00000000000000 },
+    { 0x0000000000000000, 0x9C40000000000000 },
+    { 0x0000000000000000, 0xC350000000000000 },
+    { 0x0000000000000000, 0xF424000000000000 },
+    { 0x0000000000000000, 0x9896800000000000 },
+    { 0x0000000000000000, 0xBEBC200000000000 },
+    { 0x0000000000000000, 0xEE6B280000000000 },
+    { 0x0000000000000000, 0x9502F90000000000 },
+    { 0x0000000000000000, 0xBA43B74000000000 },
+    { 0x0000000000000000, 0xE8D4A51000000000 },
+    { 0x0000000000000000, 0x9184E72A00000000 },
+    { 0x0000000000000000, 0xB5E620F480000000 },
+    { 0x0000000000000000, 0xE35FA931A0000000 },
+    { 0x0000000000000000, 0x8E1BC9BF04000000 },
+    { 0x0000000000000000, 0xB1A2BC2EC5000000 },
+    { 0x0000000000000000, 0xDE0B6B3A76400000 },
+    { 0x0000000000000000, 0x8AC7230489E80000 },
+    { 0x0000000000000000, 0xAD78EBC5AC620000 },
+    { 0x0000000000000000, 0xD8D726B7177A8000 },
+    { 0x0000000000000000, 0x878678326EAC9000 },
+    { 0x0000000000000000, 0xA968163F0A57B400 },
+    { 0x0000000000000000, 0xD3C21BCECCEDA100 },
+    { 0x0000000000000000, 0x84595161401484A0 },
+    { 0x0000000000000000, 0xA56FA5B99019A5C8 },
+    { 0x0000000000000000, 0xCECB8F27F4200F3A },
+    { 0x4000000000000000, 0x813F3978F8940984 },
+    { 0x5000000000000000, 0xA18F07D736B90BE5 },
+    { 0xA400000000000000, 0xC9F2C9CD04674EDE },
+    { 0x4D00000000000000, 0xFC6F7C4045812296 },
+    { 0xF020000000000000, 0x9DC5ADA82B70B59D },
+    { 0x6C28000000000000, 0xC5371912364CE305 },
+    { 0xC732000000000000, 0xF684DF56C3E01BC6 },
+    { 0x3C7F400000000000, 0x9A130B963A6C115C },
+    { 0x4B9F100000000000, 0xC097CE7BC90715B3 },
+    { 0x1E86D40000000000, 0xF0BDC21ABB48DB20 },
+    { 0x1314448000000000, 0x96769950B50D88F4 },
+    { 0x17D955A000000000, 0xBC143FA4E250EB31 },
+    { 0x5DCFAB0800000000, 0xEB194F8E1AE525FD },
+    { 0x5AA1CAE500000000, 0x92EFD1B8D0CF37BE },
+    { 0xF14A3D9E40000000, 0xB7ABC627050305AD },
+    { 0x6D9CCD05D0000000, 0xE596B7B0C643C719 },
+    { 0xE4820023A2000000, 0x8F7E32CE7BEA5C6F },
+    { 0xDDA2802C8A800000, 0xB35DBF821AE4F38B },
+    { 0xD50B2037AD200000, 0xE0352F62A19E306E },
+    { 0x4526F422CC340000, 0x8C213D9DA502DE45 },
+    { 0x9670B12B7F410000, 0xAF298D050E4395D6 },
+    { 0x3C0CDD765F114000, 0xDAF3F04651D47B4C },
+    { 0xA5880A69FB6AC800, 0x88D8762BF324CD0F },
+    { 0x8EEA0D047A457A00, 0xAB0E93B6EFEE0053 },
+    { 0x72A4904598D6D880, 0xD5D238A4ABE98068 },
+    { 0x47A6DA2B7F864750, 0x85A36366EB71F041 },
+    { 0x999090B65F67D924, 0xA70C3C40A64E6C51 },
+    { 0xFFF4B4E3F741CF6D, 0xD0CF4B50CFE20765 },
+    { 0xBFF8F10E7A8921A4, 0x82818F1281ED449F },
+    { 0xAFF72D52192B6A0D, 0xA321F2D7226895C7 },
+    { 0x9BF4F8A69F764490, 0xCBEA6F8CEB02BB39 },
+    { 0x02F236D04753D5B4, 0xFEE50B7025C36A08 },
+    { 0x01D762422C946590, 0x9F4F2726179A2245 },
+    { 0x424D3AD2B7B97EF5, 0xC722F0EF9D80AAD6 },
+    { 0xD2E0898765A7DEB2, 0xF8EBAD2B84E0D58B },
+    { 0x63CC55F49F88EB2F, 0x9B934C3B330C8577 },
+    { 0x3CBF6B71C76B25FB, 0xC2781F49FFCFA6D5 },
+    { 0x8BEF464E3945EF7A, 0xF316271C7FC3908A },
+    { 0x97758BF0E3CBB5AC, 0x97EDD871CFDA3A56 },
+    { 0x3D52EEED1CBEA317, 0xBDE94E8E43D0C8EC },
+    { 0x4CA7AAA863EE4BDD, 0xED63A231D4C4FB27 },
+    { 0x8FE8CAA93E74EF6A, 0x945E455F24FB1CF8 },
+    { 0xB3E2FD538E122B44, 0xB975D6B6EE39E436 },
+    { 0x60DBBCA87196B616, 0xE7D34C64A9C85D44 },
+    { 0xBC8955E946FE31CD, 0x90E40FBEEA1D3A4A },
+    { 0x6BABAB6398BDBE41, 0xB51D13AEA4A488DD },
+    { 0xC696963C7EED2DD1, 0xE264589A4DCDAB14 },
+    { 0xFC1E1DE5CF543CA2, 0x8D7EB76070A08AEC },
+    { 0x3B25A55F43294BCB, 0xB0DE65388CC8ADA8 },
+    { 0x49EF0EB713F39EBE, 0xDD15FE86AFFAD912 },
+    { 0x6E3569326C784337, 0x8A2DBF142DFCC7AB },
+    { 0x49C2C37F07965404, 0xACB92ED9397BF996 },
+    { 0xDC33745EC97BE906, 0xD7E77A8F87DAF7FB },
+    { 0x69A028BB3DED71A3, 0x86F0AC99B4E8DAFD },
+    { 0xC40832EA0D68CE0C, 0xA8ACD7C0222311BC },
+    { 0xF50A3FA490C30190, 0xD2D80DB02AABD62B },
+    { 0x792667C6DA79E0FA, 0x83C7088E1AAB65DB },
+    { 0x577001B891185938, 0xA4B8CAB1A1563F52 },
+    { 0xED4C0226B55E6F86, 0xCDE6FD5E09ABCF26 },
+    { 0x544F8158315B05B4, 0x80B05E5AC60B6178 },
+    { 0x696361AE3DB1C721, 0xA0DC75F1778E39D6 },
+    { 0x03BC3A19CD1E38E9, 0xC913936DD571C84C },
+    { 0x04AB48A04065C723, 0xFB5878494ACE3A5F },
+    { 0x62EB0D64283F9C76, 0x9D174B2DCEC0E47B },
+    { 0x3BA5D0BD324F8394, 0xC45D1DF942711D9A },
+    { 0xCA8F44EC7EE36479, 0xF5746577930D6500 },
+    { 0x7E998B13CF4E1ECB, 0x9968BF6ABBE85F20 },
+    { 0x9E3FEDD8C321A67E, 0xBFC2EF456AE276E8 },
+    { 0xC5CFE94EF3EA101E, 0xEFB3AB16C59B14A2 },
+    { 0xBBA1F1D158724A12, 0x95D04AEE3B80ECE5 },
+    { 0x2A8A6E45AE8EDC97, 0xBB445DA9CA61281F },
+    { 0xF52D09D71A3293BD, 0xEA1575143CF97226 },
+    { 0x593C2626705F9C56, 0x924D692CA61BE758 },
+    { 0x6F8B2FB00C77836C, 0xB6E0C377CFA2E12E },
+    { 0x0B6DFB9C0F956447, 0xE498F455C38B997A },
+    { 0x4724BD4189BD5EAC, 0x8EDF98B59A373FEC },
+    { 0x58EDEC91EC2CB657, 0xB2977EE300C50FE7 },
+    { 0x2F2967B66737E3ED, 0xDF3D5E9BC0F653E1 },
+    { 0xBD79E0D20082EE74, 0x8B865B215899F46C },
+    { 0xECD8590680A3AA11, 0xAE67F1E9AEC07187 },
+    { 0xE80E6F4820CC9495, 0xDA01EE641A708DE9 },
+    { 0x3109058D147FDCDD, 0x884134FE908658B2 },
+    { 0xBD4B46F0599FD415, 0xAA51823E34A7EEDE },
+    { 0x6C9E18AC7007C91A, 0xD4E5E2CDC1D1EA96 },
+    { 0x03E2CF6BC604DDB0, 0x850FADC09923329E },
+    { 0x84DB8346B786151C, 0xA6539930BF6BFF45 },
+    { 0xE612641865679A63, 0xCFE87F7CEF46FF16 },
+    { 0x4FCB7E8F3F60C07E, 0x81F14FAE158C5F6E },
+    { 0xE3BE5E330F38F09D, 0xA26DA3999AEF7749 },
+    { 0x5CADF5BFD3072CC5, 0xCB090C8001AB551C },
+    { 0x73D9732FC7C8F7F6, 0xFDCB4FA002162A63 },
+    { 0x2867E7FDDCDD9AFA, 0x9E9F11C4014DDA7E },
+    { 0xB281E1FD541501B8, 0xC646D63501A1511D },
+    { 0x1F225A7CA91A4226, 0xF7D88BC24209A565 },
+    { 0x3375788DE9B06958, 0x9AE757596946075F },
+    { 0x0052D6B1641C83AE, 0xC1A12D2FC3978937 },
+    { 0xC0678C5DBD23A49A, 0xF209787BB47D6B84 },
+    { 0xF840B7BA963646E0, 0x9745EB4D50CE6332 },
+    { 0xB650E5A93BC3D898, 0xBD176620A501FBFF },
+    { 0xA3E51F138AB4CEBE, 0xEC5D3FA8CE427AFF },
+    { 0xC66F336C36B10137, 0x93BA47C980E98CDF },
+    { 0xB80B0047445D4184, 0xB8A8D9BBE123F017 },
+    { 0xA60DC059157491E5, 0xE6D3102AD96CEC1D },
+    { 0x87C89837AD68DB2F, 0x9043EA1AC7E41392 },
+    { 0x29BABE4598C311FB, 0xB454E4A179DD1877 },
+    { 0xF4296DD6FEF3D67A, 0xE16A1DC9D8545E94 },
+    { 0x1899E4A65F58660C, 0x8CE2529E2734BB1D },
+    { 0x5EC05DCFF72E7F8F, 0xB01AE745B101E9E4 },
+    { 0x76707543F4FA1F73, 0xDC21A1171D42645D },
+    { 0x6A06494A791C53A8, 0x899504AE72497EBA },
+    { 0x0487DB9D17636892, 0xABFA45DA0EDBDE69 },
+    { 0x45A9D2845D3C42B6, 0xD6F8D7509292D603 },
+    { 0x0B8A2392BA45A9B2, 0x865B86925B9BC5C2 },
+    { 0x8E6CAC7768D7141E, 0xA7F26836F282B732 },
+    { 0x3207D795430CD926, 0xD1EF0244AF2364FF },
+    { 0x7F44E6BD49E807B8, 0x8335616AED761F1F },
+    { 0x5F16206C9C6209A6, 0xA402B9C5A8D3A6E7 },
+    { 0x36DBA887C37A8C0F, 0xCD036837130890A1 },
+    { 0xC2494954DA2C9789, 0x802221226BE55A64 },
+    { 0xF2DB9BAA10B7BD6C, 0xA02AA96B06DEB0FD },
+    { 0x6F92829494E5ACC7, 0xC83553C5C8965D3D },
+    { 0xCB772339BA1F17F9, 0xFA42A8B73ABBF48C },
+    { 0xFF2A760414536EFB, 0x9C69A97284B578D7 },
+    { 0xFEF5138519684ABA, 0xC38413CF25E2D70D },
+    { 0x7EB258665FC25D69, 0xF46518C2EF5B8CD1 },
+    { 0xEF2F773FFBD97A61, 0x98BF2F79D5993802 },
+    { 0xAAFB550FFACFD8FA, 0xBEEEFB584AFF8603 },
+    { 0x95BA2A53F983CF38, 0xEEAABA2E5DBF6784 },
+    { 0xDD945A747BF26183, 0x952AB45CFA97A0B2 },
+    { 0x94F971119AEEF9E4, 0xBA756174393D88DF },
+    { 0x7A37CD5601AAB85D, 0xE912B9D1478CEB17 },
+    { 0xAC62E055C10AB33A, 0x91ABB422CCB812EE },
+    { 0x577B986B314D6009, 0xB616A12B7FE617AA },
+    { 0xED5A7E85FDA0B80B, 0xE39C49765FDF9D94 },
+    { 0x14588F13BE847307, 0x8E41ADE9FBEBC27D },
+    { 0x596EB2D8AE258FC8, 0xB1D219647AE6B31C },
+    { 0x6FCA5F8ED9AEF3BB, 0xDE469FBD99A05FE3 },
+    { 0x25DE7BB9480D5854, 0x8AEC23D680043BEE },
+    { 0xAF561AA79A10AE6A, 0xADA72CCC20054AE9 },
+    { 0x1B2BA1518094DA04, 0xD910F7FF28069DA4 },
+    { 0x90FB44D2F05D0842, 0x87AA9AFF79042286 },
+    { 0x353A1607AC744A53, 0xA99541BF57452B28 },
+    { 0x42889B8997915CE8, 0xD3FA922F2D1675F2 },
+    { 0x69956135FEBADA11, 0x847C9B5D7C2E09B7 },
+    { 0x43FAB9837E699095, 0xA59BC234DB398C25 },
+    { 0x94F967E45E03F4BB, 0xCF02B2C21207EF2E },
+    { 0x1D1BE0EEBAC278F5, 0x8161AFB94B44F57D },
+    { 0x6462D92A69731732, 0xA1BA1BA79E1632DC },
+    { 0x7D7B8F7503CFDCFE, 0xCA28A291859BBF93 },
+    { 0x5CDA735244C3D43E, 0xFCB2CB35E702AF78 },
+    { 0x3A0888136AFA64A7, 0x9DEFBF01B061ADAB },
+    { 0x088AAA1845B8FDD0, 0xC56BAEC21C7A1916 },
+    { 0x8AAD549E57273D45, 0xF6C69A72A3989F5B },
+    { 0x36AC54E2F678864B, 0x9A3C2087A63F6399 },
+    { 0x84576A1BB416A7DD, 0xC0CB28A98FCF3C7F },
+    { 0x656D44A2A11C51D5, 0xF0FDF2D3F3C30B9F },
+    { 0x9F644AE5A4B1B325, 0x969EB7C47859E743 },
+    { 0x873D5D9F0DDE1FEE, 0xBC4665B596706114 },
+    { 0xA90CB506D155A7EA, 0xEB57FF22FC0C7959 },
+    { 0x09A7F12442D588F2, 0x9316FF75DD87CBD8 },
+    { 0x0C11ED6D538AEB2F, 0xB7DCBF5354E9BECE },
+    { 0x8F1668C8A86DA5FA, 0xE5D3EF282A242E81 },
+    { 0xF96E017D694487BC, 0x8FA475791A569D10 },
+    { 0x37C981DCC395A9AC, 0xB38D92D760EC4455 },
+    { 0x85BBE253F47B1417, 0xE070F78D3927556A },
+    { 0x93956D7478CCEC8E, 0x8C469AB843B89562 },
+    { 0x387AC8D1970027B2, 0xAF58416654A6BABB },
+    { 0x06997B05FCC0319E, 0xDB2E51BFE9D0696A },
+    { 0x441FECE3BDF81F03, 0x88FCF317F22241E2 },
+    { 0xD527E81CAD7626C3, 0xAB3C2FDDEEAAD25A },
+    { 0x8A71E223D8D3B074, 0xD60B3BD56A5586F1 },
+    { 0xF6872D5667844E49, 0x85C7056562757456 },
+    { 0xB428F8AC016561DB, 0xA738C6BEBB12D16C },
+    { 0xE13336D701BEBA52, 0xD106F86E69D785C7 },
+    { 0xECC0024661173473, 0x82A45B450226B39C },
+    { 0x27F002D7F95D0190, 0xA34D721642B06084 },
+    { 0x31EC038DF7B441F4, 0xCC20CE9BD35C78A5 },
+    { 0x7E67047175A15271, 0xFF290242C83396CE },
+    { 0x0F0062C6E984D386, 0x9F79A169BD203E41 },
+    { 0x52C07B78A3E60868, 0xC75809C42C684DD1 },
+    { 0xA7709A56CCDF8A82, 0xF92E0C3537826145 },
+    { 0x88A66076400BB691, 0x9BBCC7A142B17CCB },
+    { 0x6ACFF893D00EA435, 0xC2ABF989935DDBFE },
+    { 0x0583F6B8C4124D43, 0xF356F7EBF83552FE },
+    { 0xC3727A337A8B704A, 0x98165AF37B2153DE },
+    { 0x744F18C0592E4C5C, 0xBE1BF1B059E9A8D6 },
+    { 0x1162DEF06F79DF73, 0xEDA2EE1C7064130C },
+    { 0x8ADDCB5645AC2BA8, 0x9485D4D1C63E8BE7 },
+    { 0x6D953E2BD7173692, 0xB9A74A0637CE2EE1 },
+    { 0xC8FA8DB6CCDD0437, 0xE8111C87C5C1BA99 },
+    { 0x1D9C9892400A22A2, 0x910AB1D4DB9914A0 },
+    { 0x2503BEB6D00CAB4B, 0xB54D5E4A127F59C8 },
+    { 0x2E44AE64840FD61D, 0xE2A0B5DC971F303A },
+    { 0x5CEAECFED289E5D2, 0x8DA471A9DE737E24 },
+    { 0x7425A83E872C5F47, 0xB10D8E1456105DAD },
+    { 0xD12F124E28F77719, 0xDD50F1996B947518 },
+    { 0x82BD6B70D99AAA6F, 0x8A5296FFE33CC92F },
+    { 0x636CC64D1001550B, 0xACE73CBFDC0BFB7B },
+    { 0x3C47F7E05401AA4E, 0xD8210BEFD30EFA5A },
+    { 0x65ACFAEC34810A71, 0x8714A775E3E95C78 },
+    { 0x7F1839A741A14D0D, 0xA8D9D1535CE3B396 },
+    { 0x1EDE48111209A050, 0xD31045A8341CA07C },
+    { 0x934AED0AAB460432, 0x83EA2B892091E44D },
+    { 0xF81DA84D5617853F, 0xA4E4B66B68B65D60 },
+    { 0x36251260AB9D668E, 0xCE1DE40642E3F4B9 },
+    { 0xC1D72B7C6B426019, 0x80D2AE83E9CE78F3 },
+    { 0xB24CF65B8612F81F, 0xA1075A24E4421730 },
+    { 0xDEE033F26797B627, 0xC94930AE1D529CFC },
+    { 0x169840EF017DA3B1, 0xFB9B7CD9A4A7443C },
+    { 0x8E1F289560EE864E, 0x9D412E0806E88AA5 },
+    { 0xF1A6F2BAB92A27E2, 0xC491798A08A2AD4E },
+    { 0xAE10AF696774B1DB, 0xF5B5D7EC8ACB58A2 },
+    { 0xACCA6DA1E0A8EF29, 0x9991A6F3D6BF1765 },
+    { 0x17FD090A58D32AF3, 0xBFF610B0CC6EDD3F },
+    { 0xDDFC4B4CEF07F5B0, 0xEFF394DCFF8A948E },
+    { 0x4ABDAF101564F98E, 0x95F83D0A1FB69CD9 },
+    { 0x9D6D1AD41ABE37F1, 0xBB764C4CA7A4440F },
+    { 0x84C86189216DC5ED, 0xEA53DF5FD18D5513 },
+    { 0x32FD3CF5B4E49BB4, 0x92746B9BE2F8552C },
+    { 0x3FBC8C33221DC2A1, 0xB7118682DBB66A77 },
+    { 0x0FABAF3FEAA5334A, 0xE4D5E82392A40515 },
+    { 0x29CB4D87F2A7400E, 0x8F05B1163BA6832D },
+    { 0x743E20E9EF511012, 0xB2C71D5BCA9023F8 },
+    { 0x914DA9246B255416, 0xDF78E4B2BD342CF6 },
+    { 0x1AD089B6C2F7548E, 0x8BAB8EEFB6409C1A },
+    { 0xA184AC2473B529B1, 0xAE9672ABA3D0C320 },
+    { 0xC9E5D72D90A2741E, 0xDA3C0F568CC4F3E8 },
+    { 0x7E2FA67C7A658892, 0x8865899617FB1871 },
+    { 0xDDBB901B98FEEAB7, 0xAA7EEBFB9DF9DE8D },
+    { 0x552A74227F3EA565, 0xD51EA6FA85785631 },
+    { 0xD53A88958F87275F, 0x8533285C936B35DE },
+    { 0x8A892ABAF368F137, 0xA67FF273B8460356 },
+    { 0x2D2B7569B0432D85, 0xD01FEF10A657842C },
+    { 0x9C3B29620E29FC73, 0x8213F56A67F6B29B },
+    { 0x8349F3BA91B47B8F, 0xA298F2C501F45F42 },
+    { 0x241C70A936219A73, 0xCB3F2F7642717713 },
+    { 0xED238CD383AA0110, 0xFE0EFB53D30DD4D7 },
+    { 0xF4363804324A40AA, 0x9EC95D1463E8A506 },
+    { 0xB143C6053EDCD0D5, 0xC67BB4597CE2CE48 },
+    { 0xDD94B7868E94050A, 0xF81AA16FDC1B81DA },
+    { 0xCA7CF2B4191C8326, 0x9B10A4E5E9913128 },
+    { 0xFD1C2F611F63A3F0, 0xC1D4CE1F63F57D72 },
+    { 0xBC633B39673C8CEC, 0xF24A01A73CF2DCCF },
+    { 0xD5BE0503E085D813, 0x976E41088617CA01 },
+    { 0x4B2D8644D8A74E18, 0xBD49D14AA79DBC82 },
+    { 0xDDF8E7D60ED1219E, 0xEC9C459D51852BA2 },
+    { 0xCABB90E5C942B503, 0x93E1AB8252F33B45 },
+    { 0x3D6A751F3B936243, 0xB8DA1662E7B00A17 },
+    { 0x0CC512670A783AD4, 0xE7109BFBA19C0C9D },
+    { 0x27FB2B80668B24C5, 0x906A617D450187E2 },
+    { 0xB1F9F660802DEDF6, 0xB484F9DC9641E9DA },
+    { 0x5E7873F8A0396973, 0xE1A63853BBD26451 },
+    { 0xDB0B487B6423E1E8, 0x8D07E33455637EB2 },
+    { 0x91CE1A9A3D2CDA62, 0xB049DC016ABC5E5F },
+    { 0x7641A140CC7810FB, 0xDC5C5301C56B75F7 },
+    { 0xA9E904C87FCB0A9D, 0x89B9B3E11B6329BA },
+    { 0x546345FA9FBDCD44, 0xAC2820D9623BF429 },
+    { 0xA97C177947AD4095, 0xD732290FBACAF133 },
+    { 0x49ED8EABCCCC485D, 0x867F59A9D4BED6C0 },
+    { 0x5C68F256BFFF5A74, 0xA81F301449EE8C70 },
+    { 0x73832EEC6FFF3111, 0xD226FC195C6A2F8C },
+    { 0xC831FD53C5FF7EAB, 0x83585D8FD9C25DB7 },
+    { 0xBA3E7CA8B77F5E55, 0xA42E74F3D032F525 },
+    { 0x28CE1BD2E55F35EB, 0xCD3A1230C43FB26F },
+    { 0x7980D163CF5B81B3, 0x80444B5E7AA7CF85 },
+    { 0xD7E105BCC332621F, 0xA0555E361951C366 },
+    { 0x8DD9472BF3FEFAA7, 0xC86AB5C39FA63440 },
+    { 0xB14F98F6F0FEB951, 0xFA856334878FC150 },
+    { 0x6ED1BF9A569F33D3, 0x9C935E00D4B9D8D2 },
+    { 0x0A862F80EC4700C8, 0xC3B8358109E84F07 },
+    { 0xCD27BB612758C0FA, 0xF4A642E14C6262C8 },
+    { 0x8038D51CB897789C, 0x98E7E9CCCFBD7DBD },
+    { 0xE0470A63E6BD56C3, 0xBF21E44003ACDD2C },
+    { 0x1858CCFCE06CAC74, 0xEEEA5D5004981478 },
+    { 0x0F37801E0C43EBC8, 0x95527A5202DF0CCB },
+    { 0xD30560258F54E6BA, 0xBAA718E68396CFFD },
+    { 0x47C6B82EF32A2069, 0xE950DF20247C83FD },
+    { 0x4CDC331D57FA5441, 0x91D28B7416CDD27E },
+    { 0xE0133FE4ADF8E952, 0xB6472E511C81471D },
+    { 0x58180FDDD97723A6, 0xE3D8F9E563A198E5 },
+    { 0x570F09EAA7EA7648, 0x8E679C2F5E44FF8F },
+};
+
+// floor(log2(10^q)) for -342 <= q <= 308, without shifting a negative value.
+static inline int32_t sso_string_log2_pow10(int32_t q) {
+    return q >= 0 ? (217706 * q) >> 16 : -((-217706 * q + 65535) >> 16);
+}
+
+// Converts w * 10^q to the bits of a positive double, correctly rounded.
+static uint64_t sso_string_eisel_lemire(uint64_t w, int64_t q) {
+    if(w == 0 || q < SSO_STRING_POW5_128_MIN)
+        return 0;
+    if(q > SSO_STRING_POW5_128_MAX)
+        return 0x7FF0000000000000;
+
+    int leading_zeros = sso_string_clz64(w);
+    w <<= leading_zeros;
+
+    // Only the top 55 bits of the product are needed, so the low half of the
+    // power only matters when the bits below those could carry into them.
+    const uint64_t* power = sso_string_pow5_128[q - SSO_STRING_POW5_128_MIN];
+    uint64_t high;
+    uint64_t low = sso_string_umul128(w, power[1], &high);
+    if((high & 0x1FF) == 0x1FF) {
+        uint64_t carry;
+        sso_string_umul128(w, power[0], &carry);
+        low += carry;
+        if(carry > low)
+            high++;
+    }
+
+    int upper_bit = (int)(high >> 63);
+    int shift = upper_bit + 9;
+    uint64_t mantissa = high >> shift;
+    int32_t power2 = sso_string_log2_pow10((int32_t)q) + 63 + upper_bit - leading_zeros + 1023;
+
+    if(power2 <= 0) {
+        // Subnormal, or zero if every bit is shifted out.
+        if(-power2 + 1 >= 64)
+            return 0;
+
+        mantissa >>= -power2 + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+
+        // Rounding up can make it the smallest normal number, which still has the right bits.
+        return mantissa;
+    }
+
+    // The product is exact when 5^q fits in 64 bits, so a value exactly halfway
+    // between two doubles has to round to the even one instead of up.
+    if(low <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 && (mantissa << shift) == high)
+        mantissa &= ~(uint64_t)1;
+
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if(mantissa >= (2ull << 52)) {
+        mantissa = 1ull << 52;
+        power2++;
+    }
+
+    if(power2 >= 0x7FF)
+        return 0x7FF0000000000000;
+
+    return ((uint64_t)power2 << 52) | (mantissa & ((1ull << 52) - 1));
+}
+
+// Compares the significant digits [integer][fraction] (0.[digits] * 10^point)
+// with the midpoint between the positive double bits and the next one up.
+static int sso_string_compare_midpoint(const char* integer, size_t integer_count, const char* fraction, size_t fraction_count, int64_t point, uint64_t bits) {
+    uint64_t m;
+    int32_t e2;
+    sso_string_double_decode(bits, &m, &e2);
+
+    char midpoint[SSO_STRING_DOUBLE_EXACT_DIGITS];
+    int32_t midpoint_point;
+    size_t length = sso_string_binary_exact_digits(2 * m + 1, e2 - 1, midpoint, &midpoint_point);
+
+    if(point != midpoint_point)
+        return point < midpoint_point ? -1 : 1;
+
+    size_t count = integer_count + fraction_count;
+    for(size_t i = 0; i < count; i++) {
+        char digit = i < integer_count ? integer[i] : fraction[i - integer_count];
+        if(i >= length) {
+            if(digit != '0')
+                return 1;
+        } else if(digit != midpoint[i]) {
+            return digit < midpoint[i] ? -1 : 1;
+        }
+    }
+
+    return count < length ? -1 : 0;
+}
+
+// Matches a lowercase word at the start of [start, end) in any case.
+static bool sso_string_match_word(const char* start, const char* end, const char* word) {
+    for(; *word; start++, word++) {
+        if(start == end || (*start | 0x20) != *word)
+            return false;
+    }
+
+    return true;
+}
+
+SSO_STRING_EXPORT StringParseError string_parse_f64_view(StringView view, double* value, size_t* consumed) {
+    SSO_STRING_ASSERT_ARG(value);
+
+    const char* c = view.data;
+    const char* end = view.data + view.size;
+    bool negative = false;
+    if(c != end && (*c == '-' || *c == '+')) {
+        negative = *c == '-';
+        c++;
+    }
+
+    const char* integer = c;
+    size_t integer_count = sso_string_count_digits(c, end);
+    c += integer_count;
+
+    const char* fraction = c;
+    size_t fraction_count = 0;
+    if(c != end && *c == '.') {
+        fraction = c + 1;
+        fraction_count = sso_string_count_digits(fraction, end);
+        if(integer_count + fraction_count != 0)
+            c = fraction + fraction_count;
+    }
+
+    uint64_t bits;
+    StringParseError result = STRING_PARSE_OK;
+
+    if(integer_count + fraction_count == 0) {
+        if(sso_string_match_word(c, end, "infinity")) {
+            c += 8;
+            bits = 0x7FF0000000000000;
+        } else if(sso_string_match_word(c, end, "inf")) {
+            c += 3;
+            bits = 0x7FF0000000000000;
+        } else if(sso_string_match_word(c, end, "nan")) {
+            c += 3;
+            bits = 0x7FF8000000000000;
+        } else {
+            if(consumed)
+                *consumed = 0;
+            return STRING_PARSE_INVALID;
+        }
+    } else {
+        // The exponent is only part of the number if it has digits. Huge
+        // exponents are clamped, since anything past the range of a double
+        // rounds to zero or infinity anyway.
+        int64_t exponent = 0;
+        if(c != end && (*c | 0x20) == 'e') {
+            const char* e = c + 1;
+            bool exponent_negative = false;
+            if(e != end && (*e == '-' || *e == '+')) {
+                exponent_negative = *e == '-';
+                e++;
+            }
+
+            size_t exponent_count = sso_string_count_digits(e, end);
+            if(exponent_count != 0) {
+                for(size_t i = 0; i < exponent_count; i++) {
+                    if(exponent < 100000000)
+                        exponent = exponent * 10 + (e[i] - '0');
+                }
+
+                if(exponent_negative)
+                    exponent = -exponent;
+                c = e + exponent_count;
+            }
+        }
+
+        // The value is [integer][fraction] * 10^(exponent - fraction_count).
+        // Leading zeros don't change that, so skip them to find the significant digits.
+        exponent -= (int64_t)fraction_count;
+        while(integer_count != 0 && *integer == '0') {
+            integer++;
+            integer_count--;
+        }
+
+        if(integer_count == 0) {
+            while(fraction_count != 0 && *fraction == '0') {
+                fraction++;
+                fraction_count--;
+            }
+        }
+
+        size_t significant = integer_count + fraction_count;
+        if(significant <= 19) {
+            uint64_t w = sso_string_digits_value(0, integer, integer_count);
+            w = sso_string_digits_value(w, fraction, fraction_count);
+            bits = sso_string_eisel_lemire(w, exponent);
+        } else {
+            size_t integer_used = integer_count < 19 ? integer_count : 19;
+            size_t fraction_used = 19 - integer_used;
+            uint64_t w = sso_string_digits_value(0, integer, integer_used);
+            w = sso_string_digits_value(w, fraction, fraction_used);
+            int64_t q = exponent + (int64_t)(significant - 19);
+            bits = sso_string_eisel_lemire(w, q);
+
+            bool truncated = false;
+            for(size_t i = integer_used; i < integer_count && !truncated; i++)
+                truncated = integer[i] != '0';
+            for(size_t i = fraction_used; i < fraction_count && !truncated; i++)
+                truncated = fraction[i] != '0';
+
+            // The exact value is between w * 10^q and (w + 1) * 10^q, which are
+            // at most one double apart.
+            if(truncated && sso_string_eisel_lemire(w + 1, q) != bits) {
+                int64_t point = exponent + (int64_t)significant;
+                int order = sso_string_compare_midpoint(integer, integer_count, fraction, fraction_count, point, bits);
+                if(order > 0 || (order == 0 && (bits & 1)))
+                    bits++;
+            }
+        }
+
+        if(bits == 0x7FF0000000000000)
+            result = STRING_PARSE_OVERFLOW;
+    }
+
+    bits |= (uint64_t)negative << 63;
+    memcpy(value, &bits, sizeof(*value));
+    if(consumed)
+        *consumed = (size_t)(c - view.data);
+
+    return result;
+}
+
+// Hex and Base64. The output size is known up front, so it's reserved once and
+// written in place. Whole blocks go through the vector kernels, which stop at
+// the first block with an invalid character so the scalar loop can find its
+// exact position. Base64 needs a byte shuffle to move the 6 bit groups around,
+// which SSE2 doesn't have, so only the AVX2 and NEON builds vectorize it.
+
+#define SSO_STRING_HEX_LETTER_OFFSET(uppercase) ((uppercase) ? 'A' - '0' - 10 : 'a' - '0' - 10)
+
+// Encodes whole blocks of bytes as hex and returns how many bytes were encoded.
+static size_t sso_string_hex_encode_blocks(const unsigned char* data, size_t size, char* out, bool uppercase) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    {
+        const __m256i low_mask = _mm256_set1_epi8(0x0F);
+        const __m256i nine = _mm256_set1_epi8(9);
+        const __m256i zero = _mm256_set1_epi8('0');
+        const __m256i letter = _mm256_set1_epi8(SSO_STRING_HEX_LETTER_OFFSET(uppercase));
+        for(; i + 32 <= size; i += 32) {
+            __m256i bytes = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i high = _mm256_and_si256(_mm256_srli_epi16(bytes, 4), low_mask);
+            __m256i low = _mm256_and_si256(bytes, low_mask);
+            high = _mm256_add_epi8(_mm256_add_epi8(high, zero), _mm256_and_si256(_mm256_cmpgt_epi8(high, nine), letter));
+            low = _mm256_add_epi8(_mm256_add_epi8(low, zero), _mm256_and_si256(_mm256_cmpgt_epi8(low, nine), letter));
+
+            // The unpacks interleave within each 128 bit lane, so swap the middle halves back.
+            __m256i first = _mm256_unpacklo_epi8(high, low);
+            __m256i second = _mm256_unpackhi_epi8(high, low);
+            _mm256_storeu_si256((__m256i*)(out + i * 2), _mm256_permute2x128_si256(first, second, 0x20));
+            _mm256_storeu_si256((__m256i*)(out + i * 2 + 32), _mm256_permute2x128_si256(first, second, 0x31));
+        }
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    {
+        const __m128i low_mask = _mm_set1_epi8(0x0F);
+        const __m128i nine = _mm_set1_epi8(9);
+        const __m128i zero = _mm_set1_epi8('0');
+        const __m128i letter = _mm_set1_epi8(SSO_STRING_HEX_LETTER_OFFSET(uppercase));
+        for(; i + 16 <= size; i += 16) {
+            __m128i bytes = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i high = _mm_and_si128(_mm_srli_epi16(bytes, 4), low_mask);
+            __m128i low = _mm_and_si128(bytes, low_mask);
+            high = _mm_add_epi8(_mm_add_epi8(high, zero), _mm_and_si128(_mm_cmpgt_epi8(high, nine), letter));
+            low = _mm_add_epi8(_mm_add_epi8(low, zero), _mm_and_si128(_mm_cmpgt_epi8(low, nine), letter));
+            _mm_storeu_si128((__m128i*)(out + i * 2), _mm_unpacklo_epi8(high, low));
+            _mm_storeu_si128((__m128i*)(out + i * 2 + 16), _mm_unpackhi_epi8(high, low));
+        }
+    }
+#elif defined(SSO_STRING_NEON)
+    {
+        const uint8x16_t low_mask = vdupq_n_u8(0x0F);
+        const uint8x16_t nine = vdupq_n_u8(9);
+        const uint8x16_t zero = vdupq_n_u8('0');
+        const uint8x16_t letter = vdupq_n_u8(SSO_STRING_HEX_LETTER_OFFSET(uppercase));
+        for(; i + 16 <= size; i += 16) {
+            uint8x16_t bytes = vld1q_u8(data + i);
+            uint8x16_t high = vshrq_n_u8(bytes, 4);
+            uint8x16_t low = vandq_u8(bytes, low_mask);
+            uint8x16x2_t digits;
+            digits.val[0] = vaddq_u8(vaddq_u8(high, zero), vandq_u8(vcgtq_u8(high, nine), letter));
+            digits.val[1] = vaddq_u8(vaddq_u8(low, zero), vandq_u8(vcgtq_u8(low, nine), letter));
+            vst2q_u8((uint8_t*)out + i * 2, digits);
+        }
+    }
+#else
+    // Only the scalar loop of the caller runs.
+    (void)data;
+    (void)size;
+    (void)out;
+    (void)uppercase;
+#endif
+
+    return i;
+}
+
+#if defined(SSO_STRING_AVX2)
+
+// Converts hex digits to their values. Lanes that aren't hex digits are 0 in valid.
+static inline __m256i sso_string_hex_values_avx2(__m256i chars, __m256i* valid) {
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i letter = _mm256_sub_epi8(_mm256_or_si256(chars, _mm256_set1_epi8(0x20)), _mm256_set1_epi8('a'));
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_letter = _mm256_cmpeq_epi8(_mm256_min_epu8(letter, _mm256_set1_epi8(5)), letter);
+    *valid = _mm256_or_si256(is_digit, is_letter);
+    __m256i values = _mm256_or_si256(
+        _mm256_and_si256(digit, is_digit),
+        _mm256_and_si256(_mm256_add_epi8(letter, _mm256_set1_epi8(10)), is_letter));
+
+    // Each pair of digits is a 16 bit lane with the high digit in the low byte.
+    return _mm256_or_si256(
+        _mm256_slli_epi16(_mm256_and_si256(values, _mm256_set1_epi16(0x00FF)), 4),
+        _mm256_srli_epi16(values, 8));
+}
+
+#endif
+
+#if defined(SSO_STRING_SSE2)
+
+static inline __m128i sso_string_hex_values_sse2(__m128i chars, __m128i* valid) {
+    __m128i digit = _mm_sub_epi8(chars, _mm_set1_epi8('0'));
+    __m128i letter = _mm_sub_epi8(_mm_or_si128(chars, _mm_set1_epi8(0x20)), _mm_set1_epi8('a'));
+    __m128i is_digit = _mm_cmpeq_epi8(_mm_min_epu8(digit, _mm_set1_epi8(9)), digit);
+    __m128i is_letter = _mm_cmpeq_epi8(_mm_min_epu8(letter, _mm_set1_epi8(5)), letter);
+    *valid = _mm_or_si128(is_digit, is_letter);
+    __m128i values = _mm_or_si128(
+        _mm_and_si128(digit, is_digit),
+        _mm_and_si128(_mm_add_epi8(letter, _mm_set1_epi8(10)), is_letter));
+
+    return _mm_or_si128(
+        _mm_slli_epi16(_mm_and_si128(values, _mm_set1_epi16(0x00FF)), 4),
+        _mm_srli_epi16(values, 8));
+}
+
+#elif defined(SSO_STRING_NEON)
+
+static inline uint8x16_t sso_string_hex_values_neon(uint8x16_t chars, uint8x16_t* valid) {
+    uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+    uint8x16_t letter = vsubq_u8(vorrq_u8(chars, vdupq_n_u8(0x20)), vdupq_n_u8('a'));
+    uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t is_letter = vcleq_u8(letter, vdupq_n_u8(5));
+    *valid = vorrq_u8(is_digit, is_letter);
+    return vorrq_u8(vandq_u8(digit, is_digit), vandq_u8(vaddq_u8(letter, vdupq_n_u8(10)), is_letter));
+}
+
+#endif
+
+// Decodes whole blocks of hex digits and returns how many characters were
+// decoded. Stops before the first block with a character that isn't a digit.
+static size_t sso_string_hex_decode_blocks(const char* hex, size_t length, unsigned char* out) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    for(; i + 64 <= length; i += 64) {
+        __m256i first_valid, second_valid;
+        __m256i first = sso_string_hex_values_avx2(_mm256_loadu_si256((const __m256i*)(hex + i)), &first_valid);
+        __m256i second = sso_string_hex_values_avx2(_mm256_loadu_si256((const __m256i*)(hex + i + 32)), &second_valid);
+        if(_mm256_movemask_epi8(_mm256_and_si256(first_valid, second_valid)) != -1)
+            break;
+
+        // The pack works within each 128 bit lane, so put the 64 bit halves back in order.
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_packus_epi16(first, second), 0xD8);
+        _mm256_storeu_si256((__m256i*)(out + i / 2), bytes);
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    for(; i + 32 <= length; i += 32) {
+        __m128i first_valid, second_valid;
+        __m128i first = sso_string_hex_values_sse2(_mm_loadu_si128((const __m128i*)(hex + i)), &first_valid);
+        __m128i second = sso_string_hex_values_sse2(_mm_loadu_si128((const __m128i*)(hex + i + 16)), &second_valid);
+        if(_mm_movemask_epi8(_mm_and_si128(first_valid, second_valid)) != 0xFFFF)
+            break;
+
+        _mm_storeu_si128((__m128i*)(out + i / 2), _mm_packus_epi16(first, second));
+    }
+#elif defined(SSO_STRING_NEON)
+    for(; i + 32 <= length; i += 32) {
+        // Loading pairs splits the high and low digits into separate vectors.
+        uint8x16x2_t chars = vld2q_u8((const uint8_t*)hex + i);
+        uint8x16_t high_valid, low_valid;
+        uint8x16_t high = sso_string_hex_values_neon(chars.val[0], &high_valid);
+        uint8x16_t low = sso_string_hex_values_neon(chars.val[1], &low_valid);
+        uint64x2_t invalid = vreinterpretq_u64_u8(vmvnq_u8(vandq_u8(high_valid, low_valid)));
+        if((vgetq_lane_u64(invalid, 0) | vgetq_lane_u64(invalid, 1)) != 0)
+            break;
+
+        vst1q_u8(out + i / 2, vorrq_u8(vshlq_n_u8(high, 4), low));
+    }
+#else
+    // Only the scalar loop of the caller runs.
+    (void)hex;
+    (void)length;
+    (void)out;
+#endif
 
-    cleanup:
-        string_free_resources(&temp);
+    return i;
+}
 
-        return result;
+// The value of each hex digit, or -1 for other characters. Digits and letters
+// are mixed randomly in most input, so a lookup avoids branching on which one
+// a character is.
+static const signed char sso_string_hex_values[256] = {
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+};
+
+static inline int sso_string_hex_value(char value) {
+    return sso_string_hex_values[(unsigned char)value];
 }
 
-SSO_STRING_EXPORT bool string_join_refs(
-    String* str,
-    const String* separator,
-    const String** values,
-    size_t value_count)
-{
-    if(value_count == 0)
-        return true;
+SSO_STRING_EXPORT bool string_append_hex_bytes(String* str, const void* data, size_t size, bool uppercase) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(data || size == 0);
+
+    if(size > (STRING_MAX - string_size(str)) / 2)
+        return false;
+
+    char* out = sso_string_append_space(str, size * 2);
+    if(!out)
+        return false;
+
+    const unsigned char* bytes = data;
+    const char* digits = uppercase ? sso_string_hex_upper : sso_string_hex_lower;
+    size_t i = sso_string_hex_encode_blocks(bytes, size, out, uppercase);
+    for(; i < size; i++) {
+        out[i * 2] = digits[bytes[i] >> 4];
+        out[i * 2 + 1] = digits[bytes[i] & 0x0F];
+    }
+
+    sso_string_append_commit(str, size * 2);
+    return true;
+}
 
+SSO_STRING_EXPORT bool string_decode_hex(String* str, const char* hex, size_t length, size_t* out_error_offset) {
     SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(separator);
-    SSO_STRING_ASSERT_ARG(values);
+    SSO_STRING_ASSERT_ARG(hex || length == 0);
 
-    // Put the joined values in a temporary variable to avoid
-    // altering the result string if the operation fails.
+    size_t size = string_size(str);
+    size_t error_offset = length - 1;
+    unsigned char* out = (unsigned char*)sso_string_append_space(str, length / 2);
+    if(!out)
+        return false;
 
-    // Append the temp string to the result (str) at the end
-    // to finalize the operation.
-    bool result = false;
-    String temp = string_create("");
+    size_t even = length & ~(size_t)1;
+    size_t i = sso_string_hex_decode_blocks(hex, even, out);
+    for(; i < even; i += 2) {
+        int high = sso_string_hex_value(hex[i]);
+        int low = sso_string_hex_value(hex[i + 1]);
+        if((high | low) < 0) {
+            error_offset = high < 0 ? i : i + 1;
+            goto error;
+        }
 
-    if(!string_append_string(&temp, values[0]))
-        goto cleanup;
+        out[i / 2] = (unsigned char)(high << 4 | low);
+    }
 
-    for(size_t i = 1; i < value_count; i++) {
-        if(!string_append_string(&temp, separator))
-            goto cleanup;
+    if(even != length)
+        goto error;
 
-        if(!string_append_string(&temp, values[i]))
-            goto cleanup;
+    sso_string_append_commit(str, length / 2);
+    return true;
+
+    error:
+        string_cstr(str)[size] = '\0';
+        if(out_error_offset)
+            *out_error_offset = error_offset;
+        return false;
+}
+
+static const char sso_string_base64_alphabets[2][65] = {
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/",
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789-_"
+};
+
+// The value of each ASCII character in each alphabet, or -1 if it isn't part of it.
+static const signed char sso_string_base64_values[2][128] = {
+    {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1, -1, 63,
+        52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+        -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+        -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+        41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1
+    },
+    {
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+        -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 62, -1, -1,
+        52, 53, 54, 55, 56, 57, 58, 59, 60, 61, -1, -1, -1, -1, -1, -1,
+        -1, 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14,
+        15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, 63,
+        -1, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+        41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, -1, -1, -1, -1, -1
     }
+};
 
-    if(!string_append_string(str, &temp))
-        goto cleanup;
+// Encodes whole blocks of bytes as Base64 and returns how many bytes were encoded,
+// which is always a multiple of 3.
+static size_t sso_string_base64_encode_blocks(const unsigned char* data, size_t size, char* out, StringBase64Alphabet alphabet) {
+    size_t i = 0;
 
-    result = true;
+#if defined(SSO_STRING_AVX2)
+    {
+        const char* characters = sso_string_base64_alphabets[alphabet];
+
+        // Each lane holds 12 bytes, which become 16 characters. The shuffle
+        // copies each group of 3 bytes into a 32 bit lane as b1 b0 b2 b1, so
+        // the multiplies can move the four 6 bit groups into separate bytes.
+        const __m256i shuffle = _mm256_setr_epi8(
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+            1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+
+        // The offsets from a 6 bit value to its character, indexed by the range it's in.
+        const __m256i offsets = _mm256_setr_epi8(
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, characters[62] - 62, characters[63] - 63, 0, 0,
+            65, 71, -4, -4, -4, -4, -4, -4, -4, -4, -4, -4, characters[62] - 62, characters[63] - 63, 0, 0);
+
+        // The second load reads 4 bytes past the 24 that are encoded.
+        for(; i + 28 <= size; i += 24) {
+            __m256i bytes = _mm256_inserti128_si256(
+                _mm256_castsi128_si256(_mm_loadu_si128((const __m128i*)(data + i))),
+                _mm_loadu_si128((const __m128i*)(data + i + 12)),
+                1);
+
+            bytes = _mm256_shuffle_epi8(bytes, shuffle);
+            __m256i first = _mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0FC0FC00)), _mm256_set1_epi32(0x04000040));
+            __m256i second = _mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003F03F0)), _mm256_set1_epi32(0x01000010));
+            __m256i values = _mm256_or_si256(first, second);
+
+            // 0-25 use index 0 and 26-51 use index 1. The rest count up from 2.
+            __m256i index = _mm256_subs_epu8(values, _mm256_set1_epi8(51));
+            index = _mm256_sub_epi8(index, _mm256_cmpgt_epi8(values, _mm256_set1_epi8(25)));
+            values = _mm256_add_epi8(values, _mm256_shuffle_epi8(offsets, index));
+            _mm256_storeu_si256((__m256i*)(out + i / 3 * 4), values);
+        }
+    }
+#elif defined(SSO_STRING_NEON)
+    {
+        const char* characters = sso_string_base64_alphabets[alphabet];
+        const uint8x16_t mask = vdupq_n_u8(0x3F);
+        for(; i + 48 <= size; i += 48) {
+            // Loading triples splits the first, second and third bytes into separate vectors.
+            uint8x16x3_t bytes = vld3q_u8(data + i);
+            uint8x16x4_t values;
+            values.val[0] = vshrq_n_u8(bytes.val[0], 2);
+            values.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[0], 4), vshrq_n_u8(bytes.val[1], 4)), mask);
+            values.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(bytes.val[1], 2), vshrq_n_u8(bytes.val[2], 6)), mask);
+            values.val[3] = vandq_u8(bytes.val[2], mask);
+
+            for(int j = 0; j < 4; j++) {
+                uint8x16_t value = values.val[j];
+                uint8x16_t offset = vdupq_n_u8(65);
+                offset = vbslq_u8(vcgtq_u8(value, vdupq_n_u8(25)), vdupq_n_u8(71), offset);
+                offset = vbslq_u8(vcgtq_u8(value, vdupq_n_u8(51)), vdupq_n_u8((uint8_t)-4), offset);
+                offset = vbslq_u8(vceqq_u8(value, vdupq_n_u8(62)), vdupq_n_u8((uint8_t)(characters[62] - 62)), offset);
+                offset = vbslq_u8(vceqq_u8(value, vdupq_n_u8(63)), vdupq_n_u8((uint8_t)(characters[63] - 63)), offset);
+                values.val[j] = vaddq_u8(value, offset);
+            }
 
-    cleanup:
-        string_free_resources(&temp);
+            vst4q_u8((uint8_t*)out + i / 3 * 4, values);
+        }
+    }
+#else
+    // Only the scalar loop of the caller runs.
+    (void)data;
+    (void)size;
+    (void)out;
+    (void)alphabet;
+#endif
 
-        return result;
+    return i;
 }
 
-SSO_STRING_EXPORT String* string_split(
-    const String* str,
-    const String* separator,
-    String* results,
-    int results_count,
-    int* results_filled,
-    bool skip_empty,
-    bool init_results)
+#if defined(SSO_STRING_AVX2)
+
+// Converts Base64 characters to their values. Lanes with other characters are 0 in valid.
+static inline __m256i sso_string_base64_values_avx2(__m256i chars, char character62, char character63, __m256i* valid) {
+    __m256i upper = _mm256_sub_epi8(chars, _mm256_set1_epi8('A'));
+    __m256i lower = _mm256_sub_epi8(chars, _mm256_set1_epi8('a'));
+    __m256i digit = _mm256_sub_epi8(chars, _mm256_set1_epi8('0'));
+    __m256i is_upper = _mm256_cmpeq_epi8(_mm256_min_epu8(upper, _mm256_set1_epi8(25)), upper);
+    __m256i is_lower = _mm256_cmpeq_epi8(_mm256_min_epu8(lower, _mm256_set1_epi8(25)), lower);
+    __m256i is_digit = _mm256_cmpeq_epi8(_mm256_min_epu8(digit, _mm256_set1_epi8(9)), digit);
+    __m256i is_62 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(character62));
+    __m256i is_63 = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8(character63));
+
+    *valid = _mm256_or_si256(_mm256_or_si256(_mm256_or_si256(is_upper, is_lower), _mm256_or_si256(is_digit, is_62)), is_63);
+
+    __m256i values = _mm256_and_si256(upper, is_upper);
+    values = _mm256_or_si256(values, _mm256_and_si256(_mm256_add_epi8(lower, _mm256_set1_epi8(26)), is_lower));
+    values = _mm256_or_si256(values, _mm256_and_si256(_mm256_add_epi8(digit, _mm256_set1_epi8(52)), is_digit));
+    values = _mm256_or_si256(values, _mm256_and_si256(_mm256_set1_epi8(62), is_62));
+    return _mm256_or_si256(values, _mm256_and_si256(_mm256_set1_epi8(63), is_63));
+}
+
+#elif defined(SSO_STRING_NEON)
+
+static inline uint8x16_t sso_string_base64_values_neon(uint8x16_t chars, char character62, char character63, uint8x16_t* valid) {
+    uint8x16_t upper = vsubq_u8(chars, vdupq_n_u8('A'));
+    uint8x16_t lower = vsubq_u8(chars, vdupq_n_u8('a'));
+    uint8x16_t digit = vsubq_u8(chars, vdupq_n_u8('0'));
+    uint8x16_t is_upper = vcleq_u8(upper, vdupq_n_u8(25));
+    uint8x16_t is_lower = vcleq_u8(lower, vdupq_n_u8(25));
+    uint8x16_t is_digit = vcleq_u8(digit, vdupq_n_u8(9));
+    uint8x16_t is_62 = vceqq_u8(chars, vdupq_n_u8((uint8_t)character62));
+    uint8x16_t is_63 = vceqq_u8(chars, vdupq_n_u8((uint8_t)character63));
+
+    *valid = vorrq_u8(vorrq_u8(vorrq_u8(is_upper, is_lower), vorrq_u8(is_digit, is_62)), is_63);
+
+    uint8x16_t values = vandq_u8(upper, is_upper);
+    values = vorrq_u8(values, vandq_u8(vaddq_u8(lower, vdupq_n_u8(26)), is_lower));
+    values = vorrq_u8(values, vandq_u8(vaddq_u8(digit, vdupq_n_u8(52)), is_digit));
+    values = vorrq_u8(values, vandq_u8(vdupq_n_u8(62), is_62));
+    return vorrq_u8(values, vandq_u8(vdupq_n_u8(63), is_63));
+}
+
+#endif
+
+// Decodes whole blocks of Base64 and returns how many characters were decoded,
+// which is always a multiple of 4. Stops before the first block with a
+// character that isn't part of the alphabet.
+static size_t sso_string_base64_decode_blocks(const char* text, size_t length, unsigned char* out, StringBase64Alphabet alphabet) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    {
+        const char* characters = sso_string_base64_alphabets[alphabet];
+
+        // Packs the four 6 bit values in each 32 bit lane into 3 big endian bytes.
+        const __m256i shuffle = _mm256_setr_epi8(
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+            2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+        for(; i + 32 <= length; i += 32) {
+            __m256i valid;
+            __m256i values = sso_string_base64_values_avx2(
+                _mm256_loadu_si256((const __m256i*)(text + i)),
+                characters[62],
+                characters[63],
+                &valid);
+
+            if(_mm256_movemask_epi8(valid) != -1)
+                break;
+
+            values = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            values = _mm256_madd_epi16(values, _mm256_set1_epi32(0x00011000));
+            values = _mm256_shuffle_epi8(values, shuffle);
+            values = _mm256_permutevar8x32_epi32(values, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+            unsigned char* block = out + i / 4 * 3;
+            _mm_storeu_si128((__m128i*)block, _mm256_castsi256_si128(values));
+            _mm_storel_epi64((__m128i*)(block + 16), _mm256_extracti128_si256(values, 1));
+        }
+    }
+#elif defined(SSO_STRING_NEON)
+    {
+        const char* characters = sso_string_base64_alphabets[alphabet];
+        for(; i + 64 <= length; i += 64) {
+            // Loading groups of 4 splits the characters by their position in the group.
+            uint8x16x4_t chars = vld4q_u8((const uint8_t*)text + i);
+            uint8x16_t valid[4];
+            uint8x16_t values[4];
+            for(int j = 0; j < 4; j++)
+                values[j] = sso_string_base64_values_neon(chars.val[j], characters[62], characters[63], valid + j);
+
+            uint64x2_t invalid = vreinterpretq_u64_u8(vmvnq_u8(vandq_u8(vandq_u8(valid[0], valid[1]), vandq_u8(valid[2], valid[3]))));
+            if((vgetq_lane_u64(invalid, 0) | vgetq_lane_u64(invalid, 1)) != 0)
+                break;
+
+            uint8x16x3_t bytes;
+            bytes.val[0] = vorrq_u8(vshlq_n_u8(values[0], 2), vshrq_n_u8(values[1], 4));
+            bytes.val[1] = vorrq_u8(vshlq_n_u8(values[1], 4), vshrq_n_u8(values[2], 2));
+            bytes.val[2] = vorrq_u8(vshlq_n_u8(values[2], 6), values[3]);
+            vst3q_u8(out + i / 4 * 3, bytes);
+        }
+    }
+#else
+    // Only the scalar loop of the caller runs.
+    (void)text;
+    (void)length;
+    (void)out;
+    (void)alphabet;
+#endif
+
+    return i;
+}
+
+static inline int sso_string_base64_value(char value, StringBase64Alphabet alphabet) {
+    unsigned char c = (unsigned char)value;
+    return c < 128 ? sso_string_base64_values[alphabet][c] : -1;
+}
+
+SSO_STRING_EXPORT bool string_append_base64(String* str, const void* data, size_t size, StringBase64Alphabet alphabet) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(data || size == 0);
+
+    if(size / 3 > (STRING_MAX - string_size(str)) / 4 - 1)
+        return false;
+
+    size_t rest = size % 3;
+    size_t length = size / 3 * 4;
+    if(rest != 0)
+        length += alphabet == STRING_BASE64_STANDARD ? 4 : rest + 1;
+
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
+
+    const unsigned char* bytes = data;
+    const char* characters = sso_string_base64_alphabets[alphabet];
+    size_t i = sso_string_base64_encode_blocks(bytes, size, out, alphabet);
+    char* c = out + i / 3 * 4;
+    for(; i + 3 <= size; i += 3) {
+        uint32_t group = (uint32_t)bytes[i] << 16 | (uint32_t)bytes[i + 1] << 8 | bytes[i + 2];
+        c[0] = characters[group >> 18];
+        c[1] = characters[(group >> 12) & 0x3F];
+        c[2] = characters[(group >> 6) & 0x3F];
+        c[3] = characters[group & 0x3F];
+        c += 4;
+    }
+
+    if(rest != 0) {
+        uint32_t group = (uint32_t)bytes[i] << 16;
+        if(rest == 2)
+            group |= (uint32_t)bytes[i + 1] << 8;
+
+        *c++ = characters[group >> 18];
+        *c++ = characters[(group >> 12) & 0x3F];
+        if(rest == 2)
+            *c++ = characters[(group >> 6) & 0x3F];
+
+        if(alphabet == STRING_BASE64_STANDARD) {
+            *c++ = '=';
+            if(rest == 1)
+                *c++ = '=';
+        }
+    }
+
+    sso_string_append_commit(str, length);
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_decode_base64(
+    String* str,
+    const char* text,
+    size_t length,
+    StringBase64Alphabet alphabet,
+    size_t* out_error_offset)
 {
-    // Make sure the required inputs aren't NULL.
     SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(separator);
+    SSO_STRING_ASSERT_ARG(text || length == 0);
 
-    // results only needs to be initialized when results_count is > 0.
-    // On 0, it doesn't matter what state it is.
-    // On a negative number, results will be allocated by the function.
-    if(results_count > 0)
-        SSO_STRING_ASSERT_ARG(results);
+    // Padding can only be at the end of a whole group. Anywhere else it's an invalid character.
+    size_t padding = 0;
+    if(length % 4 == 0 && length != 0 && text[length - 1] == '=')
+        padding = text[length - 2] == '=' ? 2 : 1;
 
-    // Nothing needs to happen if there is no room for results. Return immediately.
-    if(results_count == 0) {
-        *results_filled = 0;
-        return results;
+    size_t data_length = length - padding;
+    size_t whole = data_length & ~(size_t)3;
+    size_t rest = data_length - whole;
+    size_t decoded = whole / 4 * 3 + (rest > 1 ? rest - 1 : 0);
+
+    size_t size = string_size(str);
+    size_t error_offset;
+    unsigned char* out = (unsigned char*)sso_string_append_space(str, decoded);
+    if(!out)
+        return false;
+
+    size_t i = sso_string_base64_decode_blocks(text, whole, out, alphabet);
+    unsigned char* o = out + i / 4 * 3;
+    for(; i < whole; i += 4) {
+        int a = sso_string_base64_value(text[i], alphabet);
+        int b = sso_string_base64_value(text[i + 1], alphabet);
+        int c = sso_string_base64_value(text[i + 2], alphabet);
+        int d = sso_string_base64_value(text[i + 3], alphabet);
+        if((a | b | c | d) < 0) {
+            error_offset = a < 0 ? i : b < 0 ? i + 1 : c < 0 ? i + 2 : i + 3;
+            goto error;
+        }
+
+        uint32_t group = (uint32_t)a << 18 | (uint32_t)b << 12 | (uint32_t)c << 6 | (uint32_t)d;
+        o[0] = (unsigned char)(group >> 16);
+        o[1] = (unsigned char)(group >> 8);
+        o[2] = (unsigned char)group;
+        o += 3;
     }
 
-    // Determine if the results array needs to be allocated. If so, create an
-    // initial buffer that has space for two items. This is the starting space since
-    // splitting small items tends to be pretty common (e.g. an array of key-value pairs).
-    bool allocate_results = results_count < 0;
-    if(allocate_results) {
-        results_count = 2;
-        results = malloc(results_count * sizeof(*results));
-        if(!results)
-            return NULL;
+    if(rest != 0) {
+        // One character is only 6 bits, which isn't enough for a byte.
+        int values[3] = { 0, 0, 0 };
+        for(size_t j = 0; j < rest; j++) {
+            values[j] = sso_string_base64_value(text[i + j], alphabet);
+            if(values[j] < 0) {
+                error_offset = i + j;
+                goto error;
+            }
+        }
 
-        // The results always have to be initialized by this function if the results array 
-        // was also created by it. UB otherwise.
-        init_results = true;
+        error_offset = i + rest - 1;
+        if(rest == 1)
+            goto error;
+
+        uint32_t group = (uint32_t)values[0] << 18 | (uint32_t)values[1] << 12 | (uint32_t)values[2] << 6;
+        if((group & (rest == 2 ? 0xFFFF : 0xFF)) != 0)
+            goto error;
+
+        *o++ = (unsigned char)(group >> 16);
+        if(rest == 3)
+            *o++ = (unsigned char)(group >> 8);
     }
 
-    int count = 0;
-    size_t start = 0;
+    sso_string_append_commit(str, decoded);
+    return true;
+
+    error:
+        string_cstr(str)[size] = '\0';
+        if(out_error_offset)
+            *out_error_offset = error_offset;
+        return false;
+}
+
+// JSON strings. Most values don't contain anything that has to be escaped, so
+// the text is scanned a block at a time for the next '"', '\\' or control
+// character and everything before it is copied at once.
+
+// Gets the index of the first character that has to be escaped in a JSON
+// string, or size if there isn't one.
+static size_t sso_string_json_special(const unsigned char* data, size_t size) {
+    size_t i = 0;
+
+#if defined(SSO_STRING_AVX2)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i backslash = _mm256_set1_epi8('\\');
+        const __m256i control = _mm256_set1_epi8(0x1F);
+        for(; i + 32 <= size; i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(value, quote), _mm256_cmpeq_epi8(value, backslash)),
+                _mm256_cmpeq_epi8(_mm256_min_epu8(value, control), value));
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
+    }
+#endif
+
+#if defined(SSO_STRING_SSE2)
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i backslash = _mm_set1_epi8('\\');
+        const __m128i control = _mm_set1_epi8(0x1F);
+        for(; i + 16 <= size; i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(value, quote), _mm_cmpeq_epi8(value, backslash)),
+                _mm_cmpeq_epi8(_mm_min_epu8(value, control), value));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
+    }
+#elif defined(SSO_STRING_NEON)
+    {
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t backslash = vdupq_n_u8('\\');
+        const uint8x16_t space = vdupq_n_u8(0x20);
+        for(; i + 16 <= size; i += 16) {
+            uint8x16_t value = vld1q_u8(data + i);
+            uint8x16_t special = vorrq_u8(
+                vorrq_u8(vceqq_u8(value, quote), vceqq_u8(value, backslash)),
+                vcltq_u8(value, space));
+            if(!sso_string_neon_all_set(vmvnq_u8(special)))
+                break;
+        }
+    }
+#endif
+
+    // A byte is below n when subtracting n borrows into its high bit, and '"'
+    // and '\\' become zero after the xor. Neither changes the high bit, so the
+    // same ~value mask rules out bytes above 0x7F for all three checks.
+    for(; i + 8 <= size; i += 8) {
+        uint64_t value = sso_string_load64(data + i);
+        uint64_t quote = value ^ (SSO_STRING_SWAR_ONES * '"');
+        uint64_t backslash = value ^ (SSO_STRING_SWAR_ONES * '\\');
+        uint64_t special = (value - SSO_STRING_SWAR_ONES * 0x20) | (quote - SSO_STRING_SWAR_ONES) | (backslash - SSO_STRING_SWAR_ONES);
+        if((special & ~value & SSO_STRING_SWAR_HIGHS) != 0)
+            break;
+    }
+
+    for(; i < size; i++) {
+        if(data[i] == '"' || data[i] == '\\' || data[i] < 0x20)
+            return i;
+    }
+
+    return size;
+}
+
+// The character after the backslash for the control characters with a short
+// escape, or 0 for the ones written as \u00XX.
+static const char sso_string_json_short_escapes[32] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 'b', 't', 'n', 0, 'f', 'r', 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+SSO_STRING_EXPORT bool string_append_json_escaped(String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    const unsigned char* data = (const unsigned char*)value;
+    size_t original_size = string_size(str);
+    SsoStringWriter writer;
+    sso_string_writer_init(&writer, str);
+
+    size_t i = 0;
+    while(true) {
+        // Reserve room for the clean span and the escape after it together.
+        size_t clean = sso_string_json_special(data + i, length - i);
+        if(clean > STRING_MAX - 6 - writer.size)
+            goto error;
+
+        char* out = sso_string_writer_space(&writer, clean + 6);
+        if(!out)
+            goto error;
+
+        memcpy(out, data + i, clean);
+        writer.size += clean;
+        i += clean;
+        if(i == length)
+            break;
+
+        unsigned char c = data[i++];
+        out += clean;
+        out[0] = '\\';
+        if(c == '"' || c == '\\') {
+            out[1] = (char)c;
+            writer.size += 2;
+        } else if(sso_string_json_short_escapes[c] != 0) {
+            out[1] = sso_string_json_short_escapes[c];
+            writer.size += 2;
+        } else {
+            memcpy(out + 1, "u00", 3);
+            out[4] = sso_string_hex_lower[c >> 4];
+            out[5] = sso_string_hex_lower[c & 0x0F];
+            writer.size += 6;
+        }
+    }
+
+    sso_string_writer_finish(&writer);
+    return true;
+
+    error:
+        sso_string_set_size(str, original_size);
+        string_cstr(str)[original_size] = '\0';
+        return false;
+}
+
+// Reads the four hex digits of a \u escape.
+static inline bool sso_string_json_hex4(const unsigned char* data, size_t size, Char32* value) {
+    if(size < 4)
+        return false;
+
+    int a = sso_string_hex_values[data[0]];
+    int b = sso_string_hex_values[data[1]];
+    int c = sso_string_hex_values[data[2]];
+    int d = sso_string_hex_values[data[3]];
+    if((a | b | c | d) < 0)
+        return false;
+
+    *value = (Char32)(a << 12 | b << 8 | c << 4 | d);
+    return true;
+}
+
+SSO_STRING_EXPORT bool string_json_unescape(String* str, const char* value, size_t length, size_t* out_error_offset) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    // Every escape is at least as long as what it decodes to, so the result
+    // fits in length characters.
+    const unsigned char* data = (const unsigned char*)value;
     size_t size = string_size(str);
+    size_t error_offset;
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
 
+    char* o = out;
+    size_t i = 0;
     while(true) {
-        // Find the next instance of the separator. If the index is SIZE_MAX,
-        // the function reached the end of the string without finding it.
-        size_t next = string_find_string(str, start, separator);
-        if(next == SIZE_MAX)
-            next = size;
+        size_t clean = sso_string_json_special(data + i, length - i);
+        memcpy(o, data + i, clean);
+        o += clean;
+        i += clean;
+        if(i == length)
+            break;
+
+        // Unescaped quotes and control characters aren't allowed.
+        error_offset = i;
+        if(data[i] != '\\' || i + 1 == length)
+            goto error;
 
-        size_t copy_length = next - start;
-        if(copy_length != 0 || !skip_empty) {
-            // Add the string segment to the results array. If the value fails to be added,
-            // there was an allocation error, so just break out of the function right away.
-            if(init_results) {
-                if(!string_init_size(results + count, string_data(str) + start, copy_length))
-                    goto error;
-            } else {
-                if(!string_append_string_part(results + count, str, start, copy_length))
+        char escape = (char)data[i + 1];
+        i += 2;
+        switch(escape) {
+            case '"':
+            case '\\':
+            case '/':
+                *o++ = escape;
+                break;
+            case 'b': *o++ = '\b'; break;
+            case 'f': *o++ = '\f'; break;
+            case 'n': *o++ = '\n'; break;
+            case 'r': *o++ = '\r'; break;
+            case 't': *o++ = '\t'; break;
+            case 'u': {
+                Char32 code;
+                if(!sso_string_json_hex4(data + i, length - i, &code))
                     goto error;
-            }
-
-            if(++count == results_count) {
-                if(allocate_results) {
-                    results_count *= 2;
-                    void* array = realloc(results, results_count * sizeof(*results));
-                    if(!array)
-                        goto error;
 
-                    results = array;
-                } else {
-                    *results_filled = count;
-                    return results;
+                i += 4;
+                if(code >= 0xD800 && code <= 0xDFFF) {
+                    // Only a high surrogate followed by a low one makes a code point.
+                    // The next escape is left alone when it isn't a low surrogate.
+                    Char32 low;
+                    if(code <= 0xDBFF
+                        && i + 6 <= length
+                        && data[i] == '\\'
+                        && data[i + 1] == 'u'
+                        && sso_string_json_hex4(data + i + 2, 4, &low)
+                        && low >= 0xDC00
+                        && low <= 0xDFFF)
+                    {
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                        i += 6;
+                    } else {
+                        code = SSO_UNICODE_REPLACEMENT;
+                    }
                 }
+
+                o += sso_string_u8_encode((unsigned char*)o, code);
+                break;
             }
+            default:
+                goto error;
         }
+    }
+
+    sso_string_append_commit(str, (size_t)(o - out));
+    return true;
+
+    error:
+        string_cstr(str)[size] = '\0';
+        if(out_error_offset)
+            *out_error_offset = error_offset;
+        return false;
+}
+
+// URL and HTML escaping. Like JSON strings, the text is scanned a block at a
+// time for the next character that might need rewriting and the spans between
+// them are copied at once. Encoding scans twice, once to count the escapes so
+// the result can be reserved exactly and once to write it in place. Decoding
+// never makes text longer, so the input size is reserved up front.
+
+#if defined(SSO_STRING_AVX2)
+
+// Sets the bytes of value that are between low and low + span.
+static inline __m256i sso_string_avx2_in_range(__m256i value, char low, char span) {
+    __m256i offset = _mm256_sub_epi8(value, _mm256_set1_epi8(low));
+    return _mm256_cmpeq_epi8(_mm256_min_epu8(offset, _mm256_set1_epi8(span)), offset);
+}
 
-        start = next + string_size(separator);
+#endif
 
-        // This indicates that the end of the string has been reached, and 
-        // that all relevant substrings have been copied into the results array.
-        if(start >= size) {
-            *results_filled = count;
-            return results;
-        }
-    }
+#if defined(SSO_STRING_SSE2)
 
-    error:
-        if(allocate_results)
-            free(results);
+static inline __m128i sso_string_sse2_in_range(__m128i value, char low, char span) {
+    __m128i offset = _mm_sub_epi8(value, _mm_set1_epi8(low));
+    return _mm_cmpeq_epi8(_mm_min_epu8(offset, _mm_set1_epi8(span)), offset);
+}
 
-        *results_filled = 0;
-        return NULL;
+#elif defined(SSO_STRING_NEON)
+
+static inline uint8x16_t sso_string_neon_in_range(uint8x16_t value, uint8_t low, uint8_t span) {
+    return vcleq_u8(vsubq_u8(value, vdupq_n_u8(low)), vdupq_n_u8(span));
 }
 
-SSO_STRING_EXPORT String** string_split_refs(
-    const String* str,
-    const String* separator,
-    String** results,
-    int results_count,
-    int* results_filled,
-    bool skip_empty,
-    bool init_results) 
-{
-    // Make sure the required inputs aren't NULL.
-    SSO_STRING_ASSERT_ARG(str);
-    SSO_STRING_ASSERT_ARG(separator);
+#endif
 
-    // results only needs to be initialized when results_count is > 0.
-    // On 0, it doesn't matter what state it is.
-    // On a negative number, results will be allocated by the function.
-    if(results_count > 0)
-        SSO_STRING_ASSERT_ARG(results);
+// Gets the index of the first occurrence of either of two characters, or size
+// if neither of them is found.
+static size_t sso_string_find_either(const unsigned char* data, size_t size, unsigned char first, unsigned char second) {
+    size_t i = 0;
 
-    // Nothing needs to happen if there is no room for results. Return immediately.
-    if(results_count == 0) {
-        *results_filled = 0;
-        return results;
+#if defined(SSO_STRING_AVX2)
+    {
+        const __m256i a = _mm256_set1_epi8((char)first);
+        const __m256i b = _mm256_set1_epi8((char)second);
+        for(; i + 32 <= size; i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(value, a), _mm256_cmpeq_epi8(value, b)));
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
     }
+#endif
 
-    // Determine if the results array needs to be allocated. If so, create an
-    // initial buffer that has space for two items. This is the starting space since
-    // splitting small items tends to be pretty common (e.g. an array of key-value pairs).
-    bool allocate_results = results_count < 0;
-    if(allocate_results) {
-        results_count = 2;
-        results = malloc(results_count * sizeof(*results));
-        if(!results)
-            return NULL;
-
-        // The results always have to be initialized by this function if the results array 
-        // was also created by it. UB otherwise.
-        init_results = true;
+#if defined(SSO_STRING_SSE2)
+    {
+        const __m128i a = _mm_set1_epi8((char)first);
+        const __m128i b = _mm_set1_epi8((char)second);
+        for(; i + 16 <= size; i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(value, a), _mm_cmpeq_epi8(value, b)));
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
     }
+#elif defined(SSO_STRING_NEON)
+    {
+        const uint8x16_t a = vdupq_n_u8(first);
+        const uint8x16_t b = vdupq_n_u8(second);
+        for(; i + 16 <= size; i += 16) {
+            uint8x16_t value = vld1q_u8(data + i);
+            if(!sso_string_neon_all_set(vmvnq_u8(vorrq_u8(vceqq_u8(value, a), vceqq_u8(value, b)))))
+                break;
+        }
+    }
+#endif
 
-    int count = 0;
-    size_t start = 0;
-    size_t size = string_size(str);
+    for(; i + 8 <= size; i += 8) {
+        uint64_t value = sso_string_load64(data + i);
+        uint64_t a = value ^ (SSO_STRING_SWAR_ONES * first);
+        uint64_t b = value ^ (SSO_STRING_SWAR_ONES * second);
+        if((((a - SSO_STRING_SWAR_ONES) & ~a) | ((b - SSO_STRING_SWAR_ONES) & ~b)) & SSO_STRING_SWAR_HIGHS)
+            break;
+    }
 
-    while(true) {
-        // Find the next instance of the separator. If the index is SIZE_MAX,
-        // the function reached the end of the string without finding it.
-        size_t next = string_find_string(str, start, separator);
-        if(next == SIZE_MAX)
-            next = size;
+    for(; i < size; i++) {
+        if(data[i] == first || data[i] == second)
+            return i;
+    }
 
-        size_t copy_length = next - start;
-        if(copy_length != 0 || !skip_empty) {
-            // Add the string segment to the results array. If the value fails to be added,
-            // there was an allocation error, so just break out of the function right away.
-            if(init_results) {
-                String* slice = string_create_ref("");
-                if(!slice)
-                    goto error;
-                results[count] = slice;
-            }
+    return size;
+}
 
-            if(!string_append_string_part(results[count], str, start, copy_length))
-                goto error;
+static inline bool sso_string_url_unreserved(unsigned char c) {
+    unsigned char folded = c | 0x20;
+    return (c >= '0' && c <= '9')
+        || (folded >= 'a' && folded <= 'z')
+        || c == '-'
+        || c == '.'
+        || c == '_'
+        || c == '~';
+}
 
-            if(++count == results_count) {
-                if(allocate_results) {
-                    results_count *= 2;
-                    void* array = realloc(results, results_count * sizeof(*results));
-                    if(!array)
-                        goto error;
+// Gets the index of the first character that isn't unreserved in a URL, or
+// size if there isn't one.
+static size_t sso_string_url_special(const unsigned char* data, size_t size) {
+    size_t i = 0;
 
-                    results = array;
-                } else {
-                    *results_filled = count;
-                    return results;
-                }
-            }
+#if defined(SSO_STRING_AVX2)
+    {
+        const __m256i lower = _mm256_set1_epi8(0x20);
+        const __m256i underscore = _mm256_set1_epi8('_');
+        const __m256i tilde = _mm256_set1_epi8('~');
+        for(; i + 32 <= size; i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i clean = _mm256_or_si256(
+                _mm256_or_si256(sso_string_avx2_in_range(value, '0', 9), sso_string_avx2_in_range(_mm256_or_si256(value, lower), 'a', 25)),
+                _mm256_or_si256(sso_string_avx2_in_range(value, '-', 1), _mm256_or_si256(_mm256_cmpeq_epi8(value, underscore), _mm256_cmpeq_epi8(value, tilde))));
+            uint32_t mask = ~(uint32_t)_mm256_movemask_epi8(clean);
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
         }
+    }
+#endif
 
-        start = next + string_size(separator);
-
-        // This indicates that the end of the string has been reached, and 
-        // that all relevant substrings have been copied into the results array.
-        if(start >= size) {
-            *results_filled = count;
-            return results;
+#if defined(SSO_STRING_SSE2)
+    {
+        const __m128i lower = _mm_set1_epi8(0x20);
+        const __m128i underscore = _mm_set1_epi8('_');
+        const __m128i tilde = _mm_set1_epi8('~');
+        for(; i + 16 <= size; i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i clean = _mm_or_si128(
+                _mm_or_si128(sso_string_sse2_in_range(value, '0', 9), sso_string_sse2_in_range(_mm_or_si128(value, lower), 'a', 25)),
+                _mm_or_si128(sso_string_sse2_in_range(value, '-', 1), _mm_or_si128(_mm_cmpeq_epi8(value, underscore), _mm_cmpeq_epi8(value, tilde))));
+            uint32_t mask = ~(uint32_t)_mm_movemask_epi8(clean) & 0xFFFF;
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
         }
     }
+#elif defined(SSO_STRING_NEON)
+    {
+        const uint8x16_t lower = vdupq_n_u8(0x20);
+        const uint8x16_t underscore = vdupq_n_u8('_');
+        const uint8x16_t tilde = vdupq_n_u8('~');
+        for(; i + 16 <= size; i += 16) {
+            uint8x16_t value = vld1q_u8(data + i);
+            uint8x16_t clean = vorrq_u8(
+                vorrq_u8(sso_string_neon_in_range(value, '0', 9), sso_string_neon_in_range(vorrq_u8(value, lower), 'a', 25)),
+                vorrq_u8(sso_string_neon_in_range(value, '-', 1), vorrq_u8(vceqq_u8(value, underscore), vceqq_u8(value, tilde))));
+            if(!sso_string_neon_all_set(clean))
+                break;
+        }
+    }
+#endif
 
-    error:
-        if(allocate_results) {
-            for(size_t i = 0; i < count; i++)
-                string_free(results[i]);
+    for(; i < size; i++) {
+        if(!sso_string_url_unreserved(data[i]))
+            return i;
+    }
 
-            free(results);
-        }
+    return size;
+}
 
-        *results_filled = 0;
-        return NULL;
+// Gets whether a character that isn't unreserved is written without a '%' escape.
+static inline bool sso_string_url_kept(unsigned char c, const char* safe, bool space_as_plus) {
+    return (c == ' ' && space_as_plus) || (safe && c != 0 && strchr(safe, c) != NULL);
 }
 
-SSO_STRING_EXPORT String* string_format_string(String* result, const String* format, ...) {
-    va_list argp;
+SSO_STRING_EXPORT bool string_append_url_encoded(String* str, const char* value, size_t length, const char* safe, bool space_as_plus) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
 
-    va_start(argp, format);
+    const unsigned char* data = (const unsigned char*)value;
+    size_t escapes = 0;
+    size_t i = sso_string_url_special(data, length);
+    while(i < length) {
+        if(!sso_string_url_kept(data[i], safe, space_as_plus))
+            escapes++;
 
-    result = string_format_args_cstr(result, string_data(format), argp);
+        i++;
+        i += sso_string_url_special(data + i, length - i);
+    }
 
-    va_end(argp);
+    if(length > STRING_MAX - string_size(str) || escapes > (STRING_MAX - string_size(str) - length) / 2)
+        return false;
 
-    return result;
+    size_t encoded = length + escapes * 2;
+    char* out = sso_string_append_space(str, encoded);
+    if(!out)
+        return false;
+
+    char* o = out;
+    i = 0;
+    while(true) {
+        size_t clean = sso_string_url_special(data + i, length - i);
+        memcpy(o, data + i, clean);
+        o += clean;
+        i += clean;
+        if(i == length)
+            break;
+
+        unsigned char c = data[i++];
+        if(sso_string_url_kept(c, safe, space_as_plus)) {
+            *o++ = c == ' ' && space_as_plus ? '+' : (char)c;
+        } else {
+            o[0] = '%';
+            o[1] = sso_string_hex_upper[c >> 4];
+            o[2] = sso_string_hex_upper[c & 0x0F];
+            o += 3;
+        }
+    }
+
+    sso_string_append_commit(str, encoded);
+    return true;
 }
 
-SSO_STRING_EXPORT String* string_format_cstr(String* result, const char* format, ...) {
-    va_list argp;
+SSO_STRING_EXPORT bool string_url_decode(String* str, const char* value, size_t length, bool plus_as_space, size_t* out_error_offset) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
 
-    va_start(argp, format);
+    const unsigned char* data = (const unsigned char*)value;
+    size_t size = string_size(str);
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
 
-    result = string_format_args_cstr(result, format, argp);
+    // Searching for '%' twice keeps '+' as is.
+    unsigned char plus = plus_as_space ? '+' : '%';
+    char* o = out;
+    size_t i = 0;
+    while(true) {
+        size_t clean = sso_string_find_either(data + i, length - i, '%', plus);
+        memcpy(o, data + i, clean);
+        o += clean;
+        i += clean;
+        if(i == length)
+            break;
+
+        if(data[i] == '+') {
+            *o++ = ' ';
+            i++;
+            continue;
+        }
 
-    va_end(argp);
+        int high = length - i < 3 ? -1 : sso_string_hex_values[data[i + 1]];
+        int low = length - i < 3 ? -1 : sso_string_hex_values[data[i + 2]];
+        if((high | low) < 0) {
+            string_cstr(str)[size] = '\0';
+            if(out_error_offset)
+                *out_error_offset = i;
+            return false;
+        }
 
-    return result;
-}
+        *o++ = (char)(high << 4 | low);
+        i += 3;
+    }
 
-SSO_STRING_EXPORT String* string_format_args_string(String* result, const String* format, va_list argp) {
-    return string_format_args_cstr(result, string_data(format), argp);
+    sso_string_append_commit(str, (size_t)(o - out));
+    return true;
 }
 
-SSO_STRING_EXPORT String* string_format_args_cstr(String* result, const char* format, va_list argp) {
-    #define SSO_STRING_FORMAT_BUFFER_SIZE 256
+// Gets the index of the first character that has to be escaped in HTML, or size
+// if there isn't one.
+static size_t sso_string_html_special(const unsigned char* data, size_t size) {
+    size_t i = 0;
 
-    #ifdef SSO_THREAD_LOCAL
+    // '&' and '\'' are next to each other, and '<' and '>' only differ by one
+    // bit, so five characters take three comparisons.
+#if defined(SSO_STRING_AVX2)
+    {
+        const __m256i quote = _mm256_set1_epi8('"');
+        const __m256i angle_bit = _mm256_set1_epi8(0x02);
+        const __m256i angle = _mm256_set1_epi8('>');
+        for(; i + 32 <= size; i += 32) {
+            __m256i value = _mm256_loadu_si256((const __m256i*)(data + i));
+            __m256i special = _mm256_or_si256(
+                _mm256_or_si256(_mm256_cmpeq_epi8(value, quote), sso_string_avx2_in_range(value, '&', 1)),
+                _mm256_cmpeq_epi8(_mm256_or_si256(value, angle_bit), angle));
+            uint32_t mask = (uint32_t)_mm256_movemask_epi8(special);
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
+    }
+#endif
 
-    static SSO_THREAD_LOCAL char buffer[SSO_STRING_FORMAT_BUFFER_SIZE];
+#if defined(SSO_STRING_SSE2)
+    {
+        const __m128i quote = _mm_set1_epi8('"');
+        const __m128i angle_bit = _mm_set1_epi8(0x02);
+        const __m128i angle = _mm_set1_epi8('>');
+        for(; i + 16 <= size; i += 16) {
+            __m128i value = _mm_loadu_si128((const __m128i*)(data + i));
+            __m128i special = _mm_or_si128(
+                _mm_or_si128(_mm_cmpeq_epi8(value, quote), sso_string_sse2_in_range(value, '&', 1)),
+                _mm_cmpeq_epi8(_mm_or_si128(value, angle_bit), angle));
+            uint32_t mask = (uint32_t)_mm_movemask_epi8(special);
+            if(mask != 0)
+                return i + sso_string_ctz(mask);
+        }
+    }
+#elif defined(SSO_STRING_NEON)
+    {
+        const uint8x16_t quote = vdupq_n_u8('"');
+        const uint8x16_t angle_bit = vdupq_n_u8(0x02);
+        const uint8x16_t angle = vdupq_n_u8('>');
+        for(; i + 16 <= size; i += 16) {
+            uint8x16_t value = vld1q_u8(data + i);
+            uint8x16_t special = vorrq_u8(
+                vorrq_u8(vceqq_u8(value, quote), sso_string_neon_in_range(value, '&', 1)),
+                vceqq_u8(vorrq_u8(value, angle_bit), angle));
+            if(!sso_string_neon_all_set(vmvnq_u8(special)))
+                break;
+        }
+    }
+#endif
 
-    #else
+    for(; i < size; i++) {
+        unsigned char c = data[i];
+        if(c == '"' || c == '&' || c == '\'' || c == '<' || c == '>')
+            return i;
+    }
 
-    char buffer[SSO_STRING_FORMAT_BUFFER_SIZE];
+    return size;
+}
 
-    #endif
+static inline const char* sso_string_html_escape(unsigned char c) {
+    switch(c) {
+        case '&': return "&amp;";
+        case '<': return "&lt;";
+        case '>': return "&gt;";
+        case '"': return "&quot;";
+        default: return "&#39;";
+    }
+}
 
-    SSO_STRING_ASSERT_ARG(format);
+SSO_STRING_EXPORT bool string_append_html_escaped(String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
+
+    const unsigned char* data = (const unsigned char*)value;
+    size_t extra = 0;
+    size_t i = sso_string_html_special(data, length);
+    while(i < length) {
+        extra += strlen(sso_string_html_escape(data[i])) - 1;
+        i++;
+        i += sso_string_html_special(data + i, length - i);
+    }
 
-    size_t original_size = SIZE_MAX;
-    if(!result) {
-        result = string_create_ref("");
-        if(!result)
-            return NULL;
-        
-    } else {
-        original_size = string_size(result);
+    if(length > STRING_MAX - string_size(str) || extra > STRING_MAX - string_size(str) - length)
+        return false;
+
+    size_t escaped = length + extra;
+    char* out = sso_string_append_space(str, escaped);
+    if(!out)
+        return false;
+
+    char* o = out;
+    i = 0;
+    while(true) {
+        size_t clean = sso_string_html_special(data + i, length - i);
+        memcpy(o, data + i, clean);
+        o += clean;
+        i += clean;
+        if(i == length)
+            break;
+
+        const char* escape = sso_string_html_escape(data[i++]);
+        size_t escape_length = strlen(escape);
+        memcpy(o, escape, escape_length);
+        o += escape_length;
     }
 
-    // argp may have to be used again (if the result of vsnprint is > 256), so
-    // make a copy of it to be used with the initial format.
-    va_list copy;
-    va_copy(copy, argp);
+    sso_string_append_commit(str, escaped);
+    return true;
+}
 
-    int written = vsnprintf(buffer, SSO_STRING_FORMAT_BUFFER_SIZE, format, copy);
-    va_end(copy);
+// Decodes the character reference at the start of text into out, and returns
+// how many characters it took, or 0 if text doesn't start with one.
+static size_t sso_string_html_reference(const char* text, size_t size, char** out) {
+    static const struct {
+        const char* name;
+        size_t length;
+        char value;
+    } named[] = {
+        { "&amp;", 5, '&' },
+        { "&lt;", 4, '<' },
+        { "&gt;", 4, '>' },
+        { "&quot;", 6, '"' },
+        { "&apos;", 6, '\'' }
+    };
+
+    if(size > 1 && text[1] == '#') {
+        size_t i = 2;
+        bool hex = i < size && (text[i] == 'x' || text[i] == 'X');
+        if(hex)
+            i++;
+
+        size_t start = i;
+        Char32 code = 0;
+        for(; i < size; i++) {
+            int digit = hex ? sso_string_hex_values[(unsigned char)text[i]] : text[i] >= '0' && text[i] <= '9' ? text[i] - '0' : -1;
+            if(digit < 0)
+                break;
 
-    if(written < 0) {
-        goto error;
-    } else if(written < SSO_STRING_FORMAT_BUFFER_SIZE) {
-        if(!string_append_cstr(result, buffer))\
-            goto error;
-        return result;
-    } else {
-        if(!string_reserve(result, string_size(result) + written))
-            goto error;
+            // Anything too large is replaced anyway, so stop before it can overflow.
+            if(code <= 0x10FFFF)
+                code = code * (hex ? 16 : 10) + (Char32)digit;
+        }
 
-        written = vsnprintf(
-            string_cstr(result),
-            written + 1,
-            format,
-            argp);
+        if(i == start || i == size || text[i] != ';')
+            return 0;
 
-        if(written < 0)
-            goto error;
+        if(code == 0 || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF))
+            code = SSO_UNICODE_REPLACEMENT;
 
-        size_t new_size = original_size == SIZE_MAX ? written : original_size + written;
+        *out += sso_string_u8_encode((unsigned char*)*out, code);
+        return i + 1;
+    }
 
-        // The string should always be long at this point, but do the check just in case.
-        if(sso_string_is_long(result))
-            sso_string_long_set_size(result, new_size);
-        else
-            sso_string_short_set_size(result, new_size);
+    for(size_t i = 0; i < sizeof(named) / sizeof(*named); i++) {
+        if(size >= named[i].length && memcmp(text, named[i].name, named[i].length) == 0) {
+            *(*out)++ = named[i].value;
+            return named[i].length;
+        }
     }
 
-    return result;
+    return 0;
+}
 
-    error:
-        if(original_size == SIZE_MAX)
-            string_free_resources(result);
-        else
-            string_cstr(result)[original_size] = '\0';
+SSO_STRING_EXPORT bool string_html_unescape(String* str, const char* value, size_t length) {
+    SSO_STRING_ASSERT_ARG(str);
+    SSO_STRING_ASSERT_ARG(value || length == 0);
 
-        return NULL;
+    // The shortest reference that decodes to three bytes is "&#0;", and the
+    // shortest one that decodes to four is "&#65536;", so nothing gets longer.
+    char* out = sso_string_append_space(str, length);
+    if(!out)
+        return false;
+
+    char* o = out;
+    size_t i = 0;
+    while(i < length) {
+        const char* reference = memchr(value + i, '&', length - i);
+        size_t clean = reference ? (size_t)(reference - (value + i)) : length - i;
+        memcpy(o, value + i, clean);
+        o += clean;
+        i += clean;
+        if(!reference)
+            break;
+
+        size_t used = sso_string_html_reference(value + i, length - i, &o);
+        if(used == 0) {
+            *o++ = '&';
+            used = 1;
+        }
+
+        i += used;
+    }
+
+    sso_string_append_commit(str, (size_t)(o - out));
+    return true;
 }
 
 #if SSO_STRING_SHIFT == 24
@@ -1178,4 +9738,83 @@ SSO_STRING_EXPORT size_t string_hash(String* str) {
         hash = (*(data++) ^ hash) * SSO_FNV_PRIME;
 
     return hash;
-}
\ No newline at end of file
+}
+
+SSO_STRING_EXPORT size_t string_hash_ignore_case(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t hash = SSO_FNV_OFFSET;
+    size_t i = 0;
+
+    // Fold a block at a time into a small buffer so that
+    // the hash loop doesn't need to branch on each byte.
+    unsigned char block[16];
+    for(; i + 16 <= size; i += 16) {
+        sso_string_fold_block16(block, data + i);
+        for(int j = 0; j < 16; j++)
+            hash = (block[j] ^ hash) * SSO_FNV_PRIME;
+    }
+
+    for(; i < size; i++)
+        hash = (sso_string_ascii_fold(data[i]) ^ hash) * SSO_FNV_PRIME;
+
+    return hash;
+}
+
+SSO_STRING_EXPORT size_t string_u8_hash_ignore_case(const String* str) {
+    SSO_STRING_ASSERT_ARG(str);
+
+    const unsigned char* data = (const unsigned char*)string_data(str);
+    size_t size = string_size(str);
+    size_t hash = SSO_FNV_OFFSET;
+    size_t i = 0;
+
+    // The folded codepoints are hashed in their UTF-8 form, so the result is the
+    // same as hashing a copy of the string that has been case folded.
+    while(i < size) {
+        if(data[i] <= U8_SINGLE) {
+            hash = (sso_string_ascii_fold(data[i++]) ^ hash) * SSO_FNV_PRIME;
+            continue;
+        }
+
+        int length;
+        Char32 value = sso_string_u8_decode_escaped(data + i, size - i, &length);
+        if(length == 1) {
+            // Malformed bytes are hashed as is.
+            hash = (data[i++] ^ hash) * SSO_FNV_PRIME;
+            continue;
+        }
+
+        value = sso_unicode_simple_fold(value);
+        i += length;
+
+        unsigned char encoded[4];
+        int count;
+        if(value < 0x80) {
+            encoded[0] = (unsigned char)value;
+            count = 1;
+        } else if(value < 0x800) {
+            encoded[0] = 0xC0 | (value >> 6);
+            encoded[1] = 0x80 | (value & 0x3F);
+            count = 2;
+        } else if(value < 0x10000) {
+            encoded[0] = 0xE0 | (value >> 12);
+            encoded[1] = 0x80 | ((value >> 6) & 0x3F);
+            encoded[2] = 0x80 | (value & 0x3F);
+            count = 3;
+        } else {
+            encoded[0] = 0xF0 | (value >> 18);
+            encoded[1] = 0x80 | ((value >> 12) & 0x3F);
+            encoded[2] = 0x80 | ((value >> 6) & 0x3F);
+            encoded[3] = 0x80 | (value & 0x3F);
+            count = 4;
+        }
+
+        for(int j = 0; j < count; j++)
+            hash = (encoded[j] ^ hash) * SSO_FNV_PRIME;
+    }
+
+    return hash;
+}
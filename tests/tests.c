@@ -191,6 +191,731 @@ START_TEST(string_u8_codepoints_all) {
 }
 END_TEST
 
+START_TEST(string_u8_codepoints_long_mixed) {
+    String str = string_create("");
+    size_t expected = 0;
+    // Large enough to overflow the per-lane counters of the vectorized path.
+    for(int i = 0; i < 3000; i++) {
+        string_append_cstr(&str, i % 3 == 0 ? KANA : i % 3 == 1 ? "é" : "a");
+        expected += i % 3 == 0 ? 5 : 1;
+    }
+
+    ck_assert(string_u8_codepoints(&str) == expected);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_codepoints_embedded_null) {
+    String str = string_create("ab");
+    string_push_back(&str, '\0');
+    string_append_cstr(&str, "ü");
+    ck_assert(string_u8_codepoints(&str) == 4);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_codepoints_range_clamped) {
+    String str = string_create("aé" KANA "z");
+    ck_assert(string_u8_codepoints_range(&str, 0, 3) == 2);
+    ck_assert(string_u8_codepoints_range(&str, 3, 6) == 2);
+    ck_assert(string_u8_codepoints_range(&str, 3, SIZE_MAX) == 6);
+    ck_assert(string_u8_codepoints_range(&str, string_size(&str), 10) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_substring_codepoints) {
+    // Long enough that the range starts and ends past the first few blocks.
+    String str = string_create(ALPHABET "é" ALPHABET KANA ALPHABET);
+    String out;
+    ck_assert(string_u8_substring(&str, 26, 8, &out));
+    ck_assert_str_eq(string_data(&out), "éabcdefg");
+    string_free_resources(&out);
+
+    StringView view = string_u8_substring_view(&str, 53, 6);
+    ck_assert(view.size == 16);
+    ck_assert(memcmp(view.data, KANA "a", view.size) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_substring_clamped) {
+    String str = string_create("aé" KANA);
+    String out;
+    ck_assert(string_u8_substring(&str, 2, SIZE_MAX, &out));
+    ck_assert_str_eq(string_data(&out), KANA);
+    string_free_resources(&out);
+
+    StringView view = string_u8_substring_view(&str, 100, 1);
+    ck_assert(view.size == 0);
+    ck_assert(view.data == string_data(&str) + string_size(&str));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_truncate_codepoints) {
+    String str = string_create(ALPHABET KANA ALPHABET);
+    string_u8_truncate(&str, 28);
+    ck_assert_str_eq(string_data(&str), ALPHABET "こん");
+    string_u8_truncate(&str, 100);
+    ck_assert_str_eq(string_data(&str), ALPHABET "こん");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_substring_leading_continuation) {
+    String str = string_create("\x80" "a");
+    String out;
+    ck_assert(string_u8_substring(&str, 0, 0, &out));
+    ck_assert(string_size(&out) == 0);
+    string_free_resources(&out);
+
+    ck_assert(string_u8_substring(&str, 0, 1, &out));
+    ck_assert_str_eq(string_data(&out), "\x80" "a");
+    string_free_resources(&out);
+
+    StringView view = string_u8_substring_view(&str, 0, 0);
+    ck_assert(view.size == 0);
+    ck_assert(view.data == string_data(&str));
+
+    string_u8_truncate(&str, 1);
+    ck_assert_str_eq(string_data(&str), "\x80" "a");
+    string_u8_truncate(&str, 0);
+    ck_assert(string_size(&str) == 0);
+    ck_assert_str_eq(string_data(&str), "");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_truncate_bytes_boundary) {
+    String str = string_create("aé\xF0\x9F\x98\x80z");
+    string_u8_truncate_bytes(&str, 100);
+    ck_assert(string_size(&str) == 8);
+    string_u8_truncate_bytes(&str, 6);
+    ck_assert_str_eq(string_data(&str), "aé");
+    string_u8_truncate_bytes(&str, 2);
+    ck_assert_str_eq(string_data(&str), "a");
+    string_u8_truncate_bytes(&str, 0);
+    ck_assert_str_eq(string_data(&str), "");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_utf16_surrogate_pairs) {
+    String str = string_create(ALPHABET "é" KANA "\xF0\x9F\x98\x80" ALPHABET);
+    size_t length = string_u8_utf16_length(&str);
+    ck_assert(length == 2 * strlen(ALPHABET) + 1 + 5 + 2);
+
+    Char16 small_buffer[4];
+    ck_assert(string_u8_to_utf16(&str, small_buffer, ARRAY_SIZE(small_buffer)) == SIZE_MAX);
+
+    Char16 buffer[64];
+    ck_assert(string_u8_to_utf16(&str, buffer, ARRAY_SIZE(buffer)) == length);
+    ck_assert(buffer[0] == 'a');
+    ck_assert(buffer[26] == 0xE9);
+    ck_assert(buffer[27] == 0x3053);
+    ck_assert(buffer[32] == 0xD83D);
+    ck_assert(buffer[33] == 0xDE00);
+    ck_assert(buffer[length - 1] == 'z');
+
+    String round_trip = string_create("");
+    ck_assert(string_u8_from_utf16(&round_trip, buffer, length));
+    ck_assert(string_equals(&str, &round_trip));
+
+    string_free_resources(&round_trip);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_from_utf16_unpaired_surrogates) {
+    Char16 units[] = { 'a', 0xD800, 'b', 0xDC00, 0xD83D };
+    String str = string_create("x");
+    ck_assert(string_u8_from_utf16(&str, units, ARRAY_SIZE(units)));
+    ck_assert_str_eq(string_data(&str), "xa\xEF\xBF\xBD" "b\xEF\xBF\xBD\xEF\xBF\xBD");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_utf32_round_trip) {
+    Char32 all_codepoints[] = ALL_CODEPOINTS;
+    String str = string_create(ALPHABET);
+    ck_assert(string_u8_from_utf32(&str, all_codepoints, ARRAY_SIZE(all_codepoints)));
+    ck_assert(string_u8_utf32_length(&str) == strlen(ALPHABET) + ARRAY_SIZE(all_codepoints));
+
+    Char32 buffer[64];
+    size_t length = string_u8_to_utf32(&str, buffer, ARRAY_SIZE(buffer));
+    ck_assert(length == strlen(ALPHABET) + ARRAY_SIZE(all_codepoints));
+    ck_assert(buffer[0] == 'a');
+    for(int i = 0; i < ARRAY_SIZE(all_codepoints); i++)
+        ck_assert(buffer[strlen(ALPHABET) + i] == all_codepoints[i]);
+
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_utf32_invalid_bytes) {
+    String str = string_create("a\xFF\xE3\x81z");
+    Char32 buffer[8];
+    ck_assert(string_u8_to_utf32(&str, buffer, ARRAY_SIZE(buffer)) == 5);
+    ck_assert(buffer[0] == 'a');
+    ck_assert(buffer[1] == 0xFFFD);
+    ck_assert(buffer[2] == 0xFFFD);
+    ck_assert(buffer[3] == 0xFFFD);
+    ck_assert(buffer[4] == 'z');
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_iter_forward_and_back) {
+    Char32 expected[] = { 'a', 0xE9, 0x3053, 0x1F600, 'z' };
+    String str = string_create("a\xC3\xA9\xE3\x81\x93\xF0\x9F\x98\x80z");
+    StringU8Iter iter;
+    Char32 value;
+    int count = 0;
+
+    string_u8_iter_init(&iter, &str);
+    while(string_u8_iter_next(&iter, &value))
+        ck_assert(value == expected[count++]);
+    ck_assert(count == 5);
+    ck_assert(iter.position == string_size(&str));
+
+    string_u8_iter_init_end(&iter, &str);
+    while(string_u8_iter_prev(&iter, &value))
+        ck_assert(value == expected[--count]);
+    ck_assert(count == 0);
+    ck_assert(iter.position == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_iter_invalid_bytes) {
+    // An overlong encoding, a surrogate and a truncated sequence.
+    String str = string_create("\xC0\xAF\xED\xA0\x80\xE3\x81");
+    StringU8Iter iter;
+    Char32 value;
+    int count = 0;
+
+    string_u8_iter_init(&iter, &str);
+    while(string_u8_iter_next(&iter, &value)) {
+        ck_assert(value == 0xFFFD);
+        count++;
+    }
+    ck_assert(count == 7);
+
+    string_u8_iter_init_end(&iter, &str);
+    while(string_u8_iter_prev(&iter, &value)) {
+        ck_assert(value == 0xFFFD);
+        count--;
+    }
+    ck_assert(count == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_iter_decode_chunks) {
+    String str = string_create(ALPHABET ALPHABET KANA ALPHABET);
+    Char32 expected[83];
+    Char32 buffer[83];
+    size_t total = 0;
+    size_t count;
+    StringU8Iter iter;
+
+    ck_assert(string_u8_to_utf32(&str, expected, ARRAY_SIZE(expected)) == 83);
+
+    string_u8_iter_init(&iter, &str);
+    while((count = string_u8_iter_decode(&iter, buffer + total, 20)) > 0)
+        total += count;
+
+    ck_assert(total == 83);
+    ck_assert(memcmp(buffer, expected, sizeof(expected)) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_iter_decode_invalid_in_ascii_block) {
+    // A single invalid byte at any offset of a block has to stop it from being widened as ASCII.
+    for(int offset = 0; offset < 16; offset++) {
+        for(int invalid = 0; invalid < 2; invalid++) {
+            char text[33];
+            memset(text, 'a', 32);
+            text[32] = '\0';
+            text[offset] = invalid ? (char)0xC3 : (char)0x80;
+            String str = string_create(text);
+            Char32 buffer[32];
+            StringU8Iter iter;
+            string_u8_iter_init(&iter, &str);
+            ck_assert_uint_eq(string_u8_iter_decode(&iter, buffer, 32), 32);
+            for(int i = 0; i < 32; i++)
+                ck_assert_uint_eq(buffer[i], i == offset ? 0xFFFD : 'a');
+            string_free_resources(&str);
+        }
+    }
+}
+END_TEST
+
+START_TEST(string_u8_decode_into_max) {
+    String str = string_create(KANA ALPHABET);
+    Char32 buffer[8];
+    ck_assert(string_u8_decode_into(&str, buffer, 6) == 6);
+    ck_assert(buffer[0] == 0x3053);
+    ck_assert(buffer[5] == 'a');
+    ck_assert(string_u8_decode_into(&str, buffer, 0) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_lower_mixed) {
+    String str = string_create("HELLO, WORLD! ÀÉÎ ΑΒΓ АБВ " ALPHABET);
+    ck_assert(string_u8_to_lower(&str));
+    ck_assert_str_eq(string_data(&str), "hello, world! àéî αβγ абв " ALPHABET);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_lower_final_sigma) {
+    String str = string_create("ΟΔΟΣ ΣΟΦΟΣ. Σ");
+    ck_assert(string_u8_to_lower(&str));
+    ck_assert_str_eq(string_data(&str), "οδος σοφος. σ");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_upper_expands) {
+    String str = string_create("straße ǆ ﬁ");
+    ck_assert(string_u8_to_upper(&str));
+    ck_assert_str_eq(string_data(&str), "STRASSE Ǆ FI");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_case_fold_into_appends) {
+    String str = string_create("Straße ΜΆΪΟΣ İ");
+    String out = string_create("folded: ");
+    ck_assert(string_u8_case_fold_into(&str, &out));
+    ck_assert_str_eq(string_data(&out), "folded: strasse μάϊοσ i\xCC\x87");
+    ck_assert_str_eq(string_data(&str), "Straße ΜΆΪΟΣ İ");
+    string_free_resources(&out);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_append_codepoints_mixed) {
+    // Runs of ASCII and two byte characters long enough to be encoded in blocks,
+    // followed by wider characters and invalid values.
+    Char32 values[] = {
+        'a', 'b', 'c', 'd', 0x43F, 0x440, 0x438, 0x432, 0x435, 0x442,
+        0x3053, 0x1F600, 0xD800, 0x110000, 'z'
+    };
+    String str = string_create("> ");
+    ck_assert(string_u8_append_codepoints(&str, values, ARRAY_SIZE(values)));
+    ck_assert_str_eq(string_data(&str), "> abcdпривет\xE3\x81\x93\xF0\x9F\x98\x80\xEF\xBF\xBD\xEF\xBF\xBDz");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_from_latin1_mixed) {
+    // A run of ASCII long enough to be copied in blocks, then bytes that all
+    // become two byte sequences, including the C1 range.
+    const char latin1[] = "plain ascii text here: caf\xE9 \x80\x9F \xA9\xFF";
+    String str = string_create("> ");
+    ck_assert(string_u8_from_latin1(&str, latin1, sizeof(latin1) - 1));
+    ck_assert_str_eq(string_data(&str), "> plain ascii text here: café \xC2\x80\xC2\x9F ©ÿ");
+    ck_assert(string_u8_from_latin1(&str, "", 0));
+    ck_assert_str_eq(string_data(&str), "> plain ascii text here: café \xC2\x80\xC2\x9F ©ÿ");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_from_cp1252_specials) {
+    // Smart quotes, the euro sign and the undefined bytes, which become C1 controls.
+    const char cp1252[] = "\x93quoted\x94 \x80" "5 \x81\x8D\x8F\x90\x9D \x9F\xE9";
+    String str = string_create("");
+    ck_assert(string_u8_from_cp1252(&str, cp1252, sizeof(cp1252) - 1));
+    ck_assert_str_eq(string_data(&str), "“quoted” €5 \xC2\x81\xC2\x8D\xC2\x8F\xC2\x90\xC2\x9D Ÿé");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_latin1_errors) {
+    String str = string_create("café \xE2\x82\xAC \xFF!");
+    char out[16];
+    size_t error_offset = 0;
+
+    ck_assert_uint_eq(string_u8_to_latin1(&str, out, 7, STRING_ENCODING_REPLACE, NULL), SIZE_MAX);
+
+    size_t written = string_u8_to_latin1(&str, out, sizeof(out), STRING_ENCODING_REPLACE, NULL);
+    ck_assert_uint_eq(written, 9);
+    ck_assert(memcmp(out, "caf\xE9 ? ?!", 9) == 0);
+
+    ck_assert_uint_eq(string_u8_to_latin1(&str, out, sizeof(out), STRING_ENCODING_STRICT, &error_offset), SIZE_MAX);
+    ck_assert_uint_eq(error_offset, 6);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_to_cp1252_round_trip) {
+    char cp1252[256];
+    for(int i = 0; i < 256; i++)
+        cp1252[i] = (char)i;
+
+    String str = string_create("");
+    ck_assert(string_u8_from_cp1252(&str, cp1252, sizeof(cp1252)));
+
+    char out[256];
+    size_t error_offset = 0;
+    ck_assert_uint_eq(string_u8_to_cp1252(&str, out, sizeof(out), STRING_ENCODING_STRICT, &error_offset), 256);
+    ck_assert(memcmp(out, cp1252, sizeof(cp1252)) == 0);
+
+    string_clear(&str);
+    ck_assert(string_append_cstr(&str, "Ā"));
+    ck_assert_uint_eq(string_u8_to_cp1252(&str, out, sizeof(out), STRING_ENCODING_STRICT, &error_offset), SIZE_MAX);
+    ck_assert_uint_eq(error_offset, 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+static Char32 test_map_transliterate(Char32 value, void* state) {
+    int* calls = state;
+    (*calls)++;
+    switch(value) {
+        case 0x43F: return 'p';
+        case 0x440: return 'r';
+        case 0x438: return 'i';
+        case 0x432: return 'v';
+        case 0x435: return 'e';
+        case 0x442: return 't';
+        case '-': return SSO_STRING_U8_MAP_DELETE;
+        default: return value;
+    }
+}
+
+static Char32 test_map_widen(Char32 value, void* state) {
+    return value >= 'a' && value <= 'z' ? value - 'a' + 0xFF41 : value;
+}
+
+START_TEST(string_u8_map_shrinks) {
+    String str = string_create("при-вет " ALPHABET);
+    int calls = 0;
+    ck_assert(string_u8_map(&str, test_map_transliterate, &calls));
+    ck_assert_str_eq(string_data(&str), "privet " ALPHABET);
+    ck_assert(calls == 34);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_map_grows) {
+    // Each letter becomes its three byte fullwidth form, so the result grows
+    // well past the size of the input.
+    String str = string_create("\xFF" ALPHABET);
+    ck_assert(string_u8_map(&str, test_map_widen, NULL));
+    ck_assert(string_size(&str) == 1 + 26 * 3);
+    ck_assert(string_starts_with(&str, "\xFF\xEF\xBD\x81\xEF\xBD\x82"));
+    ck_assert(string_u8_get(&str, string_size(&str) - 3) == 0xFF5A);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_map_unchanged) {
+    String str = string_create(ALPHABET KANA ALPHABET);
+    const char* data = string_data(&str);
+    int calls = 0;
+    ck_assert(string_u8_map(&str, test_map_transliterate, &calls));
+    ck_assert(string_data(&str) == data);
+    ck_assert_str_eq(string_data(&str), ALPHABET KANA ALPHABET);
+    ck_assert(calls == 26 * 2 + 5);
+
+    // The first codepoint changes, so nothing is kept from the original buffer.
+    string_insert_cstr(&str, "-", 0);
+    ck_assert(string_u8_map(&str, test_map_transliterate, &calls));
+    ck_assert_str_eq(string_data(&str), ALPHABET KANA ALPHABET);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_map_table_remaps) {
+    Char32 table[128];
+    for(int i = 0; i < 128; i++)
+        table[i] = i;
+    table['a'] = 0xE4;
+    table['o'] = 0xF6;
+    table[' '] = SSO_STRING_U8_MAP_DELETE;
+
+    String str = string_create("a lot of " KANA);
+    ck_assert(string_u8_map_table(&str, table, ARRAY_SIZE(table)));
+    ck_assert_str_eq(string_data(&str), "älötöf" KANA);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_normalize_forms) {
+    // "é" written as e + combining acute, the "ﬁ" ligature and a Hangul syllable.
+    const char* text = "Cafe\xCC\x81 \xEF\xAC\x81 \xED\x9E\xA3";
+    const char* expected[] = {
+        "Caf\xC3\xA9 \xEF\xAC\x81 \xED\x9E\xA3",
+        "Cafe\xCC\x81 \xEF\xAC\x81 \xE1\x84\x92\xE1\x85\xB5\xE1\x87\x82",
+        "Caf\xC3\xA9 fi \xED\x9E\xA3",
+        "Cafe\xCC\x81 fi \xE1\x84\x92\xE1\x85\xB5\xE1\x87\x82"
+    };
+    StringNormalization forms[] = { STRING_NFC, STRING_NFD, STRING_NFKC, STRING_NFKD };
+
+    for(int i = 0; i < 4; i++) {
+        String str = string_create(text);
+        ck_assert(string_u8_normalize(&str, forms[i]));
+        ck_assert_str_eq(string_data(&str), expected[i]);
+        ck_assert(string_u8_is_normalized(&str, forms[i]));
+        string_free_resources(&str);
+    }
+}
+END_TEST
+
+START_TEST(string_u8_normalize_reorders_marks) {
+    // a + circumflex + dot below, where the dot below has the lower combining class.
+    String str = string_create("a\xCC\x82\xCC\xA3");
+    ck_assert(!string_u8_is_normalized(&str, STRING_NFD));
+    ck_assert(string_u8_normalize(&str, STRING_NFD));
+    ck_assert_str_eq(string_data(&str), "a\xCC\xA3\xCC\x82");
+    ck_assert(string_u8_normalize(&str, STRING_NFC));
+    ck_assert_str_eq(string_data(&str), "\xE1\xBA\xAD");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_normalize_sorts_long_runs) {
+    // Acute (230) interleaved with grave below and dot below (both 220). The
+    // marks with the same class have to keep their order.
+    String str = string_create("a");
+    String expected = string_create("a");
+    for(int i = 0; i < 40; i++) {
+        string_append_cstr(&str, "\xCC\x81\xCC\x96\xCC\xA3");
+        string_append_cstr(&expected, "\xCC\x96\xCC\xA3");
+    }
+    for(int i = 0; i < 40; i++)
+        string_append_cstr(&expected, "\xCC\x81");
+    string_append_cstr(&str, "b");
+    string_append_cstr(&expected, "b");
+
+    ck_assert(string_u8_normalize(&str, STRING_NFD));
+    ck_assert(string_equals_string(&str, &expected));
+    string_free_resources(&expected);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_normalize_unchanged) {
+    String str = string_create(ALPHABET " \xC3\xA9 " KANA " \xFF");
+    const char* data = string_data(&str);
+    ck_assert(string_u8_is_normalized(&str, STRING_NFC));
+    ck_assert(string_u8_normalize(&str, STRING_NFC));
+    ck_assert(string_data(&str) == data);
+    ck_assert_str_eq(string_data(&str), ALPHABET " \xC3\xA9 " KANA " \xFF");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_normalize_into_appends) {
+    String str = string_create("\xEF\xAC\x81\xC3\xA9");
+    String out = string_create("nfkd: ");
+    ck_assert(string_u8_normalize_into(&str, &out, STRING_NFKD));
+    ck_assert_str_eq(string_data(&out), "nfkd: fie\xCC\x81");
+    ck_assert_str_eq(string_data(&str), "\xEF\xAC\x81\xC3\xA9");
+    string_free_resources(&out);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_gc_next_and_prev) {
+    // e + combining acute, a flag, a family emoji joined with ZWJs and CR LF.
+    String str = string_create("e\xCC\x81\xF0\x9F\x87\xAF\xF0\x9F\x87\xB5"
+        "\xF0\x9F\x91\xA8\xE2\x80\x8D\xF0\x9F\x91\xA9\xE2\x80\x8D\xF0\x9F\x91\xA7\r\nx");
+    size_t boundaries[] = { 0, 3, 11, 29, 31, 32 };
+
+    for(int i = 0; i < 5; i++) {
+        ck_assert(string_gc_next(&str, boundaries[i]) == boundaries[i + 1]);
+        ck_assert(string_gc_prev(&str, boundaries[i + 1]) == boundaries[i]);
+    }
+
+    ck_assert(string_gc_next(&str, 32) == 32);
+    ck_assert(string_gc_prev(&str, 0) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_gc_count_clusters) {
+    String str = string_create(ALPHABET "\r\n" KANA);
+    ck_assert(string_gc_count(&str) == 32);
+    string_clear(&str);
+    ck_assert(string_gc_count(&str) == 0);
+
+    // Regional indicators pair up into flags.
+    string_append_cstr(&str, "\xF0\x9F\x87\xAF\xF0\x9F\x87\xB5\xF0\x9F\x87\xAF");
+    ck_assert(string_gc_count(&str) == 2);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_gc_pop_back_cluster) {
+    String str = string_create("abe\xCC\x81\xCC\xA3");
+    ck_assert(string_gc_pop_back(&str) == 5);
+    ck_assert_str_eq(string_data(&str), "ab");
+    ck_assert(string_gc_pop_back(&str) == 1);
+    ck_assert(string_gc_pop_back(&str) == 1);
+    ck_assert(string_gc_pop_back(&str) == 0);
+    ck_assert(string_size(&str) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_gc_truncate_clusters) {
+    String str = string_create("Cafe\xCC\x81 \xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD!");
+    string_gc_truncate(&str, 7);
+    ck_assert_str_eq(string_data(&str), "Cafe\xCC\x81 \xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD!");
+    string_gc_truncate(&str, 6);
+    ck_assert_str_eq(string_data(&str), "Cafe\xCC\x81 \xF0\x9F\x91\x8D\xF0\x9F\x8F\xBD");
+    string_gc_truncate(&str, 4);
+    ck_assert_str_eq(string_data(&str), "Cafe\xCC\x81");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_offset_of_matches_scan) {
+    String str = string_create("");
+    for(int i = 0; i < 500; i++)
+        string_u8_push_back(&str, i % 4 == 0 ? 'a' : i % 4 == 1 ? 0xE9 : i % 4 == 2 ? 0x3053 : 0x1F600);
+
+    StringU8Index index;
+    ck_assert(string_u8_index_init(&index, &str));
+    ck_assert(string_u8_index_codepoints(&index, &str) == 500);
+
+    size_t offset = 0;
+    for(size_t i = 0; i < 500; i++) {
+        ck_assert(string_u8_offset_of(&index, &str, i) == offset);
+        ck_assert(string_u8_position_of(&index, &str, offset) == i);
+        ck_assert(string_u8_position_of(&index, &str, offset + string_u8_codepoint_size(&str, offset) - 1) == i);
+        offset += string_u8_codepoint_size(&str, offset);
+    }
+
+    ck_assert(string_u8_offset_of(&index, &str, 500) == string_size(&str));
+    ck_assert(string_u8_offset_of(&index, &str, 501) == SIZE_MAX);
+    ck_assert(string_u8_position_of(&index, &str, string_size(&str)) == 500);
+
+    string_u8_index_free_resources(&index);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_index_incremental_updates) {
+    String str = string_create("");
+    StringU8Index index;
+    ck_assert(string_u8_index_init(&index, &str));
+
+    for(int i = 0; i < 300; i++)
+        ck_assert(string_u8_index_push_back(&index, &str, i % 2 == 0 ? 'x' : 0x3053));
+
+    // Grow and shrink characters near the start so every later entry moves.
+    ck_assert(string_u8_index_set(&index, &str, 0, 0x1F600));
+    ck_assert(string_u8_index_set(&index, &str, string_u8_offset_of(&index, &str, 1), 'y'));
+    ck_assert(string_u8_index_pop_back(&index, &str) == 0x3053);
+    ck_assert(string_u8_index_pop_back(&index, &str) == 'x');
+
+    StringU8Index fresh;
+    ck_assert(string_u8_index_init(&fresh, &str));
+    ck_assert(index.count == fresh.count);
+    ck_assert(string_u8_index_codepoints(&index, &str) == 298);
+    for(size_t i = 0; i < fresh.count; i++)
+        ck_assert(index.offsets[i] == fresh.offsets[i]);
+
+    string_u8_index_free_resources(&fresh);
+    string_u8_index_free_resources(&index);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_index_rebuilds_after_invalidate) {
+    String str = string_create(KANA);
+    StringU8Index index;
+    ck_assert(string_u8_index_init(&index, &str));
+    ck_assert(string_u8_offset_of(&index, &str, 2) == 6);
+
+    // Same size, different layout.
+    string_replace_cstr(&str, 0, 3, "abc");
+    string_u8_index_invalidate(&index);
+    ck_assert(string_u8_offset_of(&index, &str, 2) == 2);
+    ck_assert(string_u8_index_codepoints(&index, &str) == 7);
+
+    // A change in size is detected without invalidating.
+    string_append_cstr(&str, "!");
+    ck_assert(string_u8_index_codepoints(&index, &str) == 8);
+
+    string_u8_index_free_resources(&index);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_validate_valid) {
+    String str = string_create("");
+    Char32 all_codepoints[] = ALL_CODEPOINTS;
+    for(int i = 0; i < ARRAY_SIZE(all_codepoints); i++)
+        string_u8_push_back(&str, all_codepoints[i]);
+
+    size_t offset = 0;
+    ck_assert(string_u8_validate(&str, &offset));
+    ck_assert(offset == SIZE_MAX);
+    ck_assert(string_u8_is_valid(&small));
+    ck_assert(string_u8_is_valid(&large));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_validate_error_offset) {
+    const char* invalid[] = {
+        ALPHABET ALPHABET "\xC0\xAF",       // Overlong
+        ALPHABET ALPHABET "\xED\xA0\x80",   // Surrogate
+        ALPHABET ALPHABET "\xF4\x90\x80\x80", // Above U+10FFFF
+        ALPHABET ALPHABET "\xE3\x81",       // Truncated
+        ALPHABET ALPHABET "\x80",           // Lone continuation
+        ALPHABET ALPHABET "\xE3\x81z"       // Missing continuation
+    };
+
+    for(int i = 0; i < ARRAY_SIZE(invalid); i++) {
+        String str = string_create(invalid[i]);
+        size_t offset = 0;
+        ck_assert(!string_u8_validate(&str, &offset));
+        ck_assert(offset == 2 * strlen(ALPHABET));
+        ck_assert(!string_u8_is_valid(&str));
+        string_free_resources(&str);
+    }
+}
+END_TEST
+
+START_TEST(string_u8_validator_split_sequences) {
+    const char* text = "aé" KANA "\xF0\x9F\x98\x80z";
+    size_t size = strlen(text);
+
+    // Feed the text one byte at a time so every sequence is split.
+    StringU8Validator validator;
+    string_u8_validator_init(&validator);
+    for(size_t i = 0; i < size; i++)
+        ck_assert(string_u8_validator_update(&validator, text + i, 1));
+
+    size_t offset = 0;
+    ck_assert(string_u8_validator_finish(&validator, &offset));
+    ck_assert(offset == SIZE_MAX);
+
+    string_u8_validator_init(&validator);
+    ck_assert(string_u8_validator_update(&validator, text, 4));
+    ck_assert(string_u8_validator_update(&validator, text + 4, 1));
+    ck_assert(!string_u8_validator_update(&validator, "z", 1));
+    ck_assert(!string_u8_validator_finish(&validator, &offset));
+    ck_assert(offset == 3);
+
+    // A sequence that is still incomplete at the end of the stream is an error.
+    string_u8_validator_init(&validator);
+    ck_assert(string_u8_validator_update(&validator, text, 5));
+    ck_assert(!string_u8_validator_finish(&validator, &offset));
+    ck_assert(offset == 3);
+}
+END_TEST
+
 START_TEST(string_get_all) {
     String kana = string_create(KANA);
     String strings[3] = { small, large, kana };
@@ -1152,7 +1877,125 @@ START_TEST(string_replace_string_grow_small_to_large) {
 }
 END_TEST
 
-START_TEST(string_substring_part) {
+START_TEST(string_replace_all_cstr_shrink) {
+    String str = string_create("one, two, three, four, five, six");
+    ck_assert(string_replace_all_cstr(&str, ", ", ";"));
+    ck_assert(string_equals(&str, "one;two;three;four;five;six"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_all_cstr_same_size) {
+    ck_assert(string_replace_all_cstr(&small, "l", "r"));
+    ck_assert(string_equals(&small, "herro"));
+}
+END_TEST
+
+START_TEST(string_replace_all_cstr_grow_small_to_large) {
+    String str = string_create("a-b-c-d");
+    ck_assert(string_replace_all_cstr(&str, "-", " and then "));
+    ck_assert(string_equals(&str, "a and then b and then c and then d"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_all_cstr_none) {
+    ck_assert(string_replace_all_cstr(&small, "z", "longer replacement"));
+    ck_assert(string_equals(&small, HELLO));
+}
+END_TEST
+
+START_TEST(string_replace_all_string_grow) {
+    String value = string_create("l");
+    String replacement = string_create("LL");
+    ck_assert(string_replace_all_string(&small, &value, &replacement));
+    ck_assert(string_equals(&small, "heLLLLo"));
+    string_free_resources(&value);
+    string_free_resources(&replacement);
+}
+END_TEST
+
+START_TEST(string_replace_first_n_cstr_limits_count) {
+    String str = string_create("a.b.c.d");
+    ck_assert(string_replace_first_n_cstr(&str, ".", "::", 2));
+    ck_assert(string_equals(&str, "a::b::c.d"));
+    ck_assert(string_replace_first_n_cstr(&str, "::", "", 1));
+    ck_assert(string_equals(&str, "ab::c.d"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_many_cstr_template) {
+    const char* values[] = { "{name}", "{age}", "{missing}" };
+    const char* replacements[] = { "Alice", "23", "" };
+    String str = string_create("{name} is {age}. {name}!");
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_equals(&str, "Alice is 23. Alice!"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_many_cstr_leftmost_longest) {
+    const char* values[] = { "bc", "abcd", "he", "hello", "ell", "lo" };
+    const char* replacements[] = { "1", "2", "3", "4", "5", "6" };
+    String str = string_create("abcd hello there abc");
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_equals(&str, "2 4 t3re a1"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_many_cstr_in_place) {
+    const char* values[] = { "xyz", "ab", "c" };
+    const char* replacements[] = { "", "ABCDEF", "-" };
+    String str = string_create("hello");
+    const char* data = string_data(&str);
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_data(&str) == data);
+    ck_assert(string_equals(&str, "hello"));
+    string_free_resources(&str);
+
+    str = string_create("xyzxyzxyz ab c xyzab");
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_equals(&str, " ABCDEF - ABCDEF"));
+
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_equals(&str, " ABCDEF - ABCDEF"));
+    string_free_resources(&str);
+
+    str = string_create("abababababababababababababababababab");
+    ck_assert(string_replace_many_cstr(&str, values, replacements, ARRAY_SIZE(values)));
+    ck_assert(string_equals(&str,
+        "ABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEF"
+        "ABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEFABCDEF"));
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_replace_many_string_does_not_rescan) {
+    String values[2];
+    String replacements[2];
+    string_init(values + 0, "a");
+    string_init(values + 1, "b");
+    string_init(replacements + 0, "b");
+    string_init(replacements + 1, "a");
+
+    ck_assert(string_replace_many_string(&small, values, replacements, 2));
+    ck_assert(string_equals(&small, HELLO));
+
+    String str = string_create("abba");
+    ck_assert(string_replace_many_string(&str, values, replacements, 2));
+    ck_assert(string_equals(&str, "baab"));
+
+    for(int i = 0; i < 2; i++) {
+        string_free_resources(values + i);
+        string_free_resources(replacements + i);
+    }
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_substring_part) {
     String hell;
     ck_assert(string_substring(&small, 0, 4, &hell));
     ck_assert(string_equals(&hell, "hell"));
@@ -1382,6 +2225,69 @@ START_TEST(string_is_null_or_whitespace_filled) {
 }
 END_TEST
 
+START_TEST(string_trim_both_ends) {
+    // Leading ASCII and ideographic spaces, trailing no-break space and newline.
+    String str = string_create("  \t\xE3\x80\x80" ALPHABET " " KANA "\xC2\xA0\n");
+    string_trim(&str);
+    ck_assert_str_eq(string_data(&str), ALPHABET " " KANA);
+
+    string_clear(&str);
+    string_append_cstr(&str, " \t hello");
+    string_trim_end(&str);
+    ck_assert_str_eq(string_data(&str), " \t hello");
+    string_trim_start(&str);
+    ck_assert_str_eq(string_data(&str), "hello");
+
+    string_clear(&str);
+    string_append_cstr(&str, " \r\n ");
+    string_trim(&str);
+    ck_assert(string_size(&str) == 0);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_trim_views) {
+    String str = string_create("\xE2\x80\x83 " ALPHABET "\t ");
+    StringView view = string_trim_view(&str);
+    ck_assert(view.size == 26);
+    ck_assert(memcmp(view.data, ALPHABET, 26) == 0);
+
+    view = string_trim_start_view(&str);
+    ck_assert(view.data == string_data(&str) + 4);
+    ck_assert(view.size == 28);
+
+    view = string_trim_end_view(&str);
+    ck_assert(view.data == string_data(&str));
+    ck_assert(view.size == 30);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_pad_sides) {
+    String str = string_create("42");
+    ck_assert(string_pad_left(&str, 5, '0'));
+    ck_assert_str_eq(string_data(&str), "00042");
+    ck_assert(string_pad_right(&str, 40, '.'));
+    ck_assert_str_eq(string_data(&str), "00042...................................");
+    ck_assert(string_pad_left(&str, 3, ' '));
+    ck_assert(string_size(&str) == 40);
+
+    string_clear(&str);
+    string_append_cstr(&str, "ab");
+    ck_assert(string_pad_center(&str, 7, '*'));
+    ck_assert_str_eq(string_data(&str), "**ab***");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_collapse_whitespace_runs) {
+    String str = string_create("  a\t\t b\xC2\xA0\n" KANA "\xE2\x80\x82 " ALPHABET ALPHABET " ");
+    string_collapse_whitespace(&str);
+    ck_assert_str_eq(string_data(&str), " a b " KANA " " ALPHABET ALPHABET " ");
+    string_free_resources(&str);
+}
+END_TEST
+
 START_TEST(string_reverse_bytes_ascii) {
     string_reverse_bytes(&small);
     ck_assert(string_equals(&small, "olleh"));
@@ -1402,6 +2308,20 @@ START_TEST(string_reverse_bytes_utf8) {
 }
 END_TEST
 
+START_TEST(string_reverse_bytes_long) {
+    // Long enough to go through every block size, with an odd byte in the middle.
+    char expected[ARRAY_SIZE(ALPHABET) * 4];
+    for(size_t i = 0; i < ARRAY_SIZE(expected) - 1; i++)
+        expected[i] = ALPHABET[(ARRAY_SIZE(expected) - 2 - i) % 26];
+    expected[ARRAY_SIZE(expected) - 1] = '\0';
+
+    String str = string_create(ALPHABET ALPHABET ALPHABET ALPHABET "abc");
+    string_reverse_bytes(&str);
+    ck_assert_str_eq(string_data(&str), expected);
+    string_free_resources(&str);
+}
+END_TEST
+
 START_TEST(string_u8_reverse_codepoints_ascii) {
     string_u8_reverse_codepoints(&small);
     ck_assert(string_equals(&small, "olleh"));
@@ -1417,6 +2337,36 @@ START_TEST(string_u8_reverse_codepoints_utf8) {
 }
 END_TEST
 
+START_TEST(string_u8_reverse_codepoints_mixed) {
+    String str = string_create("ab\xC3\xA9" KANA "\xF0\x9F\x98\x80" ALPHABET ALPHABET "\xD0\xBF");
+    string_u8_reverse_codepoints(&str);
+    ck_assert_str_eq(
+        string_data(&str), 
+        "\xD0\xBF" "zyxwvutsrqponmlkjihgfedcbazyxwvutsrqponmlkjihgfedcba" "\xF0\x9F\x98\x80" "はちにんこ" "\xC3\xA9" "ba");
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_reverse_codepoints_invalid) {
+    // Continuation bytes stay with their lead byte even if there are too many,
+    // and stray ones after ASCII stay together but apart from the ASCII byte.
+    String str = string_create("a\xC3\xA9\xA9" "b\x80\x80" "c");
+    string_u8_reverse_codepoints(&str);
+    ck_assert_str_eq(string_data(&str), "c" "\x80\x80" "b" "\xC3\xA9\xA9" "a");
+    string_free_resources(&str);
+
+    str = string_create("a\x80" "b");
+    string_u8_reverse_codepoints(&str);
+    ck_assert_str_eq(string_data(&str), "b\x80" "a");
+    string_free_resources(&str);
+
+    str = string_create("\xC3\xA9\x80" "b");
+    string_u8_reverse_codepoints(&str);
+    ck_assert_str_eq(string_data(&str), "b\xC3\xA9\x80");
+    string_free_resources(&str);
+}
+END_TEST
+
 START_TEST(string_join_none) {
     ck_assert(string_join(NULL, NULL, NULL, 0));
 }
@@ -1743,6 +2693,42 @@ START_TEST(string_format_string_append) {
 }
 END_TEST
 
+START_TEST(string_format_cstr_capacity_boundary) {
+    String result = string_create("");
+    size_t cap = string_capacity(&result);
+    ck_assert(string_format_cstr(&result, "%0*d", (int)cap, 7) != NULL);
+    ck_assert(!sso_string_is_long(&result));
+    ck_assert_uint_eq(string_size(&result), cap);
+    ck_assert(string_format_cstr(&result, "%d", 8) != NULL);
+    ck_assert_uint_eq(string_size(&result), cap + 1);
+    ck_assert_int_eq(string_data(&result)[cap - 1], '7');
+    ck_assert_int_eq(string_data(&result)[cap], '8');
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_format_cstr_large_repeated) {
+    char text[1001];
+    memset(text, 'x', 1000);
+    text[1000] = '\0';
+
+    for(int i = 0; i < 3; i++) {
+        String result = string_create("head:");
+        ck_assert(string_format_cstr(&result, "%s:%d", text, i) != NULL);
+        ck_assert_uint_eq(string_size(&result), 1007);
+        ck_assert_int_eq(string_data(&result)[1005], ':');
+        ck_assert_int_eq(string_data(&result)[1006], '0' + i);
+        ck_assert_int_eq(string_data(&result)[1007], '\0');
+        string_free_resources(&result);
+    }
+
+    String* created = string_format_cstr(NULL, "%s%s", text, text);
+    ck_assert(created != NULL);
+    ck_assert_uint_eq(string_size(created), 2000);
+    string_free(created);
+}
+END_TEST
+
 START_TEST(string_format_cstr_new) {
     String* result = string_format_cstr(NULL, "%d", 152);
     ck_assert(result != NULL);
@@ -1767,6 +2753,562 @@ START_TEST(string_format_cstr_append) {
 }
 END_TEST
 
+START_TEST(string_format_compile_integers) {
+    StringFormat* format = string_format_compile("[%d|%5d|%-5d|%05d|%+d|%.3d|%x|%#X|%#o|%llu]");
+    ck_assert(format != NULL);
+
+    String result = string_create("");
+    ck_assert(string_format_apply(&result, format, -7, 42, 42, -42, 3, 5, 255, 255, 8, ULLONG_MAX) != NULL);
+    ck_assert_str_eq(string_data(&result), "[-7|   42|42   |-0042|+3|005|ff|0XFF|010|18446744073709551615]");
+    string_free_resources(&result);
+    string_format_free(format);
+}
+END_TEST
+
+START_TEST(string_format_compile_strings_and_floats) {
+    StringFormat* format = string_format_compile("%s=%-6s|%.2s|%*s|%c %.1f%% %e");
+    ck_assert(format != NULL);
+
+    String* result = string_format_apply(NULL, format, "cpu", "usr", "system", 4, "ab", 'x', 99.25, 1500.0);
+    ck_assert(result != NULL);
+    ck_assert_str_eq(string_data(result), "cpu=usr   |sy|  ab|x 99.2% 1.500000e+03");
+    string_free(result);
+    string_format_free(format);
+}
+END_TEST
+
+START_TEST(string_format_compile_float_flags) {
+    StringFormat* format = string_format_compile("[%08.3f|%-10.2e|%+.0f|%#.0e|%E|%F|%05f|% .1f|%g|%.2Lf]");
+    ck_assert(format != NULL);
+
+    String* result = string_format_apply(NULL, format, -3.14159, 12345.678, 2.5, 0.5, 1e-300, INFINITY, -INFINITY, 0.05, 1e20, (long double)1.005);
+    ck_assert(result != NULL);
+    ck_assert_str_eq(string_data(result), "[-003.142|1.23e+04  |+2|5.e-01|1.000000E-300|INF| -inf| 0.1|1e+20|1.00]");
+    string_free(result);
+    string_format_free(format);
+}
+END_TEST
+
+START_TEST(string_format_compile_reuse) {
+    StringFormat* format = string_format_compile("%d%%, ");
+    ck_assert(format != NULL);
+
+    String result = string_create("progress: ");
+    for(int i = 0; i <= 100; i += 25)
+        ck_assert(string_format_apply(&result, format, i) != NULL);
+
+    ck_assert_str_eq(string_data(&result), "progress: 0%, 25%, 50%, 75%, 100%, ");
+    string_free_resources(&result);
+    string_format_free(format);
+}
+END_TEST
+
+START_TEST(string_format_compile_invalid) {
+    ck_assert(string_format_compile("%n") == NULL);
+    ck_assert(string_format_compile("%ls") == NULL);
+    ck_assert(string_format_compile("trailing %") == NULL);
+    ck_assert(string_format_compile("%Ld") == NULL);
+}
+END_TEST
+
+START_TEST(string_format_braces_types) {
+    String result = string_create("");
+    String host = string_create("web-01");
+    StringView view = { "viewtext", 4 };
+    ck_assert(string_format_braces(&result, "{} {} {} {} {} {} {}", &host, view, -42, 7u, 2.5, (bool)true, (char)'x'));
+    ck_assert(string_equals(&result, "web-01 view -42 7 2.5 true x"));
+    string_free_resources(&host);
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_format_braces_positional_named) {
+    String result = string_create("");
+    ck_assert(string_format_braces(&result, "{0}-{1}-{0}", "a", "b"));
+    ck_assert(string_format_braces(&result, " {host}:{port}", string_format_named("host", "localhost"), string_format_named("port", 8080)));
+    ck_assert(string_format_braces(&result, " {{{}}}", 1));
+    ck_assert(string_equals(&result, "a-b-a localhost:8080 {1}"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_format_braces_specs) {
+    String result = string_create("");
+    ck_assert(string_format_braces(&result, "[{:<5}][{:>5}][{:*^7}]", "ab", 12, "mid"));
+    ck_assert(string_equals(&result, "[ab   ][   12][**mid**]"));
+    string_clear(&result);
+    ck_assert(string_format_braces(&result, "{:+08.3f} {:#x} {:#b} {:.2e} {:05}", 3.14159, 255, 5, 12345.678, -42));
+    ck_assert(string_equals(&result, "+003.142 0xff 0b101 1.23e+04 -0042"));
+    string_clear(&result);
+    ck_assert(string_format_braces(&result, "[{:→>4}][{:4.2}]", "é", "ñandú"));
+    ck_assert(string_equals(&result, "[→→→é][ña  ]"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_format_braces_invalid) {
+    String result = string_create("keep");
+    ck_assert(!string_format_braces(&result, "{0} {}", 1, 2));
+    ck_assert(!string_format_braces(&result, "{} {}", 1));
+    ck_assert(!string_format_braces(&result, "{missing}", 1));
+    ck_assert(!string_format_braces(&result, "{:d}", "text"));
+    ck_assert(!string_format_braces(&result, "extra }", 1));
+    ck_assert(!string_format_braces(&result, "{", 1));
+    ck_assert(string_equals(&result, "keep"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_append_int_limits) {
+    String result = string_create("values:");
+    ck_assert(string_append_int(&result, 0));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_int(&result, -42));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_int(&result, INT64_MIN));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_uint(&result, UINT64_MAX));
+    ck_assert(string_equals(&result, "values:0 -42 -9223372036854775808 18446744073709551615"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_append_hex_cases) {
+    String result = string_create("");
+    ck_assert(string_append_hex(&result, 0, false));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_hex(&result, 0xDEADBEEF, false));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_hex(&result, UINT64_MAX, true));
+    ck_assert(string_equals(&result, "0 deadbeef FFFFFFFFFFFFFFFF"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_append_double_shortest) {
+    const double values[] = {
+        0.1, 0.3, 1.0 / 3.0, 100, 123456.789, -2.5, 1e21, 1e20, 1e-6, 1e-7,
+        5e-324, 1.7976931348623157e308, 9007199254740993.0, 0.0, -0.0
+    };
+    const char* expected[] = {
+        "0.1", "0.3", "0.3333333333333333", "100", "123456.789", "-2.5", "1e+21",
+        "100000000000000000000", "0.000001", "1e-7", "5e-324", "1.7976931348623157e+308",
+        "9007199254740992", "0", "-0"
+    };
+
+    for(size_t i = 0; i < ARRAY_SIZE(values); i++) {
+        String result = string_create("");
+        ck_assert(string_append_double(&result, values[i]));
+        ck_assert_str_eq(string_data(&result), expected[i]);
+        string_free_resources(&result);
+    }
+}
+END_TEST
+
+START_TEST(string_append_double_round_trips) {
+    String result = string_create("");
+    ck_assert(string_append_double(&result, INFINITY));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_double(&result, -INFINITY));
+    ck_assert(string_push_back(&result, ' '));
+    ck_assert(string_append_double(&result, NAN));
+    ck_assert(string_equals(&result, "inf -inf nan"));
+
+    // Walk through doubles of every magnitude and make sure each one parses back.
+    uint64_t bits = 1;
+    for(int i = 0; i < 4000; i++) {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        string_clear(&result);
+        ck_assert(string_append_double(&result, value));
+        double parsed = strtod(string_data(&result), NULL);
+        ck_assert(memcmp(&parsed, &value, sizeof(value)) == 0);
+        bits += 0x0007FF3A5C3E91D1ull;
+    }
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_parse_i64_cases) {
+    String str = string_create("-9223372036854775808,42");
+    int64_t value = 0;
+    size_t consumed = 0;
+    ck_assert_int_eq(string_parse_i64(&str, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(value == INT64_MIN);
+    ck_assert_uint_eq(consumed, 20);
+
+    StringView view = { string_data(&str) + 21, 2 };
+    ck_assert_int_eq(string_parse_i64_view(view, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(value == 42);
+    ck_assert_uint_eq(consumed, 2);
+
+    // The view ends before the digits do.
+    StringView part = { "12345", 3 };
+    ck_assert_int_eq(string_parse_i64_view(part, &value, NULL), STRING_PARSE_OK);
+    ck_assert(value == 123);
+
+    StringView big = { "+9223372036854775808x", 21 };
+    ck_assert_int_eq(string_parse_i64_view(big, &value, &consumed), STRING_PARSE_OVERFLOW);
+    ck_assert(value == INT64_MAX);
+    ck_assert_uint_eq(consumed, 20);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_parse_u64_cases) {
+    uint64_t value = 0;
+    size_t consumed = 0;
+    StringView max = { "0018446744073709551615 ", 23 };
+    ck_assert_int_eq(string_parse_u64_view(max, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(value == UINT64_MAX);
+    ck_assert_uint_eq(consumed, 22);
+
+    StringView over = { "18446744073709551616", 20 };
+    ck_assert_int_eq(string_parse_u64_view(over, &value, &consumed), STRING_PARSE_OVERFLOW);
+    ck_assert(value == UINT64_MAX);
+    ck_assert_uint_eq(consumed, 20);
+
+    value = 7;
+    StringView negative = { "-1", 2 };
+    ck_assert_int_eq(string_parse_u64_view(negative, &value, &consumed), STRING_PARSE_INVALID);
+    ck_assert(value == 7);
+    ck_assert_uint_eq(consumed, 0);
+
+    StringView empty = { "", 0 };
+    ck_assert_int_eq(string_parse_u64_view(empty, &value, &consumed), STRING_PARSE_INVALID);
+}
+END_TEST
+
+START_TEST(string_parse_f64_round_trips) {
+    const char* cases[] = {
+        "0.1", "-2.5", "1e23", "8.41e21", "4.9e-324", "2.2250738585072011e-308",
+        "1.7976931348623157e308", "9007199254740993", "123456789012345678901234567890",
+        // Exactly halfway between two doubles, then just above it.
+        "9007199254740993.0000000000000000000000", "9007199254740993.0000000000000000000001"
+    };
+
+    for(size_t i = 0; i < sizeof(cases) / sizeof(*cases); i++) {
+        StringView view = { cases[i], strlen(cases[i]) };
+        double value;
+        size_t consumed;
+        ck_assert_int_eq(string_parse_f64_view(view, &value, &consumed), STRING_PARSE_OK);
+        ck_assert_uint_eq(consumed, view.size);
+        double expected = strtod(cases[i], NULL);
+        ck_assert(memcmp(&value, &expected, sizeof(value)) == 0);
+    }
+
+    String result = string_create("");
+    uint64_t bits = 1;
+    for(int i = 0; i < 4000; i++) {
+        double value;
+        memcpy(&value, &bits, sizeof(value));
+        string_clear(&result);
+        ck_assert(string_append_double(&result, value));
+        double parsed;
+        ck_assert_int_eq(string_parse_f64(&result, &parsed, NULL), STRING_PARSE_OK);
+        ck_assert(memcmp(&parsed, &value, sizeof(value)) == 0);
+        bits += 0x0007FF3A5C3E91D1ull;
+    }
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_parse_f64_partial) {
+    double value = 0;
+    size_t consumed = 0;
+    StringView exponent = { "1.5e+x", 6 };
+    ck_assert_int_eq(string_parse_f64_view(exponent, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(value == 1.5);
+    ck_assert_uint_eq(consumed, 3);
+
+    StringView infinity = { "-Infinity", 9 };
+    ck_assert_int_eq(string_parse_f64_view(infinity, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(isinf(value) && value < 0);
+    ck_assert_uint_eq(consumed, 9);
+
+    StringView nan = { "nan,1", 5 };
+    ck_assert_int_eq(string_parse_f64_view(nan, &value, &consumed), STRING_PARSE_OK);
+    ck_assert(isnan(value));
+    ck_assert_uint_eq(consumed, 3);
+
+    StringView huge = { "1e400", 5 };
+    ck_assert_int_eq(string_parse_f64_view(huge, &value, &consumed), STRING_PARSE_OVERFLOW);
+    ck_assert(isinf(value));
+
+    value = 3;
+    StringView dot = { ".e5", 3 };
+    ck_assert_int_eq(string_parse_f64_view(dot, &value, &consumed), STRING_PARSE_INVALID);
+    ck_assert(value == 3);
+    ck_assert_uint_eq(consumed, 0);
+}
+END_TEST
+
+START_TEST(string_hex_bytes_round_trip) {
+    unsigned char bytes[100];
+    for(int i = 0; i < 100; i++)
+        bytes[i] = (unsigned char)(i * 37 + 11);
+
+    String result = string_create("");
+    ck_assert(string_append_hex_bytes(&result, "\x00\x7F\xAB\xFF", 4, false));
+    ck_assert(string_equals(&result, "007fabff"));
+    string_clear(&result);
+    ck_assert(string_append_hex_bytes(&result, "\x00\x7F\xAB\xFF", 4, true));
+    ck_assert(string_equals(&result, "007FABFF"));
+
+    // Every size up to 100 covers the vectorized blocks and the scalar tail.
+    for(size_t size = 0; size <= 100; size++) {
+        String hex = string_create("");
+        String decoded = string_create("");
+        ck_assert(string_append_hex_bytes(&hex, bytes, size, size % 2 == 0));
+        ck_assert_uint_eq(string_size(&hex), size * 2);
+        ck_assert(string_decode_hex(&decoded, string_data(&hex), string_size(&hex), NULL));
+        ck_assert_uint_eq(string_size(&decoded), size);
+        ck_assert(memcmp(string_data(&decoded), bytes, size) == 0);
+        string_free_resources(&hex);
+        string_free_resources(&decoded);
+    }
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_decode_hex_errors) {
+    String result = string_create("keep");
+    size_t offset = 0;
+    char hex[80];
+    memset(hex, 'a', sizeof(hex));
+    hex[70] = 'g';
+    ck_assert(!string_decode_hex(&result, hex, sizeof(hex), &offset));
+    ck_assert_uint_eq(offset, 70);
+    ck_assert(!string_decode_hex(&result, "abc", 3, &offset));
+    ck_assert_uint_eq(offset, 2);
+    ck_assert(!string_decode_hex(&result, "0x10", 4, &offset));
+    ck_assert_uint_eq(offset, 1);
+    ck_assert(string_equals(&result, "keep"));
+    ck_assert(string_decode_hex(&result, "2D41", 4, NULL));
+    ck_assert(string_equals(&result, "keep-A"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_base64_round_trip) {
+    String result = string_create("");
+    ck_assert(string_append_base64(&result, "\xFB\xFF\xBF", 3, STRING_BASE64_STANDARD));
+    ck_assert(string_append_base64(&result, "\xFB\xFF\xBF", 3, STRING_BASE64_URL));
+    ck_assert(string_append_base64(&result, "ab", 2, STRING_BASE64_STANDARD));
+    ck_assert(string_append_base64(&result, "ab", 2, STRING_BASE64_URL));
+    ck_assert(string_equals(&result, "+/+/-_-_YWI=YWI"));
+
+    unsigned char bytes[200];
+    for(int i = 0; i < 200; i++)
+        bytes[i] = (unsigned char)(i * 73 + 5);
+
+    for(size_t size = 0; size <= 200; size++) {
+        for(int alphabet = STRING_BASE64_STANDARD; alphabet <= STRING_BASE64_URL; alphabet++) {
+            String text = string_create("");
+            String decoded = string_create("");
+            ck_assert(string_append_base64(&text, bytes, size, (StringBase64Alphabet)alphabet));
+            ck_assert(string_decode_base64(&decoded, string_data(&text), string_size(&text), (StringBase64Alphabet)alphabet, NULL));
+            ck_assert_uint_eq(string_size(&decoded), size);
+            ck_assert(memcmp(string_data(&decoded), bytes, size) == 0);
+            string_free_resources(&text);
+            string_free_resources(&decoded);
+        }
+    }
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_decode_base64_errors) {
+    String result = string_create("keep");
+    size_t offset = 0;
+    char text[96];
+    memset(text, 'A', sizeof(text));
+    text[90] = '-';
+    ck_assert(!string_decode_base64(&result, text, sizeof(text), STRING_BASE64_STANDARD, &offset));
+    ck_assert_uint_eq(offset, 90);
+    ck_assert(!string_decode_base64(&result, "AB=C", 4, STRING_BASE64_STANDARD, &offset));
+    ck_assert_uint_eq(offset, 2);
+    ck_assert(!string_decode_base64(&result, "QUJDR", 5, STRING_BASE64_STANDARD, &offset));
+    ck_assert_uint_eq(offset, 4);
+    // The unused bits of the last character have to be zero.
+    ck_assert(!string_decode_base64(&result, "QR==", 4, STRING_BASE64_STANDARD, &offset));
+    ck_assert_uint_eq(offset, 1);
+    ck_assert(string_equals(&result, "keep"));
+    ck_assert(string_decode_base64(&result, "LUE", 3, STRING_BASE64_URL, NULL));
+    ck_assert(string_equals(&result, "keep-A"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_json_escaped_cases) {
+    String result = string_create("[");
+    const char value[] = "say \"hi\"\\\n\t\r\b\f\x01\x1f/\xc3\xa9";
+    ck_assert(string_append_json_escaped(&result, value, sizeof(value) - 1));
+    ck_assert(string_equals(&result, "[say \\\"hi\\\"\\\\\\n\\t\\r\\b\\f\\u0001\\u001f/\xc3\xa9"));
+    string_clear(&result);
+    ck_assert(string_append_json_escaped(&result, "a\0b", 3));
+    ck_assert_uint_eq(string_size(&result), 8);
+    ck_assert(memcmp(string_data(&result), "a\\u0000b", 8) == 0);
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_json_escaped_spans) {
+    // Put the special character at every position of several block sizes.
+    char text[100];
+    for(size_t length = 1; length <= sizeof(text); length += 11) {
+        for(size_t position = 0; position < length; position++) {
+            memset(text, 'x', length);
+            text[position] = '"';
+            String result = string_create("");
+            ck_assert(string_append_json_escaped(&result, text, length));
+            ck_assert_uint_eq(string_size(&result), length + 1);
+            ck_assert(memcmp(string_data(&result), text, position) == 0);
+            ck_assert(memcmp(string_data(&result) + position, "\\\"", 2) == 0);
+
+            String decoded = string_create("");
+            ck_assert(string_json_unescape(&decoded, string_data(&result), string_size(&result), NULL));
+            ck_assert_uint_eq(string_size(&decoded), length);
+            ck_assert(memcmp(string_data(&decoded), text, length) == 0);
+            string_free_resources(&decoded);
+            string_free_resources(&result);
+        }
+    }
+}
+END_TEST
+
+START_TEST(string_json_unescape_cases) {
+    String result = string_create("");
+    const char* text = "a\\\"b\\\\c\\/d\\b\\f\\n\\r\\t\\u00e9\\u20AC\\ud83d\\ude00";
+    ck_assert(string_json_unescape(&result, text, strlen(text), NULL));
+    ck_assert(string_equals(&result, "a\"b\\c/d\b\f\n\r\t\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80"));
+    string_clear(&result);
+    // Surrogates without their other half are replaced.
+    text = "\\ud83dx\\ude00\\ud83d\\u0041";
+    ck_assert(string_json_unescape(&result, text, strlen(text), NULL));
+    ck_assert(string_equals(&result, "\xef\xbf\xbdx\xef\xbf\xbd\xef\xbf\xbd" "A"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_json_unescape_errors) {
+    String result = string_create("keep");
+    size_t offset = 0;
+    ck_assert(!string_json_unescape(&result, "ab\"c", 4, &offset));
+    ck_assert_uint_eq(offset, 2);
+    ck_assert(!string_json_unescape(&result, "abc\n", 4, &offset));
+    ck_assert_uint_eq(offset, 3);
+    ck_assert(!string_json_unescape(&result, "a\\x", 3, &offset));
+    ck_assert_uint_eq(offset, 1);
+    ck_assert(!string_json_unescape(&result, "ab\\", 3, &offset));
+    ck_assert_uint_eq(offset, 2);
+    ck_assert(!string_json_unescape(&result, "\\u12G4", 6, &offset));
+    ck_assert_uint_eq(offset, 0);
+    ck_assert(!string_json_unescape(&result, "x\\u123", 6, &offset));
+    ck_assert_uint_eq(offset, 1);
+    ck_assert(string_equals(&result, "keep"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_url_encoded_cases) {
+    String result = string_create("?q=");
+    const char* value = "a b/c~d-e.f_g+h&\xc3\xa9";
+    ck_assert(string_append_url_encoded(&result, value, strlen(value), NULL, false));
+    ck_assert(string_equals(&result, "?q=a%20b%2Fc~d-e.f_g%2Bh%26%C3%A9"));
+    string_clear(&result);
+    ck_assert(string_append_url_encoded(&result, value, strlen(value), "/&", true));
+    ck_assert(string_equals(&result, "a+b/c~d-e.f_g%2Bh&%C3%A9"));
+    string_clear(&result);
+    ck_assert(string_append_url_encoded(&result, "x\0y", 3, NULL, false));
+    ck_assert(string_equals(&result, "x%00y"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_url_decode_cases) {
+    String result = string_create("");
+    const char* text = "a%20b%2fc+d%C3%A9";
+    ck_assert(string_url_decode(&result, text, strlen(text), false, NULL));
+    ck_assert(string_equals(&result, "a b/c+d\xc3\xa9"));
+    string_clear(&result);
+    ck_assert(string_url_decode(&result, text, strlen(text), true, NULL));
+    ck_assert(string_equals(&result, "a b/c d\xc3\xa9"));
+
+    // Round trip every byte value through spans of different lengths.
+    char bytes[256];
+    for(int i = 0; i < 256; i++)
+        bytes[i] = (char)i;
+    for(size_t length = 0; length <= sizeof(bytes); length += 37) {
+        String encoded = string_create("");
+        String decoded = string_create("");
+        ck_assert(string_append_url_encoded(&encoded, bytes + 256 - length, length, NULL, true));
+        ck_assert(string_url_decode(&decoded, string_data(&encoded), string_size(&encoded), true, NULL));
+        ck_assert_uint_eq(string_size(&decoded), length);
+        ck_assert(memcmp(string_data(&decoded), bytes + 256 - length, length) == 0);
+        string_free_resources(&decoded);
+        string_free_resources(&encoded);
+    }
+
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_url_decode_errors) {
+    String result = string_create("keep");
+    size_t offset = 0;
+    ck_assert(!string_url_decode(&result, "abc%2", 5, false, &offset));
+    ck_assert_uint_eq(offset, 3);
+    ck_assert(!string_url_decode(&result, "%41%g1", 6, false, &offset));
+    ck_assert_uint_eq(offset, 3);
+    ck_assert(!string_url_decode(&result, "%", 1, true, &offset));
+    ck_assert_uint_eq(offset, 0);
+    ck_assert(string_equals(&result, "keep"));
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_html_escaped_cases) {
+    String result = string_create("<p>");
+    const char* value = "Tom & \"Jerry\" <b>'s</b>";
+    ck_assert(string_append_html_escaped(&result, value, strlen(value)));
+    ck_assert(string_equals(&result, "<p>Tom &amp; &quot;Jerry&quot; &lt;b&gt;&#39;s&lt;/b&gt;"));
+
+    // Put the special character at every position of several block sizes.
+    char text[80];
+    for(size_t length = 1; length <= sizeof(text); length += 13) {
+        for(size_t position = 0; position < length; position++) {
+            memset(text, '=', length);
+            text[position] = '<';
+            string_clear(&result);
+            ck_assert(string_append_html_escaped(&result, text, length));
+            ck_assert_uint_eq(string_size(&result), length + 3);
+            ck_assert(memcmp(string_data(&result) + position, "&lt;", 4) == 0);
+        }
+    }
+
+    string_free_resources(&result);
+}
+END_TEST
+
+START_TEST(string_html_unescape_cases) {
+    String result = string_create("");
+    const char* text = "&lt;a href=&quot;x&quot;&gt; &amp;amp; &apos;&#39;&#x27;&#X20AC;&#128512;";
+    ck_assert(string_html_unescape(&result, text, strlen(text)));
+    ck_assert(string_equals(&result, "<a href=\"x\"> &amp; '''\xe2\x82\xac\xf0\x9f\x98\x80"));
+    string_clear(&result);
+    // Invalid code points are replaced and anything that isn't a reference is kept.
+    text = "&#0;&#xD800;&#1114112;&#99999999999;";
+    ck_assert(string_html_unescape(&result, text, strlen(text)));
+    ck_assert(string_equals(&result, "\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd\xef\xbf\xbd"));
+    string_clear(&result);
+    text = "a & b &nbsp; &#; &#x; &#65 &amp";
+    ck_assert(string_html_unescape(&result, text, strlen(text)));
+    ck_assert(string_equals(&result, text));
+    string_free_resources(&result);
+}
+END_TEST
+
 START_TEST(string_hash_verify) {
     String str = string_create("Hello world, it is I, your master.");
     size_t hash_result = string_hash(&str);
@@ -1781,6 +3323,165 @@ START_TEST(string_hash_verify) {
 }
 END_TEST
 
+START_TEST(string_compare_ignore_case_cstr_equals) {
+    ck_assert(string_compare_ignore_case_cstr(&small, "HeLLo") == 0);
+    ck_assert(string_compare_ignore_case_cstr(&small, "HELLP") < 0);
+    ck_assert(string_compare_ignore_case_cstr(&large, "ABCDEFGHIJKLMNOPQRSTUVWXYZ") == 0);
+}
+END_TEST
+
+START_TEST(string_equals_ignore_case_string_true) {
+    String value = string_create("ABCDEFGHIJKLMNOPQRSTUVWXYZ");
+    ck_assert(string_equals_ignore_case_string(&large, &value));
+    string_free_resources(&value);
+}
+END_TEST
+
+START_TEST(string_equals_ignore_case_cstr_false) {
+    ck_assert(!string_equals_ignore_case_cstr(&small, "hellp"));
+    ck_assert(!string_equals_ignore_case_cstr(&small, "hello!"));
+    // Only ASCII letters are folded.
+    ck_assert(!string_equals_ignore_case_cstr(&small, "hell["));
+}
+END_TEST
+
+START_TEST(string_find_ignore_case_cstr_found) {
+    String str = string_create("The quick brown fox jumps over the lazy dog, then THE LAZY DOG sleeps");
+    ck_assert(string_find_ignore_case_cstr(&str, 0, "LAZY dog") == 35);
+    ck_assert(string_find_ignore_case_cstr(&str, 36, "LAZY dog") == 54);
+    ck_assert(string_find_ignore_case_cstr(&str, 0, "t") == 0);
+    ck_assert(string_find_ignore_case_cstr(&str, 0, "cat") == SIZE_MAX);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_u8_equals_ignore_case_cstr_true) {
+    String str = string_create("ΣΊΣΥΦΟΣ Straße");
+    ck_assert(string_u8_equals_ignore_case_cstr(&str, "σίσυφος STRAßE"));
+    ck_assert(!string_u8_equals_ignore_case_cstr(&str, "σίσυφος STRASSE"));
+
+    // The kelvin sign folds to an ASCII k.
+    String kelvin = string_create("Kelvin");
+    ck_assert(string_u8_equals_ignore_case_cstr(&kelvin, "KELVIN"));
+
+    string_free_resources(&str);
+    string_free_resources(&kelvin);
+}
+END_TEST
+
+START_TEST(string_u8_compare_ignore_case_string_order) {
+    String left = string_create("ábc");
+    String right = string_create("ÁBD");
+    ck_assert(string_u8_compare_ignore_case_string(&left, &right) < 0);
+    ck_assert(string_u8_compare_ignore_case_string(&right, &left) > 0);
+    ck_assert(string_u8_compare_ignore_case_cstr(&left, "ÁB") > 0);
+    string_free_resources(&left);
+    string_free_resources(&right);
+}
+END_TEST
+
+START_TEST(string_u8_find_ignore_case_cstr_found) {
+    String str = string_create("Ein GROSSES Ärgernis für ärgerliche Leute");
+    ck_assert(string_u8_find_ignore_case_cstr(&str, 0, "ärger") == 12);
+    ck_assert(string_u8_find_ignore_case_cstr(&str, 13, "ÄRGER") == 27);
+    ck_assert(string_u8_find_ignore_case_cstr(&str, 0, "leute!") == SIZE_MAX);
+    string_free_resources(&str);
+}
+END_TEST
+
+START_TEST(string_hash_ignore_case_matches_lowercase) {
+    String upper = string_create("Hello World, It Is I, Your Master.");
+    String lower = string_create("hello world, it is i, your master.");
+    ck_assert(string_hash_ignore_case(&upper) == string_hash(&lower));
+    ck_assert(string_hash_ignore_case(&upper) == string_hash_ignore_case(&lower));
+    string_free_resources(&upper);
+    string_free_resources(&lower);
+}
+END_TEST
+
+START_TEST(string_u8_hash_ignore_case_matches_folded) {
+    String upper = string_create("ÀÉÎÕÜ ΣΑΣ K");
+    String folded = string_create("àéîõü σασ k");
+    ck_assert(string_u8_hash_ignore_case(&upper) == string_hash(&folded));
+    ck_assert(string_u8_hash_ignore_case(&upper) == string_u8_hash_ignore_case(&folded));
+    string_free_resources(&upper);
+    string_free_resources(&folded);
+}
+END_TEST
+
+START_TEST(string_find_batch_cstr_bitmap) {
+    String strs[10];
+    const char* values[10] = {
+        "hello", "world", "hello world", "", "say hello",
+        "HELLO", ALPHABET "hello", "hell", "o hello o", "lo"
+    };
+    for(int i = 0; i < 10; i++)
+        string_init(strs + i, values[i]);
+
+    uint8_t bitmap[2] = { 0xFF, 0xFF };
+    size_t positions[10];
+    ck_assert(string_find_batch_cstr(strs, 10, "hello", bitmap, positions) == 5);
+    ck_assert(bitmap[0] == 0x55);
+    ck_assert(bitmap[1] == 0x01);
+    ck_assert(positions[0] == 0);
+    ck_assert(positions[1] == SIZE_MAX);
+    ck_assert(positions[4] == 4);
+    ck_assert(positions[6] == strlen(ALPHABET));
+    ck_assert(positions[8] == 2);
+
+    size_t indices[10];
+    ck_assert(string_batch_indices(bitmap, 10, indices) == 5);
+    ck_assert(indices[0] == 0 && indices[1] == 2 && indices[2] == 4);
+    ck_assert(indices[3] == 6 && indices[4] == 8);
+
+    for(int i = 0; i < 10; i++)
+        string_free_resources(strs + i);
+}
+END_TEST
+
+START_TEST(string_starts_with_batch_cstr_short_and_long) {
+    String strs[4];
+    string_init(strs + 0, "hello");
+    string_init(strs + 1, "hello" ALPHABET);
+    string_init(strs + 2, "hell");
+    string_init(strs + 3, ALPHABET);
+
+    uint8_t bitmap[1];
+    ck_assert(string_starts_with_batch_cstr(strs, 4, "hello", bitmap) == 2);
+    ck_assert(bitmap[0] == 0x03);
+    ck_assert(string_starts_with_batch_cstr(strs, 4, "hello" ALPHABET, bitmap) == 1);
+    ck_assert(bitmap[0] == 0x02);
+    ck_assert(string_starts_with_batch_cstr(strs, 4, "", NULL) == 4);
+
+    for(int i = 0; i < 4; i++)
+        string_free_resources(strs + i);
+}
+END_TEST
+
+START_TEST(string_equals_batch_string_ignores_stale_bytes) {
+    String strs[3];
+    string_init(strs + 0, "hello world");
+    string_init(strs + 1, "hello");
+    string_init(strs + 2, ALPHABET);
+    // Leaves "world" in the unused part of the short buffer.
+    string_erase(strs + 0, 5, 6);
+
+    String value = string_create("hello");
+    uint8_t bitmap[1];
+    ck_assert(string_equals_batch_string(strs, 3, &value, bitmap) == 2);
+    ck_assert(bitmap[0] == 0x03);
+
+    string_shrink_to_fit(strs + 2);
+    string_erase(strs + 2, 5, strlen(ALPHABET) - 5);
+    ck_assert(string_equals_batch_cstr(strs, 3, "abcde", bitmap) == 1);
+    ck_assert(bitmap[0] == 0x04);
+
+    string_free_resources(&value);
+    for(int i = 0; i < 3; i++)
+        string_free_resources(strs + i);
+}
+END_TEST
+
 int main(void) {
     int number_failed;
 
@@ -1803,6 +3504,51 @@ int main(void) {
     tcase_add_test(tc, string_u8_codepoints_ascii);
     tcase_add_test(tc, string_u8_codepoints_utf8);
     tcase_add_test(tc, string_u8_codepoints_all);
+    tcase_add_test(tc, string_u8_codepoints_long_mixed);
+    tcase_add_test(tc, string_u8_codepoints_embedded_null);
+    tcase_add_test(tc, string_u8_codepoints_range_clamped);
+    tcase_add_test(tc, string_u8_substring_codepoints);
+    tcase_add_test(tc, string_u8_substring_clamped);
+    tcase_add_test(tc, string_u8_truncate_codepoints);
+    tcase_add_test(tc, string_u8_substring_leading_continuation);
+    tcase_add_test(tc, string_u8_truncate_bytes_boundary);
+    tcase_add_test(tc, string_u8_to_utf16_surrogate_pairs);
+    tcase_add_test(tc, string_u8_from_utf16_unpaired_surrogates);
+    tcase_add_test(tc, string_u8_utf32_round_trip);
+    tcase_add_test(tc, string_u8_to_utf32_invalid_bytes);
+    tcase_add_test(tc, string_u8_iter_forward_and_back);
+    tcase_add_test(tc, string_u8_iter_invalid_bytes);
+    tcase_add_test(tc, string_u8_iter_decode_chunks);
+    tcase_add_test(tc, string_u8_iter_decode_invalid_in_ascii_block);
+    tcase_add_test(tc, string_u8_decode_into_max);
+    tcase_add_test(tc, string_u8_to_lower_mixed);
+    tcase_add_test(tc, string_u8_to_lower_final_sigma);
+    tcase_add_test(tc, string_u8_to_upper_expands);
+    tcase_add_test(tc, string_u8_case_fold_into_appends);
+    tcase_add_test(tc, string_u8_append_codepoints_mixed);
+    tcase_add_test(tc, string_u8_from_latin1_mixed);
+    tcase_add_test(tc, string_u8_from_cp1252_specials);
+    tcase_add_test(tc, string_u8_to_latin1_errors);
+    tcase_add_test(tc, string_u8_to_cp1252_round_trip);
+    tcase_add_test(tc, string_u8_map_shrinks);
+    tcase_add_test(tc, string_u8_map_grows);
+    tcase_add_test(tc, string_u8_map_unchanged);
+    tcase_add_test(tc, string_u8_map_table_remaps);
+    tcase_add_test(tc, string_u8_normalize_forms);
+    tcase_add_test(tc, string_u8_normalize_reorders_marks);
+    tcase_add_test(tc, string_u8_normalize_sorts_long_runs);
+    tcase_add_test(tc, string_u8_normalize_unchanged);
+    tcase_add_test(tc, string_u8_normalize_into_appends);
+    tcase_add_test(tc, string_gc_next_and_prev);
+    tcase_add_test(tc, string_gc_count_clusters);
+    tcase_add_test(tc, string_gc_pop_back_cluster);
+    tcase_add_test(tc, string_gc_truncate_clusters);
+    tcase_add_test(tc, string_u8_offset_of_matches_scan);
+    tcase_add_test(tc, string_u8_index_incremental_updates);
+    tcase_add_test(tc, string_u8_index_rebuilds_after_invalidate);
+    tcase_add_test(tc, string_u8_validate_valid);
+    tcase_add_test(tc, string_u8_validate_error_offset);
+    tcase_add_test(tc, string_u8_validator_split_sequences);
     tcase_add_test(tc, string_get_all);
     tcase_add_test(tc, string_u8_get_ascii);
     tcase_add_test(tc, string_u8_get_utf8);
@@ -1888,6 +3634,16 @@ int main(void) {
     tcase_add_test(tc, string_replace_string_same_size);
     tcase_add_test(tc, string_replace_string_grow_small_to_small);
     tcase_add_test(tc, string_replace_string_grow_small_to_large);
+    tcase_add_test(tc, string_replace_all_cstr_shrink);
+    tcase_add_test(tc, string_replace_all_cstr_same_size);
+    tcase_add_test(tc, string_replace_all_cstr_grow_small_to_large);
+    tcase_add_test(tc, string_replace_all_cstr_none);
+    tcase_add_test(tc, string_replace_all_string_grow);
+    tcase_add_test(tc, string_replace_first_n_cstr_limits_count);
+    tcase_add_test(tc, string_replace_many_cstr_template);
+    tcase_add_test(tc, string_replace_many_cstr_leftmost_longest);
+    tcase_add_test(tc, string_replace_many_cstr_in_place);
+    tcase_add_test(tc, string_replace_many_string_does_not_rescan);
     tcase_add_test(tc, string_substring_part);
     tcase_add_test(tc, string_substring_whole);
     tcase_add_test(tc, string_copy_small);
@@ -1917,10 +3673,17 @@ int main(void) {
     tcase_add_test(tc, string_is_null_or_whitespace_space);
     tcase_add_test(tc, string_is_null_or_whitespace_u8_space);
     tcase_add_test(tc, string_is_null_or_whitespace_filled);
+    tcase_add_test(tc, string_trim_both_ends);
+    tcase_add_test(tc, string_trim_views);
+    tcase_add_test(tc, string_pad_sides);
+    tcase_add_test(tc, string_collapse_whitespace_runs);
     tcase_add_test(tc, string_reverse_bytes_ascii);
     tcase_add_test(tc, string_reverse_bytes_utf8);
+    tcase_add_test(tc, string_reverse_bytes_long);
     tcase_add_test(tc, string_u8_reverse_codepoints_ascii);
     tcase_add_test(tc, string_u8_reverse_codepoints_utf8);
+    tcase_add_test(tc, string_u8_reverse_codepoints_mixed);
+    tcase_add_test(tc, string_u8_reverse_codepoints_invalid);
     tcase_add_test(tc, string_join_none);
     tcase_add_test(tc, string_join_two);
     tcase_add_test(tc, string_join_many);
@@ -1933,6 +3696,38 @@ int main(void) {
     tcase_add_test(tc, string_format_cstr_new);
     tcase_add_test(tc, string_format_cstr_existing);
     tcase_add_test(tc, string_format_cstr_append);
+    tcase_add_test(tc, string_format_cstr_capacity_boundary);
+    tcase_add_test(tc, string_format_cstr_large_repeated);
+    tcase_add_test(tc, string_format_compile_integers);
+    tcase_add_test(tc, string_format_compile_strings_and_floats);
+    tcase_add_test(tc, string_format_compile_float_flags);
+    tcase_add_test(tc, string_format_compile_reuse);
+    tcase_add_test(tc, string_format_compile_invalid);
+    tcase_add_test(tc, string_format_braces_types);
+    tcase_add_test(tc, string_format_braces_positional_named);
+    tcase_add_test(tc, string_format_braces_specs);
+    tcase_add_test(tc, string_format_braces_invalid);
+    tcase_add_test(tc, string_append_int_limits);
+    tcase_add_test(tc, string_append_hex_cases);
+    tcase_add_test(tc, string_append_double_shortest);
+    tcase_add_test(tc, string_append_double_round_trips);
+    tcase_add_test(tc, string_parse_i64_cases);
+    tcase_add_test(tc, string_parse_u64_cases);
+    tcase_add_test(tc, string_parse_f64_round_trips);
+    tcase_add_test(tc, string_parse_f64_partial);
+    tcase_add_test(tc, string_hex_bytes_round_trip);
+    tcase_add_test(tc, string_decode_hex_errors);
+    tcase_add_test(tc, string_base64_round_trip);
+    tcase_add_test(tc, string_decode_base64_errors);
+    tcase_add_test(tc, string_json_escaped_cases);
+    tcase_add_test(tc, string_json_escaped_spans);
+    tcase_add_test(tc, string_json_unescape_cases);
+    tcase_add_test(tc, string_json_unescape_errors);
+    tcase_add_test(tc, string_url_encoded_cases);
+    tcase_add_test(tc, string_url_decode_cases);
+    tcase_add_test(tc, string_url_decode_errors);
+    tcase_add_test(tc, string_html_escaped_cases);
+    tcase_add_test(tc, string_html_unescape_cases);
     tcase_add_test(tc, string_split_init_into_existing_less_than_size);
     tcase_add_test(tc, string_split_init_into_existing_equal_size);
     tcase_add_test(tc, string_split_init_into_existing_greater_than_size);
@@ -1943,6 +3738,18 @@ int main(void) {
     tcase_add_test(tc, string_split_skip_empty);
     tcase_add_test(tc, string_split_dont_skip_empty);
     tcase_add_test(tc, string_hash_verify);
+    tcase_add_test(tc, string_compare_ignore_case_cstr_equals);
+    tcase_add_test(tc, string_equals_ignore_case_string_true);
+    tcase_add_test(tc, string_equals_ignore_case_cstr_false);
+    tcase_add_test(tc, string_find_ignore_case_cstr_found);
+    tcase_add_test(tc, string_u8_equals_ignore_case_cstr_true);
+    tcase_add_test(tc, string_u8_compare_ignore_case_string_order);
+    tcase_add_test(tc, string_u8_find_ignore_case_cstr_found);
+    tcase_add_test(tc, string_hash_ignore_case_matches_lowercase);
+    tcase_add_test(tc, string_u8_hash_ignore_case_matches_folded);
+    tcase_add_test(tc, string_find_batch_cstr_bitmap);
+    tcase_add_test(tc, string_starts_with_batch_cstr_short_and_long);
+    tcase_add_test(tc, string_equals_batch_string_ignores_stale_bytes);
 
 
     suite_add_tcase(s, tc);
@@ -0,0 +1,329 @@
+#!/usr/bin/env perl
+
+# Generates src/sso_string_unicode.h, which holds the Unicode property tables
+# used by the string_u8_* functions. The data comes from the Unicode Character
+# Database that ships with perl, so no extra downloads are needed.
+#
+# Usage: perl tools/unicode_tables.pl > src/sso_string_unicode.h
+#
+# Every property is stored as a two stage table. The first stage is indexed by
+# the codepoint divided by the block size, and points to a block in the second
+# stage that holds the values for each codepoint in the block. Identical blocks
+# are only stored once.
+
+use strict;
+use warnings;
+
+use Unicode::UCD qw(prop_invmap);
+
+my $CODEPOINTS = 0x110000;
+my $BLOCK_SHIFT = 7;
+my $BLOCK_SIZE = 1 << $BLOCK_SHIFT;
+
+# Expands a property into a list containing the value for every codepoint.
+# Mappings to other codepoints are returned as array references, or undef if
+# the codepoint maps to itself.
+sub expand_property {
+    my ($property) = @_;
+    my ($list, $map, $format, $default) = prop_invmap($property);
+    die "Unknown property $property" unless $list;
+
+    my @values;
+    for my $i (0 .. $#$list) {
+        my $start = $list->[$i];
+        my $end = $i < $#$list ? $list->[$i + 1] : $CODEPOINTS;
+        my $value = $map->[$i];
+
+        for my $cp ($start .. $end - 1) {
+            if($format =~ /^a/) {
+                if(ref $value) {
+                    $values[$cp] = $value;
+                } elsif($value eq '0' || $value !~ /^\d+$/) {
+                    # Placeholders such as <hangul syllable> are computed at runtime.
+                    $values[$cp] = undef;
+                } else {
+                    $values[$cp] = [$value + $cp - $start];
+                }
+            } else {
+                $values[$cp] = $value;
+            }
+        }
+    }
+
+    return \@values;
+}
+
+sub type_for {
+    my ($max) = @_;
+    return $max < 256 ? 'uint8_t' : $max < 65536 ? 'uint16_t' : 'uint32_t';
+}
+
+sub emit_array {
+    my ($type, $name, $values, $hex) = @_;
+    my $count = scalar(@$values);
+    print "static const $type ${name}[$count] = {";
+    for my $i (0 .. $count - 1) {
+        print "\n   " if $i % 16 == 0;
+        printf($hex ? " 0x%X," : " %d,", $values->[$i]);
+    }
+    print "\n};\n\n";
+}
+
+# Emits a two stage table for a list of small non-negative integers.
+# Codepoints above the returned limit all have the value 0.
+sub emit_two_stage {
+    my ($name, $values) = @_;
+    my $upper = uc($name);
+
+    my $last = 0;
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        $last = $cp if $values->[$cp];
+    }
+
+    my $blocks = ($last >> $BLOCK_SHIFT) + 1;
+    my (@stage1, @stage2, %seen);
+    my $max = 0;
+
+    for my $block (0 .. $blocks - 1) {
+        my @entries = map { $values->[$_] // 0 } ($block * $BLOCK_SIZE .. ($block + 1) * $BLOCK_SIZE - 1);
+        my $key = join(',', @entries);
+        if(!exists $seen{$key}) {
+            $seen{$key} = scalar(@stage2) / $BLOCK_SIZE;
+            push @stage2, @entries;
+        }
+        push @stage1, $seen{$key};
+        for my $entry (@entries) {
+            $max = $entry if $entry > $max;
+        }
+    }
+
+    printf("#define SSO_UNICODE_%s_LIMIT 0x%X\n\n", $upper, $blocks << $BLOCK_SHIFT);
+    emit_array(type_for(scalar(@stage2) / $BLOCK_SIZE), "sso_unicode_${name}_stage1", \@stage1);
+    emit_array(type_for($max), "sso_unicode_${name}_stage2", \@stage2);
+}
+
+# Emits a table that maps each codepoint to an index into a list of
+# unique differences between the mapped codepoint and the original.
+sub emit_delta_table {
+    my ($name, $mapping) = @_;
+    my @deltas = (0);
+    my %delta_index = (0 => 0);
+    my @values;
+
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        my $target = $mapping->[$cp];
+        next unless defined $target && @$target == 1;
+        my $delta = $target->[0] - $cp;
+        if(!exists $delta_index{$delta}) {
+            $delta_index{$delta} = scalar(@deltas);
+            push @deltas, $delta;
+        }
+        $values[$cp] = $delta_index{$delta};
+    }
+
+    emit_two_stage($name, \@values);
+    emit_array('int32_t', "sso_unicode_${name}_deltas", \@deltas);
+}
+
+# Emits a table for a full case mapping. Mappings to a single codepoint are
+# stored as deltas like emit_delta_table. Mappings to multiple codepoints are
+# stored in a separate list of entries that hold the number of codepoints
+# followed by the codepoints themselves, and are referenced by the values
+# after the last delta.
+sub emit_full_mapping {
+    my ($name, $mapping) = @_;
+    my $upper = uc($name);
+    my @deltas = (0);
+    my %delta_index = (0 => 0);
+    my (@special, %special_index, @values);
+
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        my $target = $mapping->[$cp];
+        next unless defined $target && @$target == 1;
+        my $delta = $target->[0] - $cp;
+        if(!exists $delta_index{$delta}) {
+            $delta_index{$delta} = scalar(@deltas);
+            push @deltas, $delta;
+        }
+        $values[$cp] = $delta_index{$delta};
+    }
+
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        my $target = $mapping->[$cp];
+        next unless defined $target && @$target > 1;
+        die "Mapping for $cp is too long" if @$target > 3;
+        my $key = join(',', @$target);
+        if(!exists $special_index{$key}) {
+            $special_index{$key} = scalar(@special) / 4;
+            push @special, scalar(@$target), @$target, (0) x (3 - @$target);
+        }
+        $values[$cp] = scalar(@deltas) + $special_index{$key};
+    }
+
+    emit_two_stage($name, \@values);
+    emit_array('int32_t', "sso_unicode_${name}_deltas", \@deltas);
+    printf("#define SSO_UNICODE_%s_DELTAS %d\n\n", $upper, scalar(@deltas));
+    emit_array('uint32_t', "sso_unicode_${name}_special", \@special, 1);
+}
+
+# Emits a table of flags for a list of binary properties. The first property
+# is stored in bit 0, the second in bit 1, etc.
+sub emit_flags {
+    my ($name, @properties) = @_;
+    my @values;
+
+    for my $bit (0 .. $#properties) {
+        my $property = expand_property($properties[$bit]);
+        for my $cp (0 .. $CODEPOINTS - 1) {
+            $values[$cp] |= (1 << $bit) if ($property->[$cp] // 'N') eq 'Y';
+        }
+    }
+
+    emit_two_stage($name, \@values);
+}
+
+# Emits the tables used for normalization: the full canonical and compatibility
+# decompositions, the canonical composition pairs and the quick check values.
+# Hangul syllables are decomposed and composed algorithmically.
+sub emit_normalization {
+    my $mapping = expand_property('dm');
+    my $type = expand_property('dt');
+    my $exclusions = expand_property('Comp_Ex');
+
+    my $decompose;
+    $decompose = sub {
+        my ($cp, $compat) = @_;
+        my $target = $mapping->[$cp];
+        return ($cp) unless defined $target && ($compat || $type->[$cp] eq 'Canonical');
+        return map { $decompose->($_, $compat) } @$target;
+    };
+
+    # Every decomposition is stored in a single list as its length followed
+    # by its codepoints. Index 0 holds an empty decomposition.
+    my @data = (0);
+    my %data_index;
+    my (@canonical, @compat, $longest);
+    $longest = 0;
+
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        next unless defined $mapping->[$cp];
+        for my $compat (0, 1) {
+            my @decomposition = $decompose->($cp, $compat);
+            next if @decomposition == 1 && $decomposition[0] == $cp;
+            my $key = join(',', @decomposition);
+            if(!exists $data_index{$key}) {
+                $data_index{$key} = scalar(@data);
+                push @data, scalar(@decomposition), @decomposition;
+            }
+            $longest = @decomposition if @decomposition > $longest;
+            ($compat ? \@compat : \@canonical)->[$cp] = $data_index{$key};
+        }
+    }
+
+    emit_two_stage('canonical_decomposition', \@canonical);
+    emit_two_stage('compat_decomposition', \@compat);
+    printf("#define SSO_UNICODE_DECOMPOSITION_MAX %d\n\n", $longest);
+    emit_array('uint32_t', 'sso_unicode_decompositions', \@data, 1);
+
+    # Pairs that compose into a primary composite, sorted by the first
+    # codepoint shifted left 21 bits combined with the second codepoint.
+    my @pairs;
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        my $target = $mapping->[$cp];
+        next unless defined $target && @$target == 2 && $type->[$cp] eq 'Canonical';
+        next if ($exclusions->[$cp] // 'N') eq 'Y';
+        push @pairs, [($target->[0] << 21) | $target->[1], $cp];
+    }
+    @pairs = sort { $a->[0] <=> $b->[0] } @pairs;
+
+    printf("#define SSO_UNICODE_COMPOSITION_COUNT %d\n\n", scalar(@pairs));
+    emit_array('uint64_t', 'sso_unicode_composition_keys', [map { $_->[0] } @pairs], 1);
+    emit_array('uint32_t', 'sso_unicode_composition_values', [map { $_->[1] } @pairs], 1);
+
+    my $ccc = expand_property('ccc');
+    emit_two_stage('combining_class', $ccc);
+
+    # Bits 0 and 1 are set if a codepoint is not allowed in NFD and NFKD.
+    # Bits 2 and 3 are set if it's not allowed or maybe allowed in NFC, and
+    # bits 4 and 5 are the same for NFKC.
+    my @quick_check;
+    my @properties = (['NFD_QC', 0, undef], ['NFKD_QC', 1, undef], ['NFC_QC', 2, 3], ['NFKC_QC', 4, 5]);
+    for my $property (@properties) {
+        my ($name, $no, $maybe) = @$property;
+        my $values = expand_property($name);
+        for my $cp (0 .. $CODEPOINTS - 1) {
+            my $value = $values->[$cp] // 'Y';
+            $quick_check[$cp] |= (1 << $no) if $value eq 'N';
+            $quick_check[$cp] |= (1 << $maybe) if $value eq 'M';
+        }
+    }
+    emit_two_stage('quick_check', \@quick_check);
+}
+
+# Emits the Grapheme_Cluster_Break values used to find extended grapheme
+# cluster boundaries (UAX #29). Extended_Pictographic codepoints all have
+# the value Other, so they're given a value of their own.
+sub emit_grapheme_break {
+    my @names = qw(Other CR LF Control Extend ZWJ Regional_Indicator Prepend
+        SpacingMark L V T LV LVT Extended_Pictographic);
+    my %index = map { $names[$_] => $_ } 0 .. $#names;
+
+    my $break = expand_property('GCB');
+    my $pictographic = expand_property('ExtPict');
+    my @values;
+
+    for my $cp (0 .. $CODEPOINTS - 1) {
+        my $value = $break->[$cp] // 'Other';
+        $value = 'Other' if $value eq 'ExtPict_XX';
+        if(($pictographic->[$cp] // 'N') eq 'Y') {
+            die "Extended_Pictographic codepoint $cp is $value" unless $value eq 'Other';
+            $value = 'Extended_Pictographic';
+        }
+        die "Unknown Grapheme_Cluster_Break value $value" unless exists $index{$value};
+        $values[$cp] = $index{$value};
+    }
+
+    for my $i (0 .. $#names) {
+        printf("#define SSO_UNICODE_GCB_%s %d\n", uc($names[$i]), $i);
+    }
+    printf("#define SSO_UNICODE_GCB_COUNT %d\n\n", scalar(@names));
+    emit_two_stage('grapheme_break', \@values);
+}
+
+print <<"HEADER";
+/*
+    This file is generated by tools/unicode_tables.pl from the
+    Unicode Character Database. Do not edit it manually.
+*/
+
+#ifndef SSO_STRING_SSO_STRING_UNICODE_H
+#define SSO_STRING_SSO_STRING_UNICODE_H
+
+#include <stdint.h>
+
+#define SSO_UNICODE_VERSION "@{[Unicode::UCD::UnicodeVersion()]}"
+#define SSO_UNICODE_BLOCK_SHIFT $BLOCK_SHIFT
+#define SSO_UNICODE_BLOCK_MASK @{[$BLOCK_SIZE - 1]}
+
+HEADER
+
+print "// Simple case folding (CaseFolding.txt statuses C and S).\n\n";
+emit_delta_table('simple_fold', expand_property('scf'));
+
+print "// Full case mappings (UnicodeData.txt and the unconditional mappings in SpecialCasing.txt).\n\n";
+emit_full_mapping('lower', expand_property('lc'));
+emit_full_mapping('upper', expand_property('uc'));
+
+print "// Full case folding (CaseFolding.txt statuses C and F).\n\n";
+emit_full_mapping('fold', expand_property('cf'));
+
+print "// Bit 0 is set for Cased codepoints and bit 1 for Case_Ignorable codepoints.\n\n";
+emit_flags('case_properties', 'Cased', 'Case_Ignorable');
+
+print "// Normalization (UnicodeData.txt decompositions and DerivedNormalizationProps.txt).\n\n";
+emit_normalization();
+
+print "// Grapheme cluster breaks (GraphemeBreakProperty.txt and emoji-data.txt).\n\n";
+emit_grapheme_break();
+
+print "#endif\n";